@@ -0,0 +1,118 @@
+//==================================================================================================
+//  File:
+//      cached_segmented_addressing_model.h
+//
+//  Summary:
+//      Defines a segmented addressing model that caches the most recent segment translation
+//      made by each thread.
+//==================================================================================================
+//
+#ifndef CACHED_SEGMENTED_ADDRESSING_MODEL_H_DEFINED
+#define CACHED_SEGMENTED_ADDRESSING_MODEL_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include "segmented_addressing_model.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class:
+//      cached_segmented_addressing_model
+//
+//  Summary:
+//      This class implements the same based (segment:offset) addressing model as its base,
+//      except that address() first consults a per-thread cache holding the last segment that
+//      the thread translated, that segment's base address, and the storage model's relocation
+//      epoch at the time.  While a thread keeps dereferencing pointers into one segment, a
+//      translation costs two compares against values that stay in the thread's cache instead
+//      of an indexed load from the storage model's segment table.  Any change to the segment
+//      table increments the epoch, which invalidates every thread's cached entry.
+//
+//      To opt in, a storage model names this class as its addressing_model and returns it from
+//      segment_pointer().  The representation is the same as the base's, and this class
+//      converts implicitly from its base, so such a storage model can simply derive from an
+//      existing one and wrap its segment_pointer().
+//--------------------------------------------------------------------------------------------------
+//
+template<typename SM>
+class cached_segmented_addressing_model : public segmented_addressing_model<SM>
+{
+    using base = segmented_addressing_model<SM>;
+
+  public:
+    using size_type       = typename base::size_type;
+    using difference_type = typename base::difference_type;
+
+  public:
+    ~cached_segmented_addressing_model() = default;
+
+    cached_segmented_addressing_model() noexcept = default;
+    cached_segmented_addressing_model(cached_segmented_addressing_model&&) noexcept = default;
+    cached_segmented_addressing_model(cached_segmented_addressing_model const&) noexcept = default;
+    cached_segmented_addressing_model(base const& other) noexcept;
+    cached_segmented_addressing_model(std::nullptr_t) noexcept;
+
+    cached_segmented_addressing_model&
+    operator =(cached_segmented_addressing_model&&) noexcept = default;
+    cached_segmented_addressing_model&
+    operator =(cached_segmented_addressing_model const&) noexcept = default;
+    cached_segmented_addressing_model&
+    operator =(std::nullptr_t) noexcept;
+
+    void*       address() const noexcept;
+
+  private:
+    struct translation_cache
+    {
+        uint64_t    m_epoch;
+        size_type   m_segment;
+        uint8_t*    mp_base;
+    };
+
+    //- Segment 0 is never allocated, so its base is null and the initial entry is valid as
+    //  long as the epoch has not moved.
+    //
+    static  thread_local    translation_cache   tl_cache;
+};
+
+template<typename SM>
+thread_local typename cached_segmented_addressing_model<SM>::translation_cache
+    cached_segmented_addressing_model<SM>::tl_cache = {0u, 0u, nullptr};
+
+
+template<typename SM> inline
+cached_segmented_addressing_model<SM>::cached_segmented_addressing_model(base const& other) noexcept
+:   base(other)
+{}
+
+template<typename SM> inline
+cached_segmented_addressing_model<SM>::cached_segmented_addressing_model(std::nullptr_t) noexcept
+:   base(nullptr)
+{}
+
+template<typename SM> inline
+cached_segmented_addressing_model<SM>&
+cached_segmented_addressing_model<SM>::operator =(std::nullptr_t) noexcept
+{
+    base::operator =(nullptr);
+    return *this;
+}
+
+template<typename SM> inline
+void*
+cached_segmented_addressing_model<SM>::address() const noexcept
+{
+    translation_cache&  cache   = tl_cache;
+    size_type           segment = this->segment();
+    uint64_t            epoch   = SM::relocation_epoch();
+
+    if (cache.m_segment != segment  ||  cache.m_epoch != epoch)
+    {
+        cache.m_epoch   = epoch;
+        cache.m_segment = segment;
+        cache.mp_base   = SM::segment_address(segment);
+    }
+
+    return cache.mp_base + this->offset();
+}
+
+#endif  //- CACHED_SEGMENTED_ADDRESSING_MODEL_H_DEFINED
@@ -0,0 +1,294 @@
+//==================================================================================================
+//  File:
+//      fixed_addressing_model.h
+//
+//  Summary:
+//      Defines an addressing model whose representation is an address in a fixed, reserved
+//      range, so that translation is unnecessary when the heap is mapped at that range.
+//==================================================================================================
+//
+#ifndef FIXED_ADDRESSING_MODEL_H_DEFINED
+#define FIXED_ADDRESSING_MODEL_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//--------------------------------------------------------------------------------------------------
+//  Class:
+//      fixed_addressing_model
+//
+//  Summary:
+//      This class implements an addressing model in which segment s, offset n is represented
+//      by the 64-bit value SM::fixed_base() + s * SM::max_segment_size() + n; that is, by the
+//      address that byte would have if every segment were mapped at its slot in the storage
+//      model's fixed address range.  When the storage model has managed to map the segments
+//      there, address() simply returns the stored value.  Otherwise, the value is decoded into
+//      a segment and an offset and translated through the segment table, exactly as with
+//      segmented_addressing_model.  Either way the representation is the same, so a heap
+//      image can be loaded in either mode.
+//
+//      Values outside the fixed range are ordinary addresses, as with the segmented model.  An
+//      address inside the range that does not belong to the heap cannot be represented, which
+//      is why the storage model insists on reserving the whole range before using it.
+//--------------------------------------------------------------------------------------------------
+//
+template<typename SM>
+class fixed_addressing_model
+{
+  public:
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+  public:
+    ~fixed_addressing_model() = default;
+
+    fixed_addressing_model() noexcept = default;
+    fixed_addressing_model(fixed_addressing_model&&) noexcept = default;
+    fixed_addressing_model(fixed_addressing_model const&) noexcept = default;
+    fixed_addressing_model(std::nullptr_t) noexcept;
+
+    fixed_addressing_model&     operator =(fixed_addressing_model&&) noexcept = default;
+    fixed_addressing_model&     operator =(fixed_addressing_model const&) noexcept = default;
+    fixed_addressing_model&     operator =(std::nullptr_t) noexcept;
+
+    void*       address() const noexcept;
+    size_type   offset() const noexcept;
+    size_type   segment() const noexcept;
+
+    bool        equals(std::nullptr_t) const noexcept;
+    bool        equals(void const* p) const noexcept;
+    bool        equals(fixed_addressing_model const& other) const noexcept;
+
+    bool        greater_than(std::nullptr_t) const noexcept;
+    bool        greater_than(void const* p) const noexcept;
+    bool        greater_than(fixed_addressing_model const& other) const noexcept;
+
+    bool        less_than(std::nullptr_t) const noexcept;
+    bool        less_than(void const* p) const noexcept;
+    bool        less_than(fixed_addressing_model const& other) const noexcept;
+
+    void        assign_from(void const* p);
+
+    void        decrement(difference_type dec) noexcept;
+    void        increment(difference_type inc) noexcept;
+
+    difference_type     difference(fixed_addressing_model const& other) const noexcept;
+
+    static  void    translate(fixed_addressing_model const* psrc, void** pdst, size_type n,
+                              bool prefetch = false) noexcept;
+
+  private:
+    friend  SM;
+
+    uint64_t    m_addr;
+
+  private:
+    fixed_addressing_model(size_type segment, size_type offset) noexcept;
+
+    uint64_t    relative() const noexcept;
+    bool        in_range() const noexcept;
+};
+
+
+template<typename SM> inline
+fixed_addressing_model<SM>::fixed_addressing_model(std::nullptr_t) noexcept
+:   m_addr{0u}
+{}
+
+template<typename SM> inline
+fixed_addressing_model<SM>::fixed_addressing_model(size_type segment, size_type offset) noexcept
+:   m_addr{SM::fixed_base() + uint64_t(segment) * SM::max_segment_size() + offset}
+{}
+
+template<typename SM> inline
+fixed_addressing_model<SM>&
+fixed_addressing_model<SM>::operator =(std::nullptr_t) noexcept
+{
+    m_addr = 0u;
+    return *this;
+}
+
+//- In fixed mode the stored value is the address; the test of the mode is well predicted, and
+//  replaces the segment table lookup.
+//
+template<typename SM> inline
+void*
+fixed_addressing_model<SM>::address() const noexcept
+{
+    if (SM::sm_fixed  ||  !in_range())
+    {
+        return reinterpret_cast<void*>(static_cast<uintptr_t>(m_addr));
+    }
+    return SM::sm_segment_addr[segment()] + offset();
+}
+
+template<typename SM> inline
+typename fixed_addressing_model<SM>::size_type
+fixed_addressing_model<SM>::offset() const noexcept
+{
+    return in_range() ? static_cast<size_type>(relative() % SM::max_segment_size())
+                      : static_cast<size_type>(m_addr);
+}
+
+template<typename SM> inline
+typename fixed_addressing_model<SM>::size_type
+fixed_addressing_model<SM>::segment() const noexcept
+{
+    return in_range() ? static_cast<size_type>(relative() / SM::max_segment_size()) : 0;
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::equals(std::nullptr_t) const noexcept
+{
+    return m_addr == 0;
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::equals(void const* p) const noexcept
+{
+    return address() == p;
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::equals(fixed_addressing_model const& other) const noexcept
+{
+    return m_addr == other.m_addr  ||  address() == other.address();
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::greater_than(std::nullptr_t) const noexcept
+{
+    return m_addr != 0;
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::greater_than(void const* p) const noexcept
+{
+    return address() > p;
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::greater_than(fixed_addressing_model const& other) const noexcept
+{
+    return address() > other.address();
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::less_than(std::nullptr_t) const noexcept
+{
+    return false;
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::less_than(void const* p) const noexcept
+{
+    return address() < p;
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::less_than(fixed_addressing_model const& other) const noexcept
+{
+    return address() < other.address();
+}
+
+template<typename SM>
+void
+fixed_addressing_model<SM>::assign_from(void const* p)
+{
+    uint64_t    addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p));
+
+    if (!SM::sm_fixed)
+    {
+        uint8_t const*  pbyte = static_cast<uint8_t const*>(p);
+
+        for (size_type i = SM::first_segment();  i <= SM::max_segment_count();  ++i)
+        {
+            uint8_t const*  pbottom = SM::sm_segment_addr[i];
+            uint8_t const*  ptop    = pbottom + SM::sm_segment_size[i];
+
+            if (pbottom != nullptr  &&  pbottom <= pbyte  &&  pbyte < ptop)
+            {
+                addr = SM::fixed_base() + uint64_t(i) * SM::max_segment_size() + (pbyte - pbottom);
+                break;
+            }
+        }
+    }
+
+    m_addr = addr;
+}
+
+template<typename SM> inline
+void
+fixed_addressing_model<SM>::decrement(difference_type dec) noexcept
+{
+    m_addr -= dec;
+}
+
+template<typename SM> inline
+void
+fixed_addressing_model<SM>::increment(difference_type inc) noexcept
+{
+    m_addr += inc;
+}
+
+//- Within one segment, the encoded values differ by the same amount as the addresses.
+//
+template<typename SM> inline
+typename fixed_addressing_model<SM>::difference_type
+fixed_addressing_model<SM>::difference(fixed_addressing_model const& other) const noexcept
+{
+    if (SM::sm_fixed  ||  segment() == other.segment())
+    {
+        return static_cast<difference_type>(m_addr - other.m_addr);
+    }
+    return static_cast<uint8_t const*>(address()) - static_cast<uint8_t const*>(other.address());
+}
+
+//- In fixed mode, translation of an array is a copy.
+//
+template<typename SM>
+void
+fixed_addressing_model<SM>::translate
+(fixed_addressing_model const* psrc, void** pdst, size_type n, bool) noexcept
+{
+    static_assert(sizeof(fixed_addressing_model) == sizeof(void*)  ||  sizeof(void*) < 8,
+                  "unexpected address representation");
+
+    if (SM::sm_fixed)
+    {
+        std::memcpy(pdst, psrc, n * sizeof(void*));
+    }
+    else
+    {
+        for (size_type i = 0;  i < n;  ++i)
+        {
+            pdst[i] = psrc[i].address();
+        }
+    }
+}
+
+template<typename SM> inline
+uint64_t
+fixed_addressing_model<SM>::relative() const noexcept
+{
+    return m_addr - SM::fixed_base();
+}
+
+template<typename SM> inline
+bool
+fixed_addressing_model<SM>::in_range() const noexcept
+{
+    return relative() < SM::fixed_range_size();
+}
+
+#endif  //- FIXED_ADDRESSING_MODEL_H_DEFINED
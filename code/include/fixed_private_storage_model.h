@@ -0,0 +1,173 @@
+//==================================================================================================
+//  File:
+//      fixed_private_storage_model.h
+//
+//  Summary:
+//      Defines a heap class for testing rhx_allocator that tries to map its segments at fixed
+//      addresses, so that synthetic pointers need no translation.
+//==================================================================================================
+//
+#ifndef FIXED_PRIVATE_STORAGE_MODEL_H_DEFINED
+#define FIXED_PRIVATE_STORAGE_MODEL_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include "fixed_addressing_model.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class:
+//      fixed_private_storage_model
+//
+//  Summary:
+//      This class provides the same services as segmented_private_storage_model, except that
+//      on first use it reserves a range of address space starting at fixed_base(), with one
+//      slot of max_size bytes per segment number, and commits each segment in its own slot.
+//      While every segment lives in its slot, is_fixed() returns true and fixed_addressing_model
+//      dereferences its stored value directly.  A segment grows in place by committing more of
+//      its slot; buffers that live in the free store are allocated with room for max_size bytes.
+//
+//      If the range cannot be reserved at that address (or at all, as in a 32-bit process),
+//      segments are allocated from the free store instead and pointers are translated through
+//      the segment table.  The same happens after swap_buffers() moves the segments into their
+//      shadow buffers; swapping back returns the heap to fixed mode.
+//
+//      Heap images are saved in the segmented model's file format, but since pointers are
+//      stored as addresses in the fixed range, an image records that encoding and can only be
+//      loaded by this model, which puts its segments back in their slots.
+//--------------------------------------------------------------------------------------------------
+//
+class fixed_private_storage_model
+{
+  public:
+    using difference_type  = std::ptrdiff_t;
+    using size_type        = std::size_t;
+    using addressing_model = fixed_addressing_model<fixed_private_storage_model>;
+
+    //- The allocation strategy registers a function that stores its bookkeeping in the heap,
+    //  called before the heap is saved, and one that makes it forget what it knows, called after
+    //  the segments have been replaced or removed.
+    //
+    using state_hook = void (*)();
+
+  public:
+    enum : size_type
+    {
+        max_segments = 16,          //- Same capacity as the segmented model
+        max_size     = 1u << 22,    //- 4MB segments
+        max_align    = 1u << 12,    //- Segment base addresses are page-aligned
+        page_size    = 1u << 12     //- Granularity of heap image checksums
+    };
+
+    static  void    allocate_segment(size_type segment, size_type size = max_size);
+    static  void    deallocate_segment(size_type segment);
+    static  void    resize_segment(size_type segment, size_type size);
+    static  void    clear_segments();
+    static  void    swap_buffers();
+    static  void    set_state_hooks(state_hook store, state_hook reload) noexcept;
+
+    static  void        save_image(char const* path);
+    static  void        map_image(char const* path);
+    static  uint32_t    checksum(void const* p, size_type n, uint32_t crc = 0) noexcept;
+
+    static  bool                is_fixed() noexcept;
+    static  uint8_t*            segment_address(size_type segment) noexcept;
+    static  addressing_model    segment_pointer(size_type segment, size_type offset=0) noexcept;
+    static  size_type           segment_size(size_type segment) noexcept;
+
+    static  constexpr   uint64_t    fixed_base();
+    static  constexpr   uint64_t    fixed_range_size();
+    static  constexpr   size_type   first_segment();
+    static  constexpr   size_type   max_segment_count();
+    static  constexpr   size_type   max_segment_size();
+    static  constexpr   size_type   segment_alignment();
+
+  private:
+    friend class fixed_addressing_model<fixed_private_storage_model>;
+
+    static  uint8_t*    sm_segment_addr[max_segments + 2];
+    static  size_type   sm_segment_size[max_segments + 2];
+    static  uint8_t*    sm_shadow_addr[max_segments + 2];
+    static  uint8_t*    sm_reserved_addr;
+    static  bool        sm_reserve_tried;
+    static  bool        sm_fixed;
+    static  state_hook  sm_store_hook;
+    static  state_hook  sm_reload_hook;
+
+    static  bool        reserve_range();
+    static  uint8_t*    slot_address(size_type segment) noexcept;
+    static  void        update_mode() noexcept;
+};
+
+
+inline void
+fixed_private_storage_model::set_state_hooks(state_hook store, state_hook reload) noexcept
+{
+    sm_store_hook  = store;
+    sm_reload_hook = reload;
+}
+
+inline bool
+fixed_private_storage_model::is_fixed() noexcept
+{
+    return sm_fixed;
+}
+
+inline auto
+fixed_private_storage_model::segment_address(size_type segment) noexcept -> uint8_t*
+{
+    return sm_segment_addr[segment];
+}
+
+inline auto
+fixed_private_storage_model::segment_pointer(size_type segment, size_type offset) noexcept
+-> addressing_model
+{
+    return addressing_model{segment, offset};
+}
+
+inline auto
+fixed_private_storage_model::segment_size(size_type segment) noexcept -> size_type
+{
+    return sm_segment_size[segment];
+}
+
+//- The base lies well above the addresses that typical 64-bit loaders and allocators hand out,
+//  and well below the top of a 47-bit user address space.
+//
+constexpr inline uint64_t
+fixed_private_storage_model::fixed_base()
+{
+    return uint64_t(0x2000) << 32;
+}
+
+constexpr inline uint64_t
+fixed_private_storage_model::fixed_range_size()
+{
+    return uint64_t(max_segments + 2) * max_size;
+}
+
+constexpr inline auto
+fixed_private_storage_model::first_segment() -> size_type
+{
+    return 2;
+}
+
+constexpr inline auto
+fixed_private_storage_model::max_segment_count() -> size_type
+{
+    return max_segments;
+}
+
+constexpr inline auto
+fixed_private_storage_model::max_segment_size() -> size_type
+{
+    return max_size;
+}
+
+constexpr inline auto
+fixed_private_storage_model::segment_alignment() -> size_type
+{
+    return max_align;
+}
+
+#endif  //- FIXED_PRIVATE_STORAGE_MODEL_H_DEFINED
@@ -19,7 +19,9 @@
 //  Summary:
 //      This class template implements a standard-conforming allocator that uses the pointer
 //      interface and allocation strategy expressed by its second template parameter to allocate
-//      memory for representing objects of type T.
+//      memory for representing objects of type T.  An allocator may be constructed from a
+//      strategy object, such as one tagged with the generation to allocate from; the strategy is
+//      carried along when the allocator is copied or rebound.
 //--------------------------------------------------------------------------------------------------
 //
 template<class T, class HT>
@@ -47,6 +49,7 @@ class rhx_allocator
 
   public:
     rhx_allocator();
+    explicit rhx_allocator(const HT& heap) noexcept;
     rhx_allocator(const rhx_allocator& src) noexcept;
     template<class U>
     rhx_allocator(const rhx_allocator<U, HT>& src) noexcept;
@@ -62,6 +65,7 @@ class rhx_allocator
     pointer     allocate(size_type n, const_void_pointer p);
     void        deallocate(pointer p);
     void        deallocate(pointer p, size_type n);
+    bool        expand_in_place(pointer p, size_type old_n, size_type new_n);
 
     template<class U, class... Args>
     void        construct(U* p, Args&&... args);
@@ -114,6 +118,11 @@ rhx_allocator<T, HT>::rhx_allocator()
 :   m_heap()
 {}
 
+template<class T, class HT> inline
+rhx_allocator<T, HT>::rhx_allocator(const HT& heap) noexcept
+:   m_heap(heap)
+{}
+
 template<class T, class HT> inline
 rhx_allocator<T, HT>::rhx_allocator(const rhx_allocator& src) noexcept
 :   m_heap(src.m_heap)
@@ -162,14 +171,14 @@ template<class T, class HT> inline
 typename rhx_allocator<T, HT>::pointer
 rhx_allocator<T, HT>::allocate(size_type n)
 {
-    return static_cast<pointer>(m_heap.allocate(n * sizeof(T)));
+    return static_cast<pointer>(m_heap.allocate(n * sizeof(T), alignof(T)));
 }
 
 template<class T, class HT> inline
 typename rhx_allocator<T, HT>::pointer
-rhx_allocator<T, HT>::allocate(size_type n, const_void_pointer)
+rhx_allocator<T, HT>::allocate(size_type n, const_void_pointer p)
 {
-    return static_cast<pointer>(m_heap.allocate(n * sizeof(T)));
+    return static_cast<pointer>(m_heap.allocate(n * sizeof(T), alignof(T), p));
 }
 
 template<class T, class HT> inline
@@ -186,6 +195,16 @@ rhx_allocator<T, HT>::deallocate(pointer p, size_type)
     m_heap.deallocate(p);
 }
 
+//- Attempts to grow the block at p, which holds old_n objects, so that it can hold new_n objects
+//  without moving it.  Returns false, leaving the block unchanged, if that is not possible.
+//
+template<class T, class HT> inline
+bool
+rhx_allocator<T, HT>::expand_in_place(pointer p, size_type old_n, size_type new_n)
+{
+    return m_heap.try_expand(p, old_n * sizeof(T), new_n * sizeof(T));
+}
+
 template<class T, class HT>
 template<class U, class... Args> inline
 void
@@ -209,6 +228,9 @@ rhx_allocator<T, HT>::destroy(U* p)
 //  Facility:   rhx_allocator<T> Comparison Operators
 //--------------------------------------------------------------------------------------------------
 //
+//- Allocators compare equal whatever their strategy objects, since a block may be deallocated
+//  through any allocator using the same strategy type, whichever generation it came from.
+//
 template<class T, class HT> inline bool
 operator ==(const rhx_allocator<T, HT>&, const rhx_allocator<T, HT>&)
 {
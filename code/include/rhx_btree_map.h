@@ -0,0 +1,1382 @@
+//==================================================================================================
+//  File:
+//      rhx_btree_map.h
+//
+//  Summary:
+//      Defines the rhx_btree_map<K,V,C,A> class template, an ordered map implemented as a
+//      B+tree with wide nodes.
+//==================================================================================================
+//
+#ifndef RHX_BTREE_MAP_H_DEFINED
+#define RHX_BTREE_MAP_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "rhx_trace_traits.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_btree_map<K,V,C,A>
+//
+//  Summary:
+//      This class template implements an ordered map as a B+tree.  Each node is a single
+//      allocation of roughly node_bytes bytes whose keys (and, in leaves, mapped values) are
+//      kept sorted in contiguous arrays, so a search reads a few cache lines per level and a
+//      range scan walks densely packed leaves.  The only pointers stored in the tree are the
+//      allocator's pointers between nodes (child links and the leaf chain), which makes the
+//      tree relocatable whenever the allocator's pointer type is, independent of the standard
+//      library in use.
+//
+//      Because keys and values live in separate arrays, dereferencing an iterator yields a
+//      pair of references, std::pair<K const&, V&>, rather than a reference to a stored pair.
+//      Leaves that become empty are unlinked and freed, but partially-filled nodes are not
+//      merged.  Iterators hold ordinary pointers, and are invalidated by insertion, erasure,
+//      and relocation of the heap.
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class C = std::less<K>, class A = std::allocator<std::pair<K const, V>>>
+class rhx_btree_map
+{
+  public:
+    using key_type          = K;
+    using mapped_type       = V;
+    using value_type        = std::pair<K const, V>;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using key_compare       = C;
+    using allocator_type    = A;
+    using reference         = std::pair<K const&, V&>;
+    using const_reference   = std::pair<K const&, V const&>;
+
+  private:
+    template<bool IsConst> class iterator_type;
+
+  public:
+    using iterator          = iterator_type<false>;
+    using const_iterator    = iterator_type<true>;
+
+  public:
+    ~rhx_btree_map();
+
+    rhx_btree_map();
+    rhx_btree_map(rhx_btree_map&& other) noexcept;
+    rhx_btree_map(rhx_btree_map const& other);
+    explicit rhx_btree_map(C const& comp, A const& alloc = A());
+
+    rhx_btree_map&  operator =(rhx_btree_map&& rhs) noexcept;
+    rhx_btree_map&  operator =(rhx_btree_map const& rhs);
+
+    iterator        begin() noexcept;
+    const_iterator  begin() const noexcept;
+    const_iterator  cbegin() const noexcept;
+    iterator        end() noexcept;
+    const_iterator  end() const noexcept;
+    const_iterator  cend() const noexcept;
+
+    bool            empty() const noexcept;
+    size_type       size() const noexcept;
+    size_type       height() const noexcept;
+
+    void            clear() noexcept;
+    void            swap(rhx_btree_map& other) noexcept;
+
+    std::pair<iterator, bool>   insert(value_type const& value);
+    std::pair<iterator, bool>   insert(value_type&& value);
+    template<class... Args>
+    std::pair<iterator, bool>   try_emplace(K const& key, Args&&... args);
+    template<class... Args>
+    std::pair<iterator, bool>   try_emplace(K&& key, Args&&... args);
+
+    size_type       erase(K const& key);
+    iterator        erase(const_iterator pos);
+
+    V&              operator [](K const& key);
+    V&              operator [](K&& key);
+    V&              at(K const& key);
+    V const&        at(K const& key) const;
+
+    iterator        find(K const& key);
+    const_iterator  find(K const& key) const;
+    size_type       count(K const& key) const;
+    bool            contains(K const& key) const;
+    iterator        lower_bound(K const& key);
+    const_iterator  lower_bound(K const& key) const;
+    iterator        upper_bound(K const& key);
+    const_iterator  upper_bound(K const& key) const;
+
+    key_compare     key_comp() const;
+    allocator_type  get_allocator() const;
+
+    template<class Vis>
+    void            trace(Vis& visitor);
+
+  private:
+    using alloc_traits  = std::allocator_traits<A>;
+    using key_storage   = typename std::aligned_storage<sizeof(K), alignof(K)>::type;
+    using value_storage = typename std::aligned_storage<sizeof(V), alignof(V)>::type;
+
+    //- Every pointer between nodes is a base_pointer, so a heap compactor traces each node as
+    //  a node_base, which tells from the node itself which kind it is.
+    //
+    struct node_base
+    {
+        uint32_t    m_count;
+        uint32_t    m_is_leaf;
+
+        template<class Vis>
+        void    trace(Vis& visitor);
+    };
+
+    using base_pointer  = typename alloc_traits::template rebind_traits<node_base>::pointer;
+
+    enum : size_type
+    {
+        node_bytes     = 512,
+        leaf_avail     = node_bytes - sizeof(node_base) - 2*sizeof(base_pointer),
+        leaf_fit       = leaf_avail / (sizeof(K) + sizeof(V)),
+        leaf_capacity  = (leaf_fit < 4) ? 4 : leaf_fit,
+        inner_avail    = node_bytes - sizeof(node_base) - sizeof(base_pointer),
+        inner_fit      = inner_avail / (sizeof(K) + sizeof(base_pointer)),
+        inner_capacity = (inner_fit < 4) ? 4 : inner_fit,
+        max_height     = 32
+    };
+
+    struct leaf_node : node_base
+    {
+        base_pointer    m_prev;
+        base_pointer    m_next;
+        key_storage     m_keys[leaf_capacity];
+        value_storage   m_values[leaf_capacity];
+
+        K*  keys() noexcept     { return reinterpret_cast<K*>(m_keys); }
+        V*  values() noexcept   { return reinterpret_cast<V*>(m_values); }
+    };
+
+    struct inner_node : node_base
+    {
+        base_pointer    m_children[inner_capacity + 1];
+        key_storage     m_keys[inner_capacity];
+
+        K*  keys() noexcept     { return reinterpret_cast<K*>(m_keys); }
+    };
+
+    using leaf_allocator  = typename alloc_traits::template rebind_alloc<leaf_node>;
+    using leaf_traits     = std::allocator_traits<leaf_allocator>;
+    using inner_allocator = typename alloc_traits::template rebind_alloc<inner_node>;
+    using inner_traits    = std::allocator_traits<inner_allocator>;
+
+    struct path_entry
+    {
+        inner_node*     mp_node;
+        size_type       m_index;    //- Index of the child that was descended into
+    };
+
+    base_pointer    m_root;
+    base_pointer    m_first;        //- Leftmost leaf
+    base_pointer    m_last;         //- Rightmost leaf
+    size_type       m_size;
+    size_type       m_height;       //- Number of levels; zero for an empty tree
+    key_compare     m_comp;
+    allocator_type  m_alloc;
+
+  private:
+    static  node_base*  raw(base_pointer const& p) noexcept;
+    static  leaf_node*  raw_leaf(base_pointer const& p) noexcept;
+    static  inner_node* raw_inner(base_pointer const& p) noexcept;
+
+    base_pointer    new_leaf(base_pointer const& hint);
+    base_pointer    new_inner(base_pointer const& hint);
+    void            free_leaf(base_pointer p) noexcept;
+    void            free_inner(base_pointer p) noexcept;
+    void            free_subtree(base_pointer p, size_type level) noexcept;
+
+    template<class T, class... Args>
+    void            construct(T* p, Args&&... args);
+    template<class T>
+    void            relocate(T* dst, T* src);
+
+    leaf_node*      descend(K const& key, path_entry* path) const;
+    base_pointer    node_at(path_entry const* path, size_type depth) const noexcept;
+    size_type       leaf_lower_bound(leaf_node* leaf, K const& key) const;
+    size_type       leaf_upper_bound(leaf_node* leaf, K const& key) const;
+
+    template<class KK, class... Args>
+    std::pair<iterator, bool>   try_emplace_impl(KK&& key, Args&&... args);
+    template<class KK, class... Args>
+    void            construct_element(leaf_node* leaf, size_type index, KK&& key,
+                                      Args&&... args);
+
+    void            insert_into_parent(path_entry* path, size_type level, K const& sep,
+                                       base_pointer right);
+    void            remove_from_parent(path_entry* path, size_type level);
+    iterator        erase_at(leaf_node* leaf, size_type index, path_entry* path);
+
+    iterator        make_iterator(leaf_node* leaf, size_type index) const noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_btree_map<K,V,C,A>::iterator_type<IsConst>
+//
+//  Summary:
+//      Bidirectional iterator over the leaf chain of a B+tree map.
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class C, class A>
+template<bool IsConst>
+class rhx_btree_map<K, V, C, A>::iterator_type
+{
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type        = typename rhx_btree_map::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = typename std::conditional<IsConst, std::pair<K const&, V const&>,
+                                                                 std::pair<K const&, V&>>::type;
+
+    struct pointer
+    {
+        reference   m_ref;
+        reference const*    operator ->() const noexcept    { return &m_ref; }
+    };
+
+  public:
+    iterator_type() noexcept = default;
+    template<bool B, typename std::enable_if<IsConst && !B, bool>::type = true>
+    iterator_type(iterator_type<B> const& other) noexcept;
+
+    reference       operator  *() const noexcept;
+    pointer         operator ->() const noexcept;
+    iterator_type&  operator ++() noexcept;
+    iterator_type   operator ++(int) noexcept;
+    iterator_type&  operator --() noexcept;
+    iterator_type   operator --(int) noexcept;
+
+    template<bool B>
+    bool    operator ==(iterator_type<B> const& rhs) const noexcept;
+    template<bool B>
+    bool    operator !=(iterator_type<B> const& rhs) const noexcept;
+
+  private:
+    friend class rhx_btree_map;
+    template<bool B> friend class iterator_type;
+
+    leaf_node*              mp_leaf;
+    size_type               m_index;
+    rhx_btree_map const*    mp_tree;
+
+  private:
+    iterator_type(leaf_node* leaf, size_type index, rhx_btree_map const* tree) noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_btree_map<K,V,C,A>::iterator_type<IsConst>
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class C, class A>
+template<bool IsConst> inline
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::iterator_type
+(leaf_node* leaf, size_type index, rhx_btree_map const* tree) noexcept
+:   mp_leaf{leaf}
+,   m_index{index}
+,   mp_tree{tree}
+{}
+
+template<class K, class V, class C, class A>
+template<bool IsConst>
+template<bool B, typename std::enable_if<IsConst && !B, bool>::type> inline
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::iterator_type
+(iterator_type<B> const& other) noexcept
+:   mp_leaf{other.mp_leaf}
+,   m_index{other.m_index}
+,   mp_tree{other.mp_tree}
+{}
+
+template<class K, class V, class C, class A>
+template<bool IsConst> inline
+typename rhx_btree_map<K, V, C, A>::template iterator_type<IsConst>::reference
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator *() const noexcept
+{
+    return reference(mp_leaf->keys()[m_index], mp_leaf->values()[m_index]);
+}
+
+template<class K, class V, class C, class A>
+template<bool IsConst> inline
+typename rhx_btree_map<K, V, C, A>::template iterator_type<IsConst>::pointer
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator ->() const noexcept
+{
+    return pointer{**this};
+}
+
+template<class K, class V, class C, class A>
+template<bool IsConst> inline
+typename rhx_btree_map<K, V, C, A>::template iterator_type<IsConst>&
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator ++() noexcept
+{
+    if (++m_index == mp_leaf->m_count)
+    {
+        mp_leaf = raw_leaf(mp_leaf->m_next);
+        m_index = 0;
+    }
+    return *this;
+}
+
+template<class K, class V, class C, class A>
+template<bool IsConst> inline
+typename rhx_btree_map<K, V, C, A>::template iterator_type<IsConst>
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator ++(int) noexcept
+{
+    iterator_type   tmp{*this};
+    ++(*this);
+    return tmp;
+}
+
+template<class K, class V, class C, class A>
+template<bool IsConst> inline
+typename rhx_btree_map<K, V, C, A>::template iterator_type<IsConst>&
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator --() noexcept
+{
+    if (mp_leaf == nullptr)
+    {
+        mp_leaf = raw_leaf(mp_tree->m_last);
+        m_index = mp_leaf->m_count;
+    }
+    else if (m_index == 0)
+    {
+        mp_leaf = raw_leaf(mp_leaf->m_prev);
+        m_index = mp_leaf->m_count;
+    }
+    --m_index;
+    return *this;
+}
+
+template<class K, class V, class C, class A>
+template<bool IsConst> inline
+typename rhx_btree_map<K, V, C, A>::template iterator_type<IsConst>
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator --(int) noexcept
+{
+    iterator_type   tmp{*this};
+    --(*this);
+    return tmp;
+}
+
+template<class K, class V, class C, class A>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator ==
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_leaf == rhs.mp_leaf  &&  m_index == rhs.m_index;
+}
+
+template<class K, class V, class C, class A>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_btree_map<K, V, C, A>::iterator_type<IsConst>::operator !=
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_leaf != rhs.mp_leaf  ||  m_index != rhs.m_index;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_btree_map<K,V,C,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class C, class A> inline
+rhx_btree_map<K, V, C, A>::~rhx_btree_map()
+{
+    clear();
+}
+
+template<class K, class V, class C, class A> inline
+rhx_btree_map<K, V, C, A>::rhx_btree_map()
+:   m_root(nullptr)
+,   m_first(nullptr)
+,   m_last(nullptr)
+,   m_size(0)
+,   m_height(0)
+,   m_comp()
+,   m_alloc()
+{}
+
+template<class K, class V, class C, class A> inline
+rhx_btree_map<K, V, C, A>::rhx_btree_map(rhx_btree_map&& other) noexcept
+:   m_root(other.m_root)
+,   m_first(other.m_first)
+,   m_last(other.m_last)
+,   m_size(other.m_size)
+,   m_height(other.m_height)
+,   m_comp(std::move(other.m_comp))
+,   m_alloc(std::move(other.m_alloc))
+{
+    other.m_root   = nullptr;
+    other.m_first  = nullptr;
+    other.m_last   = nullptr;
+    other.m_size   = 0;
+    other.m_height = 0;
+}
+
+//- Elements arrive in order, so every insertion appends to the rightmost leaf, which is split
+//  unevenly; the copy therefore ends up with full leaves.
+//
+template<class K, class V, class C, class A>
+rhx_btree_map<K, V, C, A>::rhx_btree_map(rhx_btree_map const& other)
+:   m_root(nullptr)
+,   m_first(nullptr)
+,   m_last(nullptr)
+,   m_size(0)
+,   m_height(0)
+,   m_comp(other.m_comp)
+,   m_alloc(alloc_traits::select_on_container_copy_construction(other.m_alloc))
+{
+    try
+    {
+        for (auto const& e : other)
+        {
+            try_emplace_impl(e.first, e.second);
+        }
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+}
+
+template<class K, class V, class C, class A> inline
+rhx_btree_map<K, V, C, A>::rhx_btree_map(C const& comp, A const& alloc)
+:   m_root(nullptr)
+,   m_first(nullptr)
+,   m_last(nullptr)
+,   m_size(0)
+,   m_height(0)
+,   m_comp(comp)
+,   m_alloc(alloc)
+{}
+
+template<class K, class V, class C, class A>
+rhx_btree_map<K, V, C, A>&
+rhx_btree_map<K, V, C, A>::operator =(rhx_btree_map&& rhs) noexcept
+{
+    if (&rhs != this)
+    {
+        clear();
+        swap(rhs);
+    }
+    return *this;
+}
+
+template<class K, class V, class C, class A>
+rhx_btree_map<K, V, C, A>&
+rhx_btree_map<K, V, C, A>::operator =(rhx_btree_map const& rhs)
+{
+    if (&rhs != this)
+    {
+        rhx_btree_map   tmp(rhs);
+        swap(tmp);
+    }
+    return *this;
+}
+
+//------
+//
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::begin() noexcept
+{
+    return make_iterator(raw_leaf(m_first), 0);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::const_iterator
+rhx_btree_map<K, V, C, A>::begin() const noexcept
+{
+    return make_iterator(raw_leaf(m_first), 0);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::const_iterator
+rhx_btree_map<K, V, C, A>::cbegin() const noexcept
+{
+    return begin();
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::end() noexcept
+{
+    return make_iterator(nullptr, 0);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::const_iterator
+rhx_btree_map<K, V, C, A>::end() const noexcept
+{
+    return make_iterator(nullptr, 0);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::const_iterator
+rhx_btree_map<K, V, C, A>::cend() const noexcept
+{
+    return end();
+}
+
+//------
+//
+template<class K, class V, class C, class A> inline
+bool
+rhx_btree_map<K, V, C, A>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::size_type
+rhx_btree_map<K, V, C, A>::size() const noexcept
+{
+    return m_size;
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::size_type
+rhx_btree_map<K, V, C, A>::height() const noexcept
+{
+    return m_height;
+}
+
+template<class K, class V, class C, class A>
+void
+rhx_btree_map<K, V, C, A>::clear() noexcept
+{
+    if (m_height != 0)
+    {
+        free_subtree(m_root, m_height);
+        m_root   = nullptr;
+        m_first  = nullptr;
+        m_last   = nullptr;
+        m_size   = 0;
+        m_height = 0;
+    }
+}
+
+template<class K, class V, class C, class A>
+void
+rhx_btree_map<K, V, C, A>::swap(rhx_btree_map& other) noexcept
+{
+    using std::swap;
+
+    swap(m_root, other.m_root);
+    swap(m_first, other.m_first);
+    swap(m_last, other.m_last);
+    swap(m_size, other.m_size);
+    swap(m_height, other.m_height);
+    swap(m_comp, other.m_comp);
+    swap(m_alloc, other.m_alloc);
+}
+
+//------
+//
+template<class K, class V, class C, class A> inline
+std::pair<typename rhx_btree_map<K, V, C, A>::iterator, bool>
+rhx_btree_map<K, V, C, A>::insert(value_type const& value)
+{
+    return try_emplace_impl(value.first, value.second);
+}
+
+template<class K, class V, class C, class A> inline
+std::pair<typename rhx_btree_map<K, V, C, A>::iterator, bool>
+rhx_btree_map<K, V, C, A>::insert(value_type&& value)
+{
+    return try_emplace_impl(std::move(const_cast<K&>(value.first)), std::move(value.second));
+}
+
+template<class K, class V, class C, class A>
+template<class... Args> inline
+std::pair<typename rhx_btree_map<K, V, C, A>::iterator, bool>
+rhx_btree_map<K, V, C, A>::try_emplace(K const& key, Args&&... args)
+{
+    return try_emplace_impl(key, std::forward<Args>(args)...);
+}
+
+template<class K, class V, class C, class A>
+template<class... Args> inline
+std::pair<typename rhx_btree_map<K, V, C, A>::iterator, bool>
+rhx_btree_map<K, V, C, A>::try_emplace(K&& key, Args&&... args)
+{
+    return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+}
+
+//------
+//
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::size_type
+rhx_btree_map<K, V, C, A>::erase(K const& key)
+{
+    if (m_height == 0)
+    {
+        return 0;
+    }
+
+    path_entry  path[max_height];
+    leaf_node*  leaf  = descend(key, path);
+    size_type   index = leaf_lower_bound(leaf, key);
+
+    if (index == leaf->m_count  ||  m_comp(key, leaf->keys()[index]))
+    {
+        return 0;
+    }
+
+    erase_at(leaf, index, path);
+    return 1;
+}
+
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::erase(const_iterator pos)
+{
+    path_entry  path[max_height];
+    leaf_node*  leaf = descend(pos.mp_leaf->keys()[pos.m_index], path);
+
+    return erase_at(leaf, pos.m_index, path);
+}
+
+//------
+//
+template<class K, class V, class C, class A> inline
+V&
+rhx_btree_map<K, V, C, A>::operator [](K const& key)
+{
+    return try_emplace_impl(key).first->second;
+}
+
+template<class K, class V, class C, class A> inline
+V&
+rhx_btree_map<K, V, C, A>::operator [](K&& key)
+{
+    return try_emplace_impl(std::move(key)).first->second;
+}
+
+template<class K, class V, class C, class A>
+V&
+rhx_btree_map<K, V, C, A>::at(K const& key)
+{
+    iterator    it = find(key);
+
+    if (it == end())
+    {
+        throw std::out_of_range("rhx_btree_map::at");
+    }
+    return it->second;
+}
+
+template<class K, class V, class C, class A>
+V const&
+rhx_btree_map<K, V, C, A>::at(K const& key) const
+{
+    const_iterator  it = find(key);
+
+    if (it == end())
+    {
+        throw std::out_of_range("rhx_btree_map::at");
+    }
+    return it->second;
+}
+
+//------
+//
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::find(K const& key)
+{
+    if (m_height != 0)
+    {
+        leaf_node*  leaf  = descend(key, nullptr);
+        size_type   index = leaf_lower_bound(leaf, key);
+
+        if (index != leaf->m_count  &&  !m_comp(key, leaf->keys()[index]))
+        {
+            return make_iterator(leaf, index);
+        }
+    }
+    return end();
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::const_iterator
+rhx_btree_map<K, V, C, A>::find(K const& key) const
+{
+    return const_cast<rhx_btree_map*>(this)->find(key);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::size_type
+rhx_btree_map<K, V, C, A>::count(K const& key) const
+{
+    return (find(key) == end()) ? 0 : 1;
+}
+
+template<class K, class V, class C, class A> inline
+bool
+rhx_btree_map<K, V, C, A>::contains(K const& key) const
+{
+    return find(key) != end();
+}
+
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::lower_bound(K const& key)
+{
+    if (m_height == 0)
+    {
+        return end();
+    }
+
+    leaf_node*  leaf  = descend(key, nullptr);
+    size_type   index = leaf_lower_bound(leaf, key);
+
+    return (index == leaf->m_count) ? make_iterator(raw_leaf(leaf->m_next), 0)
+                                    : make_iterator(leaf, index);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::const_iterator
+rhx_btree_map<K, V, C, A>::lower_bound(K const& key) const
+{
+    return const_cast<rhx_btree_map*>(this)->lower_bound(key);
+}
+
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::upper_bound(K const& key)
+{
+    if (m_height == 0)
+    {
+        return end();
+    }
+
+    leaf_node*  leaf  = descend(key, nullptr);
+    size_type   index = leaf_upper_bound(leaf, key);
+
+    return (index == leaf->m_count) ? make_iterator(raw_leaf(leaf->m_next), 0)
+                                    : make_iterator(leaf, index);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::const_iterator
+rhx_btree_map<K, V, C, A>::upper_bound(K const& key) const
+{
+    return const_cast<rhx_btree_map*>(this)->upper_bound(key);
+}
+
+//------
+//
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::key_compare
+rhx_btree_map<K, V, C, A>::key_comp() const
+{
+    return m_comp;
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::allocator_type
+rhx_btree_map<K, V, C, A>::get_allocator() const
+{
+    return m_alloc;
+}
+
+//- Reports the root and the ends of the leaf chain to a heap compactor's visitor; the nodes
+//  report the rest.
+//
+template<class K, class V, class C, class A>
+template<class Vis> inline
+void
+rhx_btree_map<K, V, C, A>::trace(Vis& visitor)
+{
+    visitor(m_root);
+    visitor(m_first);
+    visitor(m_last);
+}
+
+//- Reports a leaf's neighbours, keys, and values, or an inner node's children and keys.
+//
+template<class K, class V, class C, class A>
+template<class Vis>
+void
+rhx_btree_map<K, V, C, A>::node_base::trace(Vis& visitor)
+{
+    if (m_is_leaf)
+    {
+        leaf_node*  pn = static_cast<leaf_node*>(this);
+
+        visitor(pn->m_prev);
+        visitor(pn->m_next);
+
+        for (size_type i = 0;  i < m_count;  ++i)
+        {
+            rhx_trace_traits<K>::trace(pn->keys()[i], visitor);
+            rhx_trace_traits<V>::trace(pn->values()[i], visitor);
+        }
+    }
+    else
+    {
+        inner_node* pn = static_cast<inner_node*>(this);
+
+        for (size_type i = 0;  i <= m_count;  ++i)
+        {
+            visitor(pn->m_children[i]);
+        }
+        for (size_type i = 0;  i < m_count;  ++i)
+        {
+            rhx_trace_traits<K>::trace(pn->keys()[i], visitor);
+        }
+    }
+}
+
+//------
+//
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::node_base*
+rhx_btree_map<K, V, C, A>::raw(base_pointer const& p) noexcept
+{
+    return p ? std::addressof(*p) : nullptr;
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::leaf_node*
+rhx_btree_map<K, V, C, A>::raw_leaf(base_pointer const& p) noexcept
+{
+    return static_cast<leaf_node*>(raw(p));
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::inner_node*
+rhx_btree_map<K, V, C, A>::raw_inner(base_pointer const& p) noexcept
+{
+    return static_cast<inner_node*>(raw(p));
+}
+
+//- New nodes are allocated with a neighboring node as the placement hint, so that an allocator
+//  that honors hints can keep related nodes close together.
+//
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::base_pointer
+rhx_btree_map<K, V, C, A>::new_leaf(base_pointer const& hint)
+{
+    leaf_allocator  la(m_alloc);
+    auto            pl = leaf_traits::allocate(la, 1, hint);
+    leaf_node*      pn = std::addressof(*pl);
+
+    pn->m_count   = 0;
+    pn->m_is_leaf = 1;
+    ::new (static_cast<void*>(&pn->m_prev)) base_pointer(nullptr);
+    ::new (static_cast<void*>(&pn->m_next)) base_pointer(nullptr);
+
+    return static_cast<base_pointer>(pl);
+}
+
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::base_pointer
+rhx_btree_map<K, V, C, A>::new_inner(base_pointer const& hint)
+{
+    inner_allocator ia(m_alloc);
+    auto            pi = inner_traits::allocate(ia, 1, hint);
+    inner_node*     pn = std::addressof(*pi);
+
+    pn->m_count   = 0;
+    pn->m_is_leaf = 0;
+
+    for (size_type i = 0;  i <= inner_capacity;  ++i)
+    {
+        ::new (static_cast<void*>(&pn->m_children[i])) base_pointer(nullptr);
+    }
+
+    return static_cast<base_pointer>(pi);
+}
+
+template<class K, class V, class C, class A>
+void
+rhx_btree_map<K, V, C, A>::free_leaf(base_pointer p) noexcept
+{
+    leaf_allocator  la(m_alloc);
+    leaf_node*      pn = raw_leaf(p);
+
+    for (size_type i = 0;  i < pn->m_count;  ++i)
+    {
+        alloc_traits::destroy(m_alloc, pn->keys() + i);
+        alloc_traits::destroy(m_alloc, pn->values() + i);
+    }
+
+    using leaf_pointer = typename leaf_traits::pointer;
+    leaf_traits::deallocate(la, static_cast<leaf_pointer>(p), 1);
+}
+
+template<class K, class V, class C, class A>
+void
+rhx_btree_map<K, V, C, A>::free_inner(base_pointer p) noexcept
+{
+    inner_allocator ia(m_alloc);
+    inner_node*     pn = raw_inner(p);
+
+    for (size_type i = 0;  i < pn->m_count;  ++i)
+    {
+        alloc_traits::destroy(m_alloc, pn->keys() + i);
+    }
+
+    using inner_pointer = typename inner_traits::pointer;
+    inner_traits::deallocate(ia, static_cast<inner_pointer>(p), 1);
+}
+
+template<class K, class V, class C, class A>
+void
+rhx_btree_map<K, V, C, A>::free_subtree(base_pointer p, size_type level) noexcept
+{
+    if (level == 1)
+    {
+        free_leaf(p);
+    }
+    else
+    {
+        inner_node*     pn = raw_inner(p);
+
+        for (size_type i = 0;  i <= pn->m_count;  ++i)
+        {
+            free_subtree(pn->m_children[i], level - 1);
+        }
+        free_inner(p);
+    }
+}
+
+template<class K, class V, class C, class A>
+template<class T, class... Args> inline
+void
+rhx_btree_map<K, V, C, A>::construct(T* p, Args&&... args)
+{
+    alloc_traits::construct(m_alloc, p, std::forward<Args>(args)...);
+}
+
+//- Moves an element into uninitialized storage and destroys the source.
+//
+template<class K, class V, class C, class A>
+template<class T> inline
+void
+rhx_btree_map<K, V, C, A>::relocate(T* dst, T* src)
+{
+    alloc_traits::construct(m_alloc, dst, std::move(*src));
+    alloc_traits::destroy(m_alloc, src);
+}
+
+//- Walks from the root to the leaf that would contain the key.  When a path is supplied, the
+//  inner nodes visited and the child indices taken are recorded in it, root first.
+//
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::leaf_node*
+rhx_btree_map<K, V, C, A>::descend(K const& key, path_entry* path) const
+{
+    base_pointer    p = m_root;
+
+    for (size_type level = m_height;  level > 1;  --level)
+    {
+        inner_node*     pn    = raw_inner(p);
+        K const*        pkeys = pn->keys();
+        size_type       index = std::upper_bound(pkeys, pkeys + pn->m_count, key, m_comp) - pkeys;
+
+        if (path != nullptr)
+        {
+            path->mp_node = pn;
+            path->m_index = index;
+            ++path;
+        }
+        p = pn->m_children[index];
+    }
+
+    return raw_leaf(p);
+}
+
+//- Returns the pointer to the node reached after taking the first depth steps of a path.
+//
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::base_pointer
+rhx_btree_map<K, V, C, A>::node_at(path_entry const* path, size_type depth) const noexcept
+{
+    return (depth == 0) ? m_root : path[depth - 1].mp_node->m_children[path[depth - 1].m_index];
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::size_type
+rhx_btree_map<K, V, C, A>::leaf_lower_bound(leaf_node* leaf, K const& key) const
+{
+    K const*    pkeys = leaf->keys();
+    return std::lower_bound(pkeys, pkeys + leaf->m_count, key, m_comp) - pkeys;
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::size_type
+rhx_btree_map<K, V, C, A>::leaf_upper_bound(leaf_node* leaf, K const& key) const
+{
+    K const*    pkeys = leaf->keys();
+    return std::upper_bound(pkeys, pkeys + leaf->m_count, key, m_comp) - pkeys;
+}
+
+template<class K, class V, class C, class A>
+template<class KK, class... Args>
+std::pair<typename rhx_btree_map<K, V, C, A>::iterator, bool>
+rhx_btree_map<K, V, C, A>::try_emplace_impl(KK&& key, Args&&... args)
+{
+    if (m_height == 0)
+    {
+        m_root   = new_leaf(nullptr);
+        m_first  = m_root;
+        m_last   = m_root;
+        m_height = 1;
+    }
+
+    path_entry  path[max_height];
+    leaf_node*  leaf  = descend(key, path);
+    size_type   index = leaf_lower_bound(leaf, key);
+
+    if (index != leaf->m_count  &&  !m_comp(key, leaf->keys()[index]))
+    {
+        return std::make_pair(make_iterator(leaf, index), false);
+    }
+
+    //- A full leaf is split.  Appending past the end of the rightmost leaf starts a new, empty
+    //  leaf instead of moving half the elements, so ascending insertions fill leaves completely.
+    //
+    if (leaf->m_count == leaf_capacity)
+    {
+        base_pointer    self  = node_at(path, m_height - 1);
+        base_pointer    right = new_leaf(self);
+        leaf_node*      pr    = raw_leaf(right);
+        bool            tail  = (index == leaf_capacity  &&  !leaf->m_next);
+        size_type       split = tail ? size_type(leaf_capacity) : size_type(leaf_capacity / 2);
+
+        //- The new element is the only one in a new tail leaf, and it is constructed before the
+        //  leaf is linked in, so that a failure to construct it leaves the tree as it was.
+        //
+        if (tail)
+        {
+            try
+            {
+                construct_element(pr, 0, std::forward<KK>(key), std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                free_leaf(right);
+                throw;
+            }
+            pr->m_count = 1;
+        }
+        else
+        {
+            for (size_type i = split;  i < leaf_capacity;  ++i)
+            {
+                relocate(pr->keys() + (i - split), leaf->keys() + i);
+                relocate(pr->values() + (i - split), leaf->values() + i);
+            }
+            pr->m_count   = static_cast<uint32_t>(leaf_capacity - split);
+            leaf->m_count = static_cast<uint32_t>(split);
+        }
+
+        pr->m_prev = self;
+        pr->m_next = leaf->m_next;
+        if (leaf->m_next)
+        {
+            raw_leaf(leaf->m_next)->m_prev = right;
+        }
+        else
+        {
+            m_last = right;
+        }
+        leaf->m_next = right;
+
+        //- The separator is the smallest key now in the new leaf, which is never empty.
+        //
+        insert_into_parent(path, m_height - 1, pr->keys()[0], right);
+
+        if (tail)
+        {
+            ++m_size;
+            return std::make_pair(make_iterator(pr, 0), true);
+        }
+
+        //- A key that falls between the halves goes at the end of the left leaf, since it sorts
+        //  below the separator.
+        //
+        if (index > split)
+        {
+            leaf   = pr;
+            index -= split;
+        }
+    }
+
+    //- Open a gap at index, then construct the new element in it.
+    //
+    for (size_type i = leaf->m_count;  i > index;  --i)
+    {
+        relocate(leaf->keys() + i, leaf->keys() + (i - 1));
+        relocate(leaf->values() + i, leaf->values() + (i - 1));
+    }
+
+    try
+    {
+        construct_element(leaf, index, std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        for (size_type i = index;  i < leaf->m_count;  ++i)
+        {
+            relocate(leaf->keys() + i, leaf->keys() + (i + 1));
+            relocate(leaf->values() + i, leaf->values() + (i + 1));
+        }
+        throw;
+    }
+
+    leaf->m_count += 1;
+    ++m_size;
+
+    return std::make_pair(make_iterator(leaf, index), true);
+}
+
+//- Constructs the key and value of an element in a free slot of a leaf, leaving the slot free
+//  if either constructor throws.
+//
+template<class K, class V, class C, class A>
+template<class KK, class... Args>
+void
+rhx_btree_map<K, V, C, A>::construct_element
+(leaf_node* leaf, size_type index, KK&& key, Args&&... args)
+{
+    construct(leaf->keys() + index, std::forward<KK>(key));
+    try
+    {
+        construct(leaf->values() + index, std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        alloc_traits::destroy(m_alloc, leaf->keys() + index);
+        throw;
+    }
+}
+
+//- Inserts separator key sep and its right-hand child into the inner node at path[level - 1],
+//  splitting inner nodes as necessary.  A level of zero means that a new root is needed.
+//
+template<class K, class V, class C, class A>
+void
+rhx_btree_map<K, V, C, A>::insert_into_parent
+(path_entry* path, size_type level, K const& sep, base_pointer right)
+{
+    if (level == 0)
+    {
+        base_pointer    root = new_inner(m_root);
+        inner_node*     pn   = raw_inner(root);
+
+        construct(pn->keys(), sep);
+        pn->m_children[0] = m_root;
+        pn->m_children[1] = right;
+        pn->m_count       = 1;
+        m_root            = root;
+        m_height         += 1;
+        return;
+    }
+
+    inner_node*     pn    = path[level - 1].mp_node;
+    size_type       index = path[level - 1].m_index;
+
+    if (pn->m_count < inner_capacity)
+    {
+        for (size_type i = pn->m_count;  i > index;  --i)
+        {
+            relocate(pn->keys() + i, pn->keys() + (i - 1));
+            pn->m_children[i + 1] = pn->m_children[i];
+        }
+        construct(pn->keys() + index, sep);
+        pn->m_children[index + 1] = right;
+        pn->m_count += 1;
+        return;
+    }
+
+    //- The node is full: keys [0, mid) stay, key mid moves up, and keys (mid, capacity) move
+    //  to a new sibling along with their children.  The new entry then goes into whichever half
+    //  held the child that was split.
+    //
+    base_pointer    sib  = new_inner(node_at(path, level - 1));
+    inner_node*     ps   = raw_inner(sib);
+    size_type const mid  = inner_capacity / 2;
+
+    for (size_type i = mid + 1;  i < inner_capacity;  ++i)
+    {
+        relocate(ps->keys() + (i - mid - 1), pn->keys() + i);
+    }
+    for (size_type i = mid + 1;  i <= inner_capacity;  ++i)
+    {
+        ps->m_children[i - mid - 1] = pn->m_children[i];
+        pn->m_children[i]           = nullptr;
+    }
+    ps->m_count = static_cast<uint32_t>(inner_capacity - mid - 1);
+    pn->m_count = static_cast<uint32_t>(mid);
+
+    key_storage     up_buf;
+    K*              up = reinterpret_cast<K*>(&up_buf);
+
+    relocate(up, pn->keys() + mid);
+
+    path_entry      target = (index <= mid) ? path_entry{pn, index}
+                                            : path_entry{ps, index - mid - 1};
+    path_entry      saved  = path[level - 1];
+
+    path[level - 1] = target;
+    insert_into_parent(path, level, sep, right);
+    path[level - 1] = saved;
+
+    try
+    {
+        insert_into_parent(path, level - 1, *up, sib);
+    }
+    catch (...)
+    {
+        alloc_traits::destroy(m_alloc, up);
+        throw;
+    }
+    alloc_traits::destroy(m_alloc, up);
+}
+
+//- Removes the child at path[level - 1] from its parent.  If that leaves the parent without
+//  children, the parent is freed and removed from its own parent in turn.
+//
+template<class K, class V, class C, class A>
+void
+rhx_btree_map<K, V, C, A>::remove_from_parent(path_entry* path, size_type level)
+{
+    inner_node*     pn    = path[level - 1].mp_node;
+    size_type       index = path[level - 1].m_index;
+
+    if (pn->m_count == 0)
+    {
+        base_pointer    self = node_at(path, level - 1);
+
+        free_inner(self);
+
+        if (level == 1)
+        {
+            m_root   = nullptr;
+            m_height = 0;
+        }
+        else
+        {
+            remove_from_parent(path, level - 1);
+        }
+        return;
+    }
+
+    size_type   kidx = (index == 0) ? 0 : index - 1;
+
+    alloc_traits::destroy(m_alloc, pn->keys() + kidx);
+
+    for (size_type i = kidx;  i + 1 < pn->m_count;  ++i)
+    {
+        relocate(pn->keys() + i, pn->keys() + (i + 1));
+    }
+    for (size_type i = index;  i < pn->m_count;  ++i)
+    {
+        pn->m_children[i] = pn->m_children[i + 1];
+    }
+    pn->m_children[pn->m_count] = nullptr;
+    pn->m_count -= 1;
+
+    //- Collapse a root that has been left with a single child.
+    //
+    while (m_height > 1  &&  raw(m_root)->m_count == 0)
+    {
+        base_pointer    old_root = m_root;
+
+        m_root = raw_inner(old_root)->m_children[0];
+        free_inner(old_root);
+        m_height -= 1;
+    }
+}
+
+template<class K, class V, class C, class A>
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::erase_at(leaf_node* leaf, size_type index, path_entry* path)
+{
+    alloc_traits::destroy(m_alloc, leaf->keys() + index);
+    alloc_traits::destroy(m_alloc, leaf->values() + index);
+
+    for (size_type i = index;  i + 1 < leaf->m_count;  ++i)
+    {
+        relocate(leaf->keys() + i, leaf->keys() + (i + 1));
+        relocate(leaf->values() + i, leaf->values() + (i + 1));
+    }
+    leaf->m_count -= 1;
+    --m_size;
+
+    if (leaf->m_count != 0)
+    {
+        return (index < leaf->m_count) ? make_iterator(leaf, index)
+                                        : make_iterator(raw_leaf(leaf->m_next), 0);
+    }
+
+    //- The leaf is empty; unlink it from the leaf chain and from its parent.
+    //
+    base_pointer    self = node_at(path, m_height - 1);
+    base_pointer    next = leaf->m_next;
+
+    if (leaf->m_prev)
+    {
+        raw_leaf(leaf->m_prev)->m_next = leaf->m_next;
+    }
+    else
+    {
+        m_first = leaf->m_next;
+    }
+    if (leaf->m_next)
+    {
+        raw_leaf(leaf->m_next)->m_prev = leaf->m_prev;
+    }
+    else
+    {
+        m_last = leaf->m_prev;
+    }
+
+    free_leaf(self);
+
+    if (m_height == 1)
+    {
+        m_root   = nullptr;
+        m_height = 0;
+    }
+    else
+    {
+        remove_from_parent(path, m_height - 1);
+    }
+
+    return make_iterator(raw_leaf(next), 0);
+}
+
+template<class K, class V, class C, class A> inline
+typename rhx_btree_map<K, V, C, A>::iterator
+rhx_btree_map<K, V, C, A>::make_iterator(leaf_node* leaf, size_type index) const noexcept
+{
+    return iterator(leaf, index, this);
+}
+
+template<class K, class V, class C, class A> inline
+void
+swap(rhx_btree_map<K, V, C, A>& lhs, rhx_btree_map<K, V, C, A>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+#endif  //- RHX_BTREE_MAP_H_DEFINED
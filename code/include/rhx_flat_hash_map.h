@@ -0,0 +1,1154 @@
+//==================================================================================================
+//  File:
+//      rhx_flat_hash_map.h
+//
+//  Summary:
+//      Defines the rhx_flat_hash_map<K,V,H,E,A> class template, an open-addressing hash map
+//      whose elements are stored contiguously in a single allocation.
+//==================================================================================================
+//
+#ifndef RHX_FLAT_HASH_MAP_H_DEFINED
+#define RHX_FLAT_HASH_MAP_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "rhx_trace_traits.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RHX_FLAT_HASH_MAP_SSE2
+    #include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Class:
+//      rhx_flat_hash_group
+//
+//  Summary:
+//      This class provides the group-matching operations used to probe the control bytes of a
+//      flat hash table sixteen at a time.  Each control byte is either empty, deleted, or holds
+//      the low seven bits of a full slot's hash value.  Every operation returns a bit mask with
+//      one bit per control byte in the group.
+//--------------------------------------------------------------------------------------------------
+//
+struct rhx_flat_hash_group
+{
+    enum : int8_t
+    {
+        ctrl_empty   = -128,    //- 0b10000000
+        ctrl_deleted = -2       //- 0b11111110
+    };
+
+    enum : std::size_t
+    {
+        width = 16
+    };
+
+    static  uint32_t    match(int8_t const* pctrl, int8_t h2) noexcept;
+    static  uint32_t    match_empty(int8_t const* pctrl) noexcept;
+    static  uint32_t    match_empty_or_deleted(int8_t const* pctrl) noexcept;
+    static  uint32_t    lowest_bit(uint32_t mask) noexcept;
+};
+
+#ifdef RHX_FLAT_HASH_MAP_SSE2
+
+inline uint32_t
+rhx_flat_hash_group::match(int8_t const* pctrl, int8_t h2) noexcept
+{
+    __m128i     ctrl = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+}
+
+inline uint32_t
+rhx_flat_hash_group::match_empty(int8_t const* pctrl) noexcept
+{
+    return match(pctrl, ctrl_empty);
+}
+
+inline uint32_t
+rhx_flat_hash_group::match_empty_or_deleted(int8_t const* pctrl) noexcept
+{
+    __m128i     ctrl = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl)));
+}
+
+#else
+
+inline uint32_t
+rhx_flat_hash_group::match(int8_t const* pctrl, int8_t h2) noexcept
+{
+    uint32_t    mask = 0;
+
+    for (uint32_t i = 0;  i < width;  ++i)
+    {
+        mask |= static_cast<uint32_t>(pctrl[i] == h2) << i;
+    }
+    return mask;
+}
+
+inline uint32_t
+rhx_flat_hash_group::match_empty(int8_t const* pctrl) noexcept
+{
+    return match(pctrl, ctrl_empty);
+}
+
+inline uint32_t
+rhx_flat_hash_group::match_empty_or_deleted(int8_t const* pctrl) noexcept
+{
+    uint32_t    mask = 0;
+
+    for (uint32_t i = 0;  i < width;  ++i)
+    {
+        mask |= static_cast<uint32_t>(pctrl[i] < -1) << i;
+    }
+    return mask;
+}
+
+#endif
+
+inline uint32_t
+rhx_flat_hash_group::lowest_bit(uint32_t mask) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long   index;
+    _BitScanForward(&index, mask);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_flat_hash_map<K,V,H,E,A>
+//
+//  Summary:
+//      This class template implements an unordered map using open addressing over groups of
+//      sixteen slots.  The elements and their control bytes share one block obtained from the
+//      allocator, and that block's (possibly synthetic) pointer is the only pointer stored in
+//      the map.  Lookups hash once, compare control bytes a group at a time, and touch at most
+//      a handful of contiguous slots, so no per-element allocation or pointer chasing occurs.
+//
+//      Iterators hold ordinary pointers into the slot array; like the iterators of a vector,
+//      they are invalidated by rehashing and by relocation of the heap.
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class H = std::hash<K>, class E = std::equal_to<K>,
+         class A = std::allocator<std::pair<K const, V>>>
+class rhx_flat_hash_map
+{
+  public:
+    using key_type          = K;
+    using mapped_type       = V;
+    using value_type        = std::pair<K const, V>;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using hasher            = H;
+    using key_equal         = E;
+    using allocator_type    = A;
+    using reference         = value_type&;
+    using const_reference   = value_type const&;
+
+  private:
+    template<bool IsConst> class iterator_type;
+
+  public:
+    using iterator          = iterator_type<false>;
+    using const_iterator    = iterator_type<true>;
+
+  public:
+    ~rhx_flat_hash_map();
+
+    rhx_flat_hash_map();
+    rhx_flat_hash_map(rhx_flat_hash_map&& other) noexcept;
+    rhx_flat_hash_map(rhx_flat_hash_map const& other);
+    explicit rhx_flat_hash_map(size_type n, H const& h = H(), E const& e = E(), A const& a = A());
+
+    rhx_flat_hash_map&  operator =(rhx_flat_hash_map&& rhs) noexcept;
+    rhx_flat_hash_map&  operator =(rhx_flat_hash_map const& rhs);
+
+    iterator        begin() noexcept;
+    const_iterator  begin() const noexcept;
+    const_iterator  cbegin() const noexcept;
+    iterator        end() noexcept;
+    const_iterator  end() const noexcept;
+    const_iterator  cend() const noexcept;
+
+    bool            empty() const noexcept;
+    size_type       size() const noexcept;
+    size_type       capacity() const noexcept;
+    float           load_factor() const noexcept;
+
+    void            clear() noexcept;
+    void            reserve(size_type n);
+    void            rehash(size_type n);
+    void            swap(rhx_flat_hash_map& other) noexcept;
+
+    std::pair<iterator, bool>   insert(value_type const& value);
+    std::pair<iterator, bool>   insert(value_type&& value);
+    template<class... Args>
+    std::pair<iterator, bool>   emplace(Args&&... args);
+    template<class... Args>
+    std::pair<iterator, bool>   try_emplace(K const& key, Args&&... args);
+    template<class... Args>
+    std::pair<iterator, bool>   try_emplace(K&& key, Args&&... args);
+
+    size_type       erase(K const& key);
+    iterator        erase(const_iterator pos);
+
+    V&              operator [](K const& key);
+    V&              operator [](K&& key);
+    V&              at(K const& key);
+    V const&        at(K const& key) const;
+
+    iterator        find(K const& key);
+    const_iterator  find(K const& key) const;
+    size_type       count(K const& key) const;
+    bool            contains(K const& key) const;
+
+    hasher          hash_function() const;
+    key_equal       key_eq() const;
+    allocator_type  get_allocator() const;
+
+    template<class Vis>
+    void            trace(Vis& visitor);
+
+  private:
+    using group          = rhx_flat_hash_group;
+    using slot_storage   = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+    using alloc_traits   = std::allocator_traits<A>;
+    using slot_allocator = typename alloc_traits::template rebind_alloc<slot_storage>;
+    using slot_traits    = std::allocator_traits<slot_allocator>;
+    using slot_pointer   = typename slot_traits::pointer;
+
+    enum : size_type
+    {
+        npos = ~size_type(0)
+    };
+
+    slot_pointer    m_slots;            //- Slot array, followed by the control bytes
+    size_type       m_capacity;         //- Zero, or a power of two no smaller than group::width
+    size_type       m_size;
+    size_type       m_growth_left;      //- Insertions into empty slots allowed before growing
+    hasher          m_hash;
+    key_equal       m_equal;
+    allocator_type  m_alloc;
+
+  private:
+    static  size_type   block_units(size_type capacity) noexcept;
+    static  size_type   capacity_for(size_type n) noexcept;
+    static  size_type   max_load(size_type capacity) noexcept;
+
+    value_type*     slots() const noexcept;
+    int8_t*         ctrl() const noexcept;
+    uint64_t        hash_of(K const& key) const;
+
+    size_type       find_index(K const& key, uint64_t hash) const;
+    static  size_type   find_insert_index(int8_t const* pctrl, size_type capacity, uint64_t hash) noexcept;
+    void            set_ctrl(size_type index, int8_t h2) noexcept;
+    void            erase_index(size_type index) noexcept;
+    void            prepare_insert();
+    void            resize(size_type new_capacity);
+    void            destroy_all() noexcept;
+    void            release() noexcept;
+
+    template<class KK, class... Args>
+    std::pair<iterator, bool>   try_emplace_impl(KK&& key, Args&&... args);
+
+    iterator        make_iterator(size_type index) noexcept;
+    const_iterator  make_iterator(size_type index) const noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_flat_hash_map<K,V,H,E,A>::iterator_type<IsConst>
+//
+//  Summary:
+//      Forward iterator over the full slots of a flat hash map.
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class H, class E, class A>
+template<bool IsConst>
+class rhx_flat_hash_map<K, V, H, E, A>::iterator_type
+{
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = typename rhx_flat_hash_map::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = typename std::conditional<IsConst, value_type const&, value_type&>::type;
+    using pointer           = typename std::conditional<IsConst, value_type const*, value_type*>::type;
+
+  public:
+    iterator_type() noexcept = default;
+    template<bool C, typename std::enable_if<IsConst && !C, bool>::type = true>
+    iterator_type(iterator_type<C> const& other) noexcept;
+
+    reference       operator  *() const noexcept;
+    pointer         operator ->() const noexcept;
+    iterator_type&  operator ++() noexcept;
+    iterator_type   operator ++(int) noexcept;
+
+    template<bool C>
+    bool    operator ==(iterator_type<C> const& rhs) const noexcept;
+    template<bool C>
+    bool    operator !=(iterator_type<C> const& rhs) const noexcept;
+
+  private:
+    friend class rhx_flat_hash_map;
+    template<bool C> friend class iterator_type;
+
+    int8_t const*   mp_ctrl;
+    int8_t const*   mp_ctrl_end;
+    value_type*     mp_slot;
+
+  private:
+    iterator_type(int8_t const* pctrl, int8_t const* pend, value_type* pslot) noexcept;
+    void    skip_empty() noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_flat_hash_map<K,V,H,E,A>::iterator_type<IsConst>
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class H, class E, class A>
+template<bool IsConst> inline
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::iterator_type
+(int8_t const* pctrl, int8_t const* pend, value_type* pslot) noexcept
+:   mp_ctrl{pctrl}
+,   mp_ctrl_end{pend}
+,   mp_slot{pslot}
+{}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst>
+template<bool C, typename std::enable_if<IsConst && !C, bool>::type> inline
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::iterator_type
+(iterator_type<C> const& other) noexcept
+:   mp_ctrl{other.mp_ctrl}
+,   mp_ctrl_end{other.mp_ctrl_end}
+,   mp_slot{other.mp_slot}
+{}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::template iterator_type<IsConst>::reference
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::operator *() const noexcept
+{
+    return *mp_slot;
+}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::template iterator_type<IsConst>::pointer
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::operator ->() const noexcept
+{
+    return mp_slot;
+}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::template iterator_type<IsConst>&
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::operator ++() noexcept
+{
+    ++mp_ctrl;
+    ++mp_slot;
+    skip_empty();
+    return *this;
+}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::template iterator_type<IsConst>
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::operator ++(int) noexcept
+{
+    iterator_type   tmp{*this};
+    ++(*this);
+    return tmp;
+}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst>
+template<bool C> inline
+bool
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::operator ==
+(iterator_type<C> const& rhs) const noexcept
+{
+    return mp_ctrl == rhs.mp_ctrl;
+}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst>
+template<bool C> inline
+bool
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::operator !=
+(iterator_type<C> const& rhs) const noexcept
+{
+    return mp_ctrl != rhs.mp_ctrl;
+}
+
+template<class K, class V, class H, class E, class A>
+template<bool IsConst> inline
+void
+rhx_flat_hash_map<K, V, H, E, A>::iterator_type<IsConst>::skip_empty() noexcept
+{
+    while (mp_ctrl != mp_ctrl_end  &&  *mp_ctrl < 0)
+    {
+        ++mp_ctrl;
+        ++mp_slot;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_flat_hash_map<K,V,H,E,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class K, class V, class H, class E, class A> inline
+rhx_flat_hash_map<K, V, H, E, A>::~rhx_flat_hash_map()
+{
+    release();
+}
+
+template<class K, class V, class H, class E, class A> inline
+rhx_flat_hash_map<K, V, H, E, A>::rhx_flat_hash_map()
+:   m_slots(nullptr)
+,   m_capacity(0)
+,   m_size(0)
+,   m_growth_left(0)
+,   m_hash()
+,   m_equal()
+,   m_alloc()
+{}
+
+template<class K, class V, class H, class E, class A> inline
+rhx_flat_hash_map<K, V, H, E, A>::rhx_flat_hash_map(rhx_flat_hash_map&& other) noexcept
+:   m_slots(other.m_slots)
+,   m_capacity(other.m_capacity)
+,   m_size(other.m_size)
+,   m_growth_left(other.m_growth_left)
+,   m_hash(std::move(other.m_hash))
+,   m_equal(std::move(other.m_equal))
+,   m_alloc(std::move(other.m_alloc))
+{
+    other.m_slots       = nullptr;
+    other.m_capacity    = 0;
+    other.m_size        = 0;
+    other.m_growth_left = 0;
+}
+
+template<class K, class V, class H, class E, class A>
+rhx_flat_hash_map<K, V, H, E, A>::rhx_flat_hash_map(rhx_flat_hash_map const& other)
+:   m_slots(nullptr)
+,   m_capacity(0)
+,   m_size(0)
+,   m_growth_left(0)
+,   m_hash(other.m_hash)
+,   m_equal(other.m_equal)
+,   m_alloc(alloc_traits::select_on_container_copy_construction(other.m_alloc))
+{
+    reserve(other.m_size);
+
+    for (auto const& e : other)
+    {
+        insert(e);
+    }
+}
+
+template<class K, class V, class H, class E, class A>
+rhx_flat_hash_map<K, V, H, E, A>::rhx_flat_hash_map(size_type n, H const& h, E const& e, A const& a)
+:   m_slots(nullptr)
+,   m_capacity(0)
+,   m_size(0)
+,   m_growth_left(0)
+,   m_hash(h)
+,   m_equal(e)
+,   m_alloc(a)
+{
+    reserve(n);
+}
+
+template<class K, class V, class H, class E, class A>
+rhx_flat_hash_map<K, V, H, E, A>&
+rhx_flat_hash_map<K, V, H, E, A>::operator =(rhx_flat_hash_map&& rhs) noexcept
+{
+    if (&rhs != this)
+    {
+        release();
+        swap(rhs);
+    }
+    return *this;
+}
+
+template<class K, class V, class H, class E, class A>
+rhx_flat_hash_map<K, V, H, E, A>&
+rhx_flat_hash_map<K, V, H, E, A>::operator =(rhx_flat_hash_map const& rhs)
+{
+    if (&rhs != this)
+    {
+        rhx_flat_hash_map   tmp(rhs);
+        swap(tmp);
+    }
+    return *this;
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::iterator
+rhx_flat_hash_map<K, V, H, E, A>::begin() noexcept
+{
+    iterator    it = make_iterator(0);
+    it.skip_empty();
+    return it;
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::const_iterator
+rhx_flat_hash_map<K, V, H, E, A>::begin() const noexcept
+{
+    const_iterator  it = make_iterator(0);
+    it.skip_empty();
+    return it;
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::const_iterator
+rhx_flat_hash_map<K, V, H, E, A>::cbegin() const noexcept
+{
+    return begin();
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::iterator
+rhx_flat_hash_map<K, V, H, E, A>::end() noexcept
+{
+    return make_iterator(m_capacity);
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::const_iterator
+rhx_flat_hash_map<K, V, H, E, A>::end() const noexcept
+{
+    return make_iterator(m_capacity);
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::const_iterator
+rhx_flat_hash_map<K, V, H, E, A>::cend() const noexcept
+{
+    return end();
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A> inline
+bool
+rhx_flat_hash_map<K, V, H, E, A>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::size() const noexcept
+{
+    return m_size;
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template<class K, class V, class H, class E, class A> inline
+float
+rhx_flat_hash_map<K, V, H, E, A>::load_factor() const noexcept
+{
+    return (m_capacity == 0) ? 0.0f : static_cast<float>(m_size) / static_cast<float>(m_capacity);
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::clear() noexcept
+{
+    if (m_capacity != 0)
+    {
+        destroy_all();
+        memset(ctrl(), group::ctrl_empty, m_capacity);
+        m_size        = 0;
+        m_growth_left = max_load(m_capacity);
+    }
+}
+
+template<class K, class V, class H, class E, class A> inline
+void
+rhx_flat_hash_map<K, V, H, E, A>::reserve(size_type n)
+{
+    if (n > max_load(m_capacity))
+    {
+        resize(capacity_for(n));
+    }
+}
+
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::rehash(size_type n)
+{
+    //- A map that has never allocated a table has nothing to rehash.
+    //
+    if (n == 0  &&  m_size == 0  &&  m_capacity == 0)
+    {
+        return;
+    }
+
+    size_type   new_capacity = capacity_for((n > m_size) ? n : m_size);
+
+    if (new_capacity != m_capacity  ||  m_growth_left != max_load(m_capacity) - m_size)
+    {
+        resize(new_capacity);
+    }
+}
+
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::swap(rhx_flat_hash_map& other) noexcept
+{
+    using std::swap;
+
+    swap(m_slots, other.m_slots);
+    swap(m_capacity, other.m_capacity);
+    swap(m_size, other.m_size);
+    swap(m_growth_left, other.m_growth_left);
+    swap(m_hash, other.m_hash);
+    swap(m_equal, other.m_equal);
+    swap(m_alloc, other.m_alloc);
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A> inline
+std::pair<typename rhx_flat_hash_map<K, V, H, E, A>::iterator, bool>
+rhx_flat_hash_map<K, V, H, E, A>::insert(value_type const& value)
+{
+    return try_emplace_impl(value.first, value.second);
+}
+
+template<class K, class V, class H, class E, class A> inline
+std::pair<typename rhx_flat_hash_map<K, V, H, E, A>::iterator, bool>
+rhx_flat_hash_map<K, V, H, E, A>::insert(value_type&& value)
+{
+    return try_emplace_impl(std::move(const_cast<K&>(value.first)), std::move(value.second));
+}
+
+//- The key is only known after the element has been constructed, so emplace() builds the
+//  element in local storage first and moves it into the table if its key is not present.
+//
+template<class K, class V, class H, class E, class A>
+template<class... Args>
+std::pair<typename rhx_flat_hash_map<K, V, H, E, A>::iterator, bool>
+rhx_flat_hash_map<K, V, H, E, A>::emplace(Args&&... args)
+{
+    slot_storage    buf;
+    value_type*     ptmp = reinterpret_cast<value_type*>(&buf);
+
+    alloc_traits::construct(m_alloc, ptmp, std::forward<Args>(args)...);
+
+    try
+    {
+        auto    result = try_emplace_impl(std::move(const_cast<K&>(ptmp->first)),
+                                          std::move(ptmp->second));
+        alloc_traits::destroy(m_alloc, ptmp);
+        return result;
+    }
+    catch (...)
+    {
+        alloc_traits::destroy(m_alloc, ptmp);
+        throw;
+    }
+}
+
+template<class K, class V, class H, class E, class A>
+template<class... Args> inline
+std::pair<typename rhx_flat_hash_map<K, V, H, E, A>::iterator, bool>
+rhx_flat_hash_map<K, V, H, E, A>::try_emplace(K const& key, Args&&... args)
+{
+    return try_emplace_impl(key, std::forward<Args>(args)...);
+}
+
+template<class K, class V, class H, class E, class A>
+template<class... Args> inline
+std::pair<typename rhx_flat_hash_map<K, V, H, E, A>::iterator, bool>
+rhx_flat_hash_map<K, V, H, E, A>::try_emplace(K&& key, Args&&... args)
+{
+    return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A>
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::erase(K const& key)
+{
+    size_type   index = find_index(key, hash_of(key));
+
+    if (index == npos)
+    {
+        return 0;
+    }
+
+    erase_index(index);
+    return 1;
+}
+
+template<class K, class V, class H, class E, class A>
+typename rhx_flat_hash_map<K, V, H, E, A>::iterator
+rhx_flat_hash_map<K, V, H, E, A>::erase(const_iterator pos)
+{
+    size_type   index = static_cast<size_type>(pos.mp_slot - slots());
+    iterator    next  = make_iterator(index + 1);
+
+    erase_index(index);
+    next.skip_empty();
+    return next;
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A> inline
+V&
+rhx_flat_hash_map<K, V, H, E, A>::operator [](K const& key)
+{
+    return try_emplace_impl(key).first->second;
+}
+
+template<class K, class V, class H, class E, class A> inline
+V&
+rhx_flat_hash_map<K, V, H, E, A>::operator [](K&& key)
+{
+    return try_emplace_impl(std::move(key)).first->second;
+}
+
+template<class K, class V, class H, class E, class A>
+V&
+rhx_flat_hash_map<K, V, H, E, A>::at(K const& key)
+{
+    size_type   index = find_index(key, hash_of(key));
+
+    if (index == npos)
+    {
+        throw std::out_of_range("rhx_flat_hash_map::at");
+    }
+    return slots()[index].second;
+}
+
+template<class K, class V, class H, class E, class A>
+V const&
+rhx_flat_hash_map<K, V, H, E, A>::at(K const& key) const
+{
+    size_type   index = find_index(key, hash_of(key));
+
+    if (index == npos)
+    {
+        throw std::out_of_range("rhx_flat_hash_map::at");
+    }
+    return slots()[index].second;
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::iterator
+rhx_flat_hash_map<K, V, H, E, A>::find(K const& key)
+{
+    size_type   index = find_index(key, hash_of(key));
+    return make_iterator((index == npos) ? m_capacity : index);
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::const_iterator
+rhx_flat_hash_map<K, V, H, E, A>::find(K const& key) const
+{
+    size_type   index = find_index(key, hash_of(key));
+    return make_iterator((index == npos) ? m_capacity : index);
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::count(K const& key) const
+{
+    return (find_index(key, hash_of(key)) == npos) ? 0 : 1;
+}
+
+template<class K, class V, class H, class E, class A> inline
+bool
+rhx_flat_hash_map<K, V, H, E, A>::contains(K const& key) const
+{
+    return find_index(key, hash_of(key)) != npos;
+}
+
+//------
+//
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::hasher
+rhx_flat_hash_map<K, V, H, E, A>::hash_function() const
+{
+    return m_hash;
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::key_equal
+rhx_flat_hash_map<K, V, H, E, A>::key_eq() const
+{
+    return m_equal;
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::allocator_type
+rhx_flat_hash_map<K, V, H, E, A>::get_allocator() const
+{
+    return m_alloc;
+}
+
+//- Reports the slot block to a heap compactor's visitor, and then the elements in the full
+//  slots.  Only the map can tell which slots are full, so the block is reported as untyped
+//  and its elements are traced here, wherever the block is at the time.
+//
+template<class K, class V, class H, class E, class A>
+template<class Vis>
+void
+rhx_flat_hash_map<K, V, H, E, A>::trace(Vis& visitor)
+{
+    using void_pointer = typename std::pointer_traits<slot_pointer>::template rebind<void>;
+
+    void_pointer    vp = m_slots;
+
+    visitor(vp);
+    m_slots = static_cast<slot_pointer>(vp);
+
+    value_type*     pslots = slots();
+    int8_t const*   pctrl  = ctrl();
+
+    for (size_type i = 0;  i < m_capacity;  ++i)
+    {
+        if (pctrl[i] >= 0)
+        {
+            rhx_trace_traits<value_type>::trace(pslots[i], visitor);
+        }
+    }
+}
+
+//------
+//
+//- Number of slot_storage units needed to hold the slots plus one control byte per slot.
+//
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::block_units(size_type capacity) noexcept
+{
+    return capacity + (capacity + sizeof(slot_storage) - 1) / sizeof(slot_storage);
+}
+
+template<class K, class V, class H, class E, class A>
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::capacity_for(size_type n) noexcept
+{
+    size_type   capacity = group::width;
+
+    while (max_load(capacity) < n)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+//- The maximum load factor is 7/8.
+//
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::max_load(size_type capacity) noexcept
+{
+    return capacity - capacity / 8;
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::value_type*
+rhx_flat_hash_map<K, V, H, E, A>::slots() const noexcept
+{
+    return (m_capacity == 0) ? nullptr : reinterpret_cast<value_type*>(std::addressof(*m_slots));
+}
+
+template<class K, class V, class H, class E, class A> inline
+int8_t*
+rhx_flat_hash_map<K, V, H, E, A>::ctrl() const noexcept
+{
+    return reinterpret_cast<int8_t*>(slots() + m_capacity);
+}
+
+//- The user's hash is mixed so that the low seven bits stored in the control bytes and the
+//  high bits used to select a group are both well distributed, even for identity hashes.
+//
+template<class K, class V, class H, class E, class A> inline
+uint64_t
+rhx_flat_hash_map<K, V, H, E, A>::hash_of(K const& key) const
+{
+    uint64_t    h = static_cast<uint64_t>(m_hash(key)) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+//- Groups are probed in triangular order, which visits every group of a power-of-two table.
+//  A group containing an empty slot terminates the search.
+//
+template<class K, class V, class H, class E, class A>
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::find_index(K const& key, uint64_t hash) const
+{
+    if (m_capacity == 0)
+    {
+        return npos;
+    }
+
+    value_type const*   pslots = slots();
+    int8_t const*       pctrl  = reinterpret_cast<int8_t const*>(pslots + m_capacity);
+    int8_t              h2     = static_cast<int8_t>(hash & 0x7F);
+    size_type           gmask  = m_capacity / group::width - 1;
+    size_type           g      = static_cast<size_type>(hash >> 7) & gmask;
+
+    for (size_type i = 1;  i <= gmask + 1;  g = (g + i++) & gmask)
+    {
+        int8_t const*   pgroup = pctrl + g * group::width;
+
+        for (uint32_t m = group::match(pgroup, h2);  m != 0;  m &= (m - 1))
+        {
+            size_type   index = g * group::width + group::lowest_bit(m);
+
+            if (m_equal(pslots[index].first, key))
+            {
+                return index;
+            }
+        }
+
+        if (group::match_empty(pgroup) != 0)
+        {
+            break;
+        }
+    }
+
+    return npos;
+}
+
+template<class K, class V, class H, class E, class A>
+typename rhx_flat_hash_map<K, V, H, E, A>::size_type
+rhx_flat_hash_map<K, V, H, E, A>::find_insert_index
+(int8_t const* pctrl, size_type capacity, uint64_t hash) noexcept
+{
+    size_type       gmask = capacity / group::width - 1;
+    size_type       g     = static_cast<size_type>(hash >> 7) & gmask;
+
+    for (size_type i = 1;  ;  g = (g + i++) & gmask)
+    {
+        uint32_t    m = group::match_empty_or_deleted(pctrl + g * group::width);
+
+        if (m != 0)
+        {
+            return g * group::width + group::lowest_bit(m);
+        }
+    }
+}
+
+template<class K, class V, class H, class E, class A> inline
+void
+rhx_flat_hash_map<K, V, H, E, A>::set_ctrl(size_type index, int8_t h2) noexcept
+{
+    ctrl()[index] = h2;
+}
+
+//- If the erased slot's group still has an empty slot, no probe sequence ever continued past
+//  that group, so the slot can be marked empty instead of leaving a tombstone.
+//
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::erase_index(size_type index) noexcept
+{
+    int8_t*     pgroup = ctrl() + (index & ~(size_type(group::width) - 1));
+
+    alloc_traits::destroy(m_alloc, slots() + index);
+    --m_size;
+
+    if (group::match_empty(pgroup) != 0)
+    {
+        set_ctrl(index, group::ctrl_empty);
+        ++m_growth_left;
+    }
+    else
+    {
+        set_ctrl(index, group::ctrl_deleted);
+    }
+}
+
+//- Called before inserting into an empty slot.  When tombstones rather than elements have
+//  used up the growth budget, the table is rebuilt at its current capacity.
+//
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::prepare_insert()
+{
+    if (m_growth_left == 0)
+    {
+        if (m_capacity != 0  &&  m_size <= max_load(m_capacity) / 2)
+        {
+            resize(m_capacity);
+        }
+        else
+        {
+            resize((m_capacity == 0) ? size_type(group::width) : m_capacity * 2);
+        }
+    }
+}
+
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::resize(size_type new_capacity)
+{
+    slot_allocator  salloc(m_alloc);
+    slot_pointer    new_block = slot_traits::allocate(salloc, block_units(new_capacity));
+    value_type*     new_slots = reinterpret_cast<value_type*>(std::addressof(*new_block));
+    int8_t*         new_ctrl  = reinterpret_cast<int8_t*>(new_slots + new_capacity);
+
+    memset(new_ctrl, group::ctrl_empty, new_capacity);
+
+    value_type*     old_slots = slots();
+    int8_t const*   old_ctrl  = ctrl();
+
+    for (size_type i = 0;  i < m_capacity;  ++i)
+    {
+        if (old_ctrl[i] >= 0)
+        {
+            uint64_t    hash  = hash_of(old_slots[i].first);
+            size_type   index = find_insert_index(new_ctrl, new_capacity, hash);
+
+            alloc_traits::construct(m_alloc, new_slots + index,
+                                    std::move(const_cast<K&>(old_slots[i].first)),
+                                    std::move(old_slots[i].second));
+            alloc_traits::destroy(m_alloc, old_slots + i);
+            new_ctrl[index] = static_cast<int8_t>(hash & 0x7F);
+        }
+    }
+
+    if (m_capacity != 0)
+    {
+        slot_traits::deallocate(salloc, m_slots, block_units(m_capacity));
+    }
+
+    m_slots       = new_block;
+    m_capacity    = new_capacity;
+    m_growth_left = max_load(new_capacity) - m_size;
+}
+
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::destroy_all() noexcept
+{
+    value_type*     pslots = slots();
+    int8_t const*   pctrl  = ctrl();
+
+    for (size_type i = 0;  i < m_capacity;  ++i)
+    {
+        if (pctrl[i] >= 0)
+        {
+            alloc_traits::destroy(m_alloc, pslots + i);
+        }
+    }
+}
+
+template<class K, class V, class H, class E, class A>
+void
+rhx_flat_hash_map<K, V, H, E, A>::release() noexcept
+{
+    if (m_capacity != 0)
+    {
+        slot_allocator  salloc(m_alloc);
+
+        destroy_all();
+        slot_traits::deallocate(salloc, m_slots, block_units(m_capacity));
+        m_slots       = nullptr;
+        m_capacity    = 0;
+        m_size        = 0;
+        m_growth_left = 0;
+    }
+}
+
+template<class K, class V, class H, class E, class A>
+template<class KK, class... Args>
+std::pair<typename rhx_flat_hash_map<K, V, H, E, A>::iterator, bool>
+rhx_flat_hash_map<K, V, H, E, A>::try_emplace_impl(KK&& key, Args&&... args)
+{
+    uint64_t    hash  = hash_of(key);
+    size_type   index = find_index(key, hash);
+
+    if (index != npos)
+    {
+        return std::make_pair(make_iterator(index), false);
+    }
+
+    prepare_insert();
+    index = find_insert_index(ctrl(), m_capacity, hash);
+
+    alloc_traits::construct(m_alloc, slots() + index, std::piecewise_construct,
+                            std::forward_as_tuple(std::forward<KK>(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+
+    if (ctrl()[index] == group::ctrl_empty)
+    {
+        --m_growth_left;
+    }
+    set_ctrl(index, static_cast<int8_t>(hash & 0x7F));
+    ++m_size;
+
+    return std::make_pair(make_iterator(index), true);
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::iterator
+rhx_flat_hash_map<K, V, H, E, A>::make_iterator(size_type index) noexcept
+{
+    value_type*     pslots = slots();
+    int8_t const*   pctrl  = reinterpret_cast<int8_t const*>(pslots + m_capacity);
+
+    return iterator(pctrl + index, pctrl + m_capacity, pslots + index);
+}
+
+template<class K, class V, class H, class E, class A> inline
+typename rhx_flat_hash_map<K, V, H, E, A>::const_iterator
+rhx_flat_hash_map<K, V, H, E, A>::make_iterator(size_type index) const noexcept
+{
+    value_type*     pslots = slots();
+    int8_t const*   pctrl  = reinterpret_cast<int8_t const*>(pslots + m_capacity);
+
+    return const_iterator(pctrl + index, pctrl + m_capacity, pslots + index);
+}
+
+template<class K, class V, class H, class E, class A> inline
+void
+swap(rhx_flat_hash_map<K, V, H, E, A>& lhs, rhx_flat_hash_map<K, V, H, E, A>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+#endif  //- RHX_FLAT_HASH_MAP_H_DEFINED
@@ -0,0 +1,568 @@
+//==================================================================================================
+//  File:
+//      rhx_intern_pool.h
+//
+//  Summary:
+//      Defines the rhx_basic_intern_pool<C,Tr,A> class template, a table that stores one copy of
+//      each distinct string given to it, and the rhx_interned_string<C,Tr,A> handles it returns.
+//==================================================================================================
+//
+#ifndef RHX_INTERN_POOL_H_DEFINED
+#define RHX_INTERN_POOL_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+template<class C, class Tr, class A> class rhx_basic_intern_pool;
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_interned_string<C,Tr,A>
+//
+//  Summary:
+//      This class template is a handle to a string stored in an rhx_basic_intern_pool<C,Tr,A>.
+//      It holds nothing but the allocator's (possibly synthetic) pointer to the pool's entry for
+//      the string, which records the string's hash value and length ahead of its characters, so
+//      a handle stored in a relocatable heap remains valid when the heap moves.  Since a pool
+//      stores each distinct string once, two handles from the same pool are equal exactly when
+//      they point to the same entry, and neither comparing nor hashing them reads a character.
+//      A default-constructed handle refers to no string.
+//--------------------------------------------------------------------------------------------------
+//
+template<class C, class Tr = std::char_traits<C>, class A = std::allocator<C>>
+class rhx_interned_string
+{
+  public:
+    using traits_type       = Tr;
+    using value_type        = C;
+    using size_type         = std::size_t;
+
+  public:
+    rhx_interned_string() noexcept;
+
+    explicit    operator bool() const noexcept;
+
+    C const*    c_str() const noexcept;
+    C const*    data() const noexcept;
+    size_type   size() const noexcept;
+    bool        empty() const noexcept;
+    uint64_t    hash() const noexcept;
+
+    bool        operator ==(rhx_interned_string const& rhs) const noexcept;
+    bool        operator !=(rhx_interned_string const& rhs) const noexcept;
+    bool        operator <(rhx_interned_string const& rhs) const noexcept;
+
+    template<class V>
+    void        trace(V& visitor);
+
+  private:
+    friend class rhx_basic_intern_pool<C, Tr, A>;
+
+    //- The header of a pool entry; the characters and a terminating null follow it.  An entry
+    //  holds no pointers, so there is nothing for a heap compactor's visitor to see.
+    //
+    struct entry
+    {
+        uint64_t    m_hash;
+        uint64_t    m_size;
+
+        template<class V>
+        void    trace(V&) noexcept
+                {}
+    };
+
+    using entry_pointer = typename std::allocator_traits<A>::template rebind_traits<entry>::pointer;
+
+    entry_pointer   mp_entry;
+
+  private:
+    explicit rhx_interned_string(entry_pointer pentry) noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_basic_intern_pool<C,Tr,A>
+//
+//  Summary:
+//      This class template implements a set of strings, each stored once in a block of its own
+//      obtained from the allocator, and indexed by an open-addressing table of slots that hold
+//      an entry's hash value along with its pointer.  intern() returns the handle of the entry
+//      equal to the given characters, adding an entry first if there is none; find() only
+//      looks.  Entries live as long as the pool, so the handles it returns stay valid until it
+//      is destroyed.
+//
+//      When the pool and its allocator live in a relocatable heap, so do the entries, and the
+//      handles can be stored in the heap's containers in place of per-node copies of strings
+//      that repeat.  Interned strings are never modified, which makes them natural candidates
+//      for an allocator that places long-lived data apart from data that is rewritten.
+//--------------------------------------------------------------------------------------------------
+//
+template<class C, class Tr = std::char_traits<C>, class A = std::allocator<C>>
+class rhx_basic_intern_pool
+{
+  public:
+    using traits_type       = Tr;
+    using value_type        = C;
+    using allocator_type    = A;
+    using size_type         = std::size_t;
+    using handle            = rhx_interned_string<C, Tr, A>;
+
+    //- Describes the pool's use; requests counts every call to intern().
+    //
+    struct pool_statistics
+    {
+        size_type   strings;                //- Distinct strings stored
+        size_type   requests;               //- Strings submitted to intern()
+        size_type   bytes_stored;           //- Bytes of entries, headers included
+        size_type   bytes_saved;            //- Bytes of characters not stored again
+    };
+
+  public:
+    ~rhx_basic_intern_pool();
+
+    rhx_basic_intern_pool();
+    explicit rhx_basic_intern_pool(A const& alloc);
+    rhx_basic_intern_pool(rhx_basic_intern_pool const&) = delete;
+
+    rhx_basic_intern_pool&  operator =(rhx_basic_intern_pool const&) = delete;
+
+    handle      intern(C const* s, size_type n);
+    handle      intern(C const* s);
+    handle      find(C const* s, size_type n) const;
+    handle      find(C const* s) const;
+
+    bool        empty() const noexcept;
+    size_type   size() const noexcept;
+
+    pool_statistics const&  statistics() const noexcept;
+    allocator_type          get_allocator() const;
+
+    template<class V>
+    void        trace(V& visitor);
+
+  private:
+    using entry          = typename handle::entry;
+    using entry_pointer  = typename handle::entry_pointer;
+    using entry_alloc    = typename std::allocator_traits<A>::template rebind_alloc<entry>;
+    using entry_traits   = std::allocator_traits<entry_alloc>;
+
+    struct slot
+    {
+        entry_pointer   mp_entry;
+        uint64_t        m_hash;
+
+        template<class V>
+        void    trace(V& visitor)
+                { visitor(mp_entry); }
+    };
+
+    using slot_alloc     = typename std::allocator_traits<A>::template rebind_alloc<slot>;
+    using slot_traits    = std::allocator_traits<slot_alloc>;
+    using slot_pointer   = typename slot_traits::pointer;
+
+    enum : size_type
+    {
+        min_capacity = 64
+    };
+
+    slot_pointer        m_slots;
+    size_type           m_capacity;         //- Zero, or a power of two
+    pool_statistics     m_stats;
+    allocator_type      m_alloc;
+
+  private:
+    static  uint64_t    hash_chars(C const* s, size_type n) noexcept;
+    static  size_type   entry_units(size_type n) noexcept;
+    static  C*          entry_chars(entry* pentry) noexcept;
+
+    size_type       find_index(C const* s, size_type n, uint64_t hash) const noexcept;
+    void            grow();
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_interned_string<C,Tr,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class C, class Tr, class A> inline
+rhx_interned_string<C, Tr, A>::rhx_interned_string() noexcept
+:   mp_entry(nullptr)
+{}
+
+template<class C, class Tr, class A> inline
+rhx_interned_string<C, Tr, A>::rhx_interned_string(entry_pointer pentry) noexcept
+:   mp_entry(pentry)
+{}
+
+template<class C, class Tr, class A> inline
+rhx_interned_string<C, Tr, A>::operator bool() const noexcept
+{
+    return static_cast<bool>(mp_entry);
+}
+
+template<class C, class Tr, class A> inline
+C const*
+rhx_interned_string<C, Tr, A>::c_str() const noexcept
+{
+    return data();
+}
+
+//- The characters of the null handle are those of an empty string.
+//
+template<class C, class Tr, class A> inline
+C const*
+rhx_interned_string<C, Tr, A>::data() const noexcept
+{
+    static C const  empty_string[1] = {};
+
+    return mp_entry ? reinterpret_cast<C const*>(std::addressof(*mp_entry) + 1) : empty_string;
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_interned_string<C, Tr, A>::size_type
+rhx_interned_string<C, Tr, A>::size() const noexcept
+{
+    return mp_entry ? static_cast<size_type>(mp_entry->m_size) : 0;
+}
+
+template<class C, class Tr, class A> inline
+bool
+rhx_interned_string<C, Tr, A>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template<class C, class Tr, class A> inline
+uint64_t
+rhx_interned_string<C, Tr, A>::hash() const noexcept
+{
+    return mp_entry ? mp_entry->m_hash : 0;
+}
+
+template<class C, class Tr, class A> inline
+bool
+rhx_interned_string<C, Tr, A>::operator ==(rhx_interned_string const& rhs) const noexcept
+{
+    return mp_entry == rhs.mp_entry;
+}
+
+template<class C, class Tr, class A> inline
+bool
+rhx_interned_string<C, Tr, A>::operator !=(rhx_interned_string const& rhs) const noexcept
+{
+    return mp_entry != rhs.mp_entry;
+}
+
+//- Orders handles by their strings, so that the order does not depend on where entries happen
+//  to have been allocated.
+//
+template<class C, class Tr, class A>
+bool
+rhx_interned_string<C, Tr, A>::operator <(rhx_interned_string const& rhs) const noexcept
+{
+    if (mp_entry == rhs.mp_entry)
+    {
+        return false;
+    }
+
+    size_type   n1  = size();
+    size_type   n2  = rhs.size();
+    int         cmp = Tr::compare(data(), rhs.data(), (n1 < n2) ? n1 : n2);
+
+    return (cmp != 0) ? (cmp < 0) : (n1 < n2);
+}
+
+//- Reports the entry to a heap compactor's visitor.
+//
+template<class C, class Tr, class A>
+template<class V> inline
+void
+rhx_interned_string<C, Tr, A>::trace(V& visitor)
+{
+    visitor(mp_entry);
+}
+
+template<class C, class Tr, class A> inline
+std::basic_ostream<C, Tr>&
+operator <<(std::basic_ostream<C, Tr>& os, rhx_interned_string<C, Tr, A> const& str)
+{
+    return os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_basic_intern_pool<C,Tr,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class C, class Tr, class A>
+rhx_basic_intern_pool<C, Tr, A>::~rhx_basic_intern_pool()
+{
+    entry_alloc     ealloc(m_alloc);
+    slot_alloc      salloc(m_alloc);
+    slot*           pslots = m_capacity ? std::addressof(*m_slots) : nullptr;
+
+    for (size_type i = 0;  i < m_capacity;  ++i)
+    {
+        if (pslots[i].mp_entry)
+        {
+            entry_traits::deallocate(ealloc, pslots[i].mp_entry,
+                                     entry_units(static_cast<size_type>(pslots[i].mp_entry->m_size)));
+        }
+    }
+    if (m_capacity != 0)
+    {
+        slot_traits::deallocate(salloc, m_slots, m_capacity);
+    }
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_intern_pool<C, Tr, A>::rhx_basic_intern_pool()
+:   m_slots(nullptr)
+,   m_capacity(0)
+,   m_stats()
+,   m_alloc()
+{}
+
+template<class C, class Tr, class A> inline
+rhx_basic_intern_pool<C, Tr, A>::rhx_basic_intern_pool(A const& alloc)
+:   m_slots(nullptr)
+,   m_capacity(0)
+,   m_stats()
+,   m_alloc(alloc)
+{}
+
+//- Returns the handle of the stored copy of [s, s + n), storing one first if necessary.  The
+//  table is kept at most half full, so probe sequences stay short.
+//
+template<class C, class Tr, class A>
+typename rhx_basic_intern_pool<C, Tr, A>::handle
+rhx_basic_intern_pool<C, Tr, A>::intern(C const* s, size_type n)
+{
+    if (2 * (m_stats.strings + 1) > m_capacity)
+    {
+        grow();
+    }
+
+    uint64_t    hash  = hash_chars(s, n);
+    size_type   index = find_index(s, n, hash);
+    slot&       sl    = std::addressof(*m_slots)[index];
+
+    m_stats.requests += 1;
+
+    if (sl.mp_entry)
+    {
+        m_stats.bytes_saved += n * sizeof(C);
+        return handle(sl.mp_entry);
+    }
+
+    entry_alloc     ealloc(m_alloc);
+    entry_pointer   pentry = entry_traits::allocate(ealloc, entry_units(n));
+    entry*          pe     = std::addressof(*pentry);
+
+    pe->m_hash = hash;
+    pe->m_size = n;
+    Tr::copy(entry_chars(pe), s, n);
+    entry_chars(pe)[n] = C();
+
+    sl.mp_entry = pentry;
+    sl.m_hash   = hash;
+
+    m_stats.strings      += 1;
+    m_stats.bytes_stored += entry_units(n) * sizeof(entry);
+
+    return handle(pentry);
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_intern_pool<C, Tr, A>::handle
+rhx_basic_intern_pool<C, Tr, A>::intern(C const* s)
+{
+    return intern(s, Tr::length(s));
+}
+
+template<class C, class Tr, class A>
+typename rhx_basic_intern_pool<C, Tr, A>::handle
+rhx_basic_intern_pool<C, Tr, A>::find(C const* s, size_type n) const
+{
+    if (m_capacity == 0)
+    {
+        return handle();
+    }
+    return handle(std::addressof(*m_slots)[find_index(s, n, hash_chars(s, n))].mp_entry);
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_intern_pool<C, Tr, A>::handle
+rhx_basic_intern_pool<C, Tr, A>::find(C const* s) const
+{
+    return find(s, Tr::length(s));
+}
+
+template<class C, class Tr, class A> inline
+bool
+rhx_basic_intern_pool<C, Tr, A>::empty() const noexcept
+{
+    return m_stats.strings == 0;
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_intern_pool<C, Tr, A>::size_type
+rhx_basic_intern_pool<C, Tr, A>::size() const noexcept
+{
+    return m_stats.strings;
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_intern_pool<C, Tr, A>::pool_statistics const&
+rhx_basic_intern_pool<C, Tr, A>::statistics() const noexcept
+{
+    return m_stats;
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_intern_pool<C, Tr, A>::allocator_type
+rhx_basic_intern_pool<C, Tr, A>::get_allocator() const
+{
+    return m_alloc;
+}
+
+//- Reports the slot table, and through its slots the entries, to a heap compactor's visitor.
+//
+template<class C, class Tr, class A>
+template<class V> inline
+void
+rhx_basic_intern_pool<C, Tr, A>::trace(V& visitor)
+{
+    visitor(m_slots, m_capacity);
+}
+
+//------
+//
+//- Hashes the characters' bytes with 64-bit FNV-1a, as std::hash does for rhx_basic_string.
+//
+template<class C, class Tr, class A>
+uint64_t
+rhx_basic_intern_pool<C, Tr, A>::hash_chars(C const* s, size_type n) noexcept
+{
+    unsigned char const*    p = reinterpret_cast<unsigned char const*>(s);
+    unsigned char const*    e = p + n * sizeof(C);
+    uint64_t                h = 0xCBF29CE484222325ull;
+
+    for (;  p != e;  ++p)
+    {
+        h ^= *p;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+//- Returns the number of entry-sized units needed to hold an entry for n characters.
+//
+template<class C, class Tr, class A> inline
+typename rhx_basic_intern_pool<C, Tr, A>::size_type
+rhx_basic_intern_pool<C, Tr, A>::entry_units(size_type n) noexcept
+{
+    return 1 + ((n + 1) * sizeof(C) + sizeof(entry) - 1) / sizeof(entry);
+}
+
+template<class C, class Tr, class A> inline
+C*
+rhx_basic_intern_pool<C, Tr, A>::entry_chars(entry* pentry) noexcept
+{
+    return reinterpret_cast<C*>(pentry + 1);
+}
+
+//- Returns the index of the slot holding the entry for [s, s + n), or of the empty slot at
+//  which the probe for it ended.  Slots are probed linearly from a position taken from the
+//  high bits of the mixed hash value; only slots whose hash values match are compared.
+//
+template<class C, class Tr, class A>
+typename rhx_basic_intern_pool<C, Tr, A>::size_type
+rhx_basic_intern_pool<C, Tr, A>::find_index(C const* s, size_type n, uint64_t hash) const noexcept
+{
+    slot const*     pslots = std::addressof(*m_slots);
+    size_type       mask   = m_capacity - 1;
+    size_type       index  = static_cast<size_type>((hash * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+
+    for (;;  index = (index + 1) & mask)
+    {
+        slot const&     sl = pslots[index];
+
+        if (!sl.mp_entry)
+        {
+            return index;
+        }
+        if (sl.m_hash == hash)
+        {
+            entry const*    pe = std::addressof(*sl.mp_entry);
+
+            if (pe->m_size == n  &&  Tr::compare(entry_chars(const_cast<entry*>(pe)), s, n) == 0)
+            {
+                return index;
+            }
+        }
+    }
+}
+
+//- Doubles the table, moving each entry's slot to its new position; the entries themselves
+//  stay where they are, so outstanding handles remain valid.
+//
+template<class C, class Tr, class A>
+void
+rhx_basic_intern_pool<C, Tr, A>::grow()
+{
+    slot_alloc      salloc(m_alloc);
+    size_type       new_capacity = (m_capacity != 0) ? 2 * m_capacity : size_type(min_capacity);
+    slot_pointer    new_slots    = slot_traits::allocate(salloc, new_capacity);
+    slot*           pnew         = std::addressof(*new_slots);
+    size_type       mask         = new_capacity - 1;
+
+    for (size_type i = 0;  i < new_capacity;  ++i)
+    {
+        slot_traits::construct(salloc, pnew + i, slot{entry_pointer(nullptr), 0});
+    }
+
+    for (size_type i = 0;  i < m_capacity;  ++i)
+    {
+        slot const&     sl = std::addressof(*m_slots)[i];
+
+        if (sl.mp_entry)
+        {
+            size_type   index = static_cast<size_type>((sl.m_hash * 0x9E3779B97F4A7C15ull) >> 32);
+
+            for (index &= mask;  pnew[index].mp_entry;  index = (index + 1) & mask)
+            {}
+            pnew[index] = sl;
+        }
+    }
+
+    if (m_capacity != 0)
+    {
+        slot_traits::deallocate(salloc, m_slots, m_capacity);
+    }
+
+    m_slots    = new_slots;
+    m_capacity = new_capacity;
+}
+
+//- Interned strings hash to the value recorded in their entries, which is computed only once,
+//  when the string is first stored.
+//
+namespace std
+{
+    template<class C, class Tr, class A>
+    struct hash<rhx_interned_string<C, Tr, A>>
+    {
+        size_t  operator ()(rhx_interned_string<C, Tr, A> const& str) const noexcept
+        {
+            return static_cast<size_t>(str.hash());
+        }
+    };
+}
+
+#endif  //- RHX_INTERN_POOL_H_DEFINED
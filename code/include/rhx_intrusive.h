@@ -0,0 +1,2433 @@
+//==================================================================================================
+//  File:
+//      rhx_intrusive.h
+//
+//  Summary:
+//      Defines the rhx_intrusive_list<T,VP,Tag>, rhx_intrusive_tree<T,VP,C,Tag>, and
+//      rhx_intrusive_hash<T,VP,H,E,A,Tag> class templates, containers that link objects through
+//      hooks embedded in the objects themselves.
+//==================================================================================================
+//
+#ifndef RHX_INTRUSIVE_H_DEFINED
+#define RHX_INTRUSIVE_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "synthetic_pointer_interface.h"
+
+template<class T, class VP, class Tag> class rhx_intrusive_list;
+template<class T, class VP, class C, class Tag> class rhx_intrusive_tree;
+template<class T, class VP, class H, class E, class A, class Tag> class rhx_intrusive_hash;
+
+//- The tag of a hook that an object has only one of.
+//
+struct rhx_default_hook_tag {};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Templates:
+//      rhx_list_hook<VP,Tag>
+//      rhx_tree_hook<VP,Tag>
+//      rhx_hash_hook<VP,Tag>
+//
+//  Summary:
+//      These class templates are the links by which the intrusive containers below chain
+//      objects together.  A type T is made linkable by deriving it from a hook, whose links are
+//      pointers of the type obtained by rebinding the void pointer type VP, typically the void
+//      pointer of a relocatable heap's allocation strategy; an object allocated in that heap
+//      can then be linked into containers in the same heap without any further allocation, and
+//      the links relocate with the heap.  An object can be linked into as many containers at
+//      once as it has hooks, which are told apart by their Tag types.
+//
+//      A hook belongs to the object, not to a container: copying an object does not copy its
+//      links, and an object must be removed from its containers before it is destroyed.  For
+//      the same reason, a heap compactor learns of a container's links in two parts: the
+//      container's trace() reports the objects it points to, and T's own trace() must report
+//      the links in each of its hooks by calling the container's static trace_hook().  Links
+//      are reported as pointers to T, so that a block holding an object is traced as T.
+//--------------------------------------------------------------------------------------------------
+//
+template<class VP, class Tag = rhx_default_hook_tag>
+class rhx_list_hook
+{
+  public:
+    rhx_list_hook() noexcept;
+    rhx_list_hook(rhx_list_hook const&) noexcept;
+    rhx_list_hook&  operator =(rhx_list_hook const&) noexcept;
+
+  private:
+    template<class T, class VP2, class Tag2> friend class rhx_intrusive_list;
+
+    using pointer = typename std::pointer_traits<VP>::template rebind<rhx_list_hook>;
+
+    pointer     m_next;
+    pointer     m_prev;
+};
+
+template<class VP, class Tag = rhx_default_hook_tag>
+class rhx_tree_hook
+{
+  public:
+    rhx_tree_hook() noexcept;
+    rhx_tree_hook(rhx_tree_hook const&) noexcept;
+    rhx_tree_hook&  operator =(rhx_tree_hook const&) noexcept;
+
+  private:
+    template<class T, class VP2, class C, class Tag2> friend class rhx_intrusive_tree;
+
+    using pointer = typename std::pointer_traits<VP>::template rebind<rhx_tree_hook>;
+
+    pointer     m_parent;
+    pointer     m_left;
+    pointer     m_right;
+    uint64_t    m_red;
+};
+
+template<class VP, class Tag = rhx_default_hook_tag>
+class rhx_hash_hook
+{
+  public:
+    rhx_hash_hook() noexcept;
+    rhx_hash_hook(rhx_hash_hook const&) noexcept;
+    rhx_hash_hook&  operator =(rhx_hash_hook const&) noexcept;
+
+  private:
+    template<class T, class VP2, class H, class E, class A, class Tag2>
+    friend class rhx_intrusive_hash;
+
+    using pointer = typename std::pointer_traits<VP>::template rebind<rhx_hash_hook>;
+
+    pointer     m_next;
+    uint64_t    m_hash;                     //- Kept so that rehashing never calls H
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_intrusive_list<T,VP,Tag>
+//
+//  Summary:
+//      This class template implements a doubly-linked list of objects of type T, which must
+//      derive from rhx_list_hook<VP,Tag>.  The list holds pointers to its first and last
+//      objects, and the ends of the chain are null, so neither the list nor any object points
+//      into the list itself; a list constructed in a relocatable heap relocates with the heap,
+//      and a list can be moved.  The list neither allocates nor frees objects; clear() and the
+//      destructor unlink them.  Iterators hold ordinary pointers, and are invalidated by
+//      relocation of the heap.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class Tag = rhx_default_hook_tag>
+class rhx_intrusive_list
+{
+  public:
+    using value_type        = T;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = T&;
+    using const_reference   = T const&;
+    using hook_type         = rhx_list_hook<VP, Tag>;
+
+  private:
+    template<bool IsConst> class iterator_type;
+
+  public:
+    using iterator          = iterator_type<false>;
+    using const_iterator    = iterator_type<true>;
+
+  public:
+    ~rhx_intrusive_list();
+
+    rhx_intrusive_list() noexcept;
+    rhx_intrusive_list(rhx_intrusive_list&& other) noexcept;
+    rhx_intrusive_list(rhx_intrusive_list const&) = delete;
+
+    rhx_intrusive_list&     operator =(rhx_intrusive_list&& rhs) noexcept;
+    rhx_intrusive_list&     operator =(rhx_intrusive_list const&) = delete;
+
+    iterator        begin() noexcept;
+    const_iterator  begin() const noexcept;
+    const_iterator  cbegin() const noexcept;
+    iterator        end() noexcept;
+    const_iterator  end() const noexcept;
+    const_iterator  cend() const noexcept;
+
+    bool            empty() const noexcept;
+    size_type       size() const noexcept;
+
+    T&              front() noexcept;
+    T const&        front() const noexcept;
+    T&              back() noexcept;
+    T const&        back() const noexcept;
+
+    void            push_front(T& obj);
+    void            push_back(T& obj);
+    void            pop_front() noexcept;
+    void            pop_back() noexcept;
+    iterator        insert(const_iterator pos, T& obj);
+    iterator        erase(const_iterator pos) noexcept;
+    void            remove(T& obj) noexcept;
+
+    void            clear() noexcept;
+    void            swap(rhx_intrusive_list& other) noexcept;
+
+    iterator        iterator_to(T& obj) noexcept;
+    const_iterator  iterator_to(T const& obj) const noexcept;
+
+    template<class V>
+    void            trace(V& visitor);
+    template<class V>
+    static  void    trace_hook(T& obj, V& visitor);
+
+  private:
+    using hook_pointer   = typename hook_type::pointer;
+    using object_pointer = typename std::pointer_traits<VP>::template rebind<T>;
+
+    hook_pointer    m_first;
+    hook_pointer    m_last;
+    size_type       m_size;
+
+  private:
+    static  hook_type*  raw(hook_pointer const& p) noexcept;
+    static  hook_type*  hook_of(T const& obj) noexcept;
+    static  T*          object_of(hook_type* phook) noexcept;
+
+    template<class V>
+    static  void        trace_link(hook_pointer& link, V& visitor);
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_intrusive_tree<T,VP,C,Tag>
+//
+//  Summary:
+//      This class template implements an ordered set of objects of type T, which must derive
+//      from rhx_tree_hook<VP,Tag>, as a red-black tree.  As with rhx_intrusive_list, the tree
+//      holds only a pointer to its root and the root's parent is null, so the tree relocates
+//      with its heap and can be moved.  Objects are ordered by C, and insert() refuses an
+//      object equivalent to one already linked.  The lookup functions take any key that C can
+//      compare with T in both orders, so that an index can be searched without constructing an
+//      object.  The rebalancing works entirely on the hooks' own pointers, so that linking an
+//      object translates only the pointer to it.  Iterators hold ordinary pointers, and are
+//      invalidated by relocation of the heap.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class C = std::less<T>, class Tag = rhx_default_hook_tag>
+class rhx_intrusive_tree
+{
+  public:
+    using value_type        = T;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = T&;
+    using const_reference   = T const&;
+    using value_compare     = C;
+    using hook_type         = rhx_tree_hook<VP, Tag>;
+
+  private:
+    template<bool IsConst> class iterator_type;
+
+  public:
+    using iterator          = iterator_type<false>;
+    using const_iterator    = iterator_type<true>;
+
+  public:
+    ~rhx_intrusive_tree();
+
+    rhx_intrusive_tree();
+    rhx_intrusive_tree(rhx_intrusive_tree&& other) noexcept;
+    rhx_intrusive_tree(rhx_intrusive_tree const&) = delete;
+    explicit rhx_intrusive_tree(C const& comp);
+
+    rhx_intrusive_tree&     operator =(rhx_intrusive_tree&& rhs) noexcept;
+    rhx_intrusive_tree&     operator =(rhx_intrusive_tree const&) = delete;
+
+    iterator        begin() noexcept;
+    const_iterator  begin() const noexcept;
+    const_iterator  cbegin() const noexcept;
+    iterator        end() noexcept;
+    const_iterator  end() const noexcept;
+    const_iterator  cend() const noexcept;
+
+    bool            empty() const noexcept;
+    size_type       size() const noexcept;
+
+    std::pair<iterator, bool>   insert(T& obj);
+    iterator        erase(const_iterator pos) noexcept;
+    void            remove(T& obj) noexcept;
+
+    void            clear() noexcept;
+    void            swap(rhx_intrusive_tree& other) noexcept;
+
+    template<class K>
+    iterator        find(K const& key);
+    template<class K>
+    const_iterator  find(K const& key) const;
+    template<class K>
+    bool            contains(K const& key) const;
+    template<class K>
+    iterator        lower_bound(K const& key);
+    template<class K>
+    const_iterator  lower_bound(K const& key) const;
+    template<class K>
+    iterator        upper_bound(K const& key);
+    template<class K>
+    const_iterator  upper_bound(K const& key) const;
+
+    iterator        iterator_to(T& obj) noexcept;
+    const_iterator  iterator_to(T const& obj) const noexcept;
+    value_compare   value_comp() const;
+
+    template<class V>
+    void            trace(V& visitor);
+    template<class V>
+    static  void    trace_hook(T& obj, V& visitor);
+
+  private:
+    using hook_pointer   = typename hook_type::pointer;
+    using object_pointer = typename std::pointer_traits<VP>::template rebind<T>;
+
+    hook_pointer    m_root;
+    size_type       m_size;
+    C               m_comp;
+
+  private:
+    static  hook_type*  raw(hook_pointer const& p) noexcept;
+    static  hook_type*  hook_of(T const& obj) noexcept;
+    static  T*          object_of(hook_type* phook) noexcept;
+    static  bool        is_red(hook_pointer const& p) noexcept;
+    static  hook_type*  leftmost(hook_type* phook) noexcept;
+    static  hook_type*  rightmost(hook_type* phook) noexcept;
+    static  hook_type*  successor(hook_type* phook) noexcept;
+    static  hook_type*  predecessor(hook_type* phook) noexcept;
+
+    template<class V>
+    static  void        trace_link(hook_pointer& link, V& visitor);
+
+    template<class K>
+    hook_type*      lower_bound_hook(K const& key) const;
+    template<class K>
+    hook_type*      upper_bound_hook(K const& key) const;
+
+    void            rotate_left(hook_pointer x) noexcept;
+    void            rotate_right(hook_pointer x) noexcept;
+    void            replace_child(hook_pointer const& u, hook_pointer const& v) noexcept;
+    void            insert_fixup(hook_pointer z) noexcept;
+    void            erase_fixup(hook_pointer x, hook_pointer xp) noexcept;
+    void            unlink(hook_pointer z) noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_intrusive_hash<T,VP,H,E,A,Tag>
+//
+//  Summary:
+//      This class template implements an unordered set of objects of type T, which must derive
+//      from rhx_hash_hook<VP,Tag>, as a table of singly-linked chains.  The only memory the
+//      container allocates is its array of bucket heads, which comes from A and doubles when
+//      the table holds as many objects as buckets; each hook records its object's hash value,
+//      so that rehashing only relinks the chains.  The lookup functions take any key that H
+//      hashes as it hashes the equivalent object, and that E compares with T.  Iterators hold
+//      ordinary pointers, and are invalidated by rehashing and by relocation of the heap.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class H = std::hash<T>, class E = std::equal_to<T>,
+         class A = std::allocator<T>, class Tag = rhx_default_hook_tag>
+class rhx_intrusive_hash
+{
+  public:
+    using value_type        = T;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = T&;
+    using const_reference   = T const&;
+    using hasher            = H;
+    using key_equal         = E;
+    using allocator_type    = A;
+    using hook_type         = rhx_hash_hook<VP, Tag>;
+
+  private:
+    template<bool IsConst> class iterator_type;
+
+  public:
+    using iterator          = iterator_type<false>;
+    using const_iterator    = iterator_type<true>;
+
+  public:
+    ~rhx_intrusive_hash();
+
+    rhx_intrusive_hash();
+    rhx_intrusive_hash(rhx_intrusive_hash const&) = delete;
+    explicit rhx_intrusive_hash(H const& h, E const& e = E(), A const& a = A());
+
+    rhx_intrusive_hash&     operator =(rhx_intrusive_hash const&) = delete;
+
+    iterator        begin() noexcept;
+    const_iterator  begin() const noexcept;
+    const_iterator  cbegin() const noexcept;
+    iterator        end() noexcept;
+    const_iterator  end() const noexcept;
+    const_iterator  cend() const noexcept;
+
+    bool            empty() const noexcept;
+    size_type       size() const noexcept;
+    size_type       bucket_count() const noexcept;
+
+    std::pair<iterator, bool>   insert(T& obj);
+    iterator        erase(const_iterator pos) noexcept;
+    void            remove(T& obj) noexcept;
+
+    void            clear() noexcept;
+    void            rehash(size_type n);
+
+    template<class K>
+    iterator        find(K const& key);
+    template<class K>
+    const_iterator  find(K const& key) const;
+    template<class K>
+    bool            contains(K const& key) const;
+
+    iterator        iterator_to(T& obj) noexcept;
+    const_iterator  iterator_to(T const& obj) const noexcept;
+    allocator_type  get_allocator() const;
+
+    template<class V>
+    void            trace(V& visitor);
+    template<class V>
+    static  void    trace_hook(T& obj, V& visitor);
+
+  private:
+    using hook_pointer   = typename hook_type::pointer;
+    using object_pointer = typename std::pointer_traits<VP>::template rebind<T>;
+    using bucket_alloc   = typename std::allocator_traits<A>::template rebind_alloc<hook_pointer>;
+    using bucket_traits  = std::allocator_traits<bucket_alloc>;
+    using bucket_pointer = typename bucket_traits::pointer;
+
+    enum : size_type
+    {
+        min_buckets = 16
+    };
+
+    bucket_pointer  m_buckets;
+    size_type       m_bucket_count;         //- Zero, or a power of two
+    size_type       m_size;
+    hasher          m_hash;
+    key_equal       m_equal;
+    allocator_type  m_alloc;
+
+  private:
+    static  hook_type*  raw(hook_pointer const& p) noexcept;
+    static  hook_type*  hook_of(T const& obj) noexcept;
+    static  T*          object_of(hook_type* phook) noexcept;
+    template<class V>
+    static  void        trace_link(hook_pointer& link, V& visitor);
+
+    hook_pointer*   buckets() const noexcept;
+    size_type       bucket_index(uint64_t hash) const noexcept;
+    hook_type*      first_from(size_type index) const noexcept;
+
+    template<class K>
+    hook_type*      find_hook(K const& key, uint64_t hash) const;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_list_hook<VP,Tag>, rhx_tree_hook<VP,Tag>, rhx_hash_hook<VP,Tag>
+//--------------------------------------------------------------------------------------------------
+//
+template<class VP, class Tag> inline
+rhx_list_hook<VP, Tag>::rhx_list_hook() noexcept
+:   m_next(nullptr)
+,   m_prev(nullptr)
+{}
+
+template<class VP, class Tag> inline
+rhx_list_hook<VP, Tag>::rhx_list_hook(rhx_list_hook const&) noexcept
+:   m_next(nullptr)
+,   m_prev(nullptr)
+{}
+
+template<class VP, class Tag> inline
+rhx_list_hook<VP, Tag>&
+rhx_list_hook<VP, Tag>::operator =(rhx_list_hook const&) noexcept
+{
+    return *this;
+}
+
+template<class VP, class Tag> inline
+rhx_tree_hook<VP, Tag>::rhx_tree_hook() noexcept
+:   m_parent(nullptr)
+,   m_left(nullptr)
+,   m_right(nullptr)
+,   m_red(0)
+{}
+
+template<class VP, class Tag> inline
+rhx_tree_hook<VP, Tag>::rhx_tree_hook(rhx_tree_hook const&) noexcept
+:   m_parent(nullptr)
+,   m_left(nullptr)
+,   m_right(nullptr)
+,   m_red(0)
+{}
+
+template<class VP, class Tag> inline
+rhx_tree_hook<VP, Tag>&
+rhx_tree_hook<VP, Tag>::operator =(rhx_tree_hook const&) noexcept
+{
+    return *this;
+}
+
+template<class VP, class Tag> inline
+rhx_hash_hook<VP, Tag>::rhx_hash_hook() noexcept
+:   m_next(nullptr)
+,   m_hash(0)
+{}
+
+template<class VP, class Tag> inline
+rhx_hash_hook<VP, Tag>::rhx_hash_hook(rhx_hash_hook const&) noexcept
+:   m_next(nullptr)
+,   m_hash(0)
+{}
+
+template<class VP, class Tag> inline
+rhx_hash_hook<VP, Tag>&
+rhx_hash_hook<VP, Tag>::operator =(rhx_hash_hook const&) noexcept
+{
+    return *this;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_intrusive_list<T,VP,Tag>::iterator_type<IsConst>
+//
+//  Summary:
+//      Bidirectional iterator over the objects in an intrusive list.  The end iterator holds a
+//      null hook and a pointer to its list, from which it can be decremented.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class Tag>
+template<bool IsConst>
+class rhx_intrusive_list<T, VP, Tag>::iterator_type
+{
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = typename std::conditional<IsConst, T const&, T&>::type;
+    using pointer           = typename std::conditional<IsConst, T const*, T*>::type;
+
+  public:
+    iterator_type() noexcept = default;
+    template<bool B, typename std::enable_if<IsConst && !B, bool>::type = true>
+    iterator_type(iterator_type<B> const& other) noexcept;
+
+    reference       operator  *() const noexcept;
+    pointer         operator ->() const noexcept;
+    iterator_type&  operator ++() noexcept;
+    iterator_type   operator ++(int) noexcept;
+    iterator_type&  operator --() noexcept;
+    iterator_type   operator --(int) noexcept;
+
+    template<bool B>
+    bool    operator ==(iterator_type<B> const& rhs) const noexcept;
+    template<bool B>
+    bool    operator !=(iterator_type<B> const& rhs) const noexcept;
+
+  private:
+    friend class rhx_intrusive_list;
+    template<bool B> friend class iterator_type;
+
+    hook_type*                  mp_hook;
+    rhx_intrusive_list const*   mp_list;
+
+  private:
+    iterator_type(hook_type* phook, rhx_intrusive_list const* plist) noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_intrusive_list<T,VP,Tag>::iterator_type<IsConst>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class Tag>
+template<bool IsConst> inline
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::iterator_type
+(hook_type* phook, rhx_intrusive_list const* plist) noexcept
+:   mp_hook{phook}
+,   mp_list{plist}
+{}
+
+template<class T, class VP, class Tag>
+template<bool IsConst>
+template<bool B, typename std::enable_if<IsConst && !B, bool>::type> inline
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::iterator_type
+(iterator_type<B> const& other) noexcept
+:   mp_hook{other.mp_hook}
+,   mp_list{other.mp_list}
+{}
+
+template<class T, class VP, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_list<T, VP, Tag>::template iterator_type<IsConst>::reference
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator *() const noexcept
+{
+    return *object_of(mp_hook);
+}
+
+template<class T, class VP, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_list<T, VP, Tag>::template iterator_type<IsConst>::pointer
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator ->() const noexcept
+{
+    return object_of(mp_hook);
+}
+
+template<class T, class VP, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_list<T, VP, Tag>::template iterator_type<IsConst>&
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator ++() noexcept
+{
+    mp_hook = raw(mp_hook->m_next);
+    return *this;
+}
+
+template<class T, class VP, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_list<T, VP, Tag>::template iterator_type<IsConst>
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator ++(int) noexcept
+{
+    iterator_type   tmp{*this};
+    ++(*this);
+    return tmp;
+}
+
+template<class T, class VP, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_list<T, VP, Tag>::template iterator_type<IsConst>&
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator --() noexcept
+{
+    mp_hook = (mp_hook == nullptr) ? raw(mp_list->m_last) : raw(mp_hook->m_prev);
+    return *this;
+}
+
+template<class T, class VP, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_list<T, VP, Tag>::template iterator_type<IsConst>
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator --(int) noexcept
+{
+    iterator_type   tmp{*this};
+    --(*this);
+    return tmp;
+}
+
+template<class T, class VP, class Tag>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator ==
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_hook == rhs.mp_hook;
+}
+
+template<class T, class VP, class Tag>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_intrusive_list<T, VP, Tag>::iterator_type<IsConst>::operator !=
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_hook != rhs.mp_hook;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_intrusive_list<T,VP,Tag>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class Tag> inline
+rhx_intrusive_list<T, VP, Tag>::~rhx_intrusive_list()
+{
+    clear();
+}
+
+template<class T, class VP, class Tag> inline
+rhx_intrusive_list<T, VP, Tag>::rhx_intrusive_list() noexcept
+:   m_first(nullptr)
+,   m_last(nullptr)
+,   m_size(0)
+{}
+
+template<class T, class VP, class Tag> inline
+rhx_intrusive_list<T, VP, Tag>::rhx_intrusive_list(rhx_intrusive_list&& other) noexcept
+:   m_first(other.m_first)
+,   m_last(other.m_last)
+,   m_size(other.m_size)
+{
+    other.m_first = nullptr;
+    other.m_last  = nullptr;
+    other.m_size  = 0;
+}
+
+template<class T, class VP, class Tag> inline
+rhx_intrusive_list<T, VP, Tag>&
+rhx_intrusive_list<T, VP, Tag>::operator =(rhx_intrusive_list&& rhs) noexcept
+{
+    if (&rhs != this)
+    {
+        clear();
+        swap(rhs);
+    }
+    return *this;
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::iterator
+rhx_intrusive_list<T, VP, Tag>::begin() noexcept
+{
+    return iterator(raw(m_first), this);
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::const_iterator
+rhx_intrusive_list<T, VP, Tag>::begin() const noexcept
+{
+    return const_iterator(raw(m_first), this);
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::const_iterator
+rhx_intrusive_list<T, VP, Tag>::cbegin() const noexcept
+{
+    return begin();
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::iterator
+rhx_intrusive_list<T, VP, Tag>::end() noexcept
+{
+    return iterator(nullptr, this);
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::const_iterator
+rhx_intrusive_list<T, VP, Tag>::end() const noexcept
+{
+    return const_iterator(nullptr, this);
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::const_iterator
+rhx_intrusive_list<T, VP, Tag>::cend() const noexcept
+{
+    return end();
+}
+
+template<class T, class VP, class Tag> inline
+bool
+rhx_intrusive_list<T, VP, Tag>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::size_type
+rhx_intrusive_list<T, VP, Tag>::size() const noexcept
+{
+    return m_size;
+}
+
+template<class T, class VP, class Tag> inline
+T&
+rhx_intrusive_list<T, VP, Tag>::front() noexcept
+{
+    return *object_of(raw(m_first));
+}
+
+template<class T, class VP, class Tag> inline
+T const&
+rhx_intrusive_list<T, VP, Tag>::front() const noexcept
+{
+    return *object_of(raw(m_first));
+}
+
+template<class T, class VP, class Tag> inline
+T&
+rhx_intrusive_list<T, VP, Tag>::back() noexcept
+{
+    return *object_of(raw(m_last));
+}
+
+template<class T, class VP, class Tag> inline
+T const&
+rhx_intrusive_list<T, VP, Tag>::back() const noexcept
+{
+    return *object_of(raw(m_last));
+}
+
+template<class T, class VP, class Tag> inline
+void
+rhx_intrusive_list<T, VP, Tag>::push_front(T& obj)
+{
+    insert(begin(), obj);
+}
+
+template<class T, class VP, class Tag> inline
+void
+rhx_intrusive_list<T, VP, Tag>::push_back(T& obj)
+{
+    insert(end(), obj);
+}
+
+template<class T, class VP, class Tag> inline
+void
+rhx_intrusive_list<T, VP, Tag>::pop_front() noexcept
+{
+    erase(begin());
+}
+
+template<class T, class VP, class Tag> inline
+void
+rhx_intrusive_list<T, VP, Tag>::pop_back() noexcept
+{
+    erase(iterator(raw(m_last), this));
+}
+
+//- Links obj ahead of pos.  The object must not already be linked by this hook.
+//
+template<class T, class VP, class Tag>
+typename rhx_intrusive_list<T, VP, Tag>::iterator
+rhx_intrusive_list<T, VP, Tag>::insert(const_iterator pos, T& obj)
+{
+    hook_type*      phook = hook_of(obj);
+    hook_pointer    hp    = std::pointer_traits<hook_pointer>::pointer_to(*phook);
+
+    if (pos.mp_hook == nullptr)
+    {
+        phook->m_next = nullptr;
+        phook->m_prev = m_last;
+        if (m_last)
+        {
+            m_last->m_next = hp;
+        }
+        else
+        {
+            m_first = hp;
+        }
+        m_last = hp;
+    }
+    else
+    {
+        hook_type*  pnext = pos.mp_hook;
+
+        phook->m_next = std::pointer_traits<hook_pointer>::pointer_to(*pnext);
+        phook->m_prev = pnext->m_prev;
+        if (pnext->m_prev)
+        {
+            pnext->m_prev->m_next = hp;
+        }
+        else
+        {
+            m_first = hp;
+        }
+        pnext->m_prev = hp;
+    }
+
+    ++m_size;
+    return iterator(phook, this);
+}
+
+//- Unlinks the object at pos and returns an iterator to the one after it.
+//
+template<class T, class VP, class Tag>
+typename rhx_intrusive_list<T, VP, Tag>::iterator
+rhx_intrusive_list<T, VP, Tag>::erase(const_iterator pos) noexcept
+{
+    hook_type*  phook = pos.mp_hook;
+    hook_type*  pnext = raw(phook->m_next);
+
+    if (phook->m_prev)
+    {
+        phook->m_prev->m_next = phook->m_next;
+    }
+    else
+    {
+        m_first = phook->m_next;
+    }
+    if (phook->m_next)
+    {
+        phook->m_next->m_prev = phook->m_prev;
+    }
+    else
+    {
+        m_last = phook->m_prev;
+    }
+
+    phook->m_next = nullptr;
+    phook->m_prev = nullptr;
+    --m_size;
+
+    return iterator(pnext, this);
+}
+
+template<class T, class VP, class Tag> inline
+void
+rhx_intrusive_list<T, VP, Tag>::remove(T& obj) noexcept
+{
+    erase(iterator_to(obj));
+}
+
+template<class T, class VP, class Tag>
+void
+rhx_intrusive_list<T, VP, Tag>::clear() noexcept
+{
+    for (hook_type* phook = raw(m_first);  phook != nullptr;  )
+    {
+        hook_type*  pnext = raw(phook->m_next);
+
+        phook->m_next = nullptr;
+        phook->m_prev = nullptr;
+        phook         = pnext;
+    }
+
+    m_first = nullptr;
+    m_last  = nullptr;
+    m_size  = 0;
+}
+
+template<class T, class VP, class Tag> inline
+void
+rhx_intrusive_list<T, VP, Tag>::swap(rhx_intrusive_list& other) noexcept
+{
+    std::swap(m_first, other.m_first);
+    std::swap(m_last, other.m_last);
+    std::swap(m_size, other.m_size);
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::iterator
+rhx_intrusive_list<T, VP, Tag>::iterator_to(T& obj) noexcept
+{
+    return iterator(hook_of(obj), this);
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::const_iterator
+rhx_intrusive_list<T, VP, Tag>::iterator_to(T const& obj) const noexcept
+{
+    return const_iterator(hook_of(obj), this);
+}
+
+//- Reports the first and last objects to a heap compactor's visitor.
+//
+template<class T, class VP, class Tag>
+template<class V> inline
+void
+rhx_intrusive_list<T, VP, Tag>::trace(V& visitor)
+{
+    trace_link(m_first, visitor);
+    trace_link(m_last, visitor);
+}
+
+//- Reports the neighbours of obj in the list to a heap compactor's visitor; called from T's
+//  trace() for each list hook that T has.
+//
+template<class T, class VP, class Tag>
+template<class V> inline
+void
+rhx_intrusive_list<T, VP, Tag>::trace_hook(T& obj, V& visitor)
+{
+    hook_type*  phook = hook_of(obj);
+
+    trace_link(phook->m_next, visitor);
+    trace_link(phook->m_prev, visitor);
+}
+
+//------
+//
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::hook_type*
+rhx_intrusive_list<T, VP, Tag>::raw(hook_pointer const& p) noexcept
+{
+    return rhx_to_address(p);
+}
+
+template<class T, class VP, class Tag> inline
+typename rhx_intrusive_list<T, VP, Tag>::hook_type*
+rhx_intrusive_list<T, VP, Tag>::hook_of(T const& obj) noexcept
+{
+    return const_cast<hook_type*>(static_cast<hook_type const*>(std::addressof(obj)));
+}
+
+template<class T, class VP, class Tag> inline
+T*
+rhx_intrusive_list<T, VP, Tag>::object_of(hook_type* phook) noexcept
+{
+    return static_cast<T*>(phook);
+}
+
+//- Reports the object a link points to, as a pointer to T, to a heap compactor's visitor, and
+//  points the link at the object's hook wherever the visitor leaves the object.
+//
+template<class T, class VP, class Tag>
+template<class V>
+void
+rhx_intrusive_list<T, VP, Tag>::trace_link(hook_pointer& link, V& visitor)
+{
+    if (link)
+    {
+        object_pointer  p = std::pointer_traits<object_pointer>::pointer_to(*object_of(raw(link)));
+
+        visitor(p);
+        link = std::pointer_traits<hook_pointer>::pointer_to(*hook_of(*p));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_intrusive_tree<T,VP,C,Tag>::iterator_type<IsConst>
+//
+//  Summary:
+//      Bidirectional iterator over the objects in an intrusive tree, in order.  The end
+//      iterator holds a null hook and a pointer to its tree, from which it can be decremented.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class C, class Tag>
+template<bool IsConst>
+class rhx_intrusive_tree<T, VP, C, Tag>::iterator_type
+{
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = typename std::conditional<IsConst, T const&, T&>::type;
+    using pointer           = typename std::conditional<IsConst, T const*, T*>::type;
+
+  public:
+    iterator_type() noexcept = default;
+    template<bool B, typename std::enable_if<IsConst && !B, bool>::type = true>
+    iterator_type(iterator_type<B> const& other) noexcept;
+
+    reference       operator  *() const noexcept;
+    pointer         operator ->() const noexcept;
+    iterator_type&  operator ++() noexcept;
+    iterator_type   operator ++(int) noexcept;
+    iterator_type&  operator --() noexcept;
+    iterator_type   operator --(int) noexcept;
+
+    template<bool B>
+    bool    operator ==(iterator_type<B> const& rhs) const noexcept;
+    template<bool B>
+    bool    operator !=(iterator_type<B> const& rhs) const noexcept;
+
+  private:
+    friend class rhx_intrusive_tree;
+    template<bool B> friend class iterator_type;
+
+    hook_type*                  mp_hook;
+    rhx_intrusive_tree const*   mp_tree;
+
+  private:
+    iterator_type(hook_type* phook, rhx_intrusive_tree const* ptree) noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_intrusive_tree<T,VP,C,Tag>::iterator_type<IsConst>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class C, class Tag>
+template<bool IsConst> inline
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::iterator_type
+(hook_type* phook, rhx_intrusive_tree const* ptree) noexcept
+:   mp_hook{phook}
+,   mp_tree{ptree}
+{}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst>
+template<bool B, typename std::enable_if<IsConst && !B, bool>::type> inline
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::iterator_type
+(iterator_type<B> const& other) noexcept
+:   mp_hook{other.mp_hook}
+,   mp_tree{other.mp_tree}
+{}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::template iterator_type<IsConst>::reference
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator *() const noexcept
+{
+    return *object_of(mp_hook);
+}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::template iterator_type<IsConst>::pointer
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator ->() const noexcept
+{
+    return object_of(mp_hook);
+}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::template iterator_type<IsConst>&
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator ++() noexcept
+{
+    mp_hook = successor(mp_hook);
+    return *this;
+}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::template iterator_type<IsConst>
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator ++(int) noexcept
+{
+    iterator_type   tmp{*this};
+    ++(*this);
+    return tmp;
+}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::template iterator_type<IsConst>&
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator --() noexcept
+{
+    mp_hook = (mp_hook == nullptr) ? rightmost(raw(mp_tree->m_root)) : predecessor(mp_hook);
+    return *this;
+}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::template iterator_type<IsConst>
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator --(int) noexcept
+{
+    iterator_type   tmp{*this};
+    --(*this);
+    return tmp;
+}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator ==
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_hook == rhs.mp_hook;
+}
+
+template<class T, class VP, class C, class Tag>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_type<IsConst>::operator !=
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_hook != rhs.mp_hook;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_intrusive_tree<T,VP,C,Tag>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class C, class Tag> inline
+rhx_intrusive_tree<T, VP, C, Tag>::~rhx_intrusive_tree()
+{
+    clear();
+}
+
+template<class T, class VP, class C, class Tag> inline
+rhx_intrusive_tree<T, VP, C, Tag>::rhx_intrusive_tree()
+:   m_root(nullptr)
+,   m_size(0)
+,   m_comp()
+{}
+
+template<class T, class VP, class C, class Tag> inline
+rhx_intrusive_tree<T, VP, C, Tag>::rhx_intrusive_tree(rhx_intrusive_tree&& other) noexcept
+:   m_root(other.m_root)
+,   m_size(other.m_size)
+,   m_comp(other.m_comp)
+{
+    other.m_root = nullptr;
+    other.m_size = 0;
+}
+
+template<class T, class VP, class C, class Tag> inline
+rhx_intrusive_tree<T, VP, C, Tag>::rhx_intrusive_tree(C const& comp)
+:   m_root(nullptr)
+,   m_size(0)
+,   m_comp(comp)
+{}
+
+template<class T, class VP, class C, class Tag> inline
+rhx_intrusive_tree<T, VP, C, Tag>&
+rhx_intrusive_tree<T, VP, C, Tag>::operator =(rhx_intrusive_tree&& rhs) noexcept
+{
+    if (&rhs != this)
+    {
+        clear();
+        swap(rhs);
+    }
+    return *this;
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::iterator
+rhx_intrusive_tree<T, VP, C, Tag>::begin() noexcept
+{
+    return iterator(leftmost(raw(m_root)), this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::begin() const noexcept
+{
+    return const_iterator(leftmost(raw(m_root)), this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::cbegin() const noexcept
+{
+    return begin();
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::iterator
+rhx_intrusive_tree<T, VP, C, Tag>::end() noexcept
+{
+    return iterator(nullptr, this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::end() const noexcept
+{
+    return const_iterator(nullptr, this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::cend() const noexcept
+{
+    return end();
+}
+
+template<class T, class VP, class C, class Tag> inline
+bool
+rhx_intrusive_tree<T, VP, C, Tag>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::size_type
+rhx_intrusive_tree<T, VP, C, Tag>::size() const noexcept
+{
+    return m_size;
+}
+
+//- Links obj into the tree unless an equivalent object is already linked, in which case the
+//  returned iterator refers to that object.
+//
+template<class T, class VP, class C, class Tag>
+std::pair<typename rhx_intrusive_tree<T, VP, C, Tag>::iterator, bool>
+rhx_intrusive_tree<T, VP, C, Tag>::insert(T& obj)
+{
+    hook_pointer    parent(nullptr);
+    hook_pointer    curr = m_root;
+    bool            left = true;
+
+    while (curr)
+    {
+        T const&    other = *object_of(raw(curr));
+
+        parent = curr;
+        if (m_comp(obj, other))
+        {
+            left = true;
+            curr = curr->m_left;
+        }
+        else if (m_comp(other, obj))
+        {
+            left = false;
+            curr = curr->m_right;
+        }
+        else
+        {
+            return std::make_pair(iterator(raw(parent), this), false);
+        }
+    }
+
+    hook_type*      phook = hook_of(obj);
+    hook_pointer    z     = std::pointer_traits<hook_pointer>::pointer_to(*phook);
+
+    phook->m_parent = parent;
+    phook->m_left   = nullptr;
+    phook->m_right  = nullptr;
+    phook->m_red    = 1;
+
+    if (!parent)
+    {
+        m_root = z;
+    }
+    else if (left)
+    {
+        parent->m_left = z;
+    }
+    else
+    {
+        parent->m_right = z;
+    }
+
+    insert_fixup(z);
+    ++m_size;
+
+    return std::make_pair(iterator(phook, this), true);
+}
+
+template<class T, class VP, class C, class Tag>
+typename rhx_intrusive_tree<T, VP, C, Tag>::iterator
+rhx_intrusive_tree<T, VP, C, Tag>::erase(const_iterator pos) noexcept
+{
+    hook_type*  phook = pos.mp_hook;
+    hook_type*  pnext = successor(phook);
+
+    unlink(std::pointer_traits<hook_pointer>::pointer_to(*phook));
+    return iterator(pnext, this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+void
+rhx_intrusive_tree<T, VP, C, Tag>::remove(T& obj) noexcept
+{
+    erase(iterator_to(obj));
+}
+
+//- Unlinks every object, visiting each once without rebalancing.
+//
+template<class T, class VP, class C, class Tag>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::clear() noexcept
+{
+    hook_type*  phook = raw(m_root);
+
+    while (phook != nullptr)
+    {
+        if (phook->m_left)
+        {
+            phook = raw(phook->m_left);
+        }
+        else if (phook->m_right)
+        {
+            phook = raw(phook->m_right);
+        }
+        else
+        {
+            hook_type*  pparent = raw(phook->m_parent);
+
+            if (pparent != nullptr)
+            {
+                if (raw(pparent->m_left) == phook)
+                {
+                    pparent->m_left = nullptr;
+                }
+                else
+                {
+                    pparent->m_right = nullptr;
+                }
+            }
+            phook->m_parent = nullptr;
+            phook->m_red    = 0;
+            phook           = pparent;
+        }
+    }
+
+    m_root = nullptr;
+    m_size = 0;
+}
+
+template<class T, class VP, class C, class Tag> inline
+void
+rhx_intrusive_tree<T, VP, C, Tag>::swap(rhx_intrusive_tree& other) noexcept
+{
+    std::swap(m_root, other.m_root);
+    std::swap(m_size, other.m_size);
+    std::swap(m_comp, other.m_comp);
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K>
+typename rhx_intrusive_tree<T, VP, C, Tag>::iterator
+rhx_intrusive_tree<T, VP, C, Tag>::find(K const& key)
+{
+    hook_type*  phook = lower_bound_hook(key);
+
+    if (phook != nullptr  &&  m_comp(key, *object_of(phook)))
+    {
+        phook = nullptr;
+    }
+    return iterator(phook, this);
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K>
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::find(K const& key) const
+{
+    return const_cast<rhx_intrusive_tree*>(this)->find(key);
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K> inline
+bool
+rhx_intrusive_tree<T, VP, C, Tag>::contains(K const& key) const
+{
+    return find(key) != end();
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::iterator
+rhx_intrusive_tree<T, VP, C, Tag>::lower_bound(K const& key)
+{
+    return iterator(lower_bound_hook(key), this);
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::lower_bound(K const& key) const
+{
+    return const_iterator(lower_bound_hook(key), this);
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::iterator
+rhx_intrusive_tree<T, VP, C, Tag>::upper_bound(K const& key)
+{
+    return iterator(upper_bound_hook(key), this);
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::upper_bound(K const& key) const
+{
+    return const_iterator(upper_bound_hook(key), this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::iterator
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_to(T& obj) noexcept
+{
+    return iterator(hook_of(obj), this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::const_iterator
+rhx_intrusive_tree<T, VP, C, Tag>::iterator_to(T const& obj) const noexcept
+{
+    return const_iterator(hook_of(obj), this);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::value_compare
+rhx_intrusive_tree<T, VP, C, Tag>::value_comp() const
+{
+    return m_comp;
+}
+
+//- Reports the root object to a heap compactor's visitor.
+//
+template<class T, class VP, class C, class Tag>
+template<class V> inline
+void
+rhx_intrusive_tree<T, VP, C, Tag>::trace(V& visitor)
+{
+    trace_link(m_root, visitor);
+}
+
+//- Reports the parent and children of obj in the tree to a heap compactor's visitor; called
+//  from T's trace() for each tree hook that T has.
+//
+template<class T, class VP, class C, class Tag>
+template<class V> inline
+void
+rhx_intrusive_tree<T, VP, C, Tag>::trace_hook(T& obj, V& visitor)
+{
+    hook_type*  phook = hook_of(obj);
+
+    trace_link(phook->m_parent, visitor);
+    trace_link(phook->m_left, visitor);
+    trace_link(phook->m_right, visitor);
+}
+
+//------
+//
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::raw(hook_pointer const& p) noexcept
+{
+    return rhx_to_address(p);
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::hook_of(T const& obj) noexcept
+{
+    return const_cast<hook_type*>(static_cast<hook_type const*>(std::addressof(obj)));
+}
+
+template<class T, class VP, class C, class Tag> inline
+T*
+rhx_intrusive_tree<T, VP, C, Tag>::object_of(hook_type* phook) noexcept
+{
+    return static_cast<T*>(phook);
+}
+
+//- Reports the object a link points to, as a pointer to T, to a heap compactor's visitor, and
+//  points the link at the object's hook wherever the visitor leaves the object.
+//
+template<class T, class VP, class C, class Tag>
+template<class V>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::trace_link(hook_pointer& link, V& visitor)
+{
+    if (link)
+    {
+        object_pointer  p = std::pointer_traits<object_pointer>::pointer_to(*object_of(raw(link)));
+
+        visitor(p);
+        link = std::pointer_traits<hook_pointer>::pointer_to(*hook_of(*p));
+    }
+}
+
+//- Null links are leaves, which are black.
+//
+template<class T, class VP, class C, class Tag> inline
+bool
+rhx_intrusive_tree<T, VP, C, Tag>::is_red(hook_pointer const& p) noexcept
+{
+    return p  &&  p->m_red != 0;
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::leftmost(hook_type* phook) noexcept
+{
+    if (phook != nullptr)
+    {
+        while (phook->m_left)
+        {
+            phook = raw(phook->m_left);
+        }
+    }
+    return phook;
+}
+
+template<class T, class VP, class C, class Tag> inline
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::rightmost(hook_type* phook) noexcept
+{
+    if (phook != nullptr)
+    {
+        while (phook->m_right)
+        {
+            phook = raw(phook->m_right);
+        }
+    }
+    return phook;
+}
+
+template<class T, class VP, class C, class Tag>
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::successor(hook_type* phook) noexcept
+{
+    if (phook->m_right)
+    {
+        return leftmost(raw(phook->m_right));
+    }
+
+    hook_type*  pparent = raw(phook->m_parent);
+
+    while (pparent != nullptr  &&  raw(pparent->m_right) == phook)
+    {
+        phook   = pparent;
+        pparent = raw(pparent->m_parent);
+    }
+    return pparent;
+}
+
+template<class T, class VP, class C, class Tag>
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::predecessor(hook_type* phook) noexcept
+{
+    if (phook->m_left)
+    {
+        return rightmost(raw(phook->m_left));
+    }
+
+    hook_type*  pparent = raw(phook->m_parent);
+
+    while (pparent != nullptr  &&  raw(pparent->m_left) == phook)
+    {
+        phook   = pparent;
+        pparent = raw(pparent->m_parent);
+    }
+    return pparent;
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K>
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::lower_bound_hook(K const& key) const
+{
+    hook_type*  phook  = raw(m_root);
+    hook_type*  pbound = nullptr;
+
+    while (phook != nullptr)
+    {
+        if (m_comp(*object_of(phook), key))
+        {
+            phook = raw(phook->m_right);
+        }
+        else
+        {
+            pbound = phook;
+            phook  = raw(phook->m_left);
+        }
+    }
+    return pbound;
+}
+
+template<class T, class VP, class C, class Tag>
+template<class K>
+typename rhx_intrusive_tree<T, VP, C, Tag>::hook_type*
+rhx_intrusive_tree<T, VP, C, Tag>::upper_bound_hook(K const& key) const
+{
+    hook_type*  phook  = raw(m_root);
+    hook_type*  pbound = nullptr;
+
+    while (phook != nullptr)
+    {
+        if (m_comp(key, *object_of(phook)))
+        {
+            pbound = phook;
+            phook  = raw(phook->m_left);
+        }
+        else
+        {
+            phook = raw(phook->m_right);
+        }
+    }
+    return pbound;
+}
+
+template<class T, class VP, class C, class Tag>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::rotate_left(hook_pointer x) noexcept
+{
+    hook_pointer    y = x->m_right;
+
+    x->m_right = y->m_left;
+    if (y->m_left)
+    {
+        y->m_left->m_parent = x;
+    }
+    replace_child(x, y);
+    y->m_left   = x;
+    x->m_parent = y;
+}
+
+template<class T, class VP, class C, class Tag>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::rotate_right(hook_pointer x) noexcept
+{
+    hook_pointer    y = x->m_left;
+
+    x->m_left = y->m_right;
+    if (y->m_right)
+    {
+        y->m_right->m_parent = x;
+    }
+    replace_child(x, y);
+    y->m_right  = x;
+    x->m_parent = y;
+}
+
+//- Puts v where u hangs from u's parent, and makes u's parent v's parent.
+//
+template<class T, class VP, class C, class Tag>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::replace_child
+(hook_pointer const& u, hook_pointer const& v) noexcept
+{
+    hook_pointer    parent = u->m_parent;
+
+    if (!parent)
+    {
+        m_root = v;
+    }
+    else if (parent->m_left == u)
+    {
+        parent->m_left = v;
+    }
+    else
+    {
+        parent->m_right = v;
+    }
+    if (v)
+    {
+        v->m_parent = parent;
+    }
+}
+
+template<class T, class VP, class C, class Tag>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::insert_fixup(hook_pointer z) noexcept
+{
+    while (z != m_root  &&  is_red(z->m_parent))
+    {
+        hook_pointer    p = z->m_parent;
+        hook_pointer    g = p->m_parent;
+
+        if (p == g->m_left)
+        {
+            hook_pointer    u = g->m_right;
+
+            if (is_red(u))
+            {
+                p->m_red = 0;
+                u->m_red = 0;
+                g->m_red = 1;
+                z = g;
+            }
+            else
+            {
+                if (z == p->m_right)
+                {
+                    z = p;
+                    rotate_left(z);
+                    p = z->m_parent;
+                }
+                p->m_red = 0;
+                g->m_red = 1;
+                rotate_right(g);
+            }
+        }
+        else
+        {
+            hook_pointer    u = g->m_left;
+
+            if (is_red(u))
+            {
+                p->m_red = 0;
+                u->m_red = 0;
+                g->m_red = 1;
+                z = g;
+            }
+            else
+            {
+                if (z == p->m_left)
+                {
+                    z = p;
+                    rotate_right(z);
+                    p = z->m_parent;
+                }
+                p->m_red = 0;
+                g->m_red = 1;
+                rotate_left(g);
+            }
+        }
+    }
+    m_root->m_red = 0;
+}
+
+//- Restores the red-black properties after a black hook has been removed from above x, which
+//  may be null; xp is x's parent.
+//
+template<class T, class VP, class C, class Tag>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::erase_fixup(hook_pointer x, hook_pointer xp) noexcept
+{
+    while (x != m_root  &&  !is_red(x))
+    {
+        if (x == xp->m_left)
+        {
+            hook_pointer    w = xp->m_right;
+
+            if (is_red(w))
+            {
+                w->m_red  = 0;
+                xp->m_red = 1;
+                rotate_left(xp);
+                w = xp->m_right;
+            }
+            if (!is_red(w->m_left)  &&  !is_red(w->m_right))
+            {
+                w->m_red = 1;
+                x  = xp;
+                xp = xp->m_parent;
+            }
+            else
+            {
+                if (!is_red(w->m_right))
+                {
+                    w->m_left->m_red = 0;
+                    w->m_red = 1;
+                    rotate_right(w);
+                    w = xp->m_right;
+                }
+                w->m_red  = xp->m_red;
+                xp->m_red = 0;
+                w->m_right->m_red = 0;
+                rotate_left(xp);
+                x = m_root;
+            }
+        }
+        else
+        {
+            hook_pointer    w = xp->m_left;
+
+            if (is_red(w))
+            {
+                w->m_red  = 0;
+                xp->m_red = 1;
+                rotate_right(xp);
+                w = xp->m_left;
+            }
+            if (!is_red(w->m_right)  &&  !is_red(w->m_left))
+            {
+                w->m_red = 1;
+                x  = xp;
+                xp = xp->m_parent;
+            }
+            else
+            {
+                if (!is_red(w->m_left))
+                {
+                    w->m_right->m_red = 0;
+                    w->m_red = 1;
+                    rotate_left(w);
+                    w = xp->m_left;
+                }
+                w->m_red  = xp->m_red;
+                xp->m_red = 0;
+                w->m_left->m_red = 0;
+                rotate_right(xp);
+                x = m_root;
+            }
+        }
+    }
+    if (x)
+    {
+        x->m_red = 0;
+    }
+}
+
+//- Removes z from the tree.  When z has two children, its successor y takes its place, so
+//  that no object other than z changes its position relative to the others.
+//
+template<class T, class VP, class C, class Tag>
+void
+rhx_intrusive_tree<T, VP, C, Tag>::unlink(hook_pointer z) noexcept
+{
+    hook_pointer    x(nullptr);
+    hook_pointer    xp(nullptr);
+    bool            removed_red = z->m_red != 0;
+
+    if (!z->m_left)
+    {
+        x  = z->m_right;
+        xp = z->m_parent;
+        replace_child(z, x);
+    }
+    else if (!z->m_right)
+    {
+        x  = z->m_left;
+        xp = z->m_parent;
+        replace_child(z, x);
+    }
+    else
+    {
+        hook_pointer    y = z->m_right;
+
+        while (y->m_left)
+        {
+            y = y->m_left;
+        }
+        removed_red = y->m_red != 0;
+        x = y->m_right;
+
+        if (y->m_parent == z)
+        {
+            xp = y;
+        }
+        else
+        {
+            xp = y->m_parent;
+            replace_child(y, x);
+            y->m_right = z->m_right;
+            y->m_right->m_parent = y;
+        }
+        replace_child(z, y);
+        y->m_left = z->m_left;
+        y->m_left->m_parent = y;
+        y->m_red  = z->m_red;
+    }
+
+    if (!removed_red)
+    {
+        erase_fixup(x, xp);
+    }
+
+    z->m_parent = nullptr;
+    z->m_left   = nullptr;
+    z->m_right  = nullptr;
+    z->m_red    = 0;
+    --m_size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_intrusive_hash<T,VP,H,E,A,Tag>::iterator_type<IsConst>
+//
+//  Summary:
+//      Forward iterator over the objects in an intrusive hash table, chain by chain.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst>
+class rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type
+{
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = typename std::conditional<IsConst, T const&, T&>::type;
+    using pointer           = typename std::conditional<IsConst, T const*, T*>::type;
+
+  public:
+    iterator_type() noexcept = default;
+    template<bool B, typename std::enable_if<IsConst && !B, bool>::type = true>
+    iterator_type(iterator_type<B> const& other) noexcept;
+
+    reference       operator  *() const noexcept;
+    pointer         operator ->() const noexcept;
+    iterator_type&  operator ++() noexcept;
+    iterator_type   operator ++(int) noexcept;
+
+    template<bool B>
+    bool    operator ==(iterator_type<B> const& rhs) const noexcept;
+    template<bool B>
+    bool    operator !=(iterator_type<B> const& rhs) const noexcept;
+
+  private:
+    friend class rhx_intrusive_hash;
+    template<bool B> friend class iterator_type;
+
+    hook_type*                  mp_hook;
+    rhx_intrusive_hash const*   mp_table;
+
+  private:
+    iterator_type(hook_type* phook, rhx_intrusive_hash const* ptable) noexcept;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_intrusive_hash<T,VP,H,E,A,Tag>::iterator_type<IsConst>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst> inline
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::iterator_type
+(hook_type* phook, rhx_intrusive_hash const* ptable) noexcept
+:   mp_hook{phook}
+,   mp_table{ptable}
+{}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst>
+template<bool B, typename std::enable_if<IsConst && !B, bool>::type> inline
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::iterator_type
+(iterator_type<B> const& other) noexcept
+:   mp_hook{other.mp_hook}
+,   mp_table{other.mp_table}
+{}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::template iterator_type<IsConst>::reference
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::operator *() const noexcept
+{
+    return *object_of(mp_hook);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::template iterator_type<IsConst>::pointer
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::operator ->() const noexcept
+{
+    return object_of(mp_hook);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::template iterator_type<IsConst>&
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::operator ++() noexcept
+{
+    mp_hook = mp_hook->m_next ? raw(mp_hook->m_next)
+                              : mp_table->first_from(mp_table->bucket_index(mp_hook->m_hash) + 1);
+    return *this;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::template iterator_type<IsConst>
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::operator ++(int) noexcept
+{
+    iterator_type   tmp{*this};
+    ++(*this);
+    return tmp;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::operator ==
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_hook == rhs.mp_hook;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<bool IsConst>
+template<bool B> inline
+bool
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_type<IsConst>::operator !=
+(iterator_type<B> const& rhs) const noexcept
+{
+    return mp_hook != rhs.mp_hook;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_intrusive_hash<T,VP,H,E,A,Tag>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::~rhx_intrusive_hash()
+{
+    clear();
+    if (m_bucket_count != 0)
+    {
+        bucket_alloc    balloc(m_alloc);
+        bucket_traits::deallocate(balloc, m_buckets, m_bucket_count);
+    }
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::rhx_intrusive_hash()
+:   m_buckets(nullptr)
+,   m_bucket_count(0)
+,   m_size(0)
+,   m_hash()
+,   m_equal()
+,   m_alloc()
+{}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::rhx_intrusive_hash(H const& h, E const& e, A const& a)
+:   m_buckets(nullptr)
+,   m_bucket_count(0)
+,   m_size(0)
+,   m_hash(h)
+,   m_equal(e)
+,   m_alloc(a)
+{}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::begin() noexcept
+{
+    return iterator(first_from(0), this);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::const_iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::begin() const noexcept
+{
+    return const_iterator(first_from(0), this);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::const_iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::cbegin() const noexcept
+{
+    return begin();
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::end() noexcept
+{
+    return iterator(nullptr, this);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::const_iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::end() const noexcept
+{
+    return const_iterator(nullptr, this);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::const_iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::cend() const noexcept
+{
+    return end();
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+bool
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::size_type
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::size() const noexcept
+{
+    return m_size;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::size_type
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::bucket_count() const noexcept
+{
+    return m_bucket_count;
+}
+
+//- Links obj at the head of its chain unless an equal object is already linked, in which case
+//  the returned iterator refers to that object.  Growing the bucket array is the only step
+//  that can throw, and it happens before anything is linked.
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+std::pair<typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator, bool>
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::insert(T& obj)
+{
+    uint64_t    hash = static_cast<uint64_t>(m_hash(obj));
+
+    if (m_bucket_count != 0)
+    {
+        if (hook_type* pfound = find_hook(obj, hash))
+        {
+            return std::make_pair(iterator(pfound, this), false);
+        }
+    }
+    if (m_size + 1 > m_bucket_count)
+    {
+        rehash((m_bucket_count != 0) ? 2 * m_bucket_count : size_type(min_buckets));
+    }
+
+    hook_type*      phook  = hook_of(obj);
+    hook_pointer&   bucket = buckets()[bucket_index(hash)];
+
+    phook->m_hash = hash;
+    phook->m_next = bucket;
+    bucket        = std::pointer_traits<hook_pointer>::pointer_to(*phook);
+    ++m_size;
+
+    return std::make_pair(iterator(phook, this), true);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::erase(const_iterator pos) noexcept
+{
+    hook_type*      phook = pos.mp_hook;
+    iterator        next(phook, this);
+    hook_pointer*   plink = &buckets()[bucket_index(phook->m_hash)];
+
+    ++next;
+    while (raw(*plink) != phook)
+    {
+        plink = &(*plink)->m_next;
+    }
+
+    *plink        = phook->m_next;
+    phook->m_next = nullptr;
+    phook->m_hash = 0;
+    --m_size;
+
+    return next;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+void
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::remove(T& obj) noexcept
+{
+    erase(iterator_to(obj));
+}
+
+//- Unlinks every object, but keeps the bucket array.
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+void
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::clear() noexcept
+{
+    hook_pointer*   pbuckets = buckets();
+
+    for (size_type i = 0;  i < m_bucket_count;  ++i)
+    {
+        for (hook_type* phook = raw(pbuckets[i]);  phook != nullptr;  )
+        {
+            hook_type*  pnext = raw(phook->m_next);
+
+            phook->m_next = nullptr;
+            phook->m_hash = 0;
+            phook         = pnext;
+        }
+        pbuckets[i] = nullptr;
+    }
+    m_size = 0;
+}
+
+//- Replaces the bucket array with one of at least n buckets (and at least as many buckets as
+//  objects), moving every object to the head of its new chain by its recorded hash value.
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+void
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::rehash(size_type n)
+{
+    size_type   new_count = min_buckets;
+
+    while (new_count < n  ||  new_count < m_size)
+    {
+        new_count *= 2;
+    }
+    if (new_count == m_bucket_count)
+    {
+        return;
+    }
+
+    bucket_alloc    balloc(m_alloc);
+    bucket_pointer  new_buckets = bucket_traits::allocate(balloc, new_count);
+    hook_pointer*   pnew        = std::addressof(*new_buckets);
+    hook_pointer*   pold        = buckets();
+    size_type       old_count   = m_bucket_count;
+
+    for (size_type i = 0;  i < new_count;  ++i)
+    {
+        bucket_traits::construct(balloc, pnew + i, nullptr);
+    }
+
+    m_bucket_count = new_count;
+
+    for (size_type i = 0;  i < old_count;  ++i)
+    {
+        while (pold[i])
+        {
+            hook_pointer    hp    = pold[i];
+            hook_pointer&   dest  = pnew[bucket_index(hp->m_hash)];
+
+            pold[i]    = hp->m_next;
+            hp->m_next = dest;
+            dest       = hp;
+        }
+    }
+
+    if (old_count != 0)
+    {
+        bucket_traits::deallocate(balloc, m_buckets, old_count);
+    }
+    m_buckets = new_buckets;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<class K>
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::find(K const& key)
+{
+    if (m_size == 0)
+    {
+        return end();
+    }
+    return iterator(find_hook(key, static_cast<uint64_t>(m_hash(key))), this);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<class K>
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::const_iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::find(K const& key) const
+{
+    return const_cast<rhx_intrusive_hash*>(this)->find(key);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<class K> inline
+bool
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::contains(K const& key) const
+{
+    return find(key) != end();
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_to(T& obj) noexcept
+{
+    return iterator(hook_of(obj), this);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::const_iterator
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::iterator_to(T const& obj) const noexcept
+{
+    return const_iterator(hook_of(obj), this);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::allocator_type
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::get_allocator() const
+{
+    return m_alloc;
+}
+
+//- Reports the bucket array to a heap compactor's visitor, and then the first object in each
+//  chain.  The buckets point to hooks, not to objects, so the array is reported as untyped and
+//  its links are traced here, wherever the array is at the time.
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+template<class V>
+void
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::trace(V& visitor)
+{
+    using void_pointer = typename std::pointer_traits<bucket_pointer>::template rebind<void>;
+
+    void_pointer    vp = m_buckets;
+
+    visitor(vp);
+    m_buckets = static_cast<bucket_pointer>(vp);
+
+    hook_pointer*   pbuckets = buckets();
+
+    for (size_type i = 0;  i < m_bucket_count;  ++i)
+    {
+        trace_link(pbuckets[i], visitor);
+    }
+}
+
+//- Reports the next object in obj's chain to a heap compactor's visitor; called from T's
+//  trace() for each hash hook that T has.
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+template<class V> inline
+void
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::trace_hook(T& obj, V& visitor)
+{
+    trace_link(hook_of(obj)->m_next, visitor);
+}
+
+//------
+//
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::hook_type*
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::raw(hook_pointer const& p) noexcept
+{
+    return rhx_to_address(p);
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::hook_type*
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::hook_of(T const& obj) noexcept
+{
+    return const_cast<hook_type*>(static_cast<hook_type const*>(std::addressof(obj)));
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+T*
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::object_of(hook_type* phook) noexcept
+{
+    return static_cast<T*>(phook);
+}
+
+//- Reports the object a link points to, as a pointer to T, to a heap compactor's visitor, and
+//  points the link at the object's hook wherever the visitor leaves the object.
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+template<class V>
+void
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::trace_link(hook_pointer& link, V& visitor)
+{
+    if (link)
+    {
+        object_pointer  p = std::pointer_traits<object_pointer>::pointer_to(*object_of(raw(link)));
+
+        visitor(p);
+        link = std::pointer_traits<hook_pointer>::pointer_to(*hook_of(*p));
+    }
+}
+
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::hook_pointer*
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::buckets() const noexcept
+{
+    return (m_bucket_count != 0) ? std::addressof(*m_buckets) : nullptr;
+}
+
+//- Takes the bucket index from the high bits of the mixed hash value, as the flat hash map
+//  does, so that hashers returning their argument still spread sequential keys.
+//
+template<class T, class VP, class H, class E, class A, class Tag> inline
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::size_type
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::bucket_index(uint64_t hash) const noexcept
+{
+    uint64_t    h = hash * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_type>(h ^ (h >> 32)) & (m_bucket_count - 1);
+}
+
+//- Returns the first object in the first non-empty chain at or after index.
+//
+template<class T, class VP, class H, class E, class A, class Tag>
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::hook_type*
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::first_from(size_type index) const noexcept
+{
+    hook_pointer*   pbuckets = buckets();
+
+    for (;  index < m_bucket_count;  ++index)
+    {
+        if (pbuckets[index])
+        {
+            return raw(pbuckets[index]);
+        }
+    }
+    return nullptr;
+}
+
+template<class T, class VP, class H, class E, class A, class Tag>
+template<class K>
+typename rhx_intrusive_hash<T, VP, H, E, A, Tag>::hook_type*
+rhx_intrusive_hash<T, VP, H, E, A, Tag>::find_hook(K const& key, uint64_t hash) const
+{
+    hook_type*  phook = raw(buckets()[bucket_index(hash)]);
+
+    for (;  phook != nullptr;  phook = raw(phook->m_next))
+    {
+        if (phook->m_hash == hash  &&  m_equal(*object_of(phook), key))
+        {
+            return phook;
+        }
+    }
+    return nullptr;
+}
+
+#endif  //- RHX_INTRUSIVE_H_DEFINED
@@ -0,0 +1,460 @@
+//==================================================================================================
+//  File:
+//      rhx_ring_queue.h
+//
+//  Summary:
+//      Defines the rhx_spsc_queue<T,A> and rhx_mpmc_queue<T,A> class templates, bounded
+//      lock-free queues that can live in a relocatable heap.
+//==================================================================================================
+//
+#ifndef RHX_RING_QUEUE_H_DEFINED
+#define RHX_RING_QUEUE_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "rhx_trace_traits.h"
+
+//- The queues may be shared by processes that map the same segments, which requires their
+//  atomic indices to be lock-free (and therefore address-free).
+//
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "rhx ring queues require lock-free 64-bit atomics");
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_spsc_queue<T,A>
+//
+//  Summary:
+//      This class template implements a bounded, lock-free ring queue for one producer thread
+//      and one consumer thread.  Like the other rhx containers, it refers to its slots only
+//      through the allocator's pointer type, and its indices are plain counters, so a queue
+//      constructed in a relocatable heap relocates with the heap; with a heap whose segments
+//      are shared, the producer and consumer may be in different processes.  Typically T is a
+//      synthetic pointer to a message built in the same heap, so that only the pointer is
+//      copied.  A popped slot is reset to T(), so that it no longer refers to its message.
+//      Consumed messages can be handed back to the producer through a second queue running the
+//      other way and reused, so that neither side needs a thread-safe allocator.
+//
+//      The producer's and the consumer's indices are kept on separate cache lines, each with
+//      the owner's cached copy of the other's index; in the steady state neither side reads
+//      the other's line unless the queue appears to be full or empty.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class A = std::allocator<T>>
+class rhx_spsc_queue
+{
+  private:
+    using alloc_traits  = std::allocator_traits<A>;
+
+  public:
+    using value_type        = T;
+    using allocator_type    = A;
+    using size_type         = std::size_t;
+
+  public:
+    ~rhx_spsc_queue();
+    explicit rhx_spsc_queue(size_type capacity, A const& alloc = A());
+
+    rhx_spsc_queue(rhx_spsc_queue const&) = delete;
+    rhx_spsc_queue&     operator =(rhx_spsc_queue const&) = delete;
+
+    bool        try_push(T const& value);
+    bool        try_pop(T& value);
+
+    bool        empty() const noexcept;
+    size_type   size() const noexcept;
+    size_type   capacity() const noexcept;
+
+    template<class V>
+    void        trace(V& visitor);
+
+  private:
+    using pointer = typename alloc_traits::pointer;
+
+    alignas(64) std::atomic<uint64_t>   m_tail;         //- Producer's line
+                uint64_t                m_head_cache;
+    alignas(64) std::atomic<uint64_t>   m_head;         //- Consumer's line
+                uint64_t                m_tail_cache;
+    alignas(64) pointer                 m_slots;        //- Read-only after construction
+                size_type               m_mask;
+                allocator_type          m_alloc;
+
+  private:
+    T&      slot(uint64_t index) const noexcept;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_mpmc_queue<T,A>
+//
+//  Summary:
+//      This class template implements a bounded, lock-free ring queue for any number of
+//      producers and consumers, using a sequence number in each slot (after Dmitry Vyukov's
+//      bounded MPMC queue).  A producer claims a slot by advancing the tail index with a
+//      compare-and-swap, fills it, and then publishes it by advancing the slot's sequence
+//      number; consumers claim and release slots the same way from the head.  As with
+//      rhx_spsc_queue, the queue relocates with its heap and may be shared between processes,
+//      and popped slots are reset to T().
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class A = std::allocator<T>>
+class rhx_mpmc_queue
+{
+  public:
+    using value_type        = T;
+    using allocator_type    = A;
+    using size_type         = std::size_t;
+
+  public:
+    ~rhx_mpmc_queue();
+    explicit rhx_mpmc_queue(size_type capacity, A const& alloc = A());
+
+    rhx_mpmc_queue(rhx_mpmc_queue const&) = delete;
+    rhx_mpmc_queue&     operator =(rhx_mpmc_queue const&) = delete;
+
+    bool        try_push(T const& value);
+    bool        try_pop(T& value);
+
+    bool        empty() const noexcept;
+    size_type   size() const noexcept;
+    size_type   capacity() const noexcept;
+
+    template<class V>
+    void        trace(V& visitor);
+
+  private:
+    struct cell
+    {
+        std::atomic<uint64_t>   m_sequence;
+        T                       m_value;
+
+        template<class V>
+        void    trace(V& visitor)
+                { rhx_trace_traits<T>::trace(m_value, visitor); }
+    };
+
+    using cell_allocator = typename std::allocator_traits<A>::template rebind_alloc<cell>;
+    using cell_traits    = std::allocator_traits<cell_allocator>;
+    using cell_pointer   = typename cell_traits::pointer;
+
+    alignas(64) std::atomic<uint64_t>   m_tail;         //- Next position to push
+    alignas(64) std::atomic<uint64_t>   m_head;         //- Next position to pop
+    alignas(64) cell_pointer            m_cells;        //- Read-only after construction
+                size_type               m_mask;
+                cell_allocator          m_alloc;
+
+  private:
+    cell&   cell_at(uint64_t index) const noexcept;
+};
+
+
+//- Capacities are rounded up to a power of two, so that an index maps to a slot with a mask.
+//
+inline std::size_t
+rhx_ring_capacity(std::size_t capacity)
+{
+    std::size_t     n = 2;
+
+    while (n < capacity)
+    {
+        if (n > (~std::size_t(0) >> 2))
+        {
+            throw std::length_error("ring queue capacity is too large");
+        }
+        n <<= 1;
+    }
+    return n;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_spsc_queue<T,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class A>
+rhx_spsc_queue<T, A>::~rhx_spsc_queue()
+{
+    T*  pslots = std::addressof(*m_slots);
+
+    for (size_type i = 0;  i <= m_mask;  ++i)
+    {
+        alloc_traits::destroy(m_alloc, pslots + i);
+    }
+    alloc_traits::deallocate(m_alloc, m_slots, m_mask + 1);
+}
+
+template<class T, class A>
+rhx_spsc_queue<T, A>::rhx_spsc_queue(size_type capacity, A const& alloc)
+:   m_tail(0)
+,   m_head_cache(0)
+,   m_head(0)
+,   m_tail_cache(0)
+,   m_slots(nullptr)
+,   m_mask(rhx_ring_capacity(capacity) - 1)
+,   m_alloc(alloc)
+{
+    m_slots = alloc_traits::allocate(m_alloc, m_mask + 1);
+
+    T*  pslots = std::addressof(*m_slots);
+
+    for (size_type i = 0;  i <= m_mask;  ++i)
+    {
+        alloc_traits::construct(m_alloc, pslots + i);
+    }
+}
+
+//- Called only by the producer.  Returns false if the queue is full.
+//
+template<class T, class A> inline
+bool
+rhx_spsc_queue<T, A>::try_push(T const& value)
+{
+    uint64_t    tail = m_tail.load(std::memory_order_relaxed);
+
+    if (tail - m_head_cache > m_mask)
+    {
+        m_head_cache = m_head.load(std::memory_order_acquire);
+
+        if (tail - m_head_cache > m_mask)
+        {
+            return false;
+        }
+    }
+
+    slot(tail) = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+//- Called only by the consumer.  Returns false if the queue is empty.
+//
+template<class T, class A> inline
+bool
+rhx_spsc_queue<T, A>::try_pop(T& value)
+{
+    uint64_t    head = m_head.load(std::memory_order_relaxed);
+
+    if (head == m_tail_cache)
+    {
+        m_tail_cache = m_tail.load(std::memory_order_acquire);
+
+        if (head == m_tail_cache)
+        {
+            return false;
+        }
+    }
+
+    T&  item = slot(head);
+
+    value = std::move(item);
+    item  = T();
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template<class T, class A> inline
+bool
+rhx_spsc_queue<T, A>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+//- The result is exact only when neither side is active.
+//
+template<class T, class A> inline
+typename rhx_spsc_queue<T, A>::size_type
+rhx_spsc_queue<T, A>::size() const noexcept
+{
+    uint64_t    head = m_head.load(std::memory_order_acquire);
+    uint64_t    tail = m_tail.load(std::memory_order_acquire);
+
+    return (tail > head) ? static_cast<size_type>(tail - head) : 0;
+}
+
+template<class T, class A> inline
+typename rhx_spsc_queue<T, A>::size_type
+rhx_spsc_queue<T, A>::capacity() const noexcept
+{
+    return m_mask + 1;
+}
+
+//- Reports the slots to a heap compactor's visitor.  Every slot holds either a value or T(),
+//  so all of them are traced.
+//
+template<class T, class A>
+template<class V> inline
+void
+rhx_spsc_queue<T, A>::trace(V& visitor)
+{
+    visitor(m_slots, m_mask + 1);
+}
+
+template<class T, class A> inline
+T&
+rhx_spsc_queue<T, A>::slot(uint64_t index) const noexcept
+{
+    return std::addressof(*m_slots)[index & m_mask];
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_mpmc_queue<T,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class A>
+rhx_mpmc_queue<T, A>::~rhx_mpmc_queue()
+{
+    cell*   pcells = std::addressof(*m_cells);
+
+    for (size_type i = 0;  i <= m_mask;  ++i)
+    {
+        cell_traits::destroy(m_alloc, pcells + i);
+    }
+    cell_traits::deallocate(m_alloc, m_cells, m_mask + 1);
+}
+
+//- The sequence number of slot i starts at i, meaning that it is free for the push at position
+//  i; after that push it becomes i + 1 (full, for the pop at position i), and after that pop,
+//  i + capacity (free, for the push one lap later).
+//
+template<class T, class A>
+rhx_mpmc_queue<T, A>::rhx_mpmc_queue(size_type capacity, A const& alloc)
+:   m_tail(0)
+,   m_head(0)
+,   m_cells(nullptr)
+,   m_mask(rhx_ring_capacity(capacity) - 1)
+,   m_alloc(alloc)
+{
+    m_cells = cell_traits::allocate(m_alloc, m_mask + 1);
+
+    cell*   pcells = std::addressof(*m_cells);
+
+    for (size_type i = 0;  i <= m_mask;  ++i)
+    {
+        cell_traits::construct(m_alloc, pcells + i);
+        pcells[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<class T, class A>
+bool
+rhx_mpmc_queue<T, A>::try_push(T const& value)
+{
+    uint64_t    pos = m_tail.load(std::memory_order_relaxed);
+    cell*       pc;
+
+    for (;;)
+    {
+        pc = &cell_at(pos);
+
+        uint64_t    seq  = pc->m_sequence.load(std::memory_order_acquire);
+        int64_t     diff = static_cast<int64_t>(seq - pos);
+
+        if (diff == 0)
+        {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    pc->m_value = value;
+    pc->m_sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template<class T, class A>
+bool
+rhx_mpmc_queue<T, A>::try_pop(T& value)
+{
+    uint64_t    pos = m_head.load(std::memory_order_relaxed);
+    cell*       pc;
+
+    for (;;)
+    {
+        pc = &cell_at(pos);
+
+        uint64_t    seq  = pc->m_sequence.load(std::memory_order_acquire);
+        int64_t     diff = static_cast<int64_t>(seq - (pos + 1));
+
+        if (diff == 0)
+        {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    value       = std::move(pc->m_value);
+    pc->m_value = T();
+    pc->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return true;
+}
+
+template<class T, class A> inline
+bool
+rhx_mpmc_queue<T, A>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+//- The result is exact only when no producer or consumer is active.
+//
+template<class T, class A> inline
+typename rhx_mpmc_queue<T, A>::size_type
+rhx_mpmc_queue<T, A>::size() const noexcept
+{
+    uint64_t    head = m_head.load(std::memory_order_acquire);
+    uint64_t    tail = m_tail.load(std::memory_order_acquire);
+
+    return (tail > head) ? static_cast<size_type>(tail - head) : 0;
+}
+
+template<class T, class A> inline
+typename rhx_mpmc_queue<T, A>::size_type
+rhx_mpmc_queue<T, A>::capacity() const noexcept
+{
+    return m_mask + 1;
+}
+
+//- Reports the cells to a heap compactor's visitor; as with rhx_spsc_queue, all are traced.
+//
+template<class T, class A>
+template<class V> inline
+void
+rhx_mpmc_queue<T, A>::trace(V& visitor)
+{
+    visitor(m_cells, m_mask + 1);
+}
+
+template<class T, class A> inline
+typename rhx_mpmc_queue<T, A>::cell&
+rhx_mpmc_queue<T, A>::cell_at(uint64_t index) const noexcept
+{
+    return std::addressof(*m_cells)[index & m_mask];
+}
+
+#endif  //- RHX_RING_QUEUE_H_DEFINED
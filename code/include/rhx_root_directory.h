@@ -0,0 +1,258 @@
+//==================================================================================================
+//  File:
+//      rhx_root_directory.h
+//
+//  Summary:
+//      Defines the rhx_root_directory<HT> class template, a table of named root objects stored
+//      at a fixed location inside a relocatable heap.
+//==================================================================================================
+//
+#ifndef RHX_ROOT_DIRECTORY_H_DEFINED
+#define RHX_ROOT_DIRECTORY_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "rhx_allocator.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_root_directory<HT>
+//
+//  Summary:
+//      This class template implements a small open-addressing hash table that maps names to
+//      synthetic pointers.  The table lives in the root area that the allocation strategy HT
+//      reserves at the start of its first segment, so after a heap has been relocated or
+//      restored, its root objects can be found by name without scanning.  An entry whose object
+//      has been discarded (by the compactor) is withdrawn: it keeps its name, so that probing
+//      continues past it, but it is neither found nor counted until an object is constructed
+//      for the name again.
+//--------------------------------------------------------------------------------------------------
+//
+template<class HT>
+class rhx_root_directory
+{
+  public:
+    using size_type     = typename HT::size_type;
+    using void_pointer  = typename HT::void_pointer;
+
+    template<class T>
+    using pointer       = typename rhx_allocator<T, HT>::pointer;
+
+    enum : size_type
+    {
+        max_name_length = 39
+    };
+
+  public:
+    template<class T>
+    static  pointer<T>  find(char const* name);
+
+    template<class T, class... Args>
+    static  pointer<T>  find_or_construct(char const* name, Args&&... args);
+
+    static  bool        contains(char const* name);
+    static  size_type   size();
+    static  size_type   capacity();
+
+  private:
+    template<class T> friend class segmented_heap_compactor;
+
+    struct directory_header
+    {
+        uint64_t    m_magic;
+        uint64_t    m_capacity;
+        uint64_t    m_count;        //- Entries in use, including withdrawn ones
+        uint64_t    m_withdrawn;
+        uint64_t    m_unused[4];
+    };
+
+    struct directory_entry
+    {
+        uint64_t        m_hash;         //- Zero marks an unused entry
+        void_pointer    m_object;
+        uint64_t        m_type_size;    //- sizeof(T) at insertion, as a sanity check; zero when
+                                        //  withdrawn
+        char            m_name[max_name_length + 1];
+    };
+
+    enum : uint64_t
+    {
+        directory_magic = 0x3130524944584852ull     //- "RHXDIR01"
+    };
+
+    static  directory_header*   header();
+    static  directory_entry*    entries();
+    static  directory_entry*    lookup(char const* name, uint64_t hash);
+    static  uint64_t            hash_name(char const* name);
+    static  void                withdraw(directory_entry* pe);
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_root_directory<HT>
+//--------------------------------------------------------------------------------------------------
+//
+template<class HT>
+template<class T>
+typename rhx_root_directory<HT>::template pointer<T>
+rhx_root_directory<HT>::find(char const* name)
+{
+    directory_entry*    pe = lookup(name, hash_name(name));
+
+    if (pe->m_hash == 0  ||  pe->m_type_size != sizeof(T))
+    {
+        return nullptr;
+    }
+
+    return static_cast<pointer<T>>(pe->m_object);
+}
+
+template<class HT>
+template<class T, class... Args>
+typename rhx_root_directory<HT>::template pointer<T>
+rhx_root_directory<HT>::find_or_construct(char const* name, Args&&... args)
+{
+    uint64_t            hash = hash_name(name);
+    directory_entry*    pe   = lookup(name, hash);
+
+    if (pe->m_hash != 0  &&  pe->m_type_size != 0)
+    {
+        return (pe->m_type_size == sizeof(T)) ? static_cast<pointer<T>>(pe->m_object) : nullptr;
+    }
+
+    if (pe->m_hash == 0  &&  strlen(name) > max_name_length)
+    {
+        throw std::length_error("root directory name too long");
+    }
+    if (pe->m_hash == 0  &&  (header()->m_count + 1) >= header()->m_capacity)
+    {
+        throw std::bad_alloc();
+    }
+
+    pointer<T>  pobj = allocate<T, HT>(std::forward<Args>(args)...);
+
+    pe->m_object    = pobj;
+    pe->m_type_size = sizeof(T);
+
+    if (pe->m_hash == 0)
+    {
+        strcpy(pe->m_name, name);
+        pe->m_hash = hash;
+        header()->m_count += 1;
+    }
+    else
+    {
+        header()->m_withdrawn -= 1;
+    }
+
+    return pobj;
+}
+
+template<class HT> inline
+bool
+rhx_root_directory<HT>::contains(char const* name)
+{
+    return lookup(name, hash_name(name))->m_type_size != 0;
+}
+
+template<class HT> inline
+typename rhx_root_directory<HT>::size_type
+rhx_root_directory<HT>::size()
+{
+    return static_cast<size_type>(header()->m_count - header()->m_withdrawn);
+}
+
+template<class HT> inline
+typename rhx_root_directory<HT>::size_type
+rhx_root_directory<HT>::capacity()
+{
+    return static_cast<size_type>(header()->m_capacity);
+}
+
+//------
+//
+template<class HT>
+typename rhx_root_directory<HT>::directory_header*
+rhx_root_directory<HT>::header()
+{
+    static_assert(sizeof(directory_header) == 64  &&  sizeof(directory_entry) == 64,
+                  "unexpected root directory layout");
+
+    void*               pv = HT::root_area();
+    directory_header*   ph = static_cast<directory_header*>(pv);
+
+    //- A freshly-allocated segment is zero-filled; a restored one already has a directory.
+    //
+    if (ph->m_magic != directory_magic)
+    {
+        memset(pv, 0, HT::root_area_size);
+        ph->m_magic    = directory_magic;
+        ph->m_capacity = (HT::root_area_size - sizeof(directory_header)) / sizeof(directory_entry);
+        ph->m_count    = 0;
+    }
+
+    return ph;
+}
+
+template<class HT> inline
+typename rhx_root_directory<HT>::directory_entry*
+rhx_root_directory<HT>::entries()
+{
+    return reinterpret_cast<directory_entry*>(header() + 1);
+}
+
+//- Linear probing; returns either the entry holding the name or the empty entry that ends the
+//  probe sequence.  The table is never allowed to fill completely, so the loop terminates.
+//
+template<class HT>
+typename rhx_root_directory<HT>::directory_entry*
+rhx_root_directory<HT>::lookup(char const* name, uint64_t hash)
+{
+    directory_header*   ph   = header();
+    directory_entry*    pe   = entries();
+    uint64_t            slot = hash % ph->m_capacity;
+
+    while (pe[slot].m_hash != 0)
+    {
+        if (pe[slot].m_hash == hash  &&  strncmp(pe[slot].m_name, name, max_name_length + 1) == 0)
+        {
+            break;
+        }
+        slot = (slot + 1 == ph->m_capacity) ? 0 : slot + 1;
+    }
+
+    return pe + slot;
+}
+
+//- 64-bit FNV-1a, adjusted so that zero is never produced.
+//
+template<class HT>
+uint64_t
+rhx_root_directory<HT>::hash_name(char const* name)
+{
+    uint64_t    hash = 0xCBF29CE484222325ull;
+
+    for (;  *name != 0;  ++name)
+    {
+        hash ^= static_cast<uint8_t>(*name);
+        hash *= 0x100000001B3ull;
+    }
+
+    return (hash != 0) ? hash : 1;
+}
+
+template<class HT>
+void
+rhx_root_directory<HT>::withdraw(directory_entry* pe)
+{
+    pe->m_object    = nullptr;
+    pe->m_type_size = 0;
+    header()->m_withdrawn += 1;
+}
+
+#endif  //- RHX_ROOT_DIRECTORY_H_DEFINED
@@ -0,0 +1,478 @@
+//==================================================================================================
+//  File:
+//      rhx_string.h
+//
+//  Summary:
+//      Defines the rhx_basic_string<C,Tr,A> class template, a minimal string type built on
+//      rhx_vector that grows in place when its allocator is able to expand a block.
+//==================================================================================================
+//
+#ifndef RHX_STRING_H_DEFINED
+#define RHX_STRING_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "rhx_vector.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_basic_string<C,Tr,A>
+//
+//  Summary:
+//      This class template implements a small subset of the interface of std::basic_string
+//      on top of rhx_vector<C,A>, which holds the characters followed by a terminating null
+//      once the string has been given any storage.  There is no small-string buffer, so every
+//      non-empty string lives entirely in its allocator's heap, and appending to the most
+//      recently grown string expands its block in place when the allocator allows it.
+//--------------------------------------------------------------------------------------------------
+//
+template<class C, class Tr = std::char_traits<C>, class A = std::allocator<C>>
+class rhx_basic_string
+{
+  public:
+    using traits_type       = Tr;
+    using value_type        = C;
+    using allocator_type    = A;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = C&;
+    using const_reference   = C const&;
+    using iterator          = C*;
+    using const_iterator    = C const*;
+
+  public:
+    ~rhx_basic_string() = default;
+
+    rhx_basic_string() = default;
+    rhx_basic_string(rhx_basic_string&&) noexcept = default;
+    rhx_basic_string(rhx_basic_string const&) = default;
+    explicit rhx_basic_string(A const& alloc);
+    rhx_basic_string(C const* s, A const& alloc = A());
+    rhx_basic_string(C const* s, size_type n, A const& alloc = A());
+
+    rhx_basic_string&   operator =(rhx_basic_string&&) noexcept = default;
+    rhx_basic_string&   operator =(rhx_basic_string const&) = default;
+    rhx_basic_string&   operator =(C const* s);
+
+    iterator        begin() noexcept;
+    const_iterator  begin() const noexcept;
+    iterator        end() noexcept;
+    const_iterator  end() const noexcept;
+
+    bool            empty() const noexcept;
+    size_type       size() const noexcept;
+    size_type       length() const noexcept;
+    size_type       capacity() const noexcept;
+    void            reserve(size_type n);
+
+    C const*        c_str() const noexcept;
+    C const*        data() const noexcept;
+    C&              operator [](size_type i) noexcept;
+    C const&        operator [](size_type i) const noexcept;
+    C&              at(size_type i);
+    C const&        at(size_type i) const;
+
+    void            clear() noexcept;
+    void            swap(rhx_basic_string& other) noexcept;
+
+    void                push_back(C ch);
+    rhx_basic_string&   append(C const* s, size_type n);
+    rhx_basic_string&   append(C const* s);
+    rhx_basic_string&   append(rhx_basic_string const& str);
+    rhx_basic_string&   operator +=(C ch);
+    rhx_basic_string&   operator +=(C const* s);
+    rhx_basic_string&   operator +=(rhx_basic_string const& str);
+
+    int             compare(C const* s, size_type n) const noexcept;
+    int             compare(C const* s) const noexcept;
+    int             compare(rhx_basic_string const& str) const noexcept;
+
+    allocator_type  get_allocator() const;
+
+    template<class V>
+    void            trace(V& visitor);
+
+  private:
+    rhx_vector<C, A>    m_chars;
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_basic_string<C,Tr,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>::rhx_basic_string(A const& alloc)
+:   m_chars(alloc)
+{}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>::rhx_basic_string(C const* s, A const& alloc)
+:   m_chars(alloc)
+{
+    append(s, Tr::length(s));
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>::rhx_basic_string(C const* s, size_type n, A const& alloc)
+:   m_chars(alloc)
+{
+    append(s, n);
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>&
+rhx_basic_string<C, Tr, A>::operator =(C const* s)
+{
+    rhx_basic_string    tmp(s, m_chars.get_allocator());
+    swap(tmp);
+    return *this;
+}
+
+//------
+//
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::iterator
+rhx_basic_string<C, Tr, A>::begin() noexcept
+{
+    return m_chars.data();
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::const_iterator
+rhx_basic_string<C, Tr, A>::begin() const noexcept
+{
+    return m_chars.data();
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::iterator
+rhx_basic_string<C, Tr, A>::end() noexcept
+{
+    return m_chars.data() + size();
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::const_iterator
+rhx_basic_string<C, Tr, A>::end() const noexcept
+{
+    return m_chars.data() + size();
+}
+
+//------
+//
+template<class C, class Tr, class A> inline
+bool
+rhx_basic_string<C, Tr, A>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::size_type
+rhx_basic_string<C, Tr, A>::size() const noexcept
+{
+    return m_chars.empty() ? 0 : m_chars.size() - 1;
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::size_type
+rhx_basic_string<C, Tr, A>::length() const noexcept
+{
+    return size();
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::size_type
+rhx_basic_string<C, Tr, A>::capacity() const noexcept
+{
+    return m_chars.capacity() ? m_chars.capacity() - 1 : 0;
+}
+
+template<class C, class Tr, class A> inline
+void
+rhx_basic_string<C, Tr, A>::reserve(size_type n)
+{
+    m_chars.reserve(n + 1);
+}
+
+//------
+//
+template<class C, class Tr, class A> inline
+C const*
+rhx_basic_string<C, Tr, A>::c_str() const noexcept
+{
+    static C const  empty_string[1] = {};
+    return m_chars.empty() ? empty_string : m_chars.data();
+}
+
+template<class C, class Tr, class A> inline
+C const*
+rhx_basic_string<C, Tr, A>::data() const noexcept
+{
+    return c_str();
+}
+
+template<class C, class Tr, class A> inline
+C&
+rhx_basic_string<C, Tr, A>::operator [](size_type i) noexcept
+{
+    return m_chars[i];
+}
+
+template<class C, class Tr, class A> inline
+C const&
+rhx_basic_string<C, Tr, A>::operator [](size_type i) const noexcept
+{
+    return c_str()[i];
+}
+
+template<class C, class Tr, class A>
+C&
+rhx_basic_string<C, Tr, A>::at(size_type i)
+{
+    if (i >= size())
+    {
+        throw std::out_of_range("rhx_basic_string::at");
+    }
+    return m_chars[i];
+}
+
+template<class C, class Tr, class A>
+C const&
+rhx_basic_string<C, Tr, A>::at(size_type i) const
+{
+    if (i >= size())
+    {
+        throw std::out_of_range("rhx_basic_string::at");
+    }
+    return m_chars[i];
+}
+
+//------
+//
+template<class C, class Tr, class A> inline
+void
+rhx_basic_string<C, Tr, A>::clear() noexcept
+{
+    if (!m_chars.empty())
+    {
+        m_chars.clear();
+        m_chars.push_back(C());
+    }
+}
+
+template<class C, class Tr, class A> inline
+void
+rhx_basic_string<C, Tr, A>::swap(rhx_basic_string& other) noexcept
+{
+    m_chars.swap(other.m_chars);
+}
+
+//------
+//
+template<class C, class Tr, class A> inline
+void
+rhx_basic_string<C, Tr, A>::push_back(C ch)
+{
+    append(&ch, 1);
+}
+
+//- Capacity grows geometrically, and the source may lie inside this string, so its offset is
+//  recorded before the storage can move.
+//
+template<class C, class Tr, class A>
+rhx_basic_string<C, Tr, A>&
+rhx_basic_string<C, Tr, A>::append(C const* s, size_type n)
+{
+    size_type   len    = size();
+    size_type   needed = len + n + 1;
+
+    if (needed > m_chars.capacity())
+    {
+        C const*    pold   = m_chars.data();
+        bool        inside = (pold != nullptr  &&  !std::less<C const*>()(s, pold)  &&
+                              std::less<C const*>()(s, pold + len));
+        size_type   offset = inside ? static_cast<size_type>(s - pold) : 0;
+
+        m_chars.reserve(std::max<size_type>(needed, 2 * m_chars.capacity()));
+
+        if (inside)
+        {
+            s = m_chars.data() + offset;
+        }
+    }
+
+    if (m_chars.empty())
+    {
+        m_chars.push_back(C());
+    }
+
+    //- Overwrite the terminator, then add the remaining characters and a new terminator.
+    //
+    if (n != 0)
+    {
+        m_chars[len] = s[0];
+        m_chars.append(s + 1, s + n);
+        m_chars.push_back(C());
+    }
+
+    return *this;
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>&
+rhx_basic_string<C, Tr, A>::append(C const* s)
+{
+    return append(s, Tr::length(s));
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>&
+rhx_basic_string<C, Tr, A>::append(rhx_basic_string const& str)
+{
+    return append(str.data(), str.size());
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>&
+rhx_basic_string<C, Tr, A>::operator +=(C ch)
+{
+    return append(&ch, 1);
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>&
+rhx_basic_string<C, Tr, A>::operator +=(C const* s)
+{
+    return append(s);
+}
+
+template<class C, class Tr, class A> inline
+rhx_basic_string<C, Tr, A>&
+rhx_basic_string<C, Tr, A>::operator +=(rhx_basic_string const& str)
+{
+    return append(str);
+}
+
+//------
+//
+template<class C, class Tr, class A>
+int
+rhx_basic_string<C, Tr, A>::compare(C const* s, size_type n) const noexcept
+{
+    size_type   len = size();
+    int         cmp = Tr::compare(data(), s, std::min(len, n));
+
+    return (cmp != 0) ? cmp : (len < n) ? -1 : (len > n) ? 1 : 0;
+}
+
+template<class C, class Tr, class A> inline
+int
+rhx_basic_string<C, Tr, A>::compare(C const* s) const noexcept
+{
+    return compare(s, Tr::length(s));
+}
+
+template<class C, class Tr, class A> inline
+int
+rhx_basic_string<C, Tr, A>::compare(rhx_basic_string const& str) const noexcept
+{
+    return compare(str.data(), str.size());
+}
+
+template<class C, class Tr, class A> inline
+typename rhx_basic_string<C, Tr, A>::allocator_type
+rhx_basic_string<C, Tr, A>::get_allocator() const
+{
+    return m_chars.get_allocator();
+}
+
+template<class C, class Tr, class A>
+template<class V> inline
+void
+rhx_basic_string<C, Tr, A>::trace(V& visitor)
+{
+    m_chars.trace(visitor);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_basic_string<C,Tr,A> Non-Member Functions
+//--------------------------------------------------------------------------------------------------
+//
+template<class C, class Tr, class A> inline
+void
+swap(rhx_basic_string<C, Tr, A>& lhs, rhx_basic_string<C, Tr, A>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+template<class C, class Tr, class A> inline bool
+operator ==(rhx_basic_string<C, Tr, A> const& lhs, rhx_basic_string<C, Tr, A> const& rhs) noexcept
+{
+    return lhs.compare(rhs) == 0;
+}
+
+template<class C, class Tr, class A> inline bool
+operator ==(rhx_basic_string<C, Tr, A> const& lhs, C const* rhs) noexcept
+{
+    return lhs.compare(rhs) == 0;
+}
+
+template<class C, class Tr, class A> inline bool
+operator !=(rhx_basic_string<C, Tr, A> const& lhs, rhx_basic_string<C, Tr, A> const& rhs) noexcept
+{
+    return lhs.compare(rhs) != 0;
+}
+
+template<class C, class Tr, class A> inline bool
+operator !=(rhx_basic_string<C, Tr, A> const& lhs, C const* rhs) noexcept
+{
+    return lhs.compare(rhs) != 0;
+}
+
+template<class C, class Tr, class A> inline bool
+operator <(rhx_basic_string<C, Tr, A> const& lhs, rhx_basic_string<C, Tr, A> const& rhs) noexcept
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template<class C, class Tr, class A> inline
+std::basic_ostream<C, Tr>&
+operator <<(std::basic_ostream<C, Tr>& os, rhx_basic_string<C, Tr, A> const& str)
+{
+    return os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+//- Hashes the characters' bytes with 64-bit FNV-1a, so that the strings can be used as keys in
+//  the unordered containers and in rhx_flat_hash_map.
+//
+namespace std
+{
+    template<class C, class Tr, class A>
+    struct hash<rhx_basic_string<C, Tr, A>>
+    {
+        size_t  operator ()(rhx_basic_string<C, Tr, A> const& str) const noexcept
+        {
+            unsigned char const*    p = reinterpret_cast<unsigned char const*>(str.data());
+            unsigned char const*    e = p + str.size() * sizeof(C);
+            uint64_t                h = 0xCBF29CE484222325ull;
+
+            for (;  p != e;  ++p)
+            {
+                h ^= *p;
+                h *= 0x100000001B3ull;
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+}
+
+#endif  //- RHX_STRING_H_DEFINED
@@ -0,0 +1,132 @@
+//==================================================================================================
+//  File:
+//      rhx_trace_traits.h
+//
+//  Summary:
+//      Defines the rhx_trace_traits<T> class template, through which the heap compactor finds
+//      the synthetic pointers inside objects, and the rhx_pointer_free_traits<T> helper.
+//==================================================================================================
+//
+#ifndef RHX_TRACE_TRAITS_H_DEFINED
+#define RHX_TRACE_TRAITS_H_DEFINED
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "synthetic_pointer_interface.h"
+
+//- A stand-in for the visitor passed to a type's trace() member, used only to detect one.
+//
+struct rhx_trace_visitor
+{
+    template<class P>
+    void    operator ()(P& p, std::size_t count = 1);
+};
+
+//- A base for specializations of rhx_trace_traits describing types that hold no pointers.
+//
+template<class T>
+struct rhx_pointer_free_traits
+{
+    static constexpr bool   traced = false;
+
+    template<class V>
+    static  void    trace(T&, V&) noexcept
+                    {}
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_trace_traits<T>
+//
+//  Summary:
+//      This traits class template tells the compactor where the synthetic pointers in an object
+//      of type T are.  trace(obj, visitor) calls visitor(p) for each pointer p in obj, or
+//      visitor(p, n) for a pointer to an array whose first n elements are live; the visitor may
+//      rewrite the pointers it is given.  traced is true for every type whose objects may hold
+//      pointers.
+//
+//      A type with a member function template trace(V& visitor) is traced by calling it, as the
+//      rhx containers are.  Scalar types, including the ordinary pointers that the compactor
+//      leaves alone, hold no pointers; synthetic pointers, pairs, arrays, and const objects are
+//      traced as their members are.  Any other type must be described by specializing the class,
+//      deriving from rhx_pointer_free_traits<T> if it holds no pointers.  Guessing would risk
+//      leaving pointers into moved blocks behind, so tracing an undescribed type is an error at
+//      compile time; this includes the standard containers, whose pointers are out of reach.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class = void>
+struct rhx_trace_traits
+{
+    static_assert(sizeof(T) == 0, "rhx_trace_traits<T> does not know where T's pointers are; "
+                                  "give T a trace() member or specialize rhx_trace_traits");
+};
+
+template<class T>
+struct rhx_trace_traits<T, decltype(std::declval<T&>().trace(std::declval<rhx_trace_visitor&>()))>
+{
+    static constexpr bool   traced = true;
+
+    template<class V>
+    static  void    trace(T& obj, V& visitor)
+                    { obj.trace(visitor); }
+};
+
+template<class T>
+struct rhx_trace_traits<T, typename std::enable_if<std::is_scalar<T>::value>::type>
+:   rhx_pointer_free_traits<T>
+{};
+
+//- A const object, such as the key of a map's element, is traced as though it were not const,
+//  since the pointers in it are rewritten when it moves.
+//
+template<class T>
+struct rhx_trace_traits<T const, typename std::enable_if<!std::is_scalar<T>::value>::type>
+{
+    static constexpr bool   traced = rhx_trace_traits<T>::traced;
+
+    template<class V>
+    static  void    trace(T const& obj, V& visitor)
+                    { rhx_trace_traits<T>::trace(const_cast<T&>(obj), visitor); }
+};
+
+template<class T, class AM>
+struct rhx_trace_traits<synthetic_pointer<T, AM>, void>
+{
+    static constexpr bool   traced = true;
+
+    template<class V>
+    static  void    trace(synthetic_pointer<T, AM>& p, V& visitor)
+                    { visitor(p); }
+};
+
+template<class T1, class T2>
+struct rhx_trace_traits<std::pair<T1, T2>, void>
+{
+    static constexpr bool   traced = rhx_trace_traits<T1>::traced || rhx_trace_traits<T2>::traced;
+
+    template<class V>
+    static  void    trace(std::pair<T1, T2>& obj, V& visitor)
+                    {
+                        rhx_trace_traits<T1>::trace(obj.first, visitor);
+                        rhx_trace_traits<T2>::trace(obj.second, visitor);
+                    }
+};
+
+template<class T, std::size_t N>
+struct rhx_trace_traits<T[N], void>
+{
+    static constexpr bool   traced = rhx_trace_traits<T>::traced;
+
+    template<class V>
+    static  void    trace(T (&obj)[N], V& visitor)
+                    {
+                        for (std::size_t i = 0;  i < N;  ++i)
+                        {
+                            rhx_trace_traits<T>::trace(obj[i], visitor);
+                        }
+                    }
+};
+
+#endif  //- RHX_TRACE_TRAITS_H_DEFINED
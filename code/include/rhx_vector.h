@@ -0,0 +1,1004 @@
+//==================================================================================================
+//  File:
+//      rhx_vector.h
+//
+//  Summary:
+//      Defines the rhx_vector<T,A> class template, a dynamic array that grows in place when its
+//      allocator is able to expand a block.
+//==================================================================================================
+//
+#ifndef RHX_VECTOR_H_DEFINED
+#define RHX_VECTOR_H_DEFINED
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_has_expand_in_place<A>
+//
+//  Summary:
+//      This traits type determines whether allocator type A provides a member function
+//      expand_in_place(p, old_n, new_n), as rhx_allocator does.
+//--------------------------------------------------------------------------------------------------
+//
+template<class A, class = void>
+struct rhx_has_expand_in_place : public std::false_type
+{};
+
+template<class A>
+struct rhx_has_expand_in_place<A, decltype(void(std::declval<A&>().expand_in_place(
+                                    std::declval<typename std::allocator_traits<A>::pointer>(),
+                                    std::declval<typename std::allocator_traits<A>::size_type>(),
+                                    std::declval<typename std::allocator_traits<A>::size_type>())))>
+:   public std::true_type
+{};
+
+//- Attempts to grow the block at p in place; always fails for allocators without support.
+//
+template<class A> inline
+typename std::enable_if<rhx_has_expand_in_place<A>::value, bool>::type
+rhx_expand_in_place(A& a, typename std::allocator_traits<A>::pointer p,
+                    typename std::allocator_traits<A>::size_type old_n,
+                    typename std::allocator_traits<A>::size_type new_n)
+{
+    return a.expand_in_place(p, old_n, new_n);
+}
+
+template<class A> inline
+typename std::enable_if<!rhx_has_expand_in_place<A>::value, bool>::type
+rhx_expand_in_place(A&, typename std::allocator_traits<A>::pointer,
+                    typename std::allocator_traits<A>::size_type,
+                    typename std::allocator_traits<A>::size_type)
+{
+    return false;
+}
+
+template<class T, class HT> class rhx_allocator;
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_is_bulk_copyable<T,A>
+//
+//  Summary:
+//      This traits type determines whether a container using allocator type A may copy and
+//      relocate elements of type T with memcpy and memmove instead of constructing them one
+//      at a time.  That requires T to be trivially copyable and A's construct() to be plain
+//      placement new, as it is for std::allocator and rhx_allocator.
+//--------------------------------------------------------------------------------------------------
+//
+template<class A>
+struct rhx_constructs_by_placement : public std::false_type
+{};
+
+template<class T>
+struct rhx_constructs_by_placement<std::allocator<T>> : public std::true_type
+{};
+
+template<class T, class HT>
+struct rhx_constructs_by_placement<rhx_allocator<T, HT>> : public std::true_type
+{};
+
+template<class T, class A>
+struct rhx_is_bulk_copyable
+:   public std::integral_constant<bool, std::is_trivially_copyable<T>::value  &&
+                                        rhx_constructs_by_placement<A>::value>
+{};
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      rhx_vector<T,A>
+//
+//  Summary:
+//      This class template implements a subset of the interface of std::vector.  It stores
+//      only the allocator's pointer to its elements plus a size and capacity, so it relocates
+//      along with its allocator's heap.  When its capacity is exhausted, it first asks the
+//      allocator to expand the current block in place, and only allocates a new block and moves
+//      its elements if that fails; with a bump-pointer allocation strategy, appending to the
+//      most recently grown vector or string therefore copies nothing.
+//
+//      Iterators are ordinary pointers, and are invalidated by relocation of the heap.  Since
+//      they are, the standard algorithms see contiguous storage, and the vector's own copying,
+//      appending, inserting, and growth use memcpy and memmove for bulk-copyable elements.
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class A = std::allocator<T>>
+class rhx_vector
+{
+  private:
+    using alloc_traits  = std::allocator_traits<A>;
+
+  public:
+    using value_type        = T;
+    using allocator_type    = A;
+    using size_type         = std::size_t;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = T&;
+    using const_reference   = T const&;
+    using pointer           = typename alloc_traits::pointer;
+    using const_pointer     = typename alloc_traits::const_pointer;
+    using iterator          = T*;
+    using const_iterator    = T const*;
+
+  public:
+    ~rhx_vector();
+
+    rhx_vector();
+    rhx_vector(rhx_vector&& other) noexcept;
+    rhx_vector(rhx_vector const& other);
+    explicit rhx_vector(A const& alloc);
+    explicit rhx_vector(size_type n, T const& value = T(), A const& alloc = A());
+    rhx_vector(std::initializer_list<T> values, A const& alloc = A());
+
+    rhx_vector&     operator =(rhx_vector&& rhs) noexcept;
+    rhx_vector&     operator =(rhx_vector const& rhs);
+
+    iterator        begin() noexcept;
+    const_iterator  begin() const noexcept;
+    const_iterator  cbegin() const noexcept;
+    iterator        end() noexcept;
+    const_iterator  end() const noexcept;
+    const_iterator  cend() const noexcept;
+
+    bool            empty() const noexcept;
+    size_type       size() const noexcept;
+    size_type       capacity() const noexcept;
+    size_type       max_size() const noexcept;
+
+    T*              data() noexcept;
+    T const*        data() const noexcept;
+    T&              operator [](size_type i) noexcept;
+    T const&        operator [](size_type i) const noexcept;
+    T&              at(size_type i);
+    T const&        at(size_type i) const;
+    T&              front() noexcept;
+    T const&        front() const noexcept;
+    T&              back() noexcept;
+    T const&        back() const noexcept;
+
+    void            reserve(size_type n);
+    void            resize(size_type n);
+    void            resize(size_type n, T const& value);
+    void            clear() noexcept;
+    void            swap(rhx_vector& other) noexcept;
+
+    void            push_back(T const& value);
+    void            push_back(T&& value);
+    template<class... Args>
+    T&              emplace_back(Args&&... args);
+    void            pop_back() noexcept;
+
+    template<class InIt>
+    void            append(InIt first, InIt last);
+    iterator        insert(const_iterator pos, T const& value);
+    template<class InIt>
+    iterator        insert(const_iterator pos, InIt first, InIt last);
+    iterator        erase(const_iterator pos);
+    iterator        erase(const_iterator first, const_iterator last);
+
+    allocator_type  get_allocator() const;
+
+    template<class V>
+    void            trace(V& visitor);
+
+  private:
+    pointer         m_data;
+    size_type       m_size;
+    size_type       m_capacity;
+    allocator_type  m_alloc;
+
+  private:
+    using bulk_copy = rhx_is_bulk_copyable<T, A>;
+
+    template<class It>
+    using is_bulk_source = std::integral_constant<bool, bulk_copy::value  &&
+                                std::is_pointer<It>::value  &&
+                                std::is_same<typename std::remove_cv<
+                                    typename std::remove_pointer<It>::type>::type, T>::value>;
+
+    size_type       next_capacity(size_type min_capacity) const noexcept;
+    void            grow(size_type new_capacity);
+    void            reallocate(size_type new_capacity);
+    void            release() noexcept;
+
+    template<class InIt>
+    void            append_range(InIt first, InIt last, std::input_iterator_tag);
+    template<class FwdIt>
+    void            append_range(FwdIt first, FwdIt last, std::forward_iterator_tag);
+
+    template<class FwdIt>
+    void            construct_range(T* dst, FwdIt first, FwdIt last, std::false_type);
+    void            construct_range(T* dst, T const* first, T const* last, std::true_type);
+    void            fill_range(T* dst, size_type n, T const& value, std::false_type);
+    void            fill_range(T* dst, size_type n, T const& value, std::true_type);
+    void            relocate_range(T* dst, T* src, size_type n, std::false_type);
+    void            relocate_range(T* dst, T* src, size_type n, std::true_type);
+
+    template<class InIt>
+    iterator        insert_range(size_type index, InIt first, InIt last, std::false_type);
+    iterator        insert_range(size_type index, T const* first, T const* last, std::true_type);
+};
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   rhx_vector<T,A>
+//--------------------------------------------------------------------------------------------------
+//
+template<class T, class A> inline
+rhx_vector<T, A>::~rhx_vector()
+{
+    release();
+}
+
+template<class T, class A> inline
+rhx_vector<T, A>::rhx_vector()
+:   m_data(nullptr)
+,   m_size(0)
+,   m_capacity(0)
+,   m_alloc()
+{}
+
+template<class T, class A> inline
+rhx_vector<T, A>::rhx_vector(rhx_vector&& other) noexcept
+:   m_data(other.m_data)
+,   m_size(other.m_size)
+,   m_capacity(other.m_capacity)
+,   m_alloc(std::move(other.m_alloc))
+{
+    other.m_data     = nullptr;
+    other.m_size     = 0;
+    other.m_capacity = 0;
+}
+
+template<class T, class A>
+rhx_vector<T, A>::rhx_vector(rhx_vector const& other)
+:   m_data(nullptr)
+,   m_size(0)
+,   m_capacity(0)
+,   m_alloc(alloc_traits::select_on_container_copy_construction(other.m_alloc))
+{
+    append(other.begin(), other.end());
+}
+
+template<class T, class A> inline
+rhx_vector<T, A>::rhx_vector(A const& alloc)
+:   m_data(nullptr)
+,   m_size(0)
+,   m_capacity(0)
+,   m_alloc(alloc)
+{}
+
+template<class T, class A>
+rhx_vector<T, A>::rhx_vector(size_type n, T const& value, A const& alloc)
+:   m_data(nullptr)
+,   m_size(0)
+,   m_capacity(0)
+,   m_alloc(alloc)
+{
+    resize(n, value);
+}
+
+template<class T, class A>
+rhx_vector<T, A>::rhx_vector(std::initializer_list<T> values, A const& alloc)
+:   m_data(nullptr)
+,   m_size(0)
+,   m_capacity(0)
+,   m_alloc(alloc)
+{
+    append(values.begin(), values.end());
+}
+
+template<class T, class A>
+rhx_vector<T, A>&
+rhx_vector<T, A>::operator =(rhx_vector&& rhs) noexcept
+{
+    if (&rhs != this)
+    {
+        release();
+        swap(rhs);
+    }
+    return *this;
+}
+
+template<class T, class A>
+rhx_vector<T, A>&
+rhx_vector<T, A>::operator =(rhx_vector const& rhs)
+{
+    if (&rhs != this)
+    {
+        rhx_vector  tmp(rhs);
+        swap(tmp);
+    }
+    return *this;
+}
+
+//------
+//
+template<class T, class A> inline
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::begin() noexcept
+{
+    return data();
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::const_iterator
+rhx_vector<T, A>::begin() const noexcept
+{
+    return data();
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::const_iterator
+rhx_vector<T, A>::cbegin() const noexcept
+{
+    return data();
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::end() noexcept
+{
+    return data() + m_size;
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::const_iterator
+rhx_vector<T, A>::end() const noexcept
+{
+    return data() + m_size;
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::const_iterator
+rhx_vector<T, A>::cend() const noexcept
+{
+    return data() + m_size;
+}
+
+//------
+//
+template<class T, class A> inline
+bool
+rhx_vector<T, A>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::size_type
+rhx_vector<T, A>::size() const noexcept
+{
+    return m_size;
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::size_type
+rhx_vector<T, A>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::size_type
+rhx_vector<T, A>::max_size() const noexcept
+{
+    return alloc_traits::max_size(m_alloc);
+}
+
+//------
+//
+template<class T, class A> inline
+T*
+rhx_vector<T, A>::data() noexcept
+{
+    return m_data ? std::addressof(*m_data) : nullptr;
+}
+
+template<class T, class A> inline
+T const*
+rhx_vector<T, A>::data() const noexcept
+{
+    return m_data ? std::addressof(*m_data) : nullptr;
+}
+
+template<class T, class A> inline
+T&
+rhx_vector<T, A>::operator [](size_type i) noexcept
+{
+    return data()[i];
+}
+
+template<class T, class A> inline
+T const&
+rhx_vector<T, A>::operator [](size_type i) const noexcept
+{
+    return data()[i];
+}
+
+template<class T, class A>
+T&
+rhx_vector<T, A>::at(size_type i)
+{
+    if (i >= m_size)
+    {
+        throw std::out_of_range("rhx_vector::at");
+    }
+    return data()[i];
+}
+
+template<class T, class A>
+T const&
+rhx_vector<T, A>::at(size_type i) const
+{
+    if (i >= m_size)
+    {
+        throw std::out_of_range("rhx_vector::at");
+    }
+    return data()[i];
+}
+
+template<class T, class A> inline
+T&
+rhx_vector<T, A>::front() noexcept
+{
+    return data()[0];
+}
+
+template<class T, class A> inline
+T const&
+rhx_vector<T, A>::front() const noexcept
+{
+    return data()[0];
+}
+
+template<class T, class A> inline
+T&
+rhx_vector<T, A>::back() noexcept
+{
+    return data()[m_size - 1];
+}
+
+template<class T, class A> inline
+T const&
+rhx_vector<T, A>::back() const noexcept
+{
+    return data()[m_size - 1];
+}
+
+//------
+//
+template<class T, class A>
+void
+rhx_vector<T, A>::reserve(size_type n)
+{
+    if (n > m_capacity)
+    {
+        if (n > max_size())
+        {
+            throw std::length_error("rhx_vector::reserve");
+        }
+        grow(n);
+    }
+}
+
+template<class T, class A>
+void
+rhx_vector<T, A>::resize(size_type n)
+{
+    if (n > m_capacity)
+    {
+        if (n > max_size())
+        {
+            throw std::length_error("rhx_vector::resize");
+        }
+        grow(next_capacity(n));
+    }
+    while (m_size < n)
+    {
+        alloc_traits::construct(m_alloc, data() + m_size);
+        ++m_size;
+    }
+    while (m_size > n)
+    {
+        pop_back();
+    }
+}
+
+template<class T, class A>
+void
+rhx_vector<T, A>::resize(size_type n, T const& value)
+{
+    if (n > m_capacity)
+    {
+        if (n > max_size())
+        {
+            throw std::length_error("rhx_vector::resize");
+        }
+        grow(next_capacity(n));
+    }
+    if (m_size < n)
+    {
+        fill_range(data() + m_size, n - m_size, value, bulk_copy());
+        m_size = n;
+    }
+    while (m_size > n)
+    {
+        pop_back();
+    }
+}
+
+template<class T, class A>
+void
+rhx_vector<T, A>::clear() noexcept
+{
+    T*  p = data();
+
+    for (size_type i = 0;  i < m_size;  ++i)
+    {
+        alloc_traits::destroy(m_alloc, p + i);
+    }
+    m_size = 0;
+}
+
+template<class T, class A>
+void
+rhx_vector<T, A>::swap(rhx_vector& other) noexcept
+{
+    using std::swap;
+
+    swap(m_data, other.m_data);
+    swap(m_size, other.m_size);
+    swap(m_capacity, other.m_capacity);
+    swap(m_alloc, other.m_alloc);
+}
+
+//------
+//
+template<class T, class A> inline
+void
+rhx_vector<T, A>::push_back(T const& value)
+{
+    emplace_back(value);
+}
+
+template<class T, class A> inline
+void
+rhx_vector<T, A>::push_back(T&& value)
+{
+    emplace_back(std::move(value));
+}
+
+//- The new element is constructed in a local first when the storage must grow, since the
+//  arguments may refer to existing elements that are about to be moved.
+//
+template<class T, class A>
+template<class... Args>
+T&
+rhx_vector<T, A>::emplace_back(Args&&... args)
+{
+    if (m_size == m_capacity)
+    {
+        size_type   new_capacity = next_capacity(m_size + 1);
+
+        if (m_data  &&  rhx_expand_in_place(m_alloc, m_data, m_capacity, new_capacity))
+        {
+            m_capacity = new_capacity;
+        }
+        else
+        {
+            T   tmp(std::forward<Args>(args)...);
+
+            reallocate(new_capacity);
+            alloc_traits::construct(m_alloc, data() + m_size, std::move(tmp));
+            return data()[m_size++];
+        }
+    }
+
+    alloc_traits::construct(m_alloc, data() + m_size, std::forward<Args>(args)...);
+    return data()[m_size++];
+}
+
+template<class T, class A> inline
+void
+rhx_vector<T, A>::pop_back() noexcept
+{
+    alloc_traits::destroy(m_alloc, data() + --m_size);
+}
+
+template<class T, class A>
+template<class InIt> inline
+void
+rhx_vector<T, A>::append(InIt first, InIt last)
+{
+    append_range(first, last, typename std::iterator_traits<InIt>::iterator_category());
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::insert(const_iterator pos, T const& value)
+{
+    size_type   index = static_cast<size_type>(pos - data());
+
+    emplace_back(value);
+    std::rotate(data() + index, data() + m_size - 1, data() + m_size);
+
+    return data() + index;
+}
+
+template<class T, class A>
+template<class InIt> inline
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::insert(const_iterator pos, InIt first, InIt last)
+{
+    return insert_range(static_cast<size_type>(pos - data()), first, last,
+                        is_bulk_source<InIt>());
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::erase(const_iterator pos)
+{
+    return erase(pos, pos + 1);
+}
+
+template<class T, class A>
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::erase(const_iterator first, const_iterator last)
+{
+    T*          p     = data();
+    size_type   index = static_cast<size_type>(first - p);
+    size_type   count = static_cast<size_type>(last - first);
+
+    if (count != 0)
+    {
+        std::move(p + index + count, p + m_size, p + index);
+
+        for (size_type i = m_size - count;  i < m_size;  ++i)
+        {
+            alloc_traits::destroy(m_alloc, p + i);
+        }
+        m_size -= count;
+    }
+
+    return p + index;
+}
+
+template<class T, class A> inline
+typename rhx_vector<T, A>::allocator_type
+rhx_vector<T, A>::get_allocator() const
+{
+    return m_alloc;
+}
+
+//- Reports the element block, and its first m_size elements, to a heap compactor's visitor.
+//
+template<class T, class A>
+template<class V> inline
+void
+rhx_vector<T, A>::trace(V& visitor)
+{
+    visitor(m_data, m_size);
+}
+
+//------
+//
+//- Doubles the capacity, but never past max_size(), so that growth cannot overflow the size of
+//  the block.
+//
+template<class T, class A> inline
+typename rhx_vector<T, A>::size_type
+rhx_vector<T, A>::next_capacity(size_type min_capacity) const noexcept
+{
+    size_type   limit = max_size();
+    size_type   grown = (m_capacity < limit / 2) ? 2 * m_capacity : limit;
+
+    return std::max<size_type>(std::max<size_type>(grown, min_capacity), 8);
+}
+
+//- Grows the storage to new_capacity, in place if possible, otherwise by moving the elements
+//  to a new block.
+//
+template<class T, class A>
+void
+rhx_vector<T, A>::grow(size_type new_capacity)
+{
+    if (m_data  &&  rhx_expand_in_place(m_alloc, m_data, m_capacity, new_capacity))
+    {
+        m_capacity = new_capacity;
+    }
+    else
+    {
+        reallocate(new_capacity);
+    }
+}
+
+template<class T, class A>
+void
+rhx_vector<T, A>::reallocate(size_type new_capacity)
+{
+    pointer     pnew = alloc_traits::allocate(m_alloc, new_capacity);
+
+    try
+    {
+        relocate_range(std::addressof(*pnew), data(), m_size, bulk_copy());
+    }
+    catch (...)
+    {
+        alloc_traits::deallocate(m_alloc, pnew, new_capacity);
+        throw;
+    }
+
+    size_type   size = m_size;
+
+    release();
+    m_data     = pnew;
+    m_size     = size;
+    m_capacity = new_capacity;
+}
+
+template<class T, class A>
+void
+rhx_vector<T, A>::release() noexcept
+{
+    if (m_data)
+    {
+        clear();
+        alloc_traits::deallocate(m_alloc, m_data, m_capacity);
+        m_data     = nullptr;
+        m_capacity = 0;
+    }
+}
+
+//------
+//
+template<class T, class A>
+template<class InIt>
+void
+rhx_vector<T, A>::append_range(InIt first, InIt last, std::input_iterator_tag)
+{
+    for (;  first != last;  ++first)
+    {
+        emplace_back(*first);
+    }
+}
+
+//- When the storage must move, the new elements are constructed in the new block before the
+//  existing ones are relocated, since the source range may lie within the current storage.
+//
+template<class T, class A>
+template<class FwdIt>
+void
+rhx_vector<T, A>::append_range(FwdIt first, FwdIt last, std::forward_iterator_tag)
+{
+    using source_kind = is_bulk_source<FwdIt>;
+
+    size_type   n = static_cast<size_type>(std::distance(first, last));
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    if (m_size + n > m_capacity)
+    {
+        size_type   new_capacity = next_capacity(m_size + n);
+
+        if (m_data  &&  rhx_expand_in_place(m_alloc, m_data, m_capacity, new_capacity))
+        {
+            m_capacity = new_capacity;
+        }
+        else
+        {
+            pointer     pnew = alloc_traits::allocate(m_alloc, new_capacity);
+            T*          dst  = std::addressof(*pnew);
+            size_type   i    = 0;
+
+            try
+            {
+                construct_range(dst + m_size, first, last, source_kind());
+                i = n;
+                relocate_range(dst, data(), m_size, bulk_copy());
+            }
+            catch (...)
+            {
+                while (i != 0)
+                {
+                    alloc_traits::destroy(m_alloc, dst + m_size + --i);
+                }
+                alloc_traits::deallocate(m_alloc, pnew, new_capacity);
+                throw;
+            }
+
+            size_type   size = m_size + n;
+
+            release();
+            m_data     = pnew;
+            m_size     = size;
+            m_capacity = new_capacity;
+            return;
+        }
+    }
+
+    construct_range(data() + m_size, first, last, source_kind());
+    m_size += n;
+}
+
+//- Ranges in general are appended and then rotated into place, which also takes care of a
+//  source range that lies within the vector.
+//
+template<class T, class A>
+template<class InIt>
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::insert_range(size_type index, InIt first, InIt last, std::false_type)
+{
+    size_type   old_size = m_size;
+
+    append(first, last);
+    std::rotate(data() + index, data() + old_size, data() + m_size);
+
+    return data() + index;
+}
+
+//- A bulk-copyable range from outside the vector is inserted by opening a gap with memmove and
+//  copying into it.
+//
+template<class T, class A>
+typename rhx_vector<T, A>::iterator
+rhx_vector<T, A>::insert_range(size_type index, T const* first, T const* last, std::true_type)
+{
+    T const*    pdata  = data();
+    bool        inside = (pdata != nullptr  &&  !std::less<T const*>()(first, pdata)  &&
+                          std::less<T const*>()(first, pdata + m_size));
+
+    if (inside)
+    {
+        return insert_range(index, first, last, std::false_type());
+    }
+
+    size_type   n = static_cast<size_type>(last - first);
+
+    if (m_size + n > m_capacity)
+    {
+        grow(next_capacity(m_size + n));
+    }
+
+    T*  p = data();
+
+    if (n != 0)
+    {
+        std::memmove(p + index + n, p + index, (m_size - index) * sizeof(T));
+        std::memcpy(p + index, first, n * sizeof(T));
+        m_size += n;
+    }
+    return p + index;
+}
+
+template<class T, class A>
+template<class FwdIt>
+void
+rhx_vector<T, A>::construct_range(T* dst, FwdIt first, FwdIt last, std::false_type)
+{
+    T*  p = dst;
+
+    try
+    {
+        for (;  first != last;  ++first, ++p)
+        {
+            alloc_traits::construct(m_alloc, p, *first);
+        }
+    }
+    catch (...)
+    {
+        while (p != dst)
+        {
+            alloc_traits::destroy(m_alloc, --p);
+        }
+        throw;
+    }
+}
+
+template<class T, class A> inline
+void
+rhx_vector<T, A>::construct_range(T* dst, T const* first, T const* last, std::true_type)
+{
+    if (first != last)
+    {
+        std::memcpy(dst, first, static_cast<size_type>(last - first) * sizeof(T));
+    }
+}
+
+template<class T, class A>
+void
+rhx_vector<T, A>::fill_range(T* dst, size_type n, T const& value, std::false_type)
+{
+    size_type   i = 0;
+
+    try
+    {
+        for (;  i < n;  ++i)
+        {
+            alloc_traits::construct(m_alloc, dst + i, value);
+        }
+    }
+    catch (...)
+    {
+        while (i != 0)
+        {
+            alloc_traits::destroy(m_alloc, dst + --i);
+        }
+        throw;
+    }
+}
+
+template<class T, class A> inline
+void
+rhx_vector<T, A>::fill_range(T* dst, size_type n, T const& value, std::true_type)
+{
+    std::uninitialized_fill_n(dst, n, value);
+}
+
+//- Moves (or copies, if moving might throw) n elements into uninitialized storage; on failure
+//  the elements constructed so far are destroyed.  The sources are left for the caller.
+//
+template<class T, class A>
+void
+rhx_vector<T, A>::relocate_range(T* dst, T* src, size_type n, std::false_type)
+{
+    size_type   i = 0;
+
+    try
+    {
+        for (;  i < n;  ++i)
+        {
+            alloc_traits::construct(m_alloc, dst + i, std::move_if_noexcept(src[i]));
+        }
+    }
+    catch (...)
+    {
+        while (i != 0)
+        {
+            alloc_traits::destroy(m_alloc, dst + --i);
+        }
+        throw;
+    }
+}
+
+template<class T, class A> inline
+void
+rhx_vector<T, A>::relocate_range(T* dst, T* src, size_type n, std::true_type)
+{
+    if (n != 0)
+    {
+        std::memcpy(dst, src, n * sizeof(T));
+    }
+}
+
+template<class T, class A> inline
+void
+swap(rhx_vector<T, A>& lhs, rhx_vector<T, A>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+template<class T, class A> inline
+bool
+operator ==(rhx_vector<T, A> const& lhs, rhx_vector<T, A> const& rhs)
+{
+    return lhs.size() == rhs.size()  &&  std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<class T, class A> inline
+bool
+operator !=(rhx_vector<T, A> const& lhs, rhx_vector<T, A> const& rhs)
+{
+    return !(lhs == rhs);
+}
+
+#endif  //- RHX_VECTOR_H_DEFINED
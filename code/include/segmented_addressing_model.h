@@ -12,12 +12,46 @@
 #include <cstddef>
 #include <cstdint>
 
+#if defined(__AVX512F__)
+    #define SEGMENTED_ADDRESSING_MODEL_AVX512
+    #include <immintrin.h>
+#elif defined(__AVX2__)
+    #define SEGMENTED_ADDRESSING_MODEL_AVX2
+    #include <immintrin.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #define SEGMENTED_ADDRESSING_MODEL_PREFETCH
+    #include <xmmintrin.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Class:
+//      storage_model_traits
+//
+//  Summary:
+//      This traits class describes the segment layout of a storage model as constant
+//      expressions, so that an addressing model can specialize its translation at compile time.
+//      The defaults are taken from the storage model's constexpr members; a storage model may
+//      specialize the class instead.
+//--------------------------------------------------------------------------------------------------
+//
+template<typename SM>
+struct storage_model_traits
+{
+    static constexpr std::size_t    first_segment  = SM::first_segment();
+    static constexpr std::size_t    segment_count  = SM::max_segment_count();
+    static constexpr std::size_t    segment_size   = SM::max_segment_size();
+    static constexpr bool           single_segment = (segment_count == 1);
+};
+
 //--------------------------------------------------------------------------------------------------
 //  Class:
 //      segmented_addressing_model
 //
 //  Summary:
-//      This class implements a based (segment:offset) addressing model.
+//      This class implements a based (segment:offset) addressing model.  When the storage
+//      model's traits say that it has a single segment, translation skips the segment table.
 //--------------------------------------------------------------------------------------------------
 //
 template<typename SM>
@@ -60,12 +94,17 @@ class segmented_addressing_model
     void        decrement(difference_type dec) noexcept;
     void        increment(difference_type inc) noexcept;
 
+    difference_type     difference(segmented_addressing_model const& other) const noexcept;
+
+    static  void    translate(segmented_addressing_model const* psrc, void** pdst, size_type n,
+                              bool prefetch = false) noexcept;
+
   private:
     friend  SM;
    
     enum : uint64_t
     {
-        offset_zero = 0u,
+        offset_zero = uint64_t(0u),
         offset_mask = (~offset_zero) >> 16
     };
 
@@ -101,10 +140,25 @@ segmented_addressing_model<SM>::operator =(std::nullptr_t) noexcept
     return *this;
 }
 
+//- With a single segment, every address whose segment field is nonzero lies in that segment,
+//  whose number is a constant; subtracting it from the stored value leaves the offset, so the
+//  translation needs only the segment's base address, a load from a fixed location.  Null
+//  pointers and ordinary addresses have a segment field of zero and are returned as stored.
+//
 template<typename SM> inline
 void*
 segmented_addressing_model<SM>::address() const noexcept
 {
+    using traits = storage_model_traits<SM>;
+
+    if (traits::single_segment)
+    {
+        uint64_t const  bias  = uint64_t(traits::first_segment) << 48;
+        uint8_t*        pbase = SM::sm_segment_addr[traits::first_segment];
+
+        return (m_addr > offset_mask) ? pbase + (m_addr - bias)
+                                      : reinterpret_cast<void*>(static_cast<uintptr_t>(m_addr));
+    }
     return SM::sm_segment_addr[m_bits.m_segment] + (m_addr & offset_mask);
 }
 
@@ -229,6 +283,20 @@ segmented_addressing_model<SM>::increment(difference_type inc) noexcept
     m_addr += inc;
 }
 
+//- Returns the distance in bytes from other to this.  Two addresses in the same segment differ
+//  only in their offsets, so no translation is needed in the usual case.
+//
+template<typename SM> inline
+typename segmented_addressing_model<SM>::difference_type
+segmented_addressing_model<SM>::difference(segmented_addressing_model const& other) const noexcept
+{
+    if (m_bits.m_segment == other.m_bits.m_segment)
+    {
+        return static_cast<difference_type>(m_addr - other.m_addr);
+    }
+    return static_cast<uint8_t const*>(address()) - static_cast<uint8_t const*>(other.address());
+}
+
 template<typename SM> inline
 segmented_addressing_model<SM>::segmented_addressing_model(size_type seg, size_type off) noexcept
 :   m_addr{off}
@@ -236,4 +304,73 @@ segmented_addressing_model<SM>::segmented_addressing_model(size_type seg, size_t
     m_bits.m_segment = static_cast<uint16_t>(seg);
 }
 
+//- Translates n addresses at once, writing the i-th result to pdst[i].  The segment bases are
+//  gathered from the storage model's segment table several at a time when AVX2 or AVX-512 is
+//  enabled.  No masking is needed for null pointers or for ordinary addresses stored by
+//  assign_from(), since both carry segment number 0, whose table entry is always null.  If
+//  requested, each result is also prefetched, so that the caller's subsequent accesses find
+//  their targets on the way into the cache; callers with large arrays should translate them in
+//  modest batches, so that the prefetched lines are still there when they are used.  With a
+//  single segment there is nothing to gather, and every address is translated by address().
+//
+template<typename SM>
+void
+segmented_addressing_model<SM>::translate
+(segmented_addressing_model const* psrc, void** pdst, size_type n, bool prefetch) noexcept
+{
+    static_assert(sizeof(segmented_addressing_model) == sizeof(uint64_t)  &&
+                  sizeof(void*) == sizeof(uint64_t), "unexpected address representation");
+
+    size_type   i = 0;
+
+#if defined(SEGMENTED_ADDRESSING_MODEL_AVX512)
+    long long const*    ptable = reinterpret_cast<long long const*>(SM::sm_segment_addr);
+    __m512i const       mask   = _mm512_set1_epi64(static_cast<long long>(offset_mask));
+    bool const          gather = !storage_model_traits<SM>::single_segment;
+
+    for (;  gather  &&  i < n;  i += 8)
+    {
+        __mmask8    lanes = (n - i >= 8) ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+        __m512i     addr  = _mm512_mask_loadu_epi64(_mm512_setzero_si512(), lanes, psrc + i);
+        __m512i     segs  = _mm512_maskz_srli_epi64(lanes, addr, 48);
+        __m512i     bases = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), lanes, segs,
+                                                        ptable, 8);
+
+        _mm512_mask_storeu_epi64(pdst + i, lanes,
+                                 _mm512_add_epi64(bases, _mm512_and_si512(addr, mask)));
+    }
+#elif defined(SEGMENTED_ADDRESSING_MODEL_AVX2)
+    long long const*    ptable = reinterpret_cast<long long const*>(SM::sm_segment_addr);
+    __m256i const       mask   = _mm256_set1_epi64x(static_cast<long long>(offset_mask));
+    bool const          gather = !storage_model_traits<SM>::single_segment;
+
+    for (;  gather  &&  i + 4 <= n;  i += 4)
+    {
+        __m256i     addr  = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(psrc + i));
+        __m256i     segs  = _mm256_srli_epi64(addr, 48);
+        __m256i     bases = _mm256_i64gather_epi64(ptable, segs, 8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pdst + i),
+                            _mm256_add_epi64(bases, _mm256_and_si256(addr, mask)));
+    }
+#endif
+
+    for (;  i < n;  ++i)
+    {
+        pdst[i] = psrc[i].address();
+    }
+
+#if defined(SEGMENTED_ADDRESSING_MODEL_PREFETCH)
+    if (prefetch)
+    {
+        for (i = 0;  i < n;  ++i)
+        {
+            _mm_prefetch(static_cast<char const*>(pdst[i]), _MM_HINT_T0);
+        }
+    }
+#else
+    (void) prefetch;
+#endif
+}
+
 #endif  //- SEGMENTED_ADDRESSING_MODEL_H_DEFINED
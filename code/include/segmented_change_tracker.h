@@ -0,0 +1,497 @@
+//==================================================================================================
+//  File:
+//      segmented_change_tracker.h
+//
+//  Summary:
+//      Defines the segmented_change_tracker<SM> class template, which captures the bytes that
+//      change in a storage model's segments as self-checking blocks of records.
+//==================================================================================================
+//
+#ifndef SEGMENTED_CHANGE_TRACKER_H_DEFINED
+#define SEGMENTED_CHANGE_TRACKER_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_change_tracker<SM>
+//
+//  Summary:
+//      This class template finds the changes made to the segments of storage model SM since
+//      the previous capture, and encodes them as a block: a header, protected along with the
+//      rest of the block by a CRC32C, followed by records that each give new contents for a
+//      byte range of a segment, or note that a segment was allocated, resized in place, or
+//      deallocated.  Applying
+//      a block's records, in order, to segments in the state of the previous capture brings
+//      them to the state of this one.  The heap journal writes such blocks to a file, and heap
+//      replication sends them to a follower.
+//
+//      Changes are found by comparing each segment with a reference copy of its state at the
+//      previous capture, one cache line at a time, and runs of changed lines become records.
+//      Pages that the storage model reports as clean (i.e., still backed by the image they were
+//      mapped from) are skipped without being compared, and the reference copy of a mapped
+//      segment is filled in lazily, the first time one of its pages is seen to be dirty; until
+//      then such a page is recorded in full.
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+class segmented_change_tracker
+{
+  public:
+    using size_type = typename SM::size_type;
+
+    struct block_header
+    {
+        uint32_t    m_magic;
+        uint32_t    m_crc;              //- CRC32C of the header (with this field zero) and records
+        uint64_t    m_sequence;
+        uint64_t    m_payload_size;     //- Bytes of records following the header
+        uint64_t    m_record_count;
+    };
+
+    struct apply_statistics
+    {
+        size_type   records;            //- Byte ranges applied
+        size_type   bytes_applied;      //- Heap bytes written
+    };
+
+    enum : uint32_t
+    {
+        block_magic = 0x4B4C424Au       //- "JBLK"
+    };
+
+    enum : size_type
+    {
+        //- No block can record more than every segment in full, plus its record headers.
+        //
+        max_payload_size = 4 * (SM::max_segments + 2) * SM::max_size
+    };
+
+  public:
+    segmented_change_tracker();
+
+    void            reset(bool current_is_known);
+    size_type       capture(uint64_t sequence);
+
+    uint8_t const*  block_data() const noexcept;
+    size_type       block_size() const noexcept;
+    size_type       bytes_recorded() const noexcept;
+
+    static  bool                check_block(block_header const& bh, uint8_t const* payload);
+    static  apply_statistics    apply_block(block_header const& bh, uint8_t const* payload);
+
+  private:
+    enum : size_type
+    {
+        max_segments = SM::max_segments,
+        page_size    = SM::page_size,
+        line_size    = 64
+    };
+
+    enum : uint32_t
+    {
+        data_record     = 0,    //- Bytes [offset, offset + length) of a segment
+        allocate_record = 1,    //- The segment was allocated with size length
+        free_record     = 2,    //- The segment was deallocated
+        resize_record   = 3     //- The segment grew or shrank in place to size length
+    };
+
+    struct record_header
+    {
+        uint32_t    m_segment;
+        uint32_t    m_kind;
+        uint64_t    m_offset;
+        uint64_t    m_length;           //- Followed by the data, padded to a multiple of 8 bytes
+    };
+
+    //- The state of a segment as of the last capture.  Pages whose bit in m_valid is clear have
+    //  not been copied yet; they are known to be clean, or are recorded in full when dirty.
+    //
+    struct reference_copy
+    {
+        struct free_deleter { void operator ()(uint8_t* p) const { std::free(p); } };
+
+        std::unique_ptr<uint8_t[], free_deleter>    m_data;
+        std::vector<bool>                           m_valid;
+        size_type                                   m_size;
+    };
+
+    using reference_pointer = std::unique_ptr<reference_copy>;
+
+    reference_pointer       m_refs[max_segments + 2];
+    std::vector<uint8_t>    m_block;
+    uint64_t                m_block_records;
+    size_type               m_bytes_recorded;
+    std::vector<bool>       m_clean;
+
+  private:
+    void    make_reference(size_type segment, bool copy);
+    void    resize_reference(size_type segment);
+    void    diff_segment(size_type segment);
+    void    diff_page(size_type segment, size_type page);
+    void    add_record(uint32_t segment, uint32_t kind, uint64_t offset, uint64_t length,
+                       void const* pdata);
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_change_tracker<SM>
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+segmented_change_tracker<SM>::segmented_change_tracker()
+:   m_refs{}
+,   m_block()
+,   m_block_records{0}
+,   m_bytes_recorded{0}
+,   m_clean()
+{}
+
+//- Forgets all reference copies.  If the current contents of the segments are known to the
+//  consumer of the blocks (e.g., they are in a snapshot that a journal follows), references are
+//  taken of them; mapped segments' references are filled in lazily, and others are copied
+//  outright.  Otherwise the next capture records every segment in full, as newly allocated.
+//
+template<class SM>
+void
+segmented_change_tracker<SM>::reset(bool current_is_known)
+{
+    for (size_type i = SM::first_segment();  i <= max_segments;  ++i)
+    {
+        m_refs[i].reset();
+
+        if (current_is_known  &&  SM::segment_address(i) != nullptr)
+        {
+            make_reference(i, !SM::find_clean_pages(i, m_clean));
+        }
+    }
+}
+
+//- Builds a block holding every change made since the previous capture, and returns the number
+//  of records in it; if there are none, the block is left empty.  The allocation strategy is
+//  asked to store its bookkeeping in the heap first, so that the block carries it as well.
+//
+template<class SM>
+typename segmented_change_tracker<SM>::size_type
+segmented_change_tracker<SM>::capture(uint64_t sequence)
+{
+    SM::store_state();
+
+    m_block.assign(sizeof(block_header), 0);
+    m_block_records = 0;
+
+    for (size_type i = SM::first_segment();  i <= max_segments;  ++i)
+    {
+        diff_segment(i);
+    }
+
+    if (m_block_records == 0)
+    {
+        m_block.clear();
+        return 0;
+    }
+
+    block_header    bh = {block_magic, 0, sequence, m_block.size() - sizeof(block_header),
+                          m_block_records};
+    uint8_t const*  pp = m_block.data() + sizeof(block_header);
+
+    bh.m_crc = SM::checksum(pp, bh.m_payload_size, SM::checksum(&bh, sizeof(bh)));
+    std::memcpy(m_block.data(), &bh, sizeof(bh));
+
+    return static_cast<size_type>(m_block_records);
+}
+
+template<class SM> inline
+uint8_t const*
+segmented_change_tracker<SM>::block_data() const noexcept
+{
+    return m_block.data();
+}
+
+template<class SM> inline
+typename segmented_change_tracker<SM>::size_type
+segmented_change_tracker<SM>::block_size() const noexcept
+{
+    return m_block.size();
+}
+
+template<class SM> inline
+typename segmented_change_tracker<SM>::size_type
+segmented_change_tracker<SM>::bytes_recorded() const noexcept
+{
+    return m_bytes_recorded;
+}
+
+template<class SM>
+bool
+segmented_change_tracker<SM>::check_block(block_header const& bh, uint8_t const* payload)
+{
+    block_header    check = bh;
+
+    check.m_crc = 0;
+
+    return bh.m_magic == block_magic  &&  bh.m_payload_size <= max_payload_size  &&
+           SM::checksum(payload, static_cast<size_type>(bh.m_payload_size),
+                        SM::checksum(&check, sizeof(check))) == bh.m_crc;
+}
+
+//- Applies the records of a block that has passed check_block().  An allocation record gives
+//  a fresh, zero-filled segment, even if the segment number was in use.  The allocation strategy
+//  then reloads its bookkeeping from the heap before it next allocates.
+//
+template<class SM>
+typename segmented_change_tracker<SM>::apply_statistics
+segmented_change_tracker<SM>::apply_block(block_header const& bh, uint8_t const* payload)
+{
+    apply_statistics    stats = {};
+    uint8_t const*      pnext = payload;
+
+    for (uint64_t i = 0;  i < bh.m_record_count;  ++i)
+    {
+        record_header   rh;
+
+        std::memcpy(&rh, pnext, sizeof(rh));
+        pnext += sizeof(rh);
+
+        if (rh.m_segment < SM::first_segment()  ||  rh.m_segment > max_segments)
+        {
+            throw std::runtime_error("change record names an invalid segment");
+        }
+
+        if (rh.m_kind == allocate_record)
+        {
+            SM::deallocate_segment(rh.m_segment);
+            SM::allocate_segment(rh.m_segment, static_cast<size_type>(rh.m_length));
+        }
+        else if (rh.m_kind == free_record)
+        {
+            SM::deallocate_segment(rh.m_segment);
+        }
+        else if (rh.m_kind == resize_record)
+        {
+            if (SM::segment_address(rh.m_segment) == nullptr)
+            {
+                throw std::runtime_error("change record resizes a missing segment");
+            }
+            SM::resize_segment(rh.m_segment, static_cast<size_type>(rh.m_length));
+        }
+        else
+        {
+            if (SM::segment_address(rh.m_segment) == nullptr  ||
+                rh.m_offset + rh.m_length > SM::segment_size(rh.m_segment))
+            {
+                throw std::runtime_error("change record lies outside its segment");
+            }
+            std::memcpy(SM::segment_address(rh.m_segment) + rh.m_offset, pnext,
+                        static_cast<size_type>(rh.m_length));
+            pnext += (rh.m_length + 7) & ~uint64_t(7);
+
+            stats.records       += 1;
+            stats.bytes_applied += static_cast<size_type>(rh.m_length);
+        }
+    }
+
+    SM::reload_state();
+    return stats;
+}
+
+template<class SM>
+void
+segmented_change_tracker<SM>::make_reference(size_type segment, bool copy)
+{
+    size_type   size   = SM::segment_size(segment);
+    size_type   npages = (size + page_size - 1) / page_size;
+    auto        pref   = reference_pointer(new reference_copy);
+
+    //- calloc() leaves large blocks untouched until they are written, so an untouched reference
+    //  costs no memory.
+    //
+    pref->m_data.reset(static_cast<uint8_t*>(std::calloc(size != 0 ? size : 1, 1)));
+    pref->m_size = size;
+
+    if (!pref->m_data)
+    {
+        throw std::bad_alloc();
+    }
+
+    if (copy)
+    {
+        std::memcpy(pref->m_data.get(), SM::segment_address(segment), size);
+    }
+    pref->m_valid.assign(npages, copy);
+
+    m_refs[segment] = std::move(pref);
+}
+
+//- Brings a reference copy to the segment's new size.  Bytes past the end of a segment are
+//  always zero, so the reference is extended with zeros, and those it gives up are cleared.
+//
+template<class SM>
+void
+segmented_change_tracker<SM>::resize_reference(size_type segment)
+{
+    reference_copy&     ref      = *m_refs[segment];
+    size_type const     old_size = ref.m_size;
+    size_type const     size     = SM::segment_size(segment);
+    size_type const     npages   = (size + page_size - 1) / page_size;
+
+    if (size > old_size)
+    {
+        using data_pointer = decltype(ref.m_data);
+
+        data_pointer    pdata(static_cast<uint8_t*>(std::calloc(size, 1)));
+
+        if (!pdata)
+        {
+            throw std::bad_alloc();
+        }
+
+        //- Only valid pages are copied, so that untouched parts of the new copy stay untouched.
+        //
+        for (size_type page = 0;  page < ref.m_valid.size();  ++page)
+        {
+            size_type   first = page * page_size;
+            size_type   n     = (first + page_size < old_size) ? size_type(page_size)
+                                                               : old_size - first;
+            if (ref.m_valid[page])
+            {
+                std::memcpy(pdata.get() + first, ref.m_data.get() + first, n);
+            }
+        }
+        ref.m_data = std::move(pdata);
+    }
+    else
+    {
+        size_type   end = npages * page_size;
+
+        std::memset(ref.m_data.get() + size, 0, ((end < old_size) ? end : old_size) - size);
+    }
+
+    ref.m_valid.resize(npages, true);
+    ref.m_size = size;
+}
+
+//- Records the changes to one segment, including its allocation, resizing, or deallocation.
+//  A segment that is new to the tracker is compared against zeros, which is what a newly
+//  allocated segment holds, and is compared in full, since the consumer has none of its pages.
+//  Bytes gained by growing also start out as zeros on both sides, so only those written since
+//  are recorded.
+//
+template<class SM>
+void
+segmented_change_tracker<SM>::diff_segment(size_type segment)
+{
+    uint8_t const*  pseg = SM::segment_address(segment);
+
+    if (pseg == nullptr)
+    {
+        if (m_refs[segment])
+        {
+            add_record(static_cast<uint32_t>(segment), free_record, 0, 0, nullptr);
+            m_refs[segment].reset();
+        }
+        return;
+    }
+
+    if (!m_refs[segment])
+    {
+        add_record(static_cast<uint32_t>(segment), allocate_record, 0,
+                   SM::segment_size(segment), nullptr);
+        make_reference(segment, false);
+        m_refs[segment]->m_valid.assign(m_refs[segment]->m_valid.size(), true);
+        m_clean.assign(m_refs[segment]->m_valid.size(), false);
+    }
+    else
+    {
+        if (m_refs[segment]->m_size != SM::segment_size(segment))
+        {
+            add_record(static_cast<uint32_t>(segment), resize_record, 0,
+                       SM::segment_size(segment), nullptr);
+            resize_reference(segment);
+        }
+        SM::find_clean_pages(segment, m_clean);
+    }
+
+    for (size_type page = 0;  page < m_clean.size();  ++page)
+    {
+        if (!m_clean[page])
+        {
+            diff_page(segment, page);
+        }
+    }
+}
+
+//- Compares a page with its reference one cache line at a time, recording each run of changed
+//  lines as one byte range; a page with no valid reference is recorded in full.
+//
+template<class SM>
+void
+segmented_change_tracker<SM>::diff_page(size_type segment, size_type page)
+{
+    reference_copy&     ref   = *m_refs[segment];
+    size_type const     first = page * page_size;
+    size_type const     last  = (first + page_size < ref.m_size) ? first + page_size : ref.m_size;
+    uint8_t const*      pseg  = SM::segment_address(segment);
+    uint8_t*            pref  = ref.m_data.get();
+
+    if (!ref.m_valid[page])
+    {
+        add_record(static_cast<uint32_t>(segment), data_record, first, last - first, pseg + first);
+        std::memcpy(pref + first, pseg + first, last - first);
+        ref.m_valid[page] = true;
+        return;
+    }
+
+    size_type   run = last;         //- Start of the current run of changed lines, if any
+
+    for (size_type at = first;  at < last;  at += line_size)
+    {
+        size_type   n       = (at + line_size < last) ? size_type(line_size) : last - at;
+        bool        changed = std::memcmp(pseg + at, pref + at, n) != 0;
+
+        if (changed  &&  run == last)
+        {
+            run = at;
+        }
+        else if (!changed  &&  run != last)
+        {
+            add_record(static_cast<uint32_t>(segment), data_record, run, at - run, pseg + run);
+            std::memcpy(pref + run, pseg + run, at - run);
+            run = last;
+        }
+    }
+    if (run != last)
+    {
+        add_record(static_cast<uint32_t>(segment), data_record, run, last - run, pseg + run);
+        std::memcpy(pref + run, pseg + run, last - run);
+    }
+}
+
+template<class SM>
+void
+segmented_change_tracker<SM>::add_record
+(uint32_t segment, uint32_t kind, uint64_t offset, uint64_t length, void const* pdata)
+{
+    record_header   rh   = {segment, kind, offset, length};
+    size_type       size = (kind == data_record) ? static_cast<size_type>(length) : 0;
+    size_type       at   = m_block.size();
+
+    m_block.resize(at + sizeof(rh) + ((size + 7) & ~size_type(7)));
+    std::memcpy(m_block.data() + at, &rh, sizeof(rh));
+
+    if (size != 0)
+    {
+        std::memcpy(m_block.data() + at + sizeof(rh), pdata, size);
+        m_bytes_recorded += size;
+    }
+    ++m_block_records;
+}
+
+#endif  //- SEGMENTED_CHANGE_TRACKER_H_DEFINED
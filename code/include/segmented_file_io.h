@@ -0,0 +1,204 @@
+//==================================================================================================
+//  File:
+//      segmented_file_io.h
+//
+//  Summary:
+//      Defines thin wrappers over the unbuffered file primitives used to store and ship blocks
+//      of segment changes.
+//==================================================================================================
+//
+#ifndef SEGMENTED_FILE_IO_H_DEFINED
+#define SEGMENTED_FILE_IO_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+    #include <fcntl.h>
+    #include <io.h>
+    #include <share.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Class:
+//      segmented_file_io
+//
+//  Summary:
+//      This class gathers the few descriptor-level operations needed by the heap journal and
+//      by heap replication, so that the POSIX and Windows spellings live in one place.  The
+//      functions work on any descriptor (file, pipe, or socket) where that makes sense, and
+//      report failure by their return values.
+//--------------------------------------------------------------------------------------------------
+//
+class segmented_file_io
+{
+  public:
+    using size_type = std::size_t;
+
+  public:
+    static  int         open_file(char const* path, bool create);
+    static  void        close_file(int fd);
+
+    static  bool        write_all(int fd, void const* pdata, size_type n);
+    static  bool        read_all(int fd, void* pdata, size_type n);
+    static  size_type   read_some(int fd, void* pdata, size_type n);
+    static  long long   read_once(int fd, void* pdata, size_type n);
+    static  bool        readable(int fd, bool wait);
+
+    static  bool        seek_file(int fd, uint64_t offset);
+    static  bool        sync_file(int fd);
+    static  bool        truncate_file(int fd, uint64_t size);
+
+  private:
+    enum : size_type
+    {
+        max_chunk = 1u << 30        //- Largest transfer made by one call
+    };
+};
+
+
+inline int
+segmented_file_io::open_file(char const* path, bool create)
+{
+#if defined(_WIN32)
+    int     fd    = -1;
+    int     flags = _O_RDWR | _O_BINARY | (create ? _O_CREAT : 0);
+
+    return (_sopen_s(&fd, path, flags, _SH_DENYWR, _S_IREAD | _S_IWRITE) == 0) ? fd : -1;
+#else
+    return ::open(path, O_RDWR | (create ? O_CREAT : 0), 0644);
+#endif
+}
+
+inline void
+segmented_file_io::close_file(int fd)
+{
+#if defined(_WIN32)
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+inline bool
+segmented_file_io::write_all(int fd, void const* pdata, size_type n)
+{
+    uint8_t const*  pbyte = static_cast<uint8_t const*>(pdata);
+
+    while (n > 0)
+    {
+        size_type   chunk = (n < max_chunk) ? n : size_type(max_chunk);
+#if defined(_WIN32)
+        long long   done  = _write(fd, pbyte, static_cast<unsigned>(chunk));
+#else
+        long long   done  = ::write(fd, pbyte, chunk);
+#endif
+        if (done <= 0)
+        {
+            return false;
+        }
+        pbyte += done;
+        n     -= static_cast<size_type>(done);
+    }
+    return true;
+}
+
+inline bool
+segmented_file_io::read_all(int fd, void* pdata, size_type n)
+{
+    return read_some(fd, pdata, n) == n;
+}
+
+//- Reads until n bytes have arrived or the end of the data is reached, returning the count.
+//
+inline segmented_file_io::size_type
+segmented_file_io::read_some(int fd, void* pdata, size_type n)
+{
+    uint8_t*    pbyte = static_cast<uint8_t*>(pdata);
+    size_type   total = 0;
+
+    while (total < n)
+    {
+        long long   done = read_once(fd, pbyte + total, n - total);
+
+        if (done <= 0)
+        {
+            break;
+        }
+        total += static_cast<size_type>(done);
+    }
+    return total;
+}
+
+//- Makes a single read, returning the number of bytes read, zero at the end of the data, or a
+//  negative value on error.
+//
+inline long long
+segmented_file_io::read_once(int fd, void* pdata, size_type n)
+{
+    size_type   chunk = (n < max_chunk) ? n : size_type(max_chunk);
+#if defined(_WIN32)
+    return _read(fd, pdata, static_cast<unsigned>(chunk));
+#else
+    return ::read(fd, pdata, chunk);
+#endif
+}
+
+//- Returns whether a read from the descriptor would not block, waiting until it would if asked.
+//  Without poll(), a descriptor is always reported as readable.
+//
+inline bool
+segmented_file_io::readable(int fd, bool wait)
+{
+#if defined(_WIN32)
+    (void) fd;
+    (void) wait;
+    return true;
+#else
+    pollfd  pfd = {fd, POLLIN, 0};
+
+    return ::poll(&pfd, 1, wait ? -1 : 0) > 0;
+#endif
+}
+
+inline bool
+segmented_file_io::seek_file(int fd, uint64_t offset)
+{
+#if defined(_WIN32)
+    return _lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) >= 0;
+#else
+    return ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) >= 0;
+#endif
+}
+
+//- fdatasync() is used where it exists, since only the data, and not the timestamps, of the
+//  file needs to be durable.
+//
+inline bool
+segmented_file_io::sync_file(int fd)
+{
+#if defined(_WIN32)
+    return _commit(fd) == 0;
+#elif defined(__APPLE__)
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+}
+
+inline bool
+segmented_file_io::truncate_file(int fd, uint64_t size)
+{
+#if defined(_WIN32)
+    return _chsize_s(fd, static_cast<__int64>(size)) == 0;
+#else
+    return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+#endif  //- SEGMENTED_FILE_IO_H_DEFINED
@@ -0,0 +1,556 @@
+//==================================================================================================
+//  File:
+//      segmented_heap_collector.h
+//
+//  Summary:
+//      Defines the segmented_heap_collector<HT> class template, a conservative mark-and-sweep
+//      collector for the blocks handed out by segmented_leaky_allocation_strategy.
+//==================================================================================================
+//
+#ifndef SEGMENTED_HEAP_COLLECTOR_H_DEFINED
+#define SEGMENTED_HEAP_COLLECTOR_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_heap_collector<HT>
+//
+//  Summary:
+//      This class template implements an optional, stop-the-world collector for the heap managed
+//      by allocation strategy HT.  Marking starts from the strategy's root area (and therefore
+//      from every object in the root directory), plus any extra roots supplied by the caller,
+//      and treats every aligned 64-bit word of a reachable block as a potential pointer: a word
+//      is taken to point into the heap if it has the shape of a synthetic pointer (a value
+//      that the strategy's addressing model decodes to a segment number in the strategy's range
+//      and an offset below that segment's used extent), or if it is an ordinary address inside
+//      one of the segments.  Interior pointers keep their whole block alive.
+//
+//      Marking runs in rounds, with one thread per segment.  Each thread scans the blocks of
+//      its own segment that have been marked but not yet scanned, and marks the blocks they
+//      refer to in any segment; rounds repeat until one completes without scanning anything.
+//      The sweep, also one thread per segment, coalesces adjacent unreachable blocks and hands
+//      them to the strategy's free lists, or back to the frontier when they end there.
+//
+//      Objects that are reachable only from outside the heap (e.g., from a synthetic pointer
+//      on the stack) must be passed to collect() as extra roots.  No destructors are run.
+//--------------------------------------------------------------------------------------------------
+//
+template<class HT>
+class segmented_heap_collector
+{
+  public:
+    using size_type        = typename HT::size_type;
+    using storage_model    = typename HT::storage_model;
+    using addressing_model = typename HT::addressing_model;
+
+    struct collection_statistics
+    {
+        size_type   blocks_live;        //- Blocks found to be reachable
+        size_type   bytes_live;         //- Bytes in reachable blocks
+        size_type   blocks_freed;       //- Unreachable blocks, before coalescing
+        size_type   bytes_freed;        //- Bytes returned to the free lists or the frontier
+        size_type   mark_rounds;        //- Rounds of parallel marking
+        size_type   threads;            //- Threads used in each round
+    };
+
+  public:
+    template<class... Ptrs>
+    static  collection_statistics   collect(Ptrs const&... extra_roots);
+
+  private:
+    enum : size_type
+    {
+        segment_count = HT::segment_count,
+        granule_size  = HT::min_alignment
+    };
+
+    using atomic_bitmap = std::unique_ptr<std::atomic<uint64_t>[]>;
+    using free_run      = std::pair<size_type, size_type>;     //- First granule, end granule
+
+    struct segment_state
+    {
+        size_type               m_segment;
+        uint8_t*                mp_base;
+        size_type               m_extent;       //- Bytes in use when the collection started
+        size_type               m_granules;
+        uint64_t const*         mp_starts;      //- The strategy's block-start bitmap
+        std::vector<uint64_t>   m_summary;      //- Bit w set if word w of mp_starts is nonzero
+        atomic_bitmap           m_marks;
+        atomic_bitmap           m_grey;         //- Marked blocks not yet scanned
+        std::vector<free_run>   m_free_runs;
+        collection_statistics   m_stats;
+    };
+
+    segment_state   m_segments[segment_count];
+
+  private:
+    segmented_heap_collector();
+
+    void        mark(size_type index, size_type offset);
+    void        mark_address(void const* p);
+    void        mark_word(uint64_t word);
+    size_type   mark_all();
+    bool        scan_grey_blocks(size_type index);
+    void        scan_block(size_type index, size_type granule);
+    void        sweep(size_type index);
+
+    bool        is_active(size_type index) const noexcept;
+    bool        is_block_start(size_type index, size_type granule) const noexcept;
+    size_type   block_start(size_type index, size_type granule) const noexcept;
+    size_type   block_end(size_type index, size_type granule) const noexcept;
+
+    static  unsigned    lowest_bit(uint64_t word) noexcept;
+    static  unsigned    highest_bit(uint64_t word) noexcept;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_heap_collector<HT>
+//--------------------------------------------------------------------------------------------------
+//
+template<class HT>
+template<class... Ptrs>
+typename segmented_heap_collector<HT>::collection_statistics
+segmented_heap_collector<HT>::collect(Ptrs const&... extra_roots)
+{
+    void const*     roots[] = { static_cast<void const*>(extra_roots)..., nullptr };
+
+    HT::root_area();
+
+    segmented_heap_collector    gc;
+    collection_statistics       stats = {};
+
+    gc.mark(0, 0);
+
+    for (void const* p : roots)
+    {
+        if (p != nullptr)
+        {
+            gc.mark_address(p);
+        }
+    }
+
+    stats.mark_rounds = gc.mark_all();
+
+    //- Reclaimed memory may have been part of a hint area, so the hint areas are forgotten
+    //  along with the old free lists, which the sweep rebuilds.
+    //
+    HT::clear_free_lists();
+
+    for (auto& row : HT::sm_hint_areas)
+    {
+        for (auto& area : row)
+        {
+            area = typename HT::hint_area{};
+        }
+    }
+
+    std::vector<std::thread>    threads;
+
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        if (gc.is_active(i))
+        {
+            threads.emplace_back([&gc, i]{ gc.sweep(i); });
+        }
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    stats.threads = threads.size();
+
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        segment_state&  seg = gc.m_segments[i];
+
+        for (free_run const& run : seg.m_free_runs)
+        {
+            size_type   offset = run.first * granule_size;
+            size_type   size   = (run.second - run.first) * granule_size;
+
+            //- A run that ends at a frontier (young or tenured) is given back to the frontier.
+            //
+            size_type*  pfrontier = HT::frontier_offset(seg.m_segment);
+
+            if (pfrontier != nullptr  &&  offset + size == *pfrontier)
+            {
+                HT::clear_block_start(seg.m_segment, offset);
+                *pfrontier = offset;
+            }
+            else
+            {
+                HT::push_free_block(seg.m_segment, offset, size);
+            }
+        }
+
+        stats.blocks_live  += seg.m_stats.blocks_live;
+        stats.bytes_live   += seg.m_stats.bytes_live;
+        stats.blocks_freed += seg.m_stats.blocks_freed;
+        stats.bytes_freed  += seg.m_stats.bytes_freed;
+    }
+
+    return stats;
+}
+
+//------
+//
+template<class HT>
+segmented_heap_collector<HT>::segmented_heap_collector()
+{
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        segment_state&  seg = m_segments[i];
+
+        seg.m_segment  = storage_model::first_segment() + i;
+        seg.mp_base    = storage_model::segment_address(seg.m_segment);
+        seg.m_extent   = HT::used_extent(seg.m_segment);
+        seg.m_granules = seg.m_extent / granule_size;
+        seg.mp_starts  = HT::sm_block_starts[i];
+        seg.m_stats    = collection_statistics{};
+
+        if (seg.m_extent != 0)
+        {
+            size_type   words = (seg.m_granules + 63) / 64;
+
+            seg.m_marks.reset(new std::atomic<uint64_t>[words]());
+            seg.m_grey.reset(new std::atomic<uint64_t>[words]());
+            seg.m_summary.assign((words + 63) / 64, 0);
+
+            for (size_type w = 0;  w < words;  ++w)
+            {
+                if (seg.mp_starts[w] != 0)
+                {
+                    seg.m_summary[w / 64] |= uint64_t(1u) << (w % 64);
+                }
+            }
+        }
+    }
+}
+
+//- Marks the block containing the given offset, and queues it for scanning if it was not
+//  already marked.
+//
+template<class HT>
+void
+segmented_heap_collector<HT>::mark(size_type index, size_type offset)
+{
+    segment_state&  seg   = m_segments[index];
+    size_type       start = block_start(index, offset / granule_size);
+    uint64_t        bit   = uint64_t(1u) << (start % 64);
+    uint64_t        prev  = seg.m_marks[start / 64].fetch_or(bit, std::memory_order_relaxed);
+
+    if ((prev & bit) == 0)
+    {
+        seg.m_grey[start / 64].fetch_or(bit, std::memory_order_release);
+    }
+}
+
+template<class HT>
+void
+segmented_heap_collector<HT>::mark_address(void const* p)
+{
+    uintptr_t   addr = reinterpret_cast<uintptr_t>(p);
+
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        uintptr_t   base = reinterpret_cast<uintptr_t>(m_segments[i].mp_base);
+
+        if (is_active(i)  &&  (addr - base) < m_segments[i].m_extent)
+        {
+            mark(i, addr - base);
+            return;
+        }
+    }
+}
+
+//- A word is a synthetic pointer candidate if, read as the strategy's addressing model would
+//  store it, it names one of the strategy's segments and an offset below that segment's used
+//  extent.  Decoding through the addressing model, rather than assuming its layout, matters
+//  for models such as fixed_addressing_model, whose stored values are addresses only while the
+//  segments happen to be mapped at their slots.
+//
+template<class HT>
+void
+segmented_heap_collector<HT>::mark_word(uint64_t word)
+{
+    static_assert(sizeof(addressing_model) == sizeof(uint64_t)  &&
+                  std::is_trivially_copyable<addressing_model>::value,
+                  "the collector requires an addressing model stored as a single 64-bit word");
+
+    addressing_model    model;
+
+    std::memcpy(static_cast<void*>(&model), &word, sizeof(word));
+
+    size_type   index = model.segment() - storage_model::first_segment();
+
+    if (index < segment_count)
+    {
+        size_type   offset = model.offset();
+
+        if (offset < m_segments[index].m_extent)
+        {
+            mark(index, offset);
+        }
+        return;
+    }
+
+    mark_address(reinterpret_cast<void const*>(static_cast<uintptr_t>(word)));
+}
+
+//- Runs rounds of marking, one thread per active segment, until a round scans no blocks.
+//  Returns the number of rounds.
+//
+template<class HT>
+typename segmented_heap_collector<HT>::size_type
+segmented_heap_collector<HT>::mark_all()
+{
+    size_type   rounds = 0;
+
+    for (;;)
+    {
+        std::atomic<bool>           progress(false);
+        std::vector<std::thread>    threads;
+
+        for (size_type i = 0;  i < segment_count;  ++i)
+        {
+            if (is_active(i))
+            {
+                threads.emplace_back([this, i, &progress]
+                                     {
+                                         if (scan_grey_blocks(i))
+                                         {
+                                             progress.store(true);
+                                         }
+                                     });
+            }
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+
+        ++rounds;
+
+        if (!progress.load())
+        {
+            return rounds;
+        }
+    }
+}
+
+//- Scans the segment's grey blocks until none remain, returning whether any were found.  Other
+//  threads may add grey blocks to this segment concurrently; those that arrive after the final
+//  pass are picked up in the next round.
+//
+template<class HT>
+bool
+segmented_heap_collector<HT>::scan_grey_blocks(size_type index)
+{
+    segment_state&  seg     = m_segments[index];
+    size_type       words   = (seg.m_granules + 63) / 64;
+    bool            scanned = false;
+    bool            found   = true;
+
+    while (found)
+    {
+        found = false;
+
+        for (size_type w = 0;  w < words;  ++w)
+        {
+            uint64_t    grey = seg.m_grey[w].exchange(0, std::memory_order_acquire);
+
+            while (grey != 0)
+            {
+                scan_block(index, w * 64 + lowest_bit(grey));
+                grey &= grey - 1;
+                found = true;
+            }
+        }
+        scanned = scanned || found;
+    }
+
+    return scanned;
+}
+
+template<class HT>
+void
+segmented_heap_collector<HT>::scan_block(size_type index, size_type granule)
+{
+    segment_state&  seg = m_segments[index];
+    uint8_t const*  pb  = seg.mp_base + granule * granule_size;
+    uint8_t const*  pe  = seg.mp_base + block_end(index, granule) * granule_size;
+
+    for (;  pb < pe;  pb += sizeof(uint64_t))
+    {
+        mark_word(*reinterpret_cast<uint64_t const*>(pb));
+    }
+}
+
+//- Walks the segment's blocks in address order, counting live blocks and merging runs of
+//  unreachable ones into single free blocks.
+//
+template<class HT>
+void
+segmented_heap_collector<HT>::sweep(size_type index)
+{
+    segment_state&  seg       = m_segments[index];
+    size_type       run_start = seg.m_granules;     //- No run in progress
+
+    for (size_type g = 0;  g < seg.m_granules;  )
+    {
+        size_type   end  = block_end(index, g);
+        size_type   size = (end - g) * granule_size;
+        bool        live = (seg.m_marks[g / 64].load(std::memory_order_relaxed) >> (g % 64)) & 1u;
+
+        if (live)
+        {
+            seg.m_stats.blocks_live += 1;
+            seg.m_stats.bytes_live  += size;
+
+            if (run_start != seg.m_granules)
+            {
+                seg.m_free_runs.emplace_back(run_start, g);
+                run_start = seg.m_granules;
+            }
+        }
+        else
+        {
+            seg.m_stats.blocks_freed += 1;
+            seg.m_stats.bytes_freed  += size;
+
+            if (run_start == seg.m_granules)
+            {
+                run_start = g;
+            }
+            else
+            {
+                HT::clear_block_start(seg.m_segment, g * granule_size);
+            }
+        }
+        g = end;
+    }
+
+    if (run_start != seg.m_granules)
+    {
+        seg.m_free_runs.emplace_back(run_start, seg.m_granules);
+    }
+}
+
+//------
+//
+template<class HT> inline
+bool
+segmented_heap_collector<HT>::is_active(size_type index) const noexcept
+{
+    return m_segments[index].m_extent != 0;
+}
+
+template<class HT> inline
+bool
+segmented_heap_collector<HT>::is_block_start(size_type index, size_type granule) const noexcept
+{
+    return (m_segments[index].mp_starts[granule / 64] >> (granule % 64)) & 1u;
+}
+
+//- Returns the granule at which the block containing the given granule begins.
+//
+template<class HT>
+typename segmented_heap_collector<HT>::size_type
+segmented_heap_collector<HT>::block_start(size_type index, size_type granule) const noexcept
+{
+    segment_state const&    seg  = m_segments[index];
+    size_type               w    = granule / 64;
+    uint64_t                bits = seg.mp_starts[w] & (~uint64_t(0u) >> (63 - granule % 64));
+
+    //- Interior pointers into large blocks are common, so the nearest nonzero word below is
+    //  found through the summary, 64 words at a time.
+    //
+    if (bits == 0  &&  w != 0)
+    {
+        size_type   s     = (w - 1) / 64;
+        uint64_t    sbits = seg.m_summary[s] & (~uint64_t(0u) >> (63 - (w - 1) % 64));
+
+        while (sbits == 0  &&  s != 0)
+        {
+            sbits = seg.m_summary[--s];
+        }
+        if (sbits != 0)
+        {
+            w    = s * 64 + highest_bit(sbits);
+            bits = seg.mp_starts[w];
+        }
+    }
+
+    return (bits != 0) ? w * 64 + highest_bit(bits) : granule;
+}
+
+//- Returns the granule at which the block beginning at the given granule ends; the last block
+//  in a segment extends to the segment's used extent.
+//
+template<class HT>
+typename segmented_heap_collector<HT>::size_type
+segmented_heap_collector<HT>::block_end(size_type index, size_type granule) const noexcept
+{
+    segment_state const&    seg   = m_segments[index];
+    size_type               next  = granule + 1;
+    size_type               words = (seg.m_granules + 63) / 64;
+
+    if (next >= seg.m_granules)
+    {
+        return seg.m_granules;
+    }
+
+    size_type   w    = next / 64;
+    uint64_t    bits = seg.mp_starts[w] & (~uint64_t(0u) << (next % 64));
+
+    while (bits == 0  &&  ++w < words)
+    {
+        bits = seg.mp_starts[w];
+    }
+
+    return (bits != 0) ? std::min<size_type>(w * 64 + lowest_bit(bits), seg.m_granules)
+                       : seg.m_granules;
+}
+
+template<class HT> inline
+unsigned
+segmented_heap_collector<HT>::lowest_bit(uint64_t word) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long   index;
+    _BitScanForward64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+template<class HT> inline
+unsigned
+segmented_heap_collector<HT>::highest_bit(uint64_t word) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long   index;
+    _BitScanReverse64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(63 - __builtin_clzll(word));
+#endif
+}
+
+#endif  //- SEGMENTED_HEAP_COLLECTOR_H_DEFINED
@@ -0,0 +1,659 @@
+//==================================================================================================
+//  File:
+//      segmented_heap_compactor.h
+//
+//  Summary:
+//      Defines the segmented_heap_compactor<HT> class template, a copying compactor for the
+//      blocks handed out by segmented_leaky_allocation_strategy.
+//==================================================================================================
+//
+#ifndef SEGMENTED_HEAP_COMPACTOR_H_DEFINED
+#define SEGMENTED_HEAP_COMPACTOR_H_DEFINED
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "synthetic_pointer_interface.h"
+#include "rhx_root_directory.h"
+#include "rhx_trace_traits.h"
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_heap_compactor<HT>
+//
+//  Summary:
+//      This class template implements an optional, stop-the-world compactor for the heap
+//      managed by allocation strategy HT.  After a long run with collections, live blocks are
+//      left scattered among free ones across partly used segments; compacting copies every
+//      block reachable from the registered roots into a dense prefix of the segments, rewrites
+//      the synthetic pointers to them, and shrinks each segment to what it then holds, so that
+//      the storage model can give the pages of vacated segments back to the system.
+//
+//      Unlike the collector, the compactor is precise: it follows only the pointers that
+//      rhx_trace_traits reports, and a block is traced as an array of the type of the first
+//      pointer that reaches it.  A container whose block is not such an array, such as a hash
+//      table's slots, reports it as a void pointer and traces the contents itself.  Blocks are
+//      found breadth-first from the roots, in the manner of Cheney's algorithm, and copied in
+//      that order, so that a chain of nodes (such as a list, or the leaves of a tree) comes out
+//      laid out in iteration order with each node's own blocks beside it.  Tenured blocks stay
+//      in the tenured segment.  Interior pointers are rewritten with the same offset into the
+//      moved block.
+//
+//      Roots are pointers held outside the moved blocks: in ordinary memory, in the strategy's
+//      root area (which never moves), or in the root directory, whose entries are registered
+//      by name.  Everything not reachable from a root is discarded, including objects named in
+//      the root directory that were not registered; their entries are withdrawn, while those of
+//      unregistered objects that are reachable from a root are rewritten with the rest.  No
+//      constructors or destructors are run, and the heap must not be used by other threads, or
+//      be in a transaction, meanwhile.
+//--------------------------------------------------------------------------------------------------
+//
+template<class HT>
+class segmented_heap_compactor
+{
+  public:
+    using size_type     = typename HT::size_type;
+    using storage_model = typename HT::storage_model;
+
+    template<class T>
+    using pointer       = typename HT::template rebind_pointer<T>;
+
+    struct compaction_statistics
+    {
+        size_type   blocks_moved;       //- Reachable blocks copied
+        size_type   bytes_moved;        //- Bytes in those blocks
+        size_type   bytes_before;       //- Sum of the segments' used extents before compacting
+        size_type   bytes_after;        //- Sum of the segments' used extents afterwards
+        size_type   bytes_released;     //- Bytes by which the segments were shrunk
+        size_type   segments_vacated;   //- Segments that held blocks before and none after
+    };
+
+  public:
+    segmented_heap_compactor() = default;
+    segmented_heap_compactor(segmented_heap_compactor const&) = delete;
+
+    segmented_heap_compactor&   operator =(segmented_heap_compactor const&) = delete;
+
+    template<class T>
+    void    add_root(pointer<T>& root, size_type count = 1);
+    template<class T>
+    void    add_root(char const* name);
+
+    compaction_statistics   compact();
+
+    //- The visitor interface called by rhx_trace_traits; ordinary pointers are left alone.
+    //
+    template<class T>
+    void    operator ()(pointer<T>& p, size_type count = 1);
+    template<class T>
+    void    operator ()(T*& p, size_type count = 1) noexcept;
+
+  private:
+    enum : size_type
+    {
+        segment_count = HT::segment_count,
+        granule_size  = HT::min_alignment
+    };
+
+    using tracer       = void (*)(void* pobj, size_type count, segmented_heap_compactor& c);
+    using void_pointer = typename HT::void_pointer;
+
+    struct root_entry
+    {
+        void*       mp_root;
+        size_type   m_count;
+        tracer      m_visit;
+    };
+
+    struct live_block
+    {
+        size_type   m_index;            //- Segment index and offset before compacting
+        size_type   m_offset;
+        size_type   m_size;
+        size_type   m_new_index;        //- Segment index and offset afterwards
+        size_type   m_new_offset;
+        size_type   m_object;           //- Offset within the block of the traced objects
+        size_type   m_count;
+        size_type   m_align;
+        tracer      m_tracer;
+    };
+
+    std::vector<root_entry>         m_roots;
+    std::vector<void_pointer*>      m_named;        //- Unregistered directory entries kept
+    std::vector<live_block>         m_blocks;
+    std::map<uint64_t, size_type>   m_forward;      //- Old block location to index in m_blocks
+    size_type                       m_extents[segment_count];
+    bool                            m_fixing = false;
+
+  private:
+    template<class T>
+    static  void    trace_objects(void* pobj, size_type count, segmented_heap_compactor& c);
+    template<class T>
+    static  void    visit_root(void* proot, size_type count, segmented_heap_compactor& c);
+    template<class T>
+    static  void    visit_named_root(void* proot, size_type count, segmented_heap_compactor& c);
+
+    template<class T>
+    static  tracer  tracer_for(T*) noexcept;
+    static  tracer  tracer_for(void*) noexcept;
+
+    static  uint64_t    block_key(size_type index, size_type offset) noexcept;
+    static  uint8_t*    segment_base(size_type index) noexcept;
+
+    bool        locate(void const* p, size_type& index, size_type& offset) const noexcept;
+    size_type   block_start(size_type index, size_type offset) const noexcept;
+    size_type   block_end(size_type index, size_type offset) const noexcept;
+    size_type   find_block(size_type index, size_type offset, size_type count, size_type align,
+                           tracer trace);
+    void        settle_directory();
+    void        move_blocks();
+    void        shrink_segments(compaction_statistics& stats);
+
+    static  unsigned    lowest_bit(uint64_t word) noexcept;
+    static  unsigned    highest_bit(uint64_t word) noexcept;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_heap_compactor<HT>
+//--------------------------------------------------------------------------------------------------
+//
+//- Registers a pointer, held outside the moved blocks, to count objects of type T.  The pointer
+//  itself is rewritten by compact(), so it must outlive the compactor's use.
+//
+template<class HT>
+template<class T> inline
+void
+segmented_heap_compactor<HT>::add_root(pointer<T>& root, size_type count)
+{
+    m_roots.push_back(root_entry{std::addressof(root), count, &visit_root<T>});
+}
+
+//- Registers the object of type T named in the root directory.  Names that are not in the
+//  directory are ignored.
+//
+template<class HT>
+template<class T>
+void
+segmented_heap_compactor<HT>::add_root(char const* name)
+{
+    using directory = rhx_root_directory<HT>;
+
+    auto*   pe = directory::lookup(name, directory::hash_name(name));
+
+    if (pe->m_hash != 0)
+    {
+        m_roots.push_back(root_entry{std::addressof(pe->m_object), 1, &visit_named_root<T>});
+    }
+}
+
+//- Compacts the heap in four steps: the blocks reachable from the roots are found and traced
+//  in place, and directory entries naming other blocks are withdrawn; the blocks' contents are
+//  copied aside and the strategy is reset to an empty heap; each block is allocated anew, in
+//  the order found, and its contents copied in; and finally every pointer to a moved block, in
+//  the blocks, in the roots, and in the directory, is rewritten.  The strategy's statistics are
+//  left as they were, since compacting is not allocating.
+//
+template<class HT>
+typename segmented_heap_compactor<HT>::compaction_statistics
+segmented_heap_compactor<HT>::compact()
+{
+    compaction_statistics   stats = {};
+
+    HT::root_area();
+
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        m_extents[i]        = HT::used_extent(j);
+        stats.bytes_before += m_extents[i];
+    }
+
+    m_blocks.clear();
+    m_forward.clear();
+    m_fixing = false;
+
+    for (root_entry const& root : m_roots)
+    {
+        root.m_visit(root.mp_root, root.m_count, *this);
+    }
+
+    //- Tracing a block may append others, so fields are read before each call.
+    //
+    for (size_type b = 0;  b < m_blocks.size();  ++b)
+    {
+        live_block const&   blk   = m_blocks[b];
+        tracer              trace = blk.m_tracer;
+        uint8_t*            pobj  = segment_base(blk.m_index) + blk.m_offset + blk.m_object;
+        size_type           count = blk.m_count;
+
+        if (trace != nullptr)
+        {
+            trace(pobj, count, *this);
+        }
+    }
+
+    settle_directory();
+    move_blocks();
+
+    m_fixing = true;
+
+    for (live_block const& blk : m_blocks)
+    {
+        if (blk.m_tracer != nullptr)
+        {
+            blk.m_tracer(segment_base(blk.m_new_index) + blk.m_new_offset + blk.m_object,
+                         blk.m_count, *this);
+        }
+        stats.blocks_moved += 1;
+        stats.bytes_moved  += blk.m_size;
+    }
+    for (root_entry const& root : m_roots)
+    {
+        root.m_visit(root.mp_root, root.m_count, *this);
+    }
+    for (void_pointer* pentry : m_named)
+    {
+        (*this)(*pentry);
+    }
+
+    shrink_segments(stats);
+
+    m_named.clear();
+    m_blocks.clear();
+    m_forward.clear();
+    m_fixing = false;
+
+    return stats;
+}
+
+//- While tracing, finds (and if new, queues) the block p points into; while fixing, points p
+//  at the block's new location.  Pointers outside the strategy's segments, and into the root
+//  area, are left alone.
+//
+template<class HT>
+template<class T>
+void
+segmented_heap_compactor<HT>::operator ()(pointer<T>& p, size_type count)
+{
+    size_type   index;
+    size_type   offset;
+
+    if (!p  ||  !locate(rhx_to_address(p), index, offset))
+    {
+        return;
+    }
+
+    using object_type = typename std::remove_cv<T>::type;
+    using align_type  = typename std::conditional<std::is_void<T>::value, char, T>::type;
+
+    object_type*    ptype = nullptr;
+    size_type       b     = find_block(index, offset, count, alignof(align_type),
+                                       tracer_for(ptype));
+
+    if (m_fixing)
+    {
+        live_block const&   blk = m_blocks[b];
+
+        p = pointer<T>(storage_model::segment_pointer(storage_model::first_segment() +
+                                                      blk.m_new_index,
+                                                      blk.m_new_offset + (offset - blk.m_offset)));
+    }
+}
+
+template<class HT>
+template<class T> inline
+void
+segmented_heap_compactor<HT>::operator ()(T*&, size_type) noexcept
+{}
+
+//------
+//
+template<class HT>
+template<class T>
+void
+segmented_heap_compactor<HT>::trace_objects
+(void* pobj, size_type count, segmented_heap_compactor& c)
+{
+    T*  p = static_cast<T*>(pobj);
+
+    for (size_type i = 0;  i < count;  ++i)
+    {
+        rhx_trace_traits<T>::trace(p[i], c);
+    }
+}
+
+template<class HT>
+template<class T>
+void
+segmented_heap_compactor<HT>::visit_root
+(void* proot, size_type count, segmented_heap_compactor& c)
+{
+    c(*static_cast<pointer<T>*>(proot), count);
+}
+
+template<class HT>
+template<class T>
+void
+segmented_heap_compactor<HT>::visit_named_root
+(void* proot, size_type count, segmented_heap_compactor& c)
+{
+    auto&       entry = *static_cast<typename HT::void_pointer*>(proot);
+    pointer<T>  p     = static_cast<pointer<T>>(entry);
+
+    c(p, count);
+    entry = p;
+}
+
+//- Blocks of types that hold no pointers are copied but not traced.
+//
+template<class HT>
+template<class T> inline
+typename segmented_heap_compactor<HT>::tracer
+segmented_heap_compactor<HT>::tracer_for(T*) noexcept
+{
+    return rhx_trace_traits<T>::traced ? &trace_objects<T> : nullptr;
+}
+
+template<class HT> inline
+typename segmented_heap_compactor<HT>::tracer
+segmented_heap_compactor<HT>::tracer_for(void*) noexcept
+{
+    return nullptr;
+}
+
+template<class HT> inline
+uint64_t
+segmented_heap_compactor<HT>::block_key(size_type index, size_type offset) noexcept
+{
+    return (uint64_t(index) << 48) | offset;
+}
+
+template<class HT> inline
+uint8_t*
+segmented_heap_compactor<HT>::segment_base(size_type index) noexcept
+{
+    return storage_model::segment_address(storage_model::first_segment() + index);
+}
+
+//- Finds the segment and offset of p within the extents the segments had when compaction
+//  began, which is where every pointer still being traced or fixed points.
+//
+template<class HT>
+bool
+segmented_heap_compactor<HT>::locate
+(void const* p, size_type& index, size_type& offset) const noexcept
+{
+    uintptr_t   addr = reinterpret_cast<uintptr_t>(p);
+
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        uintptr_t   base = reinterpret_cast<uintptr_t>(segment_base(i));
+
+        if (base != 0  &&  (addr - base) < m_extents[i])
+        {
+            index  = i;
+            offset = addr - base;
+            return (i != 0  ||  offset >= HT::root_area_size);
+        }
+    }
+    return false;
+}
+
+//- Returns the offset at which the block containing the given offset begins, from the
+//  strategy's block-start bitmap.
+//
+template<class HT>
+typename segmented_heap_compactor<HT>::size_type
+segmented_heap_compactor<HT>::block_start(size_type index, size_type offset) const noexcept
+{
+    uint64_t const*     pstarts = HT::sm_block_starts[index];
+    size_type           granule = offset / granule_size;
+    size_type           w       = granule / 64;
+    uint64_t            bits    = pstarts[w] & (~uint64_t(0u) >> (63 - granule % 64));
+
+    while (bits == 0  &&  w != 0)
+    {
+        bits = pstarts[--w];
+    }
+    return (bits != 0) ? (w * 64 + highest_bit(bits)) * granule_size : offset;
+}
+
+//- Returns the offset at which the block beginning at the given offset ends; the last block in
+//  a segment extends to the segment's used extent.
+//
+template<class HT>
+typename segmented_heap_compactor<HT>::size_type
+segmented_heap_compactor<HT>::block_end(size_type index, size_type offset) const noexcept
+{
+    uint64_t const*     pstarts  = HT::sm_block_starts[index];
+    size_type           granules = m_extents[index] / granule_size;
+    size_type           next     = offset / granule_size + 1;
+    size_type           words    = (granules + 63) / 64;
+
+    if (next >= granules)
+    {
+        return m_extents[index];
+    }
+
+    size_type   w    = next / 64;
+    uint64_t    bits = pstarts[w] & (~uint64_t(0u) << (next % 64));
+
+    while (bits == 0  &&  ++w < words)
+    {
+        bits = pstarts[w];
+    }
+    return (bits != 0) ? std::min<size_type>((w * 64 + lowest_bit(bits)) * granule_size,
+                                             m_extents[index])
+                       : m_extents[index];
+}
+
+//- Returns the index in m_blocks of the block containing the given offset.  While tracing, a
+//  block seen for the first time is appended, to be traced as count objects starting at the
+//  given offset and moved with the objects' alignment; while fixing, every block has already
+//  been found, and the block-start bitmaps have been reset, so the block is looked up by its
+//  old location alone.
+//
+template<class HT>
+typename segmented_heap_compactor<HT>::size_type
+segmented_heap_compactor<HT>::find_block
+(size_type index, size_type offset, size_type count, size_type align, tracer trace)
+{
+    if (m_fixing)
+    {
+        auto    it = m_forward.upper_bound(block_key(index, offset));
+        return (--it)->second;
+    }
+
+    size_type   start = block_start(index, offset);
+    auto        found = m_forward.emplace(block_key(index, start), m_blocks.size());
+
+    if (found.second)
+    {
+        m_blocks.push_back(live_block{index, start, block_end(index, start) - start, 0, 0,
+                                      offset - start, count, align, trace});
+    }
+    return found.first->second;
+}
+
+//- Withdraws the root directory's unregistered entries whose objects were not found by
+//  tracing, and keeps the others to be rewritten along with the roots.
+//
+template<class HT>
+void
+segmented_heap_compactor<HT>::settle_directory()
+{
+    using directory = rhx_root_directory<HT>;
+
+    auto*   pe = directory::entries();
+
+    m_named.clear();
+
+    for (size_type i = 0, n = directory::capacity();  i < n;  ++i, ++pe)
+    {
+        void*       pentry = std::addressof(pe->m_object);
+        size_type   index;
+        size_type   offset;
+
+        if (pe->m_hash == 0  ||  pe->m_type_size == 0  ||
+            std::any_of(m_roots.begin(), m_roots.end(),
+                        [pentry](root_entry const& r) { return r.mp_root == pentry; })  ||
+            !pe->m_object  ||  !locate(rhx_to_address(pe->m_object), index, offset))
+        {
+            continue;
+        }
+
+        if (m_forward.count(block_key(index, block_start(index, offset))) != 0)
+        {
+            m_named.push_back(std::addressof(pe->m_object));
+        }
+        else
+        {
+            directory::withdraw(pe);
+        }
+    }
+}
+
+//- Copies the live blocks aside, resets the strategy to an empty heap, and allocates each block
+//  again in the order found, from the generation of the segment it was in.
+//
+template<class HT>
+void
+segmented_heap_compactor<HT>::move_blocks()
+{
+    size_type   total = 0;
+
+    for (live_block const& blk : m_blocks)
+    {
+        total += blk.m_size;
+    }
+
+    std::vector<uint8_t>    staging(total);
+    uint8_t*                pstage = staging.data();
+
+    for (live_block const& blk : m_blocks)
+    {
+        std::memcpy(pstage, segment_base(blk.m_index) + blk.m_offset, blk.m_size);
+        pstage += blk.m_size;
+    }
+
+    auto    saved_statistics = HT::sm_statistics;
+
+    HT::clear_free_lists();
+
+    for (auto& row : HT::sm_hint_areas)
+    {
+        for (auto& area : row)
+        {
+            area = typename HT::hint_area{};
+        }
+    }
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        std::memset(HT::sm_block_starts[i], 0,
+                    (m_extents[i] / granule_size + 63) / 64 * sizeof(uint64_t));
+        HT::sm_segment_ends[i] = 0;
+    }
+
+    HT::sm_curr_segment   = storage_model::first_segment();
+    HT::sm_curr_offset    = HT::root_area_size;
+    HT::sm_tenured_offset = 0;
+    HT::mark_bitmaps_dirty();
+    HT::set_block_start(HT::sm_curr_segment, 0);
+
+    pstage = staging.data();
+
+    for (live_block& blk : m_blocks)
+    {
+        HT          strategy(HT::generation_of(storage_model::first_segment() + blk.m_index));
+        auto        vp   = strategy.allocate(blk.m_size, blk.m_align);
+        uint8_t*    pnew = static_cast<uint8_t*>(static_cast<void*>(vp));
+
+        std::memcpy(pnew, pstage, blk.m_size);
+        pstage += blk.m_size;
+
+        for (size_type i = 0;  i < segment_count;  ++i)
+        {
+            uint8_t*    pbase = segment_base(i);
+
+            if (pbase != nullptr  &&  pbase <= pnew  &&
+                pnew < pbase + storage_model::segment_size(storage_model::first_segment() + i))
+            {
+                blk.m_new_index  = i;
+                blk.m_new_offset = static_cast<size_type>(pnew - pbase);
+            }
+        }
+    }
+
+    HT::sm_statistics = saved_statistics;
+}
+
+//- Clears what the segments held past their new extents, and shrinks each to the commit
+//  granularity that covers its extent, which lets the storage model decommit the rest.
+//
+template<class HT>
+void
+segmented_heap_compactor<HT>::shrink_segments(compaction_statistics& stats)
+{
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        size_type   extent   = HT::used_extent(j);
+        size_type   old_size = storage_model::segment_size(j);
+        size_type   new_size = HT::round_up(extent, HT::commit_size);
+
+        if (new_size < HT::commit_size)
+        {
+            new_size = HT::commit_size;
+        }
+        if (extent < old_size)
+        {
+            std::memset(segment_base(i) + extent, 0,
+                        ((new_size < old_size) ? new_size : old_size) - extent);
+        }
+        if (new_size < old_size)
+        {
+            storage_model::resize_segment(j, new_size);
+            stats.bytes_released += old_size - new_size;
+        }
+
+        stats.bytes_after      += extent;
+        stats.segments_vacated += (m_extents[i] != 0  &&  extent == 0) ? 1 : 0;
+    }
+}
+
+template<class HT> inline
+unsigned
+segmented_heap_compactor<HT>::lowest_bit(uint64_t word) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long   index;
+    _BitScanForward64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+template<class HT> inline
+unsigned
+segmented_heap_compactor<HT>::highest_bit(uint64_t word) noexcept
+{
+#ifdef _MSC_VER
+    unsigned long   index;
+    _BitScanReverse64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(63 - __builtin_clzll(word));
+#endif
+}
+
+#endif  //- SEGMENTED_HEAP_COMPACTOR_H_DEFINED
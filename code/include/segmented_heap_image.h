@@ -0,0 +1,179 @@
+//==================================================================================================
+//  File:
+//      segmented_heap_image.h
+//
+//  Summary:
+//      Defines the segmented_heap_image<SM> class template, which describes the layout of the
+//      heap image files that storage models save and load.
+//==================================================================================================
+//
+#ifndef SEGMENTED_HEAP_IMAGE_H_DEFINED
+#define SEGMENTED_HEAP_IMAGE_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_heap_image<SM>
+//
+//  Summary:
+//      A heap image file starts with a header giving the size of each segment number it holds
+//      (zero for absent segments).  It is followed by a table holding the CRC32C of every
+//      page_size bytes of those segments, and then by the contents of the segments in order.
+//      The table and each segment begin, and are padded out to, a multiple of alignment bytes,
+//      so that segments can be mapped straight from the file on any page size up to that value.
+//
+//      Storage model SM supplies the number of segments, their maximum size, the page size, and
+//      the checksum.  The header also records how the synthetic pointers stored in the segments
+//      are encoded: as segment numbers and offsets, or as addresses in a range reserved at a
+//      fixed base.  Converting one encoding to the other would require knowing which words of
+//      the heap are pointers, so a storage model loads only images in its own encoding.
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+class segmented_heap_image
+{
+  public:
+    using size_type = typename SM::size_type;
+
+    enum : uint32_t
+    {
+        offset_encoding = 0,        //- Pointers hold a segment number and an offset
+        fixed_encoding  = 1         //- Pointers hold addresses in a range at a fixed base
+    };
+
+    enum : size_type
+    {
+        alignment = 1u << 16
+    };
+
+    struct header
+    {
+        char        m_magic[8];
+        uint64_t    m_segment_size;
+        uint64_t    m_page_size;
+        uint64_t    m_sizes[SM::max_segments + 2];
+        uint32_t    m_header_crc;   //- CRC32C of the header with this field set to zero
+        uint32_t    m_encoding;     //- One of the encodings above; images predating it hold zero
+    };
+
+  public:
+    static  header      make_header(uint32_t encoding);
+    static  bool        read_header(std::FILE* fp, header& hdr);
+
+    static  uint64_t    extent(uint64_t size);
+    static  size_type   page_count(uint64_t size);
+    static  uint64_t    checksum_offset();
+    static  uint64_t    checksum_bytes(header const& hdr);
+    static  uint64_t    segment_offset(header const& hdr, size_type segment);
+    static  uint32_t    header_checksum(header hdr);
+    static  bool        write_padded(std::FILE* fp, void const* pdata, uint64_t size);
+
+  private:
+    static  constexpr   char const*     magic() { return "RHXHEAP2"; }
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_heap_image<SM>
+//--------------------------------------------------------------------------------------------------
+//
+//- Returns a header for SM's segment geometry with no segments; the caller fills in the sizes
+//  and then the checksum.
+//
+template<class SM>
+typename segmented_heap_image<SM>::header
+segmented_heap_image<SM>::make_header(uint32_t encoding)
+{
+    header  hdr = {};
+
+    std::memcpy(hdr.m_magic, magic(), sizeof(hdr.m_magic));
+    hdr.m_segment_size = SM::max_size;
+    hdr.m_page_size    = SM::page_size;
+    hdr.m_encoding     = encoding;
+
+    return hdr;
+}
+
+//- Reads a header from the start of the file, and returns whether it is intact and describes
+//  SM's page size.  The encoding and segment size are left for the caller to check.
+//
+template<class SM>
+bool
+segmented_heap_image<SM>::read_header(std::FILE* fp, header& hdr)
+{
+    return std::fread(&hdr, sizeof(hdr), 1, fp) == 1  &&
+           std::memcmp(hdr.m_magic, magic(), sizeof(hdr.m_magic)) == 0  &&
+           hdr.m_header_crc == header_checksum(hdr)  &&  hdr.m_page_size == SM::page_size;
+}
+
+template<class SM> inline
+uint64_t
+segmented_heap_image<SM>::extent(uint64_t size)
+{
+    return (size + alignment - 1) & ~uint64_t(alignment - 1);
+}
+
+template<class SM> inline
+typename segmented_heap_image<SM>::size_type
+segmented_heap_image<SM>::page_count(uint64_t size)
+{
+    return static_cast<size_type>((size + SM::page_size - 1) / SM::page_size);
+}
+
+template<class SM> inline
+uint64_t
+segmented_heap_image<SM>::checksum_offset()
+{
+    return extent(sizeof(header));
+}
+
+template<class SM> inline
+uint64_t
+segmented_heap_image<SM>::checksum_bytes(header const& hdr)
+{
+    uint64_t    bytes = 0;
+
+    for (size_type i = 0;  i <= SM::max_segments + 1;  ++i)
+    {
+        bytes += page_count(hdr.m_sizes[i]) * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+template<class SM> inline
+uint64_t
+segmented_heap_image<SM>::segment_offset(header const& hdr, size_type segment)
+{
+    uint64_t    offset = checksum_offset() + extent(checksum_bytes(hdr));
+
+    for (size_type i = 0;  i < segment;  ++i)
+    {
+        offset += extent(hdr.m_sizes[i]);
+    }
+    return offset;
+}
+
+template<class SM> inline
+uint32_t
+segmented_heap_image<SM>::header_checksum(header hdr)
+{
+    hdr.m_header_crc = 0;
+    return SM::checksum(&hdr, sizeof(hdr));
+}
+
+template<class SM>
+bool
+segmented_heap_image<SM>::write_padded(std::FILE* fp, void const* pdata, uint64_t size)
+{
+    static char const   zeros[alignment] = {};
+
+    uint64_t    pad = extent(size) - size;
+
+    return std::fwrite(pdata, 1, size, fp) == size  &&  std::fwrite(zeros, 1, pad, fp) == pad;
+}
+
+#endif  //- SEGMENTED_HEAP_IMAGE_H_DEFINED
@@ -0,0 +1,448 @@
+//==================================================================================================
+//  File:
+//      segmented_heap_journal.h
+//
+//  Summary:
+//      Defines the segmented_heap_journal<SM> class template, a redo journal that records the
+//      changes made to a storage model's segments between snapshots.
+//==================================================================================================
+//
+#ifndef SEGMENTED_HEAP_JOURNAL_H_DEFINED
+#define SEGMENTED_HEAP_JOURNAL_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "segmented_change_tracker.h"
+#include "segmented_file_io.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_heap_journal<SM>
+//
+//  Summary:
+//      This class template implements an optional write-ahead (redo) journal for the segments
+//      of storage model SM, so that the changes made since the last snapshot taken with
+//      SM::save_image() survive a crash.  At each commit point the journal captures the bytes
+//      that changed since the previous commit (see segmented_change_tracker) and appends them
+//      to the journal file as one block; recovery maps the snapshot and replays the complete
+//      blocks onto it, ignoring a torn block at the end.  The amount written, and synced, is
+//      therefore proportional to the size of the change.  Blocks are numbered consecutively,
+//      continuing across checkpoints, and a journal whose complete blocks skip or repeat a
+//      number is rejected.  Each block also carries the allocation strategy's bookkeeping as
+//      it was at the commit (see SM::store_state()), so allocating after a replay is safe.
+//
+//      A commit has two phases.  write() appends a block with the write() system call and
+//      returns its sequence number; sync() then waits until the block is durable.  Concurrent
+//      callers of sync() share fdatasync() calls (group commit): one caller syncs on behalf of
+//      all the blocks written so far, and the others wait for it.  The heap must not be
+//      modified while write() runs, so callers normally serialize their updates and write()
+//      under a lock of their own, and call sync() after releasing it.
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+class segmented_heap_journal
+{
+  public:
+    using size_type = typename SM::size_type;
+
+    struct journal_statistics
+    {
+        size_type   commits;            //- Blocks written
+        size_type   records;            //- Records in those blocks
+        size_type   bytes_recorded;     //- Heap bytes contained in those records
+        size_type   bytes_written;      //- Bytes appended to the journal file
+        size_type   syncs;              //- Calls to fdatasync()
+    };
+
+    struct replay_statistics
+    {
+        size_type   commits;            //- Complete blocks replayed
+        size_type   records;            //- Byte ranges applied
+        size_type   bytes_applied;      //- Heap bytes written
+        bool        torn_tail;          //- An incomplete or damaged block ended the journal
+    };
+
+  public:
+    ~segmented_heap_journal();
+    segmented_heap_journal();
+
+    segmented_heap_journal(segmented_heap_journal const&) = delete;
+    segmented_heap_journal&     operator =(segmented_heap_journal const&) = delete;
+
+    void        open(char const* path);
+    void        close();
+    void        checkpoint(char const* image_path);
+
+    uint64_t    write();
+    void        sync(uint64_t sequence);
+    uint64_t    commit();
+
+    journal_statistics  statistics() const;
+
+    static  replay_statistics   replay(char const* path);
+
+  private:
+    using tracker      = segmented_change_tracker<SM>;
+    using block_header = typename tracker::block_header;
+    using io           = segmented_file_io;
+
+    struct file_header
+    {
+        char        m_magic[8];
+        uint64_t    m_page_size;
+        uint64_t    m_base_sequence;    //- Sequence number of the block before the first one
+    };
+
+    int                         m_fd;
+    tracker                     m_tracker;
+    journal_statistics          m_stats;
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_synced_cv;
+    uint64_t                    m_written;      //- Sequence number of the last block written
+    uint64_t                    m_synced;       //- Sequence number of the last durable block
+    bool                        m_syncing;
+
+    static  char const          sm_magic[8];
+
+  private:
+    static  bool    read_block(int fd, block_header& bh, std::vector<uint8_t>& payload,
+                               bool& torn);
+    static  void    check_sequence(block_header const& bh, uint64_t last);
+};
+
+template<class SM>
+char const  segmented_heap_journal<SM>::sm_magic[8] = {'R', 'H', 'X', 'J', 'R', 'N', 'L', '2'};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_heap_journal<SM>
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+segmented_heap_journal<SM>::~segmented_heap_journal()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {}
+}
+
+template<class SM>
+segmented_heap_journal<SM>::segmented_heap_journal()
+:   m_fd{-1}
+,   m_tracker()
+,   m_stats{}
+,   m_written{0}
+,   m_synced{0}
+,   m_syncing{false}
+{}
+
+//- Opens (or creates) the journal file for appending.  The journal then treats the current
+//  contents of the segments as committed, so a journal that holds blocks must be replayed
+//  before it is opened.
+//
+template<class SM>
+void
+segmented_heap_journal<SM>::open(char const* path)
+{
+    close();
+
+    int             fd  = io::open_file(path, true);
+    file_header     hdr = {};
+
+    if (fd < 0)
+    {
+        throw std::runtime_error("unable to open heap journal");
+    }
+
+    if (!io::read_all(fd, &hdr, sizeof(hdr)))
+    {
+        std::memcpy(hdr.m_magic, sm_magic, sizeof(sm_magic));
+        hdr.m_page_size = SM::page_size;
+
+        if (!io::truncate_file(fd, 0)  ||  !io::seek_file(fd, 0)  ||
+            !io::write_all(fd, &hdr, sizeof(hdr))  ||  !io::sync_file(fd))
+        {
+            io::close_file(fd);
+            throw std::runtime_error("unable to initialize heap journal");
+        }
+    }
+    else if (std::memcmp(hdr.m_magic, sm_magic, sizeof(sm_magic)) != 0)
+    {
+        io::close_file(fd);
+        throw std::runtime_error("invalid heap journal");
+    }
+
+    //- Appending only happens after a replay, so blocks left after a torn one would never be
+    //  replayed; anything past the last complete block is discarded first.
+    //
+    uint64_t                last = hdr.m_base_sequence;
+    uint64_t                end  = sizeof(file_header);
+    block_header            bh;
+    std::vector<uint8_t>    payload;
+    bool                    torn;
+
+    try
+    {
+        while (read_block(fd, bh, payload, torn))
+        {
+            check_sequence(bh, last);
+            end += sizeof(bh) + payload.size();
+            last = bh.m_sequence;
+        }
+    }
+    catch (...)
+    {
+        io::close_file(fd);
+        throw;
+    }
+
+    if (!io::truncate_file(fd, end)  ||  !io::seek_file(fd, end))
+    {
+        io::close_file(fd);
+        throw std::runtime_error("unable to position heap journal");
+    }
+
+    m_fd      = fd;
+    m_written = last;
+    m_synced  = last;
+    m_tracker.reset(true);
+}
+
+template<class SM>
+void
+segmented_heap_journal<SM>::close()
+{
+    if (m_fd >= 0)
+    {
+        sync(m_written);
+        io::close_file(m_fd);
+        m_fd = -1;
+    }
+    m_tracker.reset(false);
+}
+
+//- Commits outstanding changes, saves a new snapshot, and then empties the journal, whose next
+//  block continues the numbering.  Should a crash occur between the last two steps, replaying
+//  the old journal onto the new snapshot leaves it unchanged, because the snapshot was taken at
+//  the journal's final commit.  The blocks are cut off before the header is rewritten, so that
+//  a crash in between leaves an empty journal rather than one whose numbering has a gap.
+//
+template<class SM>
+void
+segmented_heap_journal<SM>::checkpoint(char const* image_path)
+{
+    commit();
+    SM::save_image(image_path);
+
+    std::lock_guard<std::mutex>     lock(m_mutex);
+    file_header                     hdr = {};
+
+    std::memcpy(hdr.m_magic, sm_magic, sizeof(sm_magic));
+    hdr.m_page_size     = SM::page_size;
+    hdr.m_base_sequence = m_written;
+
+    if (!io::truncate_file(m_fd, sizeof(file_header))  ||  !io::sync_file(m_fd)  ||
+        !io::seek_file(m_fd, 0)  ||  !io::write_all(m_fd, &hdr, sizeof(hdr))  ||
+        !io::sync_file(m_fd))
+    {
+        throw std::runtime_error("unable to reset heap journal");
+    }
+    m_stats.syncs += 2;
+}
+
+//- Appends a block holding every change made since the previous commit, and returns its
+//  sequence number; if nothing has changed, no block is written and the sequence number of the
+//  previous block is returned.
+//
+template<class SM>
+uint64_t
+segmented_heap_journal<SM>::write()
+{
+    std::lock_guard<std::mutex>     lock(m_mutex);
+
+    if (m_fd < 0)
+    {
+        throw std::logic_error("heap journal is not open");
+    }
+
+    size_type   records = m_tracker.capture(m_written + 1);
+
+    if (records == 0)
+    {
+        return m_written;
+    }
+    if (!io::write_all(m_fd, m_tracker.block_data(), m_tracker.block_size()))
+    {
+        throw std::runtime_error("unable to write heap journal");
+    }
+
+    m_stats.commits        += 1;
+    m_stats.records        += records;
+    m_stats.bytes_recorded  = m_tracker.bytes_recorded();
+    m_stats.bytes_written  += m_tracker.block_size();
+
+    return ++m_written;
+}
+
+//- Returns once the block with the given sequence number is durable.  The first caller to find
+//  no sync in progress syncs everything written so far; callers arriving meanwhile wait for it,
+//  and then either find their blocks covered or sync the next group themselves.
+//
+template<class SM>
+void
+segmented_heap_journal<SM>::sync(uint64_t sequence)
+{
+    std::unique_lock<std::mutex>    lock(m_mutex);
+
+    while (m_synced < sequence)
+    {
+        if (m_syncing)
+        {
+            m_synced_cv.wait(lock);
+            continue;
+        }
+
+        uint64_t    target = m_written;
+        int         fd     = m_fd;
+
+        m_syncing = true;
+        lock.unlock();
+
+        bool    ok = io::sync_file(fd);
+
+        lock.lock();
+        m_syncing = false;
+        ++m_stats.syncs;
+
+        if (!ok)
+        {
+            m_synced_cv.notify_all();
+            throw std::runtime_error("unable to sync heap journal");
+        }
+        m_synced = target;
+        m_synced_cv.notify_all();
+    }
+}
+
+template<class SM>
+uint64_t
+segmented_heap_journal<SM>::commit()
+{
+    uint64_t    sequence = write();
+
+    sync(sequence);
+    return sequence;
+}
+
+template<class SM>
+typename segmented_heap_journal<SM>::journal_statistics
+segmented_heap_journal<SM>::statistics() const
+{
+    return m_stats;
+}
+
+//- Applies the complete blocks of a journal to the segments, which must hold the snapshot that
+//  the journal follows.  Replay stops at the first block that is incomplete or damaged, but a
+//  complete block out of sequence means that blocks were lost or repeated, and is an error.
+//
+template<class SM>
+typename segmented_heap_journal<SM>::replay_statistics
+segmented_heap_journal<SM>::replay(char const* path)
+{
+    replay_statistics   rs = {};
+    int                 fd = io::open_file(path, false);
+    file_header         hdr;
+
+    if (fd < 0)
+    {
+        return rs;
+    }
+    if (!io::read_all(fd, &hdr, sizeof(hdr))  ||  hdr.m_page_size != SM::page_size  ||
+        std::memcmp(hdr.m_magic, sm_magic, sizeof(sm_magic)) != 0)
+    {
+        io::close_file(fd);
+        throw std::runtime_error("invalid heap journal");
+    }
+
+    block_header            bh;
+    std::vector<uint8_t>    payload;
+    uint64_t                last = hdr.m_base_sequence;
+
+    try
+    {
+        while (read_block(fd, bh, payload, rs.torn_tail))
+        {
+            check_sequence(bh, last);
+            last = bh.m_sequence;
+
+            auto    as = tracker::apply_block(bh, payload.data());
+
+            rs.commits       += 1;
+            rs.records       += as.records;
+            rs.bytes_applied += as.bytes_applied;
+        }
+    }
+    catch (...)
+    {
+        io::close_file(fd);
+        throw;
+    }
+
+    io::close_file(fd);
+    return rs;
+}
+
+//- Reads the next block of a journal, returning false at the end of the file or at a block
+//  that is incomplete or damaged; torn is set in the latter case.
+//
+template<class SM>
+bool
+segmented_heap_journal<SM>::read_block
+(int fd, block_header& bh, std::vector<uint8_t>& payload, bool& torn)
+{
+    size_type   got = io::read_some(fd, &bh, sizeof(bh));
+
+    torn = (got != 0);
+
+    if (got != sizeof(bh)  ||  bh.m_magic != tracker::block_magic  ||
+        bh.m_payload_size > tracker::max_payload_size)
+    {
+        return false;
+    }
+
+    payload.resize(static_cast<size_type>(bh.m_payload_size));
+
+    if (!io::read_all(fd, payload.data(), payload.size())  ||
+        !tracker::check_block(bh, payload.data()))
+    {
+        return false;
+    }
+
+    torn = false;
+    return true;
+}
+
+//- Throws unless the block is the one that follows block number last; the caller closes the
+//  journal.
+//
+template<class SM>
+void
+segmented_heap_journal<SM>::check_sequence(block_header const& bh, uint64_t last)
+{
+    if (bh.m_sequence != last + 1)
+    {
+        throw std::runtime_error("missing or repeated block in heap journal");
+    }
+}
+
+#endif  //- SEGMENTED_HEAP_JOURNAL_H_DEFINED
@@ -0,0 +1,359 @@
+//==================================================================================================
+//  File:
+//      segmented_heap_replication.h
+//
+//  Summary:
+//      Defines the segmented_heap_leader<SM> and segmented_heap_follower<SM> class templates,
+//      which keep a copy of a storage model's segments up to date in another process.
+//==================================================================================================
+//
+#ifndef SEGMENTED_HEAP_REPLICATION_H_DEFINED
+#define SEGMENTED_HEAP_REPLICATION_H_DEFINED
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "segmented_change_tracker.h"
+#include "segmented_file_io.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_heap_leader<SM>
+//
+//  Summary:
+//      This class template sends the changes made to the segments of storage model SM over a
+//      stream (typically a pipe or a Unix-domain socket) to a segmented_heap_follower<SM> in
+//      another process.  Each call to publish() captures the bytes that changed since the
+//      previous call (see segmented_change_tracker) and writes them as one block, so the
+//      bandwidth used is proportional to the rate at which the heap is written, not to its
+//      size.  The first block carries every segment in full.
+//
+//      Because synthetic pointers are position-independent, the follower needs nothing more
+//      than the same segment bytes.  The heap must not be modified while publish() runs, and
+//      the caller owns the descriptor (and, on POSIX systems, the handling of SIGPIPE).
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+class segmented_heap_leader
+{
+  public:
+    using size_type = typename SM::size_type;
+
+    struct leader_statistics
+    {
+        size_type   blocks;             //- Blocks sent
+        size_type   records;            //- Records in those blocks
+        size_type   bytes_recorded;     //- Heap bytes contained in those records
+        size_type   bytes_sent;         //- Bytes written to the stream
+    };
+
+  public:
+    explicit    segmented_heap_leader(int fd);
+
+    segmented_heap_leader(segmented_heap_leader const&) = delete;
+    segmented_heap_leader&  operator =(segmented_heap_leader const&) = delete;
+
+    uint64_t            publish();
+    uint64_t            sequence() const noexcept;
+    leader_statistics   statistics() const noexcept;
+
+  private:
+    using tracker = segmented_change_tracker<SM>;
+    using io      = segmented_file_io;
+
+    int                 m_fd;
+    tracker             m_tracker;
+    uint64_t            m_sequence;     //- Sequence number of the last block sent
+    leader_statistics   m_stats;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_heap_follower<SM>
+//
+//  Summary:
+//      This class template receives the blocks sent by a segmented_heap_leader<SM> and applies
+//      them to the segments of storage model SM, which should hold no segments when the first
+//      block arrives.  A block is applied only once all of it has arrived and its checksum has
+//      been verified, so between calls to receive() the segments are always in a state that the
+//      leader published, and the follower's threads may read the heap between calls while it
+//      catches up.  Blocks are applied to the segments in place, though, so no thread may read
+//      the heap while receive() is running.  Bytes that arrive ahead of a complete block are
+//      buffered until the rest of it does.
+//
+//      Without poll() (i.e., on Windows), a descriptor is always treated as readable, so
+//      receive() may block even when it is not asked to wait.
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+class segmented_heap_follower
+{
+  public:
+    using size_type = typename SM::size_type;
+
+    struct follower_statistics
+    {
+        size_type   blocks;             //- Blocks applied
+        size_type   records;            //- Byte ranges applied
+        size_type   bytes_applied;      //- Heap bytes written
+        size_type   bytes_received;     //- Bytes read from the stream
+    };
+
+  public:
+    explicit    segmented_heap_follower(int fd);
+
+    segmented_heap_follower(segmented_heap_follower const&) = delete;
+    segmented_heap_follower&    operator =(segmented_heap_follower const&) = delete;
+
+    size_type           receive(bool wait);
+    bool                at_end() const noexcept;
+    uint64_t            sequence() const noexcept;
+    follower_statistics statistics() const noexcept;
+
+  private:
+    using tracker      = segmented_change_tracker<SM>;
+    using block_header = typename tracker::block_header;
+    using io           = segmented_file_io;
+
+    enum : size_type
+    {
+        read_size = 1u << 16        //- Smallest amount of buffer space offered to a read
+    };
+
+    int                     m_fd;
+    std::vector<uint8_t>    m_buffer;
+    size_type               m_begin;        //- Start of the unapplied bytes in m_buffer
+    size_type               m_end;          //- End of the bytes received
+    uint64_t                m_sequence;     //- Sequence number of the last block applied
+    bool                    m_at_end;
+    follower_statistics     m_stats;
+
+  private:
+    bool    apply_next();
+    bool    fill(bool wait);
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_heap_leader<SM>
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+segmented_heap_leader<SM>::segmented_heap_leader(int fd)
+:   m_fd{fd}
+,   m_tracker()
+,   m_sequence{0}
+,   m_stats{}
+{}
+
+//- Sends a block holding every change made since the previous call, and returns its sequence
+//  number; if nothing has changed, nothing is sent and the previous sequence number is returned.
+//
+template<class SM>
+uint64_t
+segmented_heap_leader<SM>::publish()
+{
+    size_type   records = m_tracker.capture(m_sequence + 1);
+
+    if (records == 0)
+    {
+        return m_sequence;
+    }
+    if (!io::write_all(m_fd, m_tracker.block_data(), m_tracker.block_size()))
+    {
+        throw std::runtime_error("unable to send heap changes");
+    }
+
+    m_stats.blocks         += 1;
+    m_stats.records        += records;
+    m_stats.bytes_recorded  = m_tracker.bytes_recorded();
+    m_stats.bytes_sent     += m_tracker.block_size();
+
+    return ++m_sequence;
+}
+
+template<class SM> inline
+uint64_t
+segmented_heap_leader<SM>::sequence() const noexcept
+{
+    return m_sequence;
+}
+
+template<class SM> inline
+typename segmented_heap_leader<SM>::leader_statistics
+segmented_heap_leader<SM>::statistics() const noexcept
+{
+    return m_stats;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_heap_follower<SM>
+//--------------------------------------------------------------------------------------------------
+//
+template<class SM>
+segmented_heap_follower<SM>::segmented_heap_follower(int fd)
+:   m_fd{fd}
+,   m_buffer()
+,   m_begin{0}
+,   m_end{0}
+,   m_sequence{0}
+,   m_at_end{false}
+,   m_stats{}
+{}
+
+//- Applies every complete block that has arrived, reading whatever the stream has ready without
+//  blocking, and returns the number of blocks applied.  If asked to wait, it first blocks until
+//  at least one block has been applied or the stream has ended.
+//
+template<class SM>
+typename segmented_heap_follower<SM>::size_type
+segmented_heap_follower<SM>::receive(bool wait)
+{
+    size_type   applied = 0;
+
+    for (;;)
+    {
+        while (apply_next())
+        {
+            ++applied;
+        }
+        if (m_at_end  ||  !fill(wait  &&  applied == 0))
+        {
+            return applied;
+        }
+    }
+}
+
+template<class SM> inline
+bool
+segmented_heap_follower<SM>::at_end() const noexcept
+{
+    return m_at_end;
+}
+
+template<class SM> inline
+uint64_t
+segmented_heap_follower<SM>::sequence() const noexcept
+{
+    return m_sequence;
+}
+
+template<class SM> inline
+typename segmented_heap_follower<SM>::follower_statistics
+segmented_heap_follower<SM>::statistics() const noexcept
+{
+    return m_stats;
+}
+
+//- Applies the block at the front of the buffer, if all of it has arrived.  A damaged or
+//  out-of-order block means that the follower can no longer track the leader, so it throws.
+//
+template<class SM>
+bool
+segmented_heap_follower<SM>::apply_next()
+{
+    block_header    bh;
+    size_type       avail = m_end - m_begin;
+
+    if (avail < sizeof(bh))
+    {
+        return false;
+    }
+
+    std::memcpy(&bh, m_buffer.data() + m_begin, sizeof(bh));
+
+    if (bh.m_magic != tracker::block_magic  ||  bh.m_payload_size > tracker::max_payload_size)
+    {
+        throw std::runtime_error("invalid heap replication stream");
+    }
+    if (avail - sizeof(bh) < bh.m_payload_size)
+    {
+        return false;
+    }
+
+    uint8_t const*  payload = m_buffer.data() + m_begin + sizeof(bh);
+
+    if (!tracker::check_block(bh, payload)  ||  bh.m_sequence != m_sequence + 1)
+    {
+        throw std::runtime_error("damaged or missing block in heap replication stream");
+    }
+
+    auto    as = tracker::apply_block(bh, payload);
+
+    m_begin               += sizeof(bh) + static_cast<size_type>(bh.m_payload_size);
+    m_sequence             = bh.m_sequence;
+    m_stats.blocks        += 1;
+    m_stats.records       += as.records;
+    m_stats.bytes_applied += as.bytes_applied;
+
+    return true;
+}
+
+//- Makes one read from the stream into the buffer, first moving any partial block to the front
+//  and growing the buffer to hold the whole of it.  Returns false if no data was ready (when not
+//  waiting) or the stream has ended, and throws if the read fails, which must not be mistaken
+//  for the leader closing the stream.
+//
+template<class SM>
+bool
+segmented_heap_follower<SM>::fill(bool wait)
+{
+    if (!io::readable(m_fd, wait))
+    {
+        return false;
+    }
+
+    size_type   avail = m_end - m_begin;
+    size_type   need  = read_size;
+
+    if (avail >= sizeof(block_header))
+    {
+        block_header    bh;
+
+        std::memcpy(&bh, m_buffer.data() + m_begin, sizeof(bh));
+        need = sizeof(bh) + static_cast<size_type>(bh.m_payload_size) - avail;
+        need = (need < read_size) ? size_type(read_size) : need;
+    }
+
+    if (m_begin != 0)
+    {
+        std::memmove(m_buffer.data(), m_buffer.data() + m_begin, avail);
+        m_begin = 0;
+        m_end   = avail;
+    }
+    if (m_buffer.size() < m_end + need)
+    {
+        m_buffer.resize(m_end + need);
+    }
+
+    long long   done = io::read_once(m_fd, m_buffer.data() + m_end, m_buffer.size() - m_end);
+
+    //- An interrupted read has read nothing, and the caller simply reads again.
+    //
+    if (done < 0  &&  errno == EINTR)
+    {
+        return true;
+    }
+    if (done < 0)
+    {
+        throw std::runtime_error("unable to read heap replication stream");
+    }
+    if (done == 0)
+    {
+        m_at_end = true;
+        return false;
+    }
+
+    m_end                  += static_cast<size_type>(done);
+    m_stats.bytes_received += static_cast<size_type>(done);
+
+    return true;
+}
+
+#endif  //- SEGMENTED_HEAP_REPLICATION_H_DEFINED
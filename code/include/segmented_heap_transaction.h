@@ -0,0 +1,127 @@
+//==================================================================================================
+//  File:
+//      segmented_heap_transaction.h
+//
+//  Summary:
+//      Defines the segmented_heap_transaction<HT> class template, which lets a batch of changes
+//      to a heap be undone.
+//==================================================================================================
+//
+#ifndef SEGMENTED_HEAP_TRANSACTION_H_DEFINED
+#define SEGMENTED_HEAP_TRANSACTION_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      segmented_heap_transaction<HT>
+//
+//  Summary:
+//      This class template brackets a batch of changes to the heap of allocation strategy HT,
+//      such as a bulk import, so that they can be undone if the batch fails.  Constructing an
+//      object opens a transaction; containers may then be modified freely, and the changes
+//      are either kept by commit() or undone by rollback(), which is also what happens if the
+//      object is destroyed while the transaction is still open (e.g., by an exception).
+//
+//      The storage model keeps the undo image in the shadow buffers that it already holds for
+//      each segment, and rolling back copies back only the pages that differ from it.  The
+//      strategy's bookkeeping, which lives outside the heap, is saved when the transaction
+//      begins and restored with the pages.  Only one transaction can be open at a time, and
+//      segments that existed when it began cannot be deallocated before it ends.
+//--------------------------------------------------------------------------------------------------
+//
+template<class HT>
+class segmented_heap_transaction
+{
+  public:
+    using storage_model = typename HT::storage_model;
+    using size_type     = typename HT::size_type;
+
+  public:
+    ~segmented_heap_transaction();
+    segmented_heap_transaction();
+
+    segmented_heap_transaction(segmented_heap_transaction const&) = delete;
+    segmented_heap_transaction&     operator =(segmented_heap_transaction const&) = delete;
+
+    void        commit();
+    size_type   rollback();
+    bool        active() const noexcept;
+
+  private:
+    using allocation_state = typename HT::allocation_state;
+
+    std::unique_ptr<allocation_state>   mp_state;   //- Null once the transaction has ended
+};
+
+
+//--------------------------------------------------------------------------------------------------
+//  Facility:   segmented_heap_transaction<HT>
+//--------------------------------------------------------------------------------------------------
+//
+template<class HT>
+segmented_heap_transaction<HT>::~segmented_heap_transaction()
+{
+    try
+    {
+        if (mp_state)
+        {
+            rollback();
+        }
+    }
+    catch (...)
+    {}
+}
+
+template<class HT>
+segmented_heap_transaction<HT>::segmented_heap_transaction()
+:   mp_state(new allocation_state)
+{
+    HT::save_state(*mp_state);
+    storage_model::begin_transaction();
+}
+
+template<class HT>
+void
+segmented_heap_transaction<HT>::commit()
+{
+    if (!mp_state)
+    {
+        throw std::logic_error("heap transaction has already ended");
+    }
+
+    storage_model::commit_transaction();
+    mp_state.reset();
+}
+
+//- Undoes every change made to the heap since the transaction began, and returns the number of
+//  pages that had to be restored.
+//
+template<class HT>
+typename segmented_heap_transaction<HT>::size_type
+segmented_heap_transaction<HT>::rollback()
+{
+    if (!mp_state)
+    {
+        throw std::logic_error("heap transaction has already ended");
+    }
+
+    size_type   restored = storage_model::rollback_transaction();
+
+    HT::restore_state(*mp_state);
+    mp_state.reset();
+
+    return restored;
+}
+
+template<class HT> inline
+bool
+segmented_heap_transaction<HT>::active() const noexcept
+{
+    return static_cast<bool>(mp_state);
+}
+
+#endif  //- SEGMENTED_HEAP_TRANSACTION_H_DEFINED
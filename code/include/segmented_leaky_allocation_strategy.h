@@ -11,6 +11,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
 
 #include "synthetic_pointer_interface.h"
 
@@ -20,6 +24,24 @@
 //
 //  Summary:
 //      This class implements a simple leaky allocation strategy for testing purposes.
+//
+//      Allocations are segregated by generation.  Young blocks, the default, are carved from a
+//      frontier that sweeps through all but the last segment; tenured blocks, meant for data
+//      that is written once and then only read (reference tables, interned keys, and the like),
+//      come from a frontier of their own in the last segment.  The pages holding tenured data
+//      thus stay clean while young data is rewritten, and incremental snapshots, journals, and
+//      replication have that much less to copy.  A strategy object allocates from the
+//      generation it was constructed with, so tagging an allocator tags every container that
+//      uses it.  With a single segment there is nowhere to segregate tenured blocks, and they
+//      are allocated as young ones.
+//
+//      The strategy's bookkeeping (frontiers, free lists, block-start bitmaps) lives outside the
+//      heap, where it is cheap to update.  If the storage model has a segment to spare, the
+//      bookkeeping is copied into it whenever the storage model is about to save or capture the
+//      heap, so that it travels with images, journals, and replicas; and when the storage model
+//      replaces the segments, the strategy forgets what it had and loads the copy that came with
+//      them before allocating again.  A heap whose segments exist, but hold no such copy, is
+//      never allocated from, since that would overwrite it.
 //--------------------------------------------------------------------------------------------------
 //
 template<class SM>
@@ -38,31 +60,240 @@ class segmented_leaky_allocation_strategy
     template<class T>
     using rebind_pointer        = synthetic_pointer<T, addressing_model>;
 
+    //- Running totals describing how the strategy has consumed its segments.
+    //
+    struct heap_statistics
+    {
+        size_type   allocations;            //- Number of calls to allocate()
+        size_type   bytes_requested;        //- Sum of the sizes passed to allocate()
+        size_type   bytes_allocated;        //- Bytes consumed, including all padding
+        size_type   rounding_padding;       //- Bytes added to round sizes up to min_alignment
+        size_type   alignment_padding;      //- Bytes skipped to align a chunk's offset
+        size_type   hinted_allocations;     //- Allocations placed in a hint area
+        size_type   hint_area_bytes;        //- Bytes reserved for hint areas
+        size_type   expansions;             //- Successful calls to try_expand() that grew a block
+        size_type   reused_allocations;     //- Allocations satisfied from the free lists
+        size_type   tenured_allocations;    //- Allocations placed in the tenured segment
+    };
+
+    enum generation : uint8_t
+    {
+        young_generation   = 0,     //- Data that is written while the heap is in use
+        tenured_generation = 1      //- Long-lived data that is rarely, if ever, written again
+    };
+
+    enum : size_type
+    {
+        min_alignment  = 16u,
+        root_area_size = 8192u      //- Reserved at offset 0 of the first segment
+    };
+
   public:
+    segmented_leaky_allocation_strategy() noexcept = default;
+    explicit segmented_leaky_allocation_strategy(generation gen) noexcept;
+
+    generation      allocation_generation() const noexcept;
     size_type       max_size() const;
 
     void_pointer    allocate(size_type n);
+    void_pointer    allocate(size_type n, size_type align);
+    void_pointer    allocate(size_type n, size_type align, const_void_pointer hint);
     void            deallocate(void_pointer p);
+    bool            try_expand(void_pointer p, size_type old_n, size_type new_n);
 
     static  void    swap_buffers();
 
+    static  void_pointer            root_area();
+    static  heap_statistics const&  statistics() noexcept;
+
   private:
+    template<class HT> friend class segmented_heap_collector;
+    template<class HT> friend class segmented_heap_transaction;
+    template<class HT> friend class segmented_heap_compactor;
+
     enum : size_type 
     {
-        segment_count = 4
+        //- Four segments, or fewer if that is all the storage model provides.
+        //
+        segment_count       = (storage_model::max_segment_count() < 4)
+                            ? storage_model::max_segment_count() : 4,
+
+        //- The last segment is reserved for tenured blocks, unless it is the only one.
+        //
+        young_segments      = (segment_count > 1) ? segment_count - 1 : 1,
+        generation_count    = 2,
+        region_size         = 1u << 16,     //- Granularity at which hints are tracked
+        hint_area_size      = 1u << 12,     //- Bytes reserved at a time for hinted allocations
+        commit_size         = 1u << 20,     //- Granularity at which segments are grown
+        max_hinted_size     = hint_area_size / 4,
+        regions_per_segment = storage_model::max_segment_size() / region_size,
+        bitmap_words        = storage_model::max_segment_size() / min_alignment / 64,
+        free_list_count     = 20,
+
+        //- The segment following the strategy's own holds the persisted bookkeeping, if the
+        //  storage model has that many.  Each bitmap is stored in a run of words whose length is
+        //  a power of two, so that the runs move only when one of them outgrows its run.
+        //
+        state_segment       = (storage_model::max_segment_count() > segment_count)
+                            ? storage_model::first_segment() + segment_count : 0,
+        min_bitmap_run      = 512,
+        state_magic         = 0x5453484Cu   //- "LHST"
+    };
+
+    //- The unused part [m_offset, m_limit) of a block of memory in segment m_segment, from which
+    //  allocations hinted at some region are made.
+    //
+    struct hint_area
+    {
+        size_type   m_segment;
+        size_type   m_offset;
+        size_type   m_limit;
+    };
+
+    //- The location of a free block, expressed as a segment and offset; a segment number of
+    //  zero denotes the end of a list.
+    //
+    struct free_link
+    {
+        uint32_t    m_segment;
+        uint32_t    m_offset;
+    };
+
+    //- Header written into the first bytes of every block on a free list.
+    //
+    struct free_block
+    {
+        free_link   m_next;
+        uint64_t    m_size;
+    };
+
+    //- The header of the state segment.  It is followed by the used words of each segment's
+    //  block-start bitmap, in runs of m_bitmap_runs[i] words at byte offsets m_bitmap_offsets[i].
+    //  Hint areas are not persisted; after loading, hinted allocations start new areas.
+    //
+    struct persisted_state
+    {
+        uint64_t            m_magic;
+        uint64_t            m_curr_segment;
+        uint64_t            m_curr_offset;
+        uint64_t            m_tenured_offset;
+        uint64_t            m_free_bytes;
+        uint64_t            m_segment_ends[segment_count];
+        uint64_t            m_bitmap_offsets[segment_count];
+        uint64_t            m_bitmap_runs[segment_count];
+        uint64_t            m_bitmap_words[segment_count];
+        free_link           m_free_lists[generation_count][free_list_count];
+        heap_statistics     m_statistics;
+    };
+
+    //- A copy of the strategy's bookkeeping, which lives outside the heap, taken when a heap
+    //  transaction begins so that rolling back can restore it along with the segments.
+    //
+    struct allocation_state
+    {
+        size_type           m_curr_segment;
+        size_type           m_curr_offset;
+        heap_statistics     m_statistics;
+        hint_area           m_hint_areas[segment_count][regions_per_segment];
+        uint64_t            m_block_starts[segment_count][bitmap_words];
+        size_type           m_segment_ends[segment_count];
+        free_link           m_free_lists[generation_count][free_list_count];
+        size_type           m_free_bytes;
+        size_type           m_tenured_offset;
     };
 
     static  difference_type     round_up(difference_type x, difference_type r);
+    static  size_type           check_alignment(size_type align);
+    static  size_type           advance_frontier(size_type size, size_type align, size_type& pad);
+    static  bool                advance_tenured(size_type size, size_type align,
+                                                size_type& offset, size_type& pad);
+    static  void                commit_frontier(size_type segment, size_type end);
+    static  hint_area*          find_hint_area(const_void_pointer const& hint);
     static  void                init_segments();
 
-    static  size_type   sm_curr_segment;
-    static  size_type   sm_curr_offset;
+    static  size_type           tenured_segment();
+    static  size_type*          frontier_offset(size_type segment);
+    static  generation          generation_of(size_type segment);
+
+    static  void                set_block_start(size_type segment, size_type offset);
+    static  void                clear_block_start(size_type segment, size_type offset);
+    static  size_type           used_extent(size_type segment);
+    static  size_type           used_bitmap_words(size_type segment);
+    static  size_type           free_list_index(size_type size);
+    static  free_block*         free_block_at(free_link link);
+    static  void                push_free_block(size_type segment, size_type offset, size_type n);
+    static  free_link           pop_free_block(generation gen, size_type n, size_type align,
+                                               size_type& block_size);
+    static  void                clear_free_lists();
+
+    static  void                save_state(allocation_state& state);
+    static  void                restore_state(allocation_state const& state);
+
+    static  void                persist_state();
+    static  void                forget_state();
+    static  void                load_state();
+    static  size_type           bitmap_run(size_type words);
+    static  void                mark_bitmaps_dirty();
+
+    static  size_type           sm_curr_segment;
+    static  size_type           sm_curr_offset;
+    static  heap_statistics     sm_statistics;
+    static  hint_area           sm_hint_areas[segment_count][regions_per_segment];
+
+    //- Block-start bitmaps, one bit per min_alignment bytes of each segment, record where every
+    //  block handed out by the strategy begins; the collector uses them to find block bounds.
+    //
+    static  uint64_t            sm_block_starts[segment_count][bitmap_words];
+    static  size_type           sm_segment_ends[segment_count];
+    static  free_link           sm_free_lists[generation_count][free_list_count];
+    static  size_type           sm_free_bytes;
+    static  size_type           sm_tenured_offset;      //- Frontier of the tenured segment
+
+    //- The words [first, last) of each bitmap may have changed since the bookkeeping was last
+    //  persisted; the range is empty when first >= last.
+    //
+    static  size_type           sm_dirty_first[segment_count];
+    static  size_type           sm_dirty_last[segment_count];
+
+    generation      m_generation = young_generation;
 };
 
 template<class SM>
 typename segmented_leaky_allocation_strategy<SM>::size_type     segmented_leaky_allocation_strategy<SM>::sm_curr_segment = 0;
 template<class SM>
 typename segmented_leaky_allocation_strategy<SM>::size_type     segmented_leaky_allocation_strategy<SM>::sm_curr_offset = 0;
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::heap_statistics   segmented_leaky_allocation_strategy<SM>::sm_statistics = {};
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::hint_area  segmented_leaky_allocation_strategy<SM>::sm_hint_areas[segment_count][regions_per_segment] = {};
+template<class SM>
+uint64_t    segmented_leaky_allocation_strategy<SM>::sm_block_starts[segment_count][bitmap_words] = {};
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::size_type     segmented_leaky_allocation_strategy<SM>::sm_segment_ends[segment_count] = {};
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::free_link  segmented_leaky_allocation_strategy<SM>::sm_free_lists[generation_count][free_list_count] = {};
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::size_type     segmented_leaky_allocation_strategy<SM>::sm_free_bytes = 0;
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::size_type     segmented_leaky_allocation_strategy<SM>::sm_tenured_offset = 0;
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::size_type     segmented_leaky_allocation_strategy<SM>::sm_dirty_first[segment_count] = {};
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::size_type     segmented_leaky_allocation_strategy<SM>::sm_dirty_last[segment_count] = {};
+
+
+template<class SM> inline
+segmented_leaky_allocation_strategy<SM>::segmented_leaky_allocation_strategy
+(generation gen) noexcept
+:   m_generation{gen}
+{}
+
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::generation
+segmented_leaky_allocation_strategy<SM>::allocation_generation() const noexcept
+{
+    return m_generation;
+}
 
 
 template<class SM> inline
@@ -72,30 +303,144 @@ segmented_leaky_allocation_strategy<SM>::max_size() const
     return storage_model::max_segment_size() / 2;
 }
 
-template<class SM>
+template<class SM> inline
 typename segmented_leaky_allocation_strategy<SM>::void_pointer
 segmented_leaky_allocation_strategy<SM>::allocate(size_type n)
 {
+    return allocate(n, min_alignment);
+}
+
+//- Chunk offsets are aligned to max(align, min_alignment).  Since the storage model aligns the
+//  base address of every segment to segment_alignment(), aligning the offset aligns the address.
+//
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::void_pointer
+segmented_leaky_allocation_strategy<SM>::allocate(size_type n, size_type align)
+{
+    align = check_alignment(align);
+
     if (sm_curr_segment == 0)
     {
         init_segments();
     }
 
-    size_type   chunk_size   = round_up(n, 16u);
-    size_type   chunk_offset = sm_curr_offset;
+    size_type   chunk_size = round_up(n, min_alignment);
+    bool        tenured    = (m_generation == tenured_generation  &&  tenured_segment() != 0);
 
-    if ((chunk_offset + chunk_size) > storage_model::max_segment_size())
+    //- Blocks reclaimed by a collection are reused before the frontier is advanced, but only
+    //  within the generation they were reclaimed from.
+    //
+    if (sm_free_bytes != 0)
     {
-        ++sm_curr_segment;
-        chunk_offset   = 0;
-        sm_curr_offset = chunk_size;
+        size_type   block_size = 0;
+        free_link   block      = pop_free_block(tenured ? tenured_generation : young_generation,
+                                                chunk_size, align, block_size);
+
+        if (block.m_segment != 0)
+        {
+            if (block_size > chunk_size)
+            {
+                size_type   rest = block.m_offset + chunk_size;
+
+                set_block_start(block.m_segment, rest);
+                push_free_block(block.m_segment, rest, block_size - chunk_size);
+            }
+
+            sm_statistics.allocations         += 1;
+            sm_statistics.reused_allocations  += 1;
+            sm_statistics.tenured_allocations += tenured ? 1 : 0;
+            sm_statistics.bytes_requested     += n;
+            sm_statistics.rounding_padding    += chunk_size - n;
+
+            return storage_model::segment_pointer(block.m_segment, block.m_offset);
+        }
     }
-    else
+
+    //- A tenured block that does not fit in the tenured segment is allocated as a young one.
+    //
+    size_type   chunk_pad     = 0;
+    size_type   chunk_offset  = 0;
+    size_type   chunk_segment = tenured_segment();
+
+    if (!tenured  ||  !advance_tenured(chunk_size, align, chunk_offset, chunk_pad))
     {
-        sm_curr_offset += chunk_size;
+        tenured       = false;
+        chunk_offset  = advance_frontier(chunk_size, align, chunk_pad);
+        chunk_segment = sm_curr_segment;
     }
 
-    return storage_model::segment_pointer(sm_curr_segment, chunk_offset);
+    set_block_start(chunk_segment, chunk_offset);
+
+    sm_statistics.allocations         += 1;
+    sm_statistics.tenured_allocations += tenured ? 1 : 0;
+    sm_statistics.bytes_requested     += n;
+    sm_statistics.bytes_allocated     += chunk_size + chunk_pad;
+    sm_statistics.rounding_padding    += chunk_size - n;
+    sm_statistics.alignment_padding   += chunk_pad;
+
+    return storage_model::segment_pointer(chunk_segment, chunk_offset);
+}
+
+//- Small allocations hinted at an existing block are made from a hint area associated with the
+//  region of the segment that contains the hinted block.  Each area is reserved from the
+//  frontier in one piece, so blocks allocated near one another (e.g., neighboring nodes of a
+//  container) share pages instead of being interleaved with unrelated allocations.  When an
+//  area is used up, the rest of it is abandoned and a new one is reserved.  Hint areas are young;
+//  tenured blocks are packed at their own frontier, and hints for them are ignored.
+//
+//  Blocks hinted at the same region are thus kept together, but not next to the hinted block
+//  itself: an area is carved wherever the frontier is when it is reserved, which is near the
+//  hinted block only if that block was allocated recently.  The blocks hinted at an old block
+//  still share pages with one another, at the frontier.
+//
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::void_pointer
+segmented_leaky_allocation_strategy<SM>::allocate
+(size_type n, size_type align, const_void_pointer hint)
+{
+    if (sm_curr_segment == 0)
+    {
+        init_segments();
+    }
+
+    bool        hinted = (n <= max_hinted_size  &&  hint  &&  m_generation == young_generation);
+    hint_area*  pa     = hinted ? find_hint_area(hint) : nullptr;
+
+    if (pa == nullptr)
+    {
+        return allocate(n, align);
+    }
+
+    align = check_alignment(align);
+
+    size_type   chunk_size   = round_up(n, min_alignment);
+    size_type   chunk_offset = round_up(pa->m_offset, align);
+
+    if (pa->m_limit == 0  ||  (chunk_offset + chunk_size) > pa->m_limit)
+    {
+        size_type   area_pad    = 0;
+        size_type   area_offset = advance_frontier(hint_area_size, hint_area_size, area_pad);
+
+        pa->m_segment = sm_curr_segment;
+        pa->m_offset  = area_offset;
+        pa->m_limit   = area_offset + hint_area_size;
+        chunk_offset  = round_up(area_offset, align);
+
+        sm_statistics.bytes_allocated   += hint_area_size + area_pad;
+        sm_statistics.alignment_padding += area_pad;
+        sm_statistics.hint_area_bytes   += hint_area_size;
+    }
+
+    sm_statistics.allocations        += 1;
+    sm_statistics.hinted_allocations += 1;
+    sm_statistics.bytes_requested    += n;
+    sm_statistics.rounding_padding   += chunk_size - n;
+    sm_statistics.alignment_padding  += chunk_offset - pa->m_offset;
+
+    pa->m_offset = chunk_offset + chunk_size;
+    set_block_start(pa->m_segment, chunk_offset);
+
+    return storage_model::segment_pointer(pa->m_segment, chunk_offset);
 }
 
 template<class SM> inline
@@ -103,6 +448,69 @@ void
 segmented_leaky_allocation_strategy<SM>::deallocate(void_pointer)
 {}
 
+//- A block can only grow in place if it ends at a frontier (young or tenured) and the segment
+//  can grow to hold the new size; in the append-only case, that is usually the most recently
+//  allocated block.  Requests that fit in the block's existing (rounded-up) size always succeed.
+//
+template<class SM>
+bool
+segmented_leaky_allocation_strategy<SM>::try_expand
+(void_pointer p, size_type old_n, size_type new_n)
+{
+    size_type   old_size = round_up(old_n, min_alignment);
+    size_type   new_size = round_up(new_n, min_alignment);
+
+    if (new_size <= old_size)
+    {
+        return true;
+    }
+    if (sm_curr_segment == 0  ||  !p)
+    {
+        return false;
+    }
+
+    uint8_t*    pend    = static_cast<uint8_t*>(static_cast<void*>(p)) + old_size;
+    size_type   segment = 0;
+
+    for (size_type s : {sm_curr_segment, tenured_segment()})
+    {
+        if (s != 0  &&  pend == storage_model::segment_address(s) + *frontier_offset(s))
+        {
+            segment = s;
+        }
+    }
+    if (segment == 0)
+    {
+        return false;
+    }
+
+    size_type&  frontier = *frontier_offset(segment);
+    size_type   new_end  = frontier - old_size + new_size;
+
+    if (new_end > storage_model::max_segment_size())
+    {
+        return false;
+    }
+
+    try
+    {
+        commit_frontier(segment, new_end);
+    }
+    catch (std::bad_alloc const&)
+    {
+        return false;
+    }
+
+    frontier = new_end;
+
+    sm_statistics.expansions       += 1;
+    sm_statistics.bytes_requested  += new_n - old_n;
+    sm_statistics.bytes_allocated  += new_size - old_size;
+    sm_statistics.rounding_padding += (new_size - new_n) - (old_size - old_n);
+
+    return true;
+}
+
 template<class SM> inline
 void
 segmented_leaky_allocation_strategy<SM>::swap_buffers()
@@ -110,6 +518,28 @@ segmented_leaky_allocation_strategy<SM>::swap_buffers()
     storage_model::swap_buffers();
 }
 
+//- The root area is never handed out by allocate(), so it is always found at the same location
+//  in the first segment, regardless of where the heap is loaded.
+//
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::void_pointer
+segmented_leaky_allocation_strategy<SM>::root_area()
+{
+    if (sm_curr_segment == 0)
+    {
+        init_segments();
+    }
+
+    return storage_model::segment_pointer(storage_model::first_segment(), 0);
+}
+
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::heap_statistics const&
+segmented_leaky_allocation_strategy<SM>::statistics() noexcept
+{
+    return sm_statistics;
+}
+
 template<class SM> inline
 typename segmented_leaky_allocation_strategy<SM>::difference_type
 segmented_leaky_allocation_strategy<SM>::round_up(difference_type x, difference_type r)
@@ -117,15 +547,570 @@ segmented_leaky_allocation_strategy<SM>::round_up(difference_type x, difference_
     return (x % r) ? (x + r - (x % r)) : x;
 }
 
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::size_type
+segmented_leaky_allocation_strategy<SM>::check_alignment(size_type align)
+{
+    if (align < min_alignment)
+    {
+        align = min_alignment;
+    }
+    if ((align & (align - 1)) != 0  ||  align > storage_model::segment_alignment())
+    {
+        throw std::bad_alloc();
+    }
+    return align;
+}
+
+//- Reserves a chunk at the frontier, moving on to the next segment if the current one cannot
+//  grow to hold it.  Returns the chunk's offset within sm_curr_segment, and sets pad to the
+//  number of bytes skipped to align it.
+//
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::size_type
+segmented_leaky_allocation_strategy<SM>::advance_frontier
+(size_type size, size_type align, size_type& pad)
+{
+    size_type   chunk_offset = round_up(sm_curr_offset, align);
+
+    if ((chunk_offset + size) > storage_model::max_segment_size())
+    {
+        if ((sm_curr_segment + 1) >= (storage_model::first_segment() + young_segments))
+        {
+            throw std::bad_alloc();
+        }
+
+        commit_frontier(sm_curr_segment + 1, size);
+
+        sm_segment_ends[sm_curr_segment - storage_model::first_segment()] = sm_curr_offset;
+        ++sm_curr_segment;
+        chunk_offset   = 0;
+        pad            = 0;
+        sm_curr_offset = size;
+    }
+    else
+    {
+        commit_frontier(sm_curr_segment, chunk_offset + size);
+
+        pad            = chunk_offset - sm_curr_offset;
+        sm_curr_offset = chunk_offset + size;
+    }
+
+    return chunk_offset;
+}
+
+//- Reserves a chunk at the frontier of the tenured segment, if there is one and it can grow to
+//  hold the chunk.  Sets offset to the chunk's offset, and pad as for advance_frontier().
+//
+template<class SM>
+bool
+segmented_leaky_allocation_strategy<SM>::advance_tenured
+(size_type size, size_type align, size_type& offset, size_type& pad)
+{
+    size_type   segment      = tenured_segment();
+    size_type   chunk_offset = round_up(sm_tenured_offset, align);
+
+    if (segment == 0  ||  (chunk_offset + size) > storage_model::max_segment_size())
+    {
+        return false;
+    }
+
+    commit_frontier(segment, chunk_offset + size);
+
+    offset            = chunk_offset;
+    pad               = chunk_offset - sm_tenured_offset;
+    sm_tenured_offset = chunk_offset + size;
+
+    return true;
+}
+
+//- Segments start small and are grown in place, commit_size bytes at a time, as the frontier
+//  reaches their ends; since a segment never moves, offsets handed out earlier remain valid.
+//
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::commit_frontier(size_type segment, size_type end)
+{
+    if (end > storage_model::segment_size(segment))
+    {
+        size_type   size = round_up(end, commit_size);
+
+        storage_model::resize_segment(segment, (size < storage_model::max_segment_size())
+                                               ? size : storage_model::max_segment_size());
+    }
+}
+
+//- Returns the hint area for the region containing the hinted block, or null if the hint does
+//  not point into one of the strategy's segments.  The region is found from the segment and
+//  offset that the hint already holds, without searching the segments for its address.
+//
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::hint_area*
+segmented_leaky_allocation_strategy<SM>::find_hint_area(const_void_pointer const& hint)
+{
+    addressing_model const&     model  = hint.model();
+    size_type                   index  = model.segment() - storage_model::first_segment();
+    size_type                   offset = model.offset();
+
+    if (index < segment_count  &&  offset < storage_model::segment_size(model.segment()))
+    {
+        return &sm_hint_areas[index][offset / region_size];
+    }
+    return nullptr;
+}
+
+//- Sets up the strategy's bookkeeping on first use, or after the storage model has replaced the
+//  segments.  Segments that already exist hold a heap (e.g., one mapped from an image), whose
+//  bookkeeping is loaded rather than started afresh over it.
+//
 template<class SM>
 void
 segmented_leaky_allocation_strategy<SM>::init_segments()
 {
+    storage_model::set_state_hooks(&persist_state, &forget_state);
+
+    bool    existing = (state_segment != 0  &&
+                        storage_model::segment_address(state_segment) != nullptr);
+
     for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
     {
-        storage_model::allocate_segment(j);
+        existing = existing  ||  storage_model::segment_address(j) != nullptr;
+    }
+    if (existing)
+    {
+        load_state();
+        return;
+    }
+
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        storage_model::allocate_segment(j, commit_size);
+    }
+    if (state_segment != 0)
+    {
+        storage_model::allocate_segment(state_segment, sizeof(persisted_state));
+    }
+
+    sm_curr_segment   = storage_model::first_segment();
+    sm_curr_offset    = root_area_size;
+    sm_tenured_offset = 0;
+    mark_bitmaps_dirty();
+
+    //- The root area is treated as a block of its own, so that the collector scans it.
+    //
+    set_block_start(sm_curr_segment, 0);
+}
+
+//- Returns the number of the tenured segment, or zero if there is none.
+//
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::size_type
+segmented_leaky_allocation_strategy<SM>::tenured_segment()
+{
+    return (segment_count > 1) ? storage_model::first_segment() + young_segments : 0;
+}
+
+//- Returns the offset at which the frontier in the segment stands, or null if the segment is
+//  neither the young frontier's current segment nor the tenured segment.
+//
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::size_type*
+segmented_leaky_allocation_strategy<SM>::frontier_offset(size_type segment)
+{
+    return (segment == sm_curr_segment)   ? &sm_curr_offset
+         : (segment == tenured_segment()) ? &sm_tenured_offset
+         : nullptr;
+}
+
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::generation
+segmented_leaky_allocation_strategy<SM>::generation_of(size_type segment)
+{
+    return (segment == tenured_segment()) ? tenured_generation : young_generation;
+}
+
+template<class SM> inline
+void
+segmented_leaky_allocation_strategy<SM>::set_block_start(size_type segment, size_type offset)
+{
+    size_type   index   = segment - storage_model::first_segment();
+    size_type   granule = offset / min_alignment;
+    size_type   word    = granule / 64;
+
+    sm_block_starts[index][word] |= uint64_t(1u) << (granule % 64);
+
+    sm_dirty_first[index] = (word < sm_dirty_first[index]) ? word : sm_dirty_first[index];
+    sm_dirty_last[index]  = (word < sm_dirty_last[index])  ? sm_dirty_last[index] : word + 1;
+}
+
+//- Forgets a block start, as when the collector coalesces a block with the one before it.  Only
+//  the segment's own dirty range is touched, so segments may be cleared concurrently.
+//
+template<class SM> inline
+void
+segmented_leaky_allocation_strategy<SM>::clear_block_start(size_type segment, size_type offset)
+{
+    size_type   index   = segment - storage_model::first_segment();
+    size_type   granule = offset / min_alignment;
+    size_type   word    = granule / 64;
+
+    sm_block_starts[index][word] &= ~(uint64_t(1u) << (granule % 64));
+
+    sm_dirty_first[index] = (word < sm_dirty_first[index]) ? word : sm_dirty_first[index];
+    sm_dirty_last[index]  = (word < sm_dirty_last[index])  ? sm_dirty_last[index] : word + 1;
+}
+
+//- Returns the number of bytes of the segment that have been handed out from the frontier.
+//
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::size_type
+segmented_leaky_allocation_strategy<SM>::used_extent(size_type segment)
+{
+    size_type   index = segment - storage_model::first_segment();
+
+    return (segment == tenured_segment()) ? sm_tenured_offset
+         : (segment == sm_curr_segment)   ? sm_curr_offset
+         : (segment < sm_curr_segment)    ? sm_segment_ends[index]
+         : 0;
+}
+
+//- Returns the number of words of the segment's block-start bitmap that cover its used extent;
+//  the bits past it are all clear.
+//
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::size_type
+segmented_leaky_allocation_strategy<SM>::used_bitmap_words(size_type segment)
+{
+    return (used_extent(segment) / min_alignment + 63) / 64;
+}
+
+//- Free list i holds blocks of at least min_alignment * 2^i bytes, and less than twice that,
+//  except for the last list, which holds everything larger.
+//
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::size_type
+segmented_leaky_allocation_strategy<SM>::free_list_index(size_type size)
+{
+    size_type   index = 0;
+
+    for (size /= min_alignment;  size > 1  &&  index < (free_list_count - 1);  size >>= 1)
+    {
+        ++index;
+    }
+    return index;
+}
+
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::free_block*
+segmented_leaky_allocation_strategy<SM>::free_block_at(free_link link)
+{
+    uint8_t*    pseg = storage_model::segment_address(link.m_segment);
+    return reinterpret_cast<free_block*>(pseg + link.m_offset);
+}
+
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::push_free_block
+(size_type segment, size_type offset, size_type n)
+{
+    free_link&  head = sm_free_lists[generation_of(segment)][free_list_index(n)];
+    free_link   link = {static_cast<uint32_t>(segment), static_cast<uint32_t>(offset)};
+    free_block* pb   = free_block_at(link);
+
+    pb->m_next     = head;
+    pb->m_size     = n;
+    head           = link;
+    sm_free_bytes += n;
+}
+
+//- First fit among the generation's lists, starting with the list whose blocks might be just
+//  large enough.  Blocks whose offsets do not satisfy the requested alignment are passed over.
+//
+template<class SM>
+typename segmented_leaky_allocation_strategy<SM>::free_link
+segmented_leaky_allocation_strategy<SM>::pop_free_block
+(generation gen, size_type n, size_type align, size_type& block_size)
+{
+    for (size_type i = free_list_index(n);  i < free_list_count;  ++i)
+    {
+        for (free_link* plink = &sm_free_lists[gen][i];  plink->m_segment != 0;  )
+        {
+            free_link   link = *plink;
+            free_block* pb   = free_block_at(link);
+
+            if (pb->m_size >= n  &&  (link.m_offset % align) == 0)
+            {
+                *plink         = pb->m_next;
+                block_size     = static_cast<size_type>(pb->m_size);
+                sm_free_bytes -= block_size;
+                return link;
+            }
+            plink = &pb->m_next;
+        }
+    }
+    return free_link{0, 0};
+}
+
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::clear_free_lists()
+{
+    for (auto& lists : sm_free_lists)
+    {
+        for (free_link& head : lists)
+        {
+            head = free_link{0, 0};
+        }
+    }
+    sm_free_bytes = 0;
+}
+
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::save_state(allocation_state& state)
+{
+    state.m_curr_segment   = sm_curr_segment;
+    state.m_curr_offset    = sm_curr_offset;
+    state.m_statistics     = sm_statistics;
+    state.m_free_bytes     = sm_free_bytes;
+    state.m_tenured_offset = sm_tenured_offset;
+
+    std::memcpy(state.m_hint_areas, sm_hint_areas, sizeof(sm_hint_areas));
+    std::memcpy(state.m_segment_ends, sm_segment_ends, sizeof(sm_segment_ends));
+    std::memcpy(state.m_free_lists, sm_free_lists, sizeof(sm_free_lists));
+
+    //- The bitmaps cover all the address space reserved for the segments, which is far more
+    //  than they use, so only the words covering the used extents are saved.
+    //
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        std::memcpy(state.m_block_starts[i], sm_block_starts[i],
+                    used_bitmap_words(j) * sizeof(uint64_t));
+    }
+}
+
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::restore_state(allocation_state const& state)
+{
+    size_type   current_words[segment_count];
+
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        current_words[i] = used_bitmap_words(j);
+    }
+
+    sm_curr_segment   = state.m_curr_segment;
+    sm_curr_offset    = state.m_curr_offset;
+    sm_statistics     = state.m_statistics;
+    sm_free_bytes     = state.m_free_bytes;
+    sm_tenured_offset = state.m_tenured_offset;
+
+    std::memcpy(sm_hint_areas, state.m_hint_areas, sizeof(sm_hint_areas));
+    std::memcpy(sm_segment_ends, state.m_segment_ends, sizeof(sm_segment_ends));
+    std::memcpy(sm_free_lists, state.m_free_lists, sizeof(sm_free_lists));
+
+    //- Blocks allocated past the saved extents must be forgotten as well.
+    //
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        size_type   words = used_bitmap_words(j);
+
+        std::memcpy(sm_block_starts[i], state.m_block_starts[i], words * sizeof(uint64_t));
+
+        if (current_words[i] > words)
+        {
+            std::memset(sm_block_starts[i] + words, 0,
+                        (current_words[i] - words) * sizeof(uint64_t));
+        }
+    }
+    mark_bitmaps_dirty();
+}
+
+//- Called by the storage model before it saves or captures the heap, to bring the state segment
+//  up to date.  Only the bitmap words changed since the last call are copied, unless a bitmap
+//  needs a run of another length, in which case the runs are laid out again and copied in full.
+//
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::persist_state()
+{
+    if (state_segment == 0  ||  sm_curr_segment == 0  ||
+        storage_model::segment_address(state_segment) == nullptr)
+    {
+        return;
+    }
+
+    size_type   words[segment_count];
+    size_type   runs[segment_count];
+    bool        relayout = false;
+
+    auto    ps = reinterpret_cast<persisted_state*>(storage_model::segment_address(state_segment));
+
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        words[i]  = used_bitmap_words(j);
+        runs[i]   = bitmap_run(words[i]);
+        relayout  = relayout  ||  ps->m_magic != state_magic  ||  runs[i] != ps->m_bitmap_runs[i];
+    }
+
+    if (relayout)
+    {
+        size_type   offset = round_up(sizeof(persisted_state), sizeof(uint64_t));
+
+        for (size_type i = 0;  i < segment_count;  ++i)
+        {
+            ps->m_bitmap_offsets[i] = offset;
+            ps->m_bitmap_runs[i]    = runs[i];
+            ps->m_bitmap_words[i]   = 0;
+            offset += runs[i] * sizeof(uint64_t);
+        }
+        if (offset > storage_model::segment_size(state_segment))
+        {
+            storage_model::resize_segment(state_segment, offset);
+        }
+    }
+
+    uint8_t*    pseg = storage_model::segment_address(state_segment);
+
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        uint64_t*   prun  = reinterpret_cast<uint64_t*>(pseg + ps->m_bitmap_offsets[i]);
+        size_type   first = relayout ? 0 : sm_dirty_first[i];
+        size_type   last  = relayout ? words[i]
+                          : (sm_dirty_last[i] < words[i]) ? sm_dirty_last[i] : words[i];
+
+        if (relayout)
+        {
+            std::memset(prun, 0, runs[i] * sizeof(uint64_t));
+        }
+        else if (ps->m_bitmap_words[i] > words[i])
+        {
+            std::memset(prun + words[i], 0, (ps->m_bitmap_words[i] - words[i]) * sizeof(uint64_t));
+        }
+        if (first < last)
+        {
+            std::memcpy(prun + first, sm_block_starts[i] + first,
+                        (last - first) * sizeof(uint64_t));
+        }
+        ps->m_bitmap_words[i] = words[i];
+        ps->m_segment_ends[i] = sm_segment_ends[i];
+        sm_dirty_first[i]     = bitmap_words;
+        sm_dirty_last[i]      = 0;
+    }
+
+    ps->m_curr_segment   = sm_curr_segment;
+    ps->m_curr_offset    = sm_curr_offset;
+    ps->m_tenured_offset = sm_tenured_offset;
+    ps->m_free_bytes     = sm_free_bytes;
+    ps->m_statistics     = sm_statistics;
+    std::memcpy(ps->m_free_lists, sm_free_lists, sizeof(sm_free_lists));
+    ps->m_magic          = state_magic;
+}
+
+//- Called by the storage model when it has replaced or removed the segments, so that the next
+//  use of the strategy sets it up again from whatever segments exist then.
+//
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::forget_state()
+{
+    if (sm_curr_segment == 0)
+    {
+        return;
+    }
+
+    for (size_type i = 0, j = storage_model::first_segment();  i < segment_count;  ++i, ++j)
+    {
+        std::memset(sm_block_starts[i], 0, used_bitmap_words(j) * sizeof(uint64_t));
+        sm_segment_ends[i] = 0;
+    }
+    std::memset(sm_hint_areas, 0, sizeof(sm_hint_areas));
+    clear_free_lists();
+
+    sm_statistics     = heap_statistics{};
+    sm_curr_segment   = 0;
+    sm_curr_offset    = 0;
+    sm_tenured_offset = 0;
+}
+
+//- Loads the bookkeeping persisted with existing segments, checking that it describes them.
+//
+template<class SM>
+void
+segmented_leaky_allocation_strategy<SM>::load_state()
+{
+    uint8_t const*  pseg = (state_segment != 0) ? storage_model::segment_address(state_segment)
+                                                : nullptr;
+    size_type       size = (pseg != nullptr) ? storage_model::segment_size(state_segment) : 0;
+
+    auto    ps = reinterpret_cast<persisted_state const*>(pseg);
+
+    if (size < sizeof(persisted_state)  ||  ps->m_magic != state_magic)
+    {
+        throw std::logic_error("heap segments exist, but hold no allocation state");
+    }
+
+    bool    valid = ps->m_curr_segment >= storage_model::first_segment()  &&
+                    ps->m_curr_segment <  storage_model::first_segment() + young_segments  &&
+                    ps->m_curr_offset <= storage_model::max_segment_size()  &&
+                    ps->m_tenured_offset <= storage_model::max_segment_size();
+
+    for (size_type i = 0;  valid  &&  i < segment_count;  ++i)
+    {
+        valid = storage_model::segment_address(storage_model::first_segment() + i) != nullptr  &&
+                ps->m_bitmap_words[i] <= ps->m_bitmap_runs[i]  &&
+                ps->m_bitmap_runs[i] <= bitmap_words  &&
+                ps->m_bitmap_offsets[i] + ps->m_bitmap_runs[i] * sizeof(uint64_t) <= size;
+    }
+    if (!valid)
+    {
+        throw std::runtime_error("heap allocation state is invalid");
+    }
+
+    sm_curr_segment   = static_cast<size_type>(ps->m_curr_segment);
+    sm_curr_offset    = static_cast<size_type>(ps->m_curr_offset);
+    sm_tenured_offset = static_cast<size_type>(ps->m_tenured_offset);
+    sm_free_bytes     = static_cast<size_type>(ps->m_free_bytes);
+    sm_statistics     = ps->m_statistics;
+    std::memcpy(sm_free_lists, ps->m_free_lists, sizeof(sm_free_lists));
+
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        sm_segment_ends[i] = static_cast<size_type>(ps->m_segment_ends[i]);
+        std::memcpy(sm_block_starts[i], pseg + ps->m_bitmap_offsets[i],
+                    static_cast<size_type>(ps->m_bitmap_words[i]) * sizeof(uint64_t));
+        sm_dirty_first[i] = bitmap_words;
+        sm_dirty_last[i]  = 0;
+    }
+}
+
+//- Returns the number of words in the run that holds a bitmap of the given number of words.
+//
+template<class SM> inline
+typename segmented_leaky_allocation_strategy<SM>::size_type
+segmented_leaky_allocation_strategy<SM>::bitmap_run(size_type words)
+{
+    size_type   run = (words != 0) ? size_type(min_bitmap_run) : 0;
+
+    while (run < words)
+    {
+        run *= 2;
+    }
+    return run;
+}
+
+//- Marks every word of the bitmaps as changed, after they have been rewritten wholesale.
+//
+template<class SM> inline
+void
+segmented_leaky_allocation_strategy<SM>::mark_bitmaps_dirty()
+{
+    for (size_type i = 0;  i < segment_count;  ++i)
+    {
+        sm_dirty_first[i] = 0;
+        sm_dirty_last[i]  = bitmap_words;
     }
-    sm_curr_segment = storage_model::first_segment();
 }
 
 #endif  //- SEGMENTED_LEAKY_ALLOCATION_STRATEGY_H_DEFINED
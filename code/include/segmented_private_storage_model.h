@@ -11,6 +11,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <vector>
 #include "segmented_addressing_model.h"
 
 class segmented_private_storage_model
@@ -20,33 +22,152 @@ class segmented_private_storage_model
     using size_type        = std::size_t; 
     using addressing_model = segmented_addressing_model<segmented_private_storage_model>;
 
+    //- The allocation strategy registers a function that stores its bookkeeping in the heap,
+    //  called before the heap is saved or captured, and one that makes it forget what it knows,
+    //  called after the segments have been replaced or removed.
+    //
+    using state_hook = void (*)();
+
   public:
     enum : size_type
     {
-        max_segments = 8,           //- Don't need many for testing
-        max_size     = 1u << 22     //- 4MB segments
+        max_segments = 16,          //- Room for the heap plus a few imported images
+
+        //- Address space reserved for each segment, up to which it can grow in place: 256MB,
+        //  or 4MB in a 32-bit process.
+        //
+        max_size     = (sizeof(void*) >= 8) ? (1u << 28) : (1u << 22),
+        max_align    = 1u << 12,    //- Segment base addresses are page-aligned
+        page_size    = 1u << 12     //- Granularity of heap image checksums
+    };
+
+    //- Describes the checksumming done by save_image() and by verification of a loaded image.
+    //
+    struct checksum_stats
+    {
+        size_type   bytes_hashed;           //- Bytes whose CRC32C was computed
+        size_type   pages_reused;           //- Clean pages whose saved checksums were kept
+        size_type   bad_pages;              //- Pages that failed verification
+        size_type   threads;                //- Threads used, one per segment
+        double      seconds;                //- Elapsed time
+    };
+
+    //- Describes a pass of sample_segments(), or a call to evict_segment().
+    //
+    struct tiering_stats
+    {
+        size_type   segments_referenced;    //- Segments referenced since the previous pass
+        size_type   segments_evicted;       //- Segments written to the cold store and released
+        size_type   bytes_written;          //- Bytes written to the cold store
+        size_type   bytes_released;         //- Resident bytes released by evicting
+        size_type   resident_bytes;         //- Resident bytes of all segments afterwards
     };
 
     static  void    allocate_segment(size_type segment, size_type size = max_size);
     static  void    deallocate_segment(size_type segment);
+    static  void    resize_segment(size_type segment, size_type size);
     static  void    clear_segments();
     static  void    swap_buffers();
 
+    static  void    set_state_hooks(state_hook store, state_hook reload) noexcept;
+    static  void    store_state();
+    static  void    reload_state();
+
+    static  size_type   import_segments(uint8_t const* const* images, size_type const* sizes,
+                                        size_type count, size_type image_first);
+
+    static  checksum_stats  save_image(char const* path);
+    static  checksum_stats  map_image(char const* path, size_type const* hot = nullptr,
+                                      size_type hot_count = 0, bool verify = true);
+    static  checksum_stats  verify_segments(size_type const* segments = nullptr,
+                                            size_type count = 0);
+
+    static  bool        find_clean_pages(size_type segment, std::vector<bool>& clean);
+
+    static  void            open_cold_store(char const* path);
+    static  void            close_cold_store();
+    static  tiering_stats   sample_segments(size_type idle_passes = 2, size_type max_resident = 0);
+    static  tiering_stats   evict_segment(size_type segment);
+    static  bool            segment_evicted(size_type segment) noexcept;
+
+    static  void        begin_transaction();
+    static  void        commit_transaction() noexcept;
+    static  size_type   rollback_transaction();
+    static  bool        in_transaction() noexcept;
+    static  uint32_t    checksum(void const* p, size_type n, uint32_t crc = 0) noexcept;
+
     static  uint8_t*            segment_address(size_type segment) noexcept;
     static  addressing_model    segment_pointer(size_type segment, size_type offset=0) noexcept;
     static  size_type           segment_size(size_type segment) noexcept;
+    static  uint64_t            relocation_epoch() noexcept;
 
     static  constexpr   size_type   first_segment();
     static  constexpr   size_type   max_segment_count();
     static  constexpr   size_type   max_segment_size();
+    static  constexpr   size_type   segment_alignment();
 
   private:
     friend class segmented_addressing_model<segmented_private_storage_model>;
     
+    //- The primary and shadow buffers of each segment are reservations of max_size bytes of
+    //  address space, of which only the first sm_segment_size bytes (rounded up to a multiple
+    //  of 64KB) are committed; the bytes past a segment's size are always zero.
+    //
     static  uint8_t*            sm_segment_addr[max_segments + 2];
     static  addressing_model    sm_segment_data[max_segments + 2];
     static  size_type           sm_segment_size[max_segments + 2];
     static  uint8_t*            sm_shadow_addr[max_segments + 2];
+
+    //- True for segments whose primary buffers begin with a private mapping of the image file
+    //  that map_image() loaded them from.
+    //
+    static  bool                sm_segment_mapped[max_segments + 2];
+
+    //- Per-page CRC32C of each segment as last saved or loaded.  For a mapped segment, the
+    //  checksums of pages still backed by the image file remain valid, so only pages written
+    //  since need to be hashed again; segments loaded without verification are flagged until
+    //  verify_segments() has checked them.
+    //
+    static  uint32_t            sm_page_crc[max_segments + 2][max_size / page_size];
+    static  bool                sm_segment_unverified[max_segments + 2];
+
+    //- While a transaction is open, the shadow buffer of each segment that existed when it
+    //  began holds that segment's contents at the time, except for pages of mapped segments
+    //  that were still backed by the image file, which are flagged in sm_undo_clean instead.
+    //  Segments that did not exist are recorded with a size of zero.
+    //
+    static  bool                sm_transaction_open;
+    static  size_type           sm_undo_size[max_segments + 2];
+    static  std::vector<bool>   sm_undo_clean[max_segments + 2];
+
+    //- Incremented whenever a segment's base address changes, so that cached translations can
+    //  be recognized as stale.  Kept on its own cache line, away from the segment tables.
+    //
+    alignas(64) static  uint64_t    sm_relocation_epoch;
+
+    //- The cold store is a sparse scratch file in which each segment has a region of max_size
+    //  bytes, at offset segment * max_size.  An evicted segment's primary buffer is a private
+    //  mapping of its region, and sm_segment_mapped is also set for it.  sm_idle_passes counts
+    //  the sampling passes since each segment's pages were last found referenced.
+    //
+    static  std::FILE*          sm_cold_store;
+    static  bool                sm_segment_cold[max_segments + 2];
+    static  size_type           sm_idle_passes[max_segments + 2];
+
+    //- Pages that are backed by a file, but whose contents may differ from those the segment
+    //  was mapped from an image with: pages that were not backed by a file when the segment was
+    //  evicted, and pages whose private copies a rollback discarded, which a capture may have
+    //  seen written.  find_clean_pages() reports them as dirty.
+    //
+    static  std::vector<bool>   sm_page_written[max_segments + 2];
+
+    static  state_hook          sm_store_hook;
+    static  state_hook          sm_reload_hook;
+
+    static  bool                find_backed_pages(size_type segment, std::vector<bool>& backed);
+    static  checksum_stats      update_checksums(size_type segment);
+    static  checksum_stats      check_checksums(size_type segment);
+    static  tiering_stats       evict(size_type segment, size_type resident);
 };
 
 
@@ -69,6 +190,49 @@ segmented_private_storage_model::segment_size(size_type segment) noexcept -> siz
     return sm_segment_size[segment];
 }
 
+inline void
+segmented_private_storage_model::set_state_hooks(state_hook store, state_hook reload) noexcept
+{
+    sm_store_hook  = store;
+    sm_reload_hook = reload;
+}
+
+inline void
+segmented_private_storage_model::store_state()
+{
+    if (sm_store_hook != nullptr)
+    {
+        sm_store_hook();
+    }
+}
+
+inline void
+segmented_private_storage_model::reload_state()
+{
+    if (sm_reload_hook != nullptr)
+    {
+        sm_reload_hook();
+    }
+}
+
+inline bool
+segmented_private_storage_model::in_transaction() noexcept
+{
+    return sm_transaction_open;
+}
+
+inline bool
+segmented_private_storage_model::segment_evicted(size_type segment) noexcept
+{
+    return sm_segment_cold[segment];
+}
+
+inline uint64_t
+segmented_private_storage_model::relocation_epoch() noexcept
+{
+    return sm_relocation_epoch;
+}
+
 constexpr inline auto
 segmented_private_storage_model::first_segment() -> size_type
 {
@@ -87,4 +251,10 @@ segmented_private_storage_model::max_segment_size() -> size_type
     return max_size;
 }
 
+constexpr inline auto
+segmented_private_storage_model::segment_alignment() -> size_type
+{
+    return max_align;
+}
+
 #endif  //- SEGMENTED_PRIVATE_STORAGE_MODEL_H_DEFINED
@@ -0,0 +1,136 @@
+//==================================================================================================
+//  File:
+//      single_segment_storage_model.h
+//
+//  Summary:
+//      Defines a heap class for testing rhx_allocator whose heap lives in exactly one segment,
+//      so that synthetic pointers can be translated without consulting the segment table.
+//==================================================================================================
+//
+#ifndef SINGLE_SEGMENT_STORAGE_MODEL_H_DEFINED
+#define SINGLE_SEGMENT_STORAGE_MODEL_H_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include "segmented_addressing_model.h"
+
+//--------------------------------------------------------------------------------------------------
+//  Class:
+//      single_segment_storage_model
+//
+//  Summary:
+//      This class provides the segment services of segmented_private_storage_model for a heap
+//      of a single segment, numbered first_segment().  Its max_segment_count() is 1, which
+//      storage_model_traits reports as a constant expression; segmented_addressing_model then
+//      translates a pointer with one load of the segment's base address, which the compiler is
+//      free to hoist out of loops, and an add, instead of indexing the segment table with the
+//      pointer's segment number and masking off its offset.  The representation is unchanged.
+//
+//      Like the other models, the segment has a shadow buffer into which swap_buffers() moves
+//      it, and it grows in place up to max_size bytes.
+//--------------------------------------------------------------------------------------------------
+//
+class single_segment_storage_model
+{
+  public:
+    using difference_type  = std::ptrdiff_t;
+    using size_type        = std::size_t;
+    using addressing_model = segmented_addressing_model<single_segment_storage_model>;
+
+    //- The allocation strategy registers a function that stores its bookkeeping in the heap,
+    //  which this model never saves, and one that makes it forget what it knows, called after
+    //  the segment has been removed.
+    //
+    using state_hook = void (*)();
+
+  public:
+    enum : size_type
+    {
+        max_segments = 1,           //- The whole heap lives in one segment
+
+        //- Address space reserved for the segment, up to which it can grow in place: 256MB, or
+        //  4MB in a 32-bit process.
+        //
+        max_size     = (sizeof(void*) >= 8) ? (1u << 28) : (1u << 22),
+        max_align    = 1u << 12     //- Segment base addresses are page-aligned
+    };
+
+    static  void    allocate_segment(size_type segment, size_type size = max_size);
+    static  void    deallocate_segment(size_type segment);
+    static  void    resize_segment(size_type segment, size_type size);
+    static  void    clear_segments();
+    static  void    swap_buffers();
+    static  void    set_state_hooks(state_hook store, state_hook reload) noexcept;
+
+    static  uint8_t*            segment_address(size_type segment) noexcept;
+    static  addressing_model    segment_pointer(size_type segment, size_type offset=0) noexcept;
+    static  size_type           segment_size(size_type segment) noexcept;
+
+    static  constexpr   size_type   first_segment();
+    static  constexpr   size_type   max_segment_count();
+    static  constexpr   size_type   max_segment_size();
+    static  constexpr   size_type   segment_alignment();
+
+  private:
+    friend class segmented_addressing_model<single_segment_storage_model>;
+
+    //- The tables have the same shape as those of the segmented model, so that the general
+    //  translation code still applies; every entry but the first segment's stays null.
+    //
+    static  uint8_t*    sm_segment_addr[max_segments + 2];
+    static  size_type   sm_segment_size[max_segments + 2];
+    static  uint8_t*    sm_shadow_addr[max_segments + 2];
+    static  state_hook  sm_reload_hook;
+};
+
+
+inline void
+single_segment_storage_model::set_state_hooks(state_hook, state_hook reload) noexcept
+{
+    sm_reload_hook = reload;
+}
+
+inline auto
+single_segment_storage_model::segment_address(size_type segment) noexcept -> uint8_t*
+{
+    return sm_segment_addr[segment];
+}
+
+inline auto
+single_segment_storage_model::segment_pointer(size_type segment, size_type offset) noexcept
+-> addressing_model
+{
+    return addressing_model{segment, offset};
+}
+
+inline auto
+single_segment_storage_model::segment_size(size_type segment) noexcept -> size_type
+{
+    return sm_segment_size[segment];
+}
+
+constexpr inline auto
+single_segment_storage_model::first_segment() -> size_type
+{
+    return 2;
+}
+
+constexpr inline auto
+single_segment_storage_model::max_segment_count() -> size_type
+{
+    return max_segments;
+}
+
+constexpr inline auto
+single_segment_storage_model::max_segment_size() -> size_type
+{
+    return max_size;
+}
+
+constexpr inline auto
+single_segment_storage_model::segment_alignment() -> size_type
+{
+    return max_align;
+}
+
+#endif  //- SINGLE_SEGMENT_STORAGE_MODEL_H_DEFINED
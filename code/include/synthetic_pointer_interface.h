@@ -13,6 +13,7 @@
 #include <cstdint>
 #include <type_traits>
 #include <iterator>
+#include <memory>
 
 //--------------------------------------------------------------------------------------------------
 //  Class:
@@ -42,4 +43,69 @@ struct synthetic_pointer_traits
 #include "synthetic_void_pointer_interface.h"
 #include "synthetic_pointer_compare_ops.h"
 
+//--------------------------------------------------------------------------------------------------
+//  Class Template:
+//      std::pointer_traits<synthetic_pointer<T, AM>>
+//
+//  Summary:
+//      This specialization adds to_address(), so that std::to_address() and rhx_to_address()
+//      can obtain an ordinary pointer from a synthetic pointer without dereferencing it.  That
+//      is what lets algorithms treat a range of synthetic pointers as contiguous memory.
+//--------------------------------------------------------------------------------------------------
+//
+namespace std {
+
+template<class T, class AM>
+struct pointer_traits<synthetic_pointer<T, AM>>
+{
+  private:
+    struct not_a_reference {};
+
+  public:
+    using pointer         = synthetic_pointer<T, AM>;
+    using element_type    = T;
+    using difference_type = typename pointer::difference_type;
+
+    template<class U>
+    using rebind = synthetic_pointer<U, AM>;
+
+    using reference = typename std::conditional<std::is_void<T>::value, not_a_reference, T>::type&;
+
+    static  pointer     pointer_to(reference r) noexcept;
+    static  T*          to_address(pointer const& p) noexcept;
+};
+
+template<class T, class AM> inline
+typename pointer_traits<synthetic_pointer<T, AM>>::pointer
+pointer_traits<synthetic_pointer<T, AM>>::pointer_to(reference r) noexcept
+{
+    return pointer(std::addressof(r));
+}
+
+template<class T, class AM> inline
+T*
+pointer_traits<synthetic_pointer<T, AM>>::to_address(pointer const& p) noexcept
+{
+    return static_cast<T*>(p);
+}
+
+}   //- namespace std
+
+//- Returns the ordinary pointer corresponding to an ordinary or synthetic pointer; this is
+//  std::to_address() for C++14.
+//
+template<class T> inline
+T*
+rhx_to_address(T* p) noexcept
+{
+    return p;
+}
+
+template<class T, class AM> inline
+T*
+rhx_to_address(synthetic_pointer<T, AM> const& p) noexcept
+{
+    return std::pointer_traits<synthetic_pointer<T, AM>>::to_address(p);
+}
+
 #endif  //- SYNTHETIC_POINTER_INTERFACE_H_DEFINED
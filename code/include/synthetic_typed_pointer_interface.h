@@ -32,6 +32,9 @@ class synthetic_pointer
     using reference         = T&;
     using pointer           = synthetic_pointer;
     using iterator_category = std::random_access_iterator_tag;
+#if __cplusplus >= 202002L  ||  (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+    using iterator_concept  = std::contiguous_iterator_tag;
+#endif
 
   public:
     //- Special member functions - make intentions explicit.
@@ -62,6 +65,10 @@ class synthetic_pointer
     template<class U, synthetic_pointer_traits::implicitly_convertible<U, T> = true>
     synthetic_pointer&   operator =(synthetic_pointer<U, AM> const& p);
 
+    //- The addressing model, as given to the constructor that takes one.
+    //
+    AM const&   model() const noexcept;
+
     //- User-defined conversion.
     //
     explicit    operator bool() const;
@@ -85,9 +92,9 @@ class synthetic_pointer
     synthetic_pointer        operator +(difference_type n) const;
 
     synthetic_pointer&       operator ++();
-    synthetic_pointer const  operator ++(int);
+    synthetic_pointer        operator ++(int);
     synthetic_pointer&       operator --();
-    synthetic_pointer const  operator --(int);
+    synthetic_pointer        operator --(int);
     synthetic_pointer&       operator +=(difference_type n);
     synthetic_pointer&       operator -=(difference_type n);
 
@@ -95,6 +102,11 @@ class synthetic_pointer
     //
     static  synthetic_pointer     pointer_to(element_type& e);
 
+    //- Converts an array of synthetic pointers to ordinary pointers in one call.
+    //
+    static  void    translate(synthetic_pointer const* psrc, T** pdst, size_type n,
+                              bool prefetch = false);
+
     //- Additional helper functions used to implement the comparison operators.
     //
     bool    equals(std::nullptr_t) const;
@@ -177,6 +189,13 @@ synthetic_pointer<T, AM>::operator =(synthetic_pointer<U, AM> const& rhs)
 
 //------
 //
+template<class T, class AM> inline
+AM const&
+synthetic_pointer<T, AM>::model() const noexcept
+{
+    return m_addrmodel;
+}
+
 template<class T, class AM> inline
 synthetic_pointer<T, AM>::operator bool() const
 {
@@ -231,10 +250,7 @@ template<class T, class AM> inline
 typename synthetic_pointer<T, AM>::difference_type
 synthetic_pointer<T, AM>::operator -(synthetic_pointer const& rhs) const
 {
-    uint8_t const*  p1 = static_cast<uint8_t const*>(m_addrmodel.address());
-    uint8_t const*  p2 = static_cast<uint8_t const*>(rhs.m_addrmodel.address());
-
-    return (p1 - p2) / sizeof(T);
+    return m_addrmodel.difference(rhs.m_addrmodel) / static_cast<difference_type>(sizeof(T));
 }
 
 template<class T, class AM> inline
@@ -255,6 +271,15 @@ synthetic_pointer<T, AM>::operator +(difference_type n) const
     return tmp;
 }
 
+//- Addition is commutative, as random-access iterators require.
+//
+template<class T, class AM> inline
+synthetic_pointer<T, AM>
+operator +(typename synthetic_pointer<T, AM>::difference_type n, synthetic_pointer<T, AM> const& p)
+{
+    return p + n;
+}
+
 template<class T, class AM> inline
 synthetic_pointer<T, AM>&
 synthetic_pointer<T, AM>::operator ++()
@@ -264,7 +289,7 @@ synthetic_pointer<T, AM>::operator ++()
 }
 
 template<class T, class AM> inline
-synthetic_pointer<T, AM> const
+synthetic_pointer<T, AM>
 synthetic_pointer<T, AM>::operator ++(int)
 {
     synthetic_pointer   tmp{*this};
@@ -281,7 +306,7 @@ synthetic_pointer<T, AM>::operator --()
 }
 
 template<class T, class AM> inline
-synthetic_pointer<T, AM> const
+synthetic_pointer<T, AM>
 synthetic_pointer<T, AM>::operator --(int)
 {
     synthetic_pointer   tmp{*this};
@@ -383,4 +408,20 @@ synthetic_pointer<T, AM>::pointer_to(element_type& e)
     return synthetic_pointer(&e);
 }
 
+//- A synthetic pointer is nothing but its addressing model, so an array of them can be handed
+//  to the addressing model's batch translation as an array of addressing models.
+//
+template<class T, class AM> inline
+void
+synthetic_pointer<T, AM>::translate
+(synthetic_pointer const* psrc, T** pdst, size_type n, bool prefetch)
+{
+    using raw_pointer = typename std::remove_cv<T>::type*;
+
+    static_assert(sizeof(synthetic_pointer) == sizeof(AM), "unexpected pointer representation");
+
+    void**  pout = reinterpret_cast<void**>(const_cast<raw_pointer*>(pdst));
+    AM::translate(reinterpret_cast<AM const*>(psrc), pout, n, prefetch);
+}
+
 #endif  //- SYNTHETIC_TYPED_POINTER_INTERFACE_H_DEFINED
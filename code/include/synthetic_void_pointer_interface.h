@@ -65,6 +65,10 @@ class synthetic_pointer<void, AM>
     template<class U, synthetic_pointer_traits::implicitly_convertible<U, void> = true>
     synthetic_pointer&   operator =(synthetic_pointer<U, AM> const& p);
 
+    //- The addressing model, as given to the constructor that takes one.
+    //
+    AM const&   model() const noexcept;
+
     //- User-defined conversion.
     //
     explicit    operator bool() const;
@@ -158,6 +162,13 @@ synthetic_pointer<void, AM>::operator =(synthetic_pointer<U, AM> const& rhs)
 
 //------
 //
+template<class AM> inline
+AM const&
+synthetic_pointer<void, AM>::model() const noexcept
+{
+    return m_addrmodel;
+}
+
 template<class AM> inline
 synthetic_pointer<void, AM>::operator bool() const
 {
@@ -310,6 +321,10 @@ class synthetic_pointer<void const, AM>
     template<class U, synthetic_pointer_traits::implicitly_convertible<U, void const> = true>
     synthetic_pointer&   operator =(synthetic_pointer<U, AM> const& p);
 
+    //- The addressing model, as given to the constructor that takes one.
+    //
+    AM const&   model() const noexcept;
+
     //- User-defined conversion.
     //
     explicit    operator bool() const;
@@ -403,6 +418,13 @@ synthetic_pointer<void const, AM>::operator =(synthetic_pointer<U, AM> const& rh
 
 //------
 //
+template<class AM> inline
+AM const&
+synthetic_pointer<void const, AM>::model() const noexcept
+{
+    return m_addrmodel;
+}
+
 template<class AM> inline
 synthetic_pointer<void const, AM>::operator bool() const
 {
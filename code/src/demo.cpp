@@ -6,26 +6,57 @@
 
 // #define SEE_MAP_BUG
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 #include <deque>
 #include <list>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <forward_list>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "segmented_addressing_model.h"
+#include "cached_segmented_addressing_model.h"
+#include "fixed_private_storage_model.h"
 #include "segmented_private_storage_model.h"
+#include "single_segment_storage_model.h"
 #include "synthetic_pointer_interface.h"
 #include "segmented_leaky_allocation_strategy.h"
 #include "rhx_allocator.h"
+#include "rhx_btree_map.h"
+#include "rhx_flat_hash_map.h"
+#include "rhx_intern_pool.h"
+#include "rhx_intrusive.h"
+#include "rhx_ring_queue.h"
+#include "rhx_root_directory.h"
+#include "rhx_string.h"
+#include "rhx_vector.h"
+#include "segmented_heap_collector.h"
+#include "segmented_heap_compactor.h"
+#include "segmented_heap_journal.h"
+#include "segmented_heap_replication.h"
+#include "segmented_heap_transaction.h"
+
+#include <atomic>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/socket.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
 
 using namespace std;
 
 using test_strategy = segmented_leaky_allocation_strategy<segmented_private_storage_model>;
 
+using test_roots    = rhx_root_directory<test_strategy>;
+
 template<class T> using test_allocator     = rhx_allocator<T, test_strategy>;
 template<class C> using test_string        = basic_string<C, char_traits<C>, test_allocator<C>>;
 template<class T> using test_fwdlist       = forward_list<T, test_allocator<T>>;
@@ -34,6 +65,35 @@ template<class T> using test_deque         = deque<T, test_allocator<T>>;
 template<class T> using test_vector        = vector<T, test_allocator<T>>;
 template<class K, class V> using test_map  = map<K, V, less<K>, test_allocator<pair<K const, V>>>;
 template<class K, class V> using test_umap = unordered_map<K, V, hash<K>, equal_to<K>, test_allocator<pair<K const, V>>>;
+template<class K, class V> using test_flat_map = rhx_flat_hash_map<K, V, hash<K>, equal_to<K>, test_allocator<pair<K const, V>>>;
+template<class K, class V> using test_btree_map = rhx_btree_map<K, V, less<K>, test_allocator<pair<K const, V>>>;
+template<class T> using test_rhx_vector    = rhx_vector<T, test_allocator<T>>;
+template<class C> using test_rhx_string    = rhx_basic_string<C, char_traits<C>, test_allocator<C>>;
+using test_collector = segmented_heap_collector<test_strategy>;
+using test_compactor = segmented_heap_compactor<test_strategy>;
+using test_journal   = segmented_heap_journal<segmented_private_storage_model>;
+using test_leader    = segmented_heap_leader<segmented_private_storage_model>;
+using test_follower  = segmented_heap_follower<segmented_private_storage_model>;
+using test_transaction = segmented_heap_transaction<test_strategy>;
+
+using test_cached_model = cached_segmented_addressing_model<segmented_private_storage_model>;
+template<class T> using test_pointer        = test_strategy::rebind_pointer<T>;
+template<class T> using test_cached_pointer = synthetic_pointer<T, test_cached_model>;
+
+using fixed_strategy = segmented_leaky_allocation_strategy<fixed_private_storage_model>;
+
+template<class T> using fixed_allocator    = rhx_allocator<T, fixed_strategy>;
+template<class T> using fixed_rhx_vector   = rhx_vector<T, fixed_allocator<T>>;
+template<class K, class V> using fixed_btree_map = rhx_btree_map<K, V, less<K>, fixed_allocator<pair<K const, V>>>;
+template<class T> using fixed_pointer      = fixed_strategy::rebind_pointer<T>;
+using fixed_collector = segmented_heap_collector<fixed_strategy>;
+
+using single_strategy = segmented_leaky_allocation_strategy<single_segment_storage_model>;
+
+template<class T> using single_allocator   = rhx_allocator<T, single_strategy>;
+template<class T> using single_rhx_vector  = rhx_vector<T, single_allocator<T>>;
+template<class K, class V> using single_btree_map = rhx_btree_map<K, V, less<K>, single_allocator<pair<K const, V>>>;
+template<class T> using single_pointer     = single_strategy::rebind_pointer<T>;
 
 void test1()
 {
@@ -273,6 +333,2870 @@ void test6()
     }
 }
 
+struct alignas(64) cache_line_counter
+{
+    uint64_t    count;
+};
+
+void test7()
+{
+    auto    spv = allocate<test_vector<cache_line_counter>, test_strategy>();
+
+    for (int i = 0;  i < 8;  ++i)
+    {
+        spv->push_back(cache_line_counter{static_cast<uint64_t>(i)});
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "***  TEST ALIGNMENT  ***" << endl;
+    cout << "orignal vector address is: " << &(*spv) << endl;
+
+    for (auto const& e : *spv)
+    {
+        cout << &e << " mod 64 = " << (reinterpret_cast<uintptr_t>(&e) % 64) << endl;
+    }
+
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+    cout << "relocated vector address is: " << &(*spv) << endl;
+
+    for (auto const& e : *spv)
+    {
+        cout << &e << " mod 64 = " << (reinterpret_cast<uintptr_t>(&e) % 64) << endl;
+    }
+
+    auto const&     stats = test_strategy::statistics();
+
+    cout << "allocations:       " << stats.allocations << endl;
+    cout << "bytes requested:   " << stats.bytes_requested << endl;
+    cout << "bytes allocated:   " << stats.bytes_allocated << endl;
+    cout << "rounding padding:  " << stats.rounding_padding << endl;
+    cout << "alignment padding: " << stats.alignment_padding << endl;
+    cout << "hinted allocations: " << stats.hinted_allocations << endl;
+}
+
+void test8()
+{
+    using demo_list = test_vector<test_string<char>>;
+
+    auto    spv = test_roots::find_or_construct<demo_list>("test8.strings");
+    char    str[256];
+
+    for (int i = 1;  i <= 5;  ++i)
+    {
+        sprintf(str, "this is very long test string of persistent piffle #%d for roots", i);
+        spv->push_back(str);
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "*****  TEST ROOTS  *****" << endl;
+    cout << "orignal root address is: " << &(*spv) << endl;
+
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+
+    auto    spr = test_roots::find<demo_list>("test8.strings");
+
+    cout << "relocated root address is: " << &(*spr) << endl;
+    cout << "roots in directory: " << test_roots::size() << endl;
+
+    for (auto const& e : *spr)
+    {
+        cout << e << endl;
+    }
+}
+
+//- Scatters consecutive integers, so that neither map benefits from sequential key order.
+//
+inline int
+scatter(int i)
+{
+    return static_cast<int>((static_cast<uint32_t>(i) * 2654435761u) >> 1);
+}
+
+template<class M>
+void run_map_workload(char const* name, M& map, int count)
+{
+    auto    stats0 = test_strategy::statistics();
+    auto    t0     = chrono::steady_clock::now();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        map[scatter(i)] = i;
+    }
+
+    auto    t1     = chrono::steady_clock::now();
+    auto    stats1 = test_strategy::statistics();
+    long    sum    = 0;
+
+    //- Look keys up in a different order than they were inserted; half of them are missing.
+    //
+    for (int pass = 0;  pass < 10;  ++pass)
+    {
+        for (int i = 0;  i < 2 * count;  ++i)
+        {
+            auto    it = map.find(scatter(static_cast<int>((i * 40503LL) % (2 * count))));
+            sum += (it != map.end()) ? it->second : 0;
+        }
+    }
+
+    auto    t2 = chrono::steady_clock::now();
+    auto    ns = [](chrono::steady_clock::duration d)
+                 { return chrono::duration_cast<chrono::nanoseconds>(d).count(); };
+
+    cout << name << ": " << (stats1.allocations - stats0.allocations) << " allocations, "
+         << (stats1.bytes_allocated - stats0.bytes_allocated) << " bytes, "
+         << (ns(t1 - t0) / count) << " ns/insert, "
+         << (ns(t2 - t1) / (20 * count)) << " ns/find (checksum " << sum << ")" << endl;
+}
+
+void test9()
+{
+    int const   count = 50000;
+
+    auto    spumap = allocate<test_umap<int, int>, test_strategy>();
+    auto    spflat = allocate<test_flat_map<int, int>, test_strategy>();
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "***  TEST FLAT MAP  ****" << endl;
+
+    run_map_workload("unordered_map", *spumap, count);
+    run_map_workload("flat_hash_map", *spflat, count);
+
+    cout << "orignal flat map address is: " << &(*spflat) << endl;
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+    cout << "relocated flat map address is: " << &(*spflat) << endl;
+
+    int     missing = 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        auto    it = spflat->find(scatter(i));
+        missing += (it == spflat->end()  ||  it->second != i) ? 1 : 0;
+    }
+
+    cout << "flat map size " << spflat->size() << ", missing after relocation: " << missing << endl;
+
+    //- Rehashing a map that never held anything must not give it a table.
+    //
+    auto    spempty = allocate<test_flat_map<int, int>, test_strategy>();
+    auto    stats0  = test_strategy::statistics();
+
+    spempty->rehash(0);
+
+    auto    stats1  = test_strategy::statistics();
+    auto    extra   = stats1.allocations - stats0.allocations;
+
+    cout << "allocations by rehash(0) of an empty map: " << extra
+         << ", errors: " << ((extra == 0  &&  spempty->capacity() == 0) ? 0 : 1) << endl;
+}
+
+template<class M>
+void run_ordered_workload(char const* name, M& map, int count)
+{
+    auto    stats0 = test_strategy::statistics();
+    auto    t0     = chrono::steady_clock::now();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        map[scatter(i)] = i;
+    }
+
+    auto    t1     = chrono::steady_clock::now();
+    auto    stats1 = test_strategy::statistics();
+    long    sum    = 0;
+
+    for (int pass = 0;  pass < 10;  ++pass)
+    {
+        for (auto const& e : map)
+        {
+            sum += e.second;
+        }
+    }
+
+    auto    t2 = chrono::steady_clock::now();
+
+    //- Range scans of 100 consecutive elements from scattered starting keys.
+    //
+    for (int i = 0;  i < count / 10;  ++i)
+    {
+        auto    it = map.lower_bound(scatter(static_cast<int>((i * 40503LL) % count)));
+
+        for (int j = 0;  j < 100  &&  it != map.end();  ++j, ++it)
+        {
+            sum += it->second;
+        }
+    }
+
+    auto    t3 = chrono::steady_clock::now();
+    auto    ns = [](chrono::steady_clock::duration d)
+                 { return chrono::duration_cast<chrono::nanoseconds>(d).count(); };
+
+    cout << name << ": " << (stats1.allocations - stats0.allocations) << " allocations, "
+         << (stats1.bytes_allocated - stats0.bytes_allocated) << " bytes, "
+         << (ns(t1 - t0) / count) << " ns/insert, "
+         << (ns(t2 - t1) / 10000) << " us/full iteration, "
+         << (ns(t3 - t2) / (count / 10)) << " ns/range scan (checksum " << sum << ")" << endl;
+}
+
+//- A value whose constructor throws for one chosen value, to check that a failed insertion
+//  leaves a container as it was.
+//
+struct fussy_value
+{
+    static  int     sm_reject;
+
+    int     m_value;
+
+    explicit fussy_value(int value) : m_value(value)
+    {
+        if (value == sm_reject)
+        {
+            throw runtime_error("value rejected");
+        }
+    }
+};
+
+int     fussy_value::sm_reject = -1;
+
+void test10()
+{
+    int const   count = 50000;
+
+    auto    spmap = allocate<test_map<int, int>, test_strategy>();
+    auto    sptree = allocate<test_btree_map<int, int>, test_strategy>();
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "***  TEST BTREE MAP  ***" << endl;
+
+    run_ordered_workload("map      ", *spmap, count);
+    run_ordered_workload("btree_map", *sptree, count);
+
+    cout << "orignal btree map address is: " << &(*sptree) << endl;
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+    cout << "relocated btree map address is: " << &(*sptree) << endl;
+
+    int     errors = 0;
+    int     prev   = -1;
+    size_t  cnt    = 0;
+
+    for (auto const& e : *sptree)
+    {
+        errors += (e.first <= prev  ||  scatter(e.second) != e.first) ? 1 : 0;
+        prev    = e.first;
+        ++cnt;
+    }
+
+    cout << "btree map size " << sptree->size() << ", height " << sptree->height()
+         << ", iterated " << cnt << ", errors after relocation: " << errors << endl;
+
+    //- Ascending insertions, every fifth of which fails, some of them when a full tail leaf is
+    //  split; after each failure the last element must still be the last one iterated.  The
+    //  failed keys are then inserted between existing ones.
+    //
+    auto    spfussy      = allocate<test_btree_map<int, fussy_value>, test_strategy>();
+    int     failed       = 0;
+    int     fussy_errors = 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        fussy_value::sm_reject = (i % 5 == 0) ? i : -1;
+
+        try
+        {
+            spfussy->try_emplace(i, i);
+        }
+        catch (runtime_error const&)
+        {
+            auto    it = spfussy->find(i - 1);
+
+            fussy_errors += (i != 0  &&  (it == spfussy->end()  ||  ++it != spfussy->end()));
+            ++failed;
+        }
+    }
+    fussy_errors += (spfussy->size() != static_cast<size_t>(count - failed)) ? 1 : 0;
+
+    fussy_value::sm_reject = -1;
+
+    for (int i = 0;  i < count;  i += 5)
+    {
+        spfussy->try_emplace(i, i);
+    }
+
+    prev = -1;
+    cnt  = 0;
+
+    for (auto const& e : *spfussy)
+    {
+        fussy_errors += (e.first != prev + 1  ||  e.second.m_value != e.first) ? 1 : 0;
+        prev          = e.first;
+        ++cnt;
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        auto    it = spfussy->find(i);
+        fussy_errors += (it == spfussy->end()  ||  it->second.m_value != i) ? 1 : 0;
+    }
+    fussy_errors += (cnt != static_cast<size_t>(count)  ||  spfussy->size() != cnt) ? 1 : 0;
+
+    cout << "failed insertions: " << failed << ", errors after failed insertions: "
+         << fussy_errors << endl;
+}
+
+//- Counts the distinct 4KB pages touched by ordered iteration.
+//
+template<class M>
+size_t count_pages(M const& map)
+{
+    vector<uintptr_t>   pages;
+
+    for (auto const& e : map)
+    {
+        pages.push_back(reinterpret_cast<uintptr_t>(&e.second) >> 12);
+    }
+
+    sort(pages.begin(), pages.end());
+    return unique(pages.begin(), pages.end()) - pages.begin();
+}
+
+void test11()
+{
+    int const   count = 20000;
+
+    auto    spmap  = allocate<test_map<int, int>, test_strategy>();
+    auto    sptree = allocate<test_btree_map<int, int>, test_strategy>();
+    auto    spstrs = allocate<test_vector<test_string<char>>, test_strategy>();
+    auto    stats0 = test_strategy::statistics();
+    char    str[256];
+
+    //- Grow both maps over time, interleaved with unrelated string allocations.
+    //
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[scatter(i)]  = i;
+        (*sptree)[scatter(i)] = i;
+
+        if (i % 4 == 0)
+        {
+            sprintf(str, "this is very long test string of interleaved nonsense #%d for hints", i);
+            spstrs->push_back(str);
+        }
+    }
+
+    auto    stats1 = test_strategy::statistics();
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "***  TEST LOCALITY  ****" << endl;
+    cout << "pages touched iterating map:       " << count_pages(*spmap) << endl;
+    cout << "pages touched iterating btree map: " << count_pages(*sptree) << endl;
+    cout << "hinted allocations: " << (stats1.hinted_allocations - stats0.hinted_allocations)
+         << ", hint area bytes: " << (stats1.hint_area_bytes - stats0.hint_area_bytes) << endl;
+}
+
+template<class V, class S>
+void run_growth_workload(char const* name, V& vec, S& str, int count)
+{
+    auto    stats0 = test_strategy::statistics();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        vec.push_back(i);
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        str += static_cast<char>('a' + i % 26);
+    }
+
+    auto    stats1 = test_strategy::statistics();
+
+    cout << name << ": " << (stats1.allocations - stats0.allocations) << " allocations, "
+         << (stats1.expansions - stats0.expansions) << " expansions, "
+         << (stats1.bytes_allocated - stats0.bytes_allocated) << " bytes" << endl;
+}
+
+void test12()
+{
+    int const   count = 100000;
+
+    auto    spvec  = allocate<test_vector<int>, test_strategy>();
+    auto    spstr  = allocate<test_string<char>, test_strategy>();
+    auto    sprvec = allocate<test_rhx_vector<int>, test_strategy>();
+    auto    sprstr = allocate<test_rhx_string<char>, test_strategy>();
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST GROWTH  *****" << endl;
+
+    run_growth_workload("vector + string        ", *spvec, *spstr, count);
+    run_growth_workload("rhx_vector + rhx_string", *sprvec, *sprstr, count);
+
+    cout << "orignal rhx_vector address is: " << &(*sprvec) << endl;
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+    cout << "relocated rhx_vector address is: " << &(*sprvec) << endl;
+
+    int     errors = 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        errors += ((*sprvec)[i] != i  ||  (*sprstr)[i] != static_cast<char>('a' + i % 26)) ? 1 : 0;
+    }
+
+    //- Sizes past max_size() are refused, including those whose byte counts would overflow.
+    //
+    size_t const    huge[] = { sprvec->max_size() + 1, size_t(-1) / 2 };
+
+    for (size_t n : huge)
+    {
+        int     refused = 0;
+
+        try
+        {
+            sprvec->resize(n);
+        }
+        catch (length_error const&)
+        {
+            ++refused;
+        }
+        try
+        {
+            sprvec->resize(n, -1);
+        }
+        catch (length_error const&)
+        {
+            ++refused;
+        }
+        errors += (refused != 2  ||  sprvec->size() != static_cast<size_t>(count)) ? 1 : 0;
+    }
+
+    cout << "rhx_vector size " << sprvec->size() << ", rhx_string size " << sprstr->size()
+         << ", errors after relocation: " << errors << endl;
+}
+
+void test13()
+{
+    using demo_map = test_btree_map<int, test_rhx_string<char>>;
+
+    int const   count = 10000;
+
+    auto    spmap = test_roots::find_or_construct<demo_map>("test13.map");
+    auto    spvec = allocate<test_rhx_vector<int>, test_strategy>();
+    char    str[256];
+
+    //- Overwrite every value a few times; the replaced strings become garbage.
+    //
+    for (int pass = 0;  pass < 4;  ++pass)
+    {
+        for (int i = 0;  i < count;  ++i)
+        {
+            sprintf(str, "this is very long test string of collectable nonsense #%d.%d", i, pass);
+            (*spmap)[i] = str;
+        }
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        spvec->push_back(i);
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST COLLECT  ****" << endl;
+
+    //- The bookkeeping is stored before the collection too, as an image or journal capture
+    //  would, so that storing it again afterwards copies only what the sweep changed.
+    //
+    segmented_private_storage_model::store_state();
+
+    auto    gcstats = test_collector::collect(spvec);
+
+    cout << "live blocks: " << gcstats.blocks_live << ", live bytes: " << gcstats.bytes_live << endl;
+    cout << "freed blocks: " << gcstats.blocks_freed << ", freed bytes: " << gcstats.bytes_freed
+         << endl;
+    cout << "mark rounds: " << gcstats.mark_rounds << ", threads: " << gcstats.threads << endl;
+
+    //- Store the strategy's bookkeeping and load it back, as saving and mapping an image would,
+    //  so that the blocks reused below, and the second collection, rely on the stored block
+    //  starts agreeing with the free blocks that the sweep coalesced.
+    //
+    auto    stats0 = test_strategy::statistics();
+
+    segmented_private_storage_model::store_state();
+    segmented_private_storage_model::reload_state();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        sprintf(str, "this is very long test string of collectable nonsense #%d.%d", i, 4);
+        (*spmap)[i] = str;
+    }
+
+    auto    stats1 = test_strategy::statistics();
+    int     errors = 0;
+
+    //- Strings longer than the ones freed are carved from the coalesced free blocks, and must
+    //  survive a second collection whole, and the small blocks allocated after it.
+    //
+    auto    long_str = [&str](int i)
+                       {
+                           sprintf(str, "%s #%d, %s", "a string that spans several of the blocks",
+                                   i, "which the first collection freed and coalesced");
+                           return str;
+                       };
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[count + i] = long_str(i);
+    }
+
+    test_collector::collect(spvec);
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        spvec->push_back(i);
+        sprintf(str, "short #%d", i);
+        (*spmap)[2 * count + i] = str;
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        sprintf(str, "this is very long test string of collectable nonsense #%d.%d", i, 4);
+        errors += ((*spmap)[i] != str  ||  (*spvec)[i] != i) ? 1 : 0;
+        errors += ((*spmap)[count + i] != long_str(i)) ? 1 : 0;
+        sprintf(str, "short #%d", i);
+        errors += ((*spmap)[2 * count + i] != str) ? 1 : 0;
+    }
+
+    cout << "allocations after collection: " << (stats1.allocations - stats0.allocations)
+         << ", reused: " << (stats1.reused_allocations - stats0.reused_allocations)
+         << ", errors: " << errors << endl;
+}
+
+//- Returns the address that an object at p in the live heap has in an imported copy of it.
+//
+template<class T>
+T* imported_address(T* p, size_t new_first)
+{
+    using sm = segmented_private_storage_model;
+
+    uint8_t*    pbyte = reinterpret_cast<uint8_t*>(p);
+
+    for (size_t s = sm::first_segment();  s < new_first;  ++s)
+    {
+        uint8_t*    pseg = sm::segment_address(s);
+
+        if (pseg <= pbyte  &&  pbyte < pseg + sm::segment_size(s))
+        {
+            uint8_t*    pnew = sm::segment_address(new_first + (s - sm::first_segment()));
+            return reinterpret_cast<T*>(pnew + (pbyte - pseg));
+        }
+    }
+    return nullptr;
+}
+
+void test14()
+{
+    using sm       = segmented_private_storage_model;
+    using demo_map = test_btree_map<int, test_rhx_string<char>>;
+
+    //- Capture an image of the heap's segments, as if it had been persisted, and then load it
+    //  twice alongside the live heap.
+    //
+    vector<vector<uint8_t>>     image;
+    vector<uint8_t const*>      images;
+    vector<size_t>              sizes;
+
+    for (size_t s = sm::first_segment();  sm::segment_address(s) != nullptr;  ++s)
+    {
+        image.emplace_back(sm::segment_address(s), sm::segment_address(s) + sm::segment_size(s));
+    }
+    for (auto const& seg : image)
+    {
+        images.push_back(seg.data());
+        sizes.push_back(seg.size());
+    }
+
+    size_t  count  = images.size();
+    auto    start  = chrono::high_resolution_clock::now();
+    size_t  shard1 = sm::import_segments(images.data(), sizes.data(), count, sm::first_segment());
+    size_t  shard2 = sm::import_segments(images.data(), sizes.data(), count, sm::first_segment());
+    auto    finish = chrono::high_resolution_clock::now();
+
+    auto        spmap = test_roots::find<demo_map>("test13.map");
+    demo_map*   pmap1 = imported_address(&(*spmap), shard1);
+    demo_map*   pmap2 = imported_address(&(*spmap), shard2);
+
+    (*pmap1)[0] = "changed in the first shard only";
+
+    int     errors = 0;
+
+    for (auto const& e : *spmap)
+    {
+        errors += (e.first != 0  &&  (*pmap1)[e.first] != e.second) ? 1 : 0;
+        errors += ((*pmap2)[e.first] != e.second) ? 1 : 0;
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "*****  TEST IMPORT  ****" << endl;
+    cout << "shards imported at segments " << shard1 << " and " << shard2 << " in "
+         << chrono::duration_cast<chrono::microseconds>(finish - start).count() << " usec" << endl;
+    cout << "original map address is: " << &(*spmap) << endl;
+    cout << "imported map addresses are: " << pmap1 << ", " << pmap2 << endl;
+    cout << "map sizes " << spmap->size() << ", " << pmap1->size() << ", " << pmap2->size()
+         << ", errors after import: " << errors << endl;
+
+    //- Give the segment slots back for the tests that follow.
+    //
+    for (size_t i = 0;  i < count;  ++i)
+    {
+        sm::deallocate_segment(shard1 + i);
+        sm::deallocate_segment(shard2 + i);
+    }
+}
+
+template<class P>
+long long run_translation_workload(char const* name, vector<P> const& ptrs, int passes)
+{
+    long long   sum   = 0;
+    auto        start = chrono::high_resolution_clock::now();
+
+    for (int pass = 0;  pass < passes;  ++pass)
+    {
+        for (auto const& p : ptrs)
+        {
+            sum += *p;
+        }
+    }
+
+    auto    finish = chrono::high_resolution_clock::now();
+    auto    nsec   = chrono::duration_cast<chrono::nanoseconds>(finish - start).count();
+
+    cout << name << ": " << static_cast<double>(nsec) / (double(passes) * ptrs.size())
+         << " nsec per dereference" << endl;
+
+    return sum;
+}
+
+template<class P>
+long long
+run_batch_translation_workload(char const* name, vector<P> const& ptrs, int passes, bool prefetch)
+{
+    int const   batch = 64;
+
+    long long   sum   = 0;
+    int*        raw[batch];
+    auto        start = chrono::high_resolution_clock::now();
+
+    for (int pass = 0;  pass < passes;  ++pass)
+    {
+        for (size_t i = 0;  i < ptrs.size();  i += batch)
+        {
+            size_t  n = min<size_t>(batch, ptrs.size() - i);
+
+            P::translate(ptrs.data() + i, raw, n, prefetch);
+
+            for (size_t j = 0;  j < n;  ++j)
+            {
+                sum += *raw[j];
+            }
+        }
+    }
+
+    auto    finish = chrono::high_resolution_clock::now();
+    auto    nsec   = chrono::duration_cast<chrono::nanoseconds>(finish - start).count();
+
+    cout << name << ": " << static_cast<double>(nsec) / (double(passes) * ptrs.size())
+         << " nsec per dereference" << endl;
+
+    return sum;
+}
+
+void test15()
+{
+    int const   count  = 100000;
+    int const   passes = 50;
+
+    auto    spvec = allocate<test_rhx_vector<int>, test_strategy>();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        spvec->push_back(i);
+    }
+
+    vector<int*>                    raw_ptrs;
+    vector<test_pointer<int>>       plain_ptrs;
+    vector<test_cached_pointer<int>> cached_ptrs;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        raw_ptrs.push_back(&(*spvec)[i]);
+        plain_ptrs.push_back(&(*spvec)[i]);
+        cached_ptrs.push_back(&(*spvec)[i]);
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "**  TEST TRANSLATION  **" << endl;
+
+    long long   raw_sum    = run_translation_workload("raw pointer          ", raw_ptrs, passes);
+    long long   plain_sum  = run_translation_workload("synthetic pointer    ", plain_ptrs, passes);
+    long long   cached_sum = run_translation_workload("cached synthetic ptr ", cached_ptrs, passes);
+    long long   batch_sum  = run_batch_translation_workload("batch translation    ", plain_ptrs,
+                                                            passes, false);
+
+    //- Visit the same elements in scattered order, where prefetching matters more.
+    //
+    vector<int*>                scattered_raw;
+    vector<test_pointer<int>>   scattered_ptrs;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        int     j = static_cast<int>((i * 40503LL) % count);
+
+        scattered_raw.push_back(raw_ptrs[j]);
+        scattered_ptrs.push_back(plain_ptrs[j]);
+    }
+
+    run_translation_workload("scattered raw pointer", scattered_raw, passes);
+    run_translation_workload("scattered synthetic  ", scattered_ptrs, passes);
+    run_batch_translation_workload("scattered batch      ", scattered_ptrs, passes, false);
+    run_batch_translation_workload("scattered prefetched ", scattered_ptrs, passes, true);
+
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+
+    (*spvec)[0] = count;
+
+    long long   moved_sum = run_translation_workload("cached after relocate", cached_ptrs, 1);
+
+    bool    mismatch = (raw_sum != plain_sum  ||  raw_sum != cached_sum  ||  raw_sum != batch_sum);
+
+    cout << "errors: " << (mismatch ? 1 : 0)
+         << ", errors after relocation: " << ((moved_sum != raw_sum / passes + count) ? 1 : 0)
+         << endl;
+}
+
+//- Times copying, appending, and inserting blocks of ints, which a vector can do with memcpy
+//  and memmove when it recognizes its storage as contiguous.
+//
+template<class V>
+void run_bulk_workload(char const* name, vector<int> const& src, int passes)
+{
+    int const   block = 1000;
+
+    chrono::nanoseconds     t_append(0), t_copy(0), t_insert(0);
+    size_t                  errors = 0;
+
+    for (int pass = 0;  pass < passes;  ++pass)
+    {
+        {
+            auto    t0 = chrono::high_resolution_clock::now();
+            V       vec;
+
+            vec.insert(vec.end(), src.data(), src.data() + src.size());
+
+            auto    t1 = chrono::high_resolution_clock::now();
+            V       dup(vec);
+            auto    t2 = chrono::high_resolution_clock::now();
+
+            for (int i = 0;  i < 20;  ++i)
+            {
+                dup.insert(dup.begin(), src.data(), src.data() + block);
+            }
+
+            auto    t3 = chrono::high_resolution_clock::now();
+
+            t_append += t1 - t0;
+            t_copy   += t2 - t1;
+            t_insert += t3 - t2;
+            errors   += (dup.size() != src.size() + 20 * block) ? 1 : 0;
+            errors   += (dup[20 * block] != src[0]) ? 1 : 0;
+        }
+
+        //- The vectors above are garbage now; reclaim them so that the heap does not fill up.
+        //
+        test_collector::collect();
+    }
+
+    auto    usec = [passes](chrono::nanoseconds t) { return t.count() / (1000.0 * passes); };
+
+    cout << name << ": append " << usec(t_append) << " usec, copy " << usec(t_copy)
+         << " usec, insert " << usec(t_insert) << " usec, errors " << errors << endl;
+}
+
+void test16()
+{
+    int const   count  = 50000;
+    int const   passes = 10;
+
+    vector<int>     src;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        src.push_back(scatter(i));
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "*****  TEST BULK  ******" << endl;
+
+    run_bulk_workload<vector<int>>("std vector     ", src, passes);
+    run_bulk_workload<test_vector<int>>("vector         ", src, passes);
+    run_bulk_workload<test_rhx_vector<int>>("rhx_vector     ", src, passes);
+}
+
+void test17()
+{
+    int const   count  = 100000;
+    int const   passes = 50;
+
+    auto    spvec = allocate<fixed_rhx_vector<int>, fixed_strategy>();
+    auto    spmap = allocate<fixed_btree_map<int, int>, fixed_strategy>();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        spvec->push_back(i);
+        (*spmap)[scatter(i)] = i;
+    }
+
+    vector<int*>                raw_ptrs;
+    vector<fixed_pointer<int>>  fixed_ptrs;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        int     j = static_cast<int>((i * 40503LL) % count);
+
+        raw_ptrs.push_back(&(*spvec)[j]);
+        fixed_ptrs.push_back(&(*spvec)[j]);
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "*****  TEST FIXED  *****" << endl;
+    cout << "fixed mode: " << fixed_private_storage_model::is_fixed() << endl;
+
+    long long   raw_sum   = run_translation_workload("raw pointer          ", raw_ptrs, passes);
+    long long   fixed_sum = run_translation_workload("fixed synthetic ptr  ", fixed_ptrs, passes);
+    long long   batch_sum = run_batch_translation_workload("fixed batch          ", fixed_ptrs,
+                                                           passes, false);
+
+    //- After swapping, the segments are no longer in their slots, and the same pointers must be
+    //  translated through the segment table.
+    //
+    cout << "******  SWAPPING  ******" << endl;
+    fixed_strategy::swap_buffers();
+    cout << "fixed mode: " << fixed_private_storage_model::is_fixed() << endl;
+
+    long long   moved_sum = run_translation_workload("translated synthetic ", fixed_ptrs, passes);
+    int         errors    = 0;
+
+    //- The stored pointers still hold fixed-range values, which the collector must decode
+    //  rather than take for addresses; new entries would overwrite anything it wrongly freed.
+    //
+    auto    gcstats = fixed_collector::collect(spvec, spmap);
+
+    for (int i = 0;  i < count / 10;  ++i)
+    {
+        (*spmap)[-2 - i] = -2 - i;
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        errors += ((*spvec)[i] != i  ||  (*spmap)[scatter(i)] != i) ? 1 : 0;
+    }
+    for (int i = 0;  i < count / 10;  ++i)
+    {
+        errors += (spmap->erase(-2 - i) != 1) ? 1 : 0;
+    }
+    errors += (gcstats.blocks_live < 2) ? 1 : 0;
+
+    spmap->erase(scatter(0));
+    (*spmap)[-1] = -1;
+
+    cout << "******  SWAPPING  ******" << endl;
+    fixed_strategy::swap_buffers();
+    cout << "fixed mode: " << fixed_private_storage_model::is_fixed() << endl;
+
+    errors += (spmap->find(scatter(0)) != spmap->end()  ||  (*spmap)[-1] != -1) ? 1 : 0;
+    errors += (spmap->size() != static_cast<size_t>(count)) ? 1 : 0;
+
+    bool    mismatch = (raw_sum != fixed_sum  ||  raw_sum != batch_sum  ||  raw_sum != moved_sum);
+
+    cout << "errors: " << (mismatch ? 1 : 0) << ", errors after relocation: " << errors << endl;
+
+    //- An image of the heap reloads into the same slots, where the stored addresses are valid
+    //  as they stand; the segmented model must refuse it rather than misread those addresses.
+    //
+    cout << "******  RELOADING  *****" << endl;
+    fixed_private_storage_model::save_image("test17.heap");
+    fixed_private_storage_model::clear_segments();
+    fixed_private_storage_model::map_image("test17.heap");
+
+    int     reload_errors = 0;
+    bool    refused       = false;
+
+    for (int i = 1;  i < count;  ++i)
+    {
+        reload_errors += ((*spvec)[i] != i  ||  (*spmap)[scatter(i)] != i) ? 1 : 0;
+    }
+    try
+    {
+        segmented_private_storage_model::map_image("test17.heap");
+    }
+    catch (std::runtime_error const&)
+    {
+        refused = true;
+    }
+    std::remove("test17.heap");
+
+    cout << "fixed mode: " << fixed_private_storage_model::is_fixed()
+         << ", errors after reload: " << reload_errors
+         << ", refused by segmented model: " << refused << endl;
+}
+
+void test18()
+{
+    using sm       = segmented_private_storage_model;
+    using demo_map = test_btree_map<int, int>;
+
+    int const       count = 50000;
+    char const*     path  = "test18.img";
+
+    auto    spmap = test_roots::find_or_construct<demo_map>("test18.map");
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[scatter(i)] = i;
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST MAP IMAGE  **" << endl;
+
+    sm::save_image(path);
+
+    //- For comparison, the cost of reading the whole image before serving anything.
+    //
+    vector<char>    buf(1u << 20);
+    size_t          nread = 0;
+
+    auto    t0 = chrono::high_resolution_clock::now();
+    FILE*   fp = fopen(path, "rb");
+
+    while (fp != nullptr  &&  !feof(fp))
+    {
+        nread += fread(buf.data(), 1, buf.size(), fp);
+    }
+    if (fp != nullptr)
+    {
+        fclose(fp);
+    }
+
+    //- Drop the heap and restore it from the image; only the first segment, which holds the
+    //  root directory, is hinted as hot, and only it is verified before it is first used.
+    //
+    sm::clear_segments();
+
+    size_t const    hot = sm::first_segment();
+
+    auto    t1 = chrono::high_resolution_clock::now();
+    sm::map_image(path, &hot, 1, false);
+    auto    t2 = chrono::high_resolution_clock::now();
+
+    sm::verify_segments(&hot, 1);
+
+    auto    spfound = test_roots::find<demo_map>("test18.map");
+    int     first   = (spfound != nullptr) ? spfound->find(scatter(12345))->second : -1;
+    auto    t3      = chrono::high_resolution_clock::now();
+
+    int     errors = (first != 12345) ? 1 : 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        errors += ((*spfound)[scatter(i)] != i) ? 1 : 0;
+    }
+    (*spfound)[-1] = -1;
+    errors += (spfound->size() != static_cast<size_t>(count) + 1) ? 1 : 0;
+
+    auto    usec = [](chrono::nanoseconds t) { return t.count() / 1000; };
+
+    cout << "image of " << nread << " bytes read in " << usec(t1 - t0) << " usec" << endl;
+    cout << "image mapped in " << usec(t2 - t1) << " usec, first query after "
+         << usec(t3 - t1) << " usec" << endl;
+    cout << "errors after restore: " << errors << endl;
+
+#if defined(__unix__) || defined(__APPLE__)
+    //- A process that starts out knowing nothing of the heap maps the image and allocates from
+    //  it; the bookkeeping that came with the image keeps new blocks clear of the old ones.  It
+    //  must also refuse to allocate from segments that hold no bookkeeping.
+    //
+    pid_t   pid = fork();
+
+    if (pid == 0)
+    {
+        int     child_errors = 0;
+
+        sm::clear_segments();
+        sm::allocate_segment(sm::first_segment());
+
+        try
+        {
+            test_strategy::root_area();
+            ++child_errors;
+        }
+        catch (std::logic_error const&)
+        {}
+
+        sm::clear_segments();
+        sm::map_image(path);
+
+        auto    spchild = test_roots::find<demo_map>("test18.map");
+
+        if (spchild == nullptr)
+        {
+            _exit(1);
+        }
+        for (int i = 0;  i < count;  ++i)
+        {
+            (*spchild)[-2 - i] = -2 - i;
+        }
+        for (int i = 0;  i < count;  ++i)
+        {
+            child_errors += ((*spchild)[scatter(i)] != i  ||  (*spchild)[-2 - i] != -2 - i);
+        }
+        child_errors += (spchild->size() != 2 * static_cast<size_t>(count)) ? 1 : 0;
+
+        _exit(child_errors != 0 ? 1 : 0);
+    }
+
+    int     status = 0;
+
+    waitpid(pid, &status, 0);
+
+    cout << "errors after allocating in another process: "
+         << ((pid > 0  &&  WIFEXITED(status)  &&  WEXITSTATUS(status) == 0) ? 0 : 1) << endl;
+#endif
+
+    remove(path);
+}
+
+void test19()
+{
+    using sm       = segmented_private_storage_model;
+    using demo_map = test_btree_map<int, int>;
+
+    int const       count = 50000;
+    char const*     path  = "test19.img";
+
+    auto    spmap = test_roots::find_or_construct<demo_map>("test19.map");
+    auto    mbps  = [](sm::checksum_stats const& s) { return s.bytes_hashed / s.seconds / 1e6; };
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[scatter(i)] = i;
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST CHECKSUM  ***" << endl;
+
+    //- Save the heap, reload it with full verification, change a few entries, and save it
+    //  again; the second save hashes only the pages written since the reload.
+    //
+    auto    save1 = sm::save_image(path);
+
+    cout << "saved: hashed " << save1.bytes_hashed << " bytes, reused " << save1.pages_reused
+         << " page checksums" << endl;
+
+    sm::clear_segments();
+
+    auto    load1 = sm::map_image(path);
+
+    cout << "verified: " << load1.bytes_hashed << " bytes with " << load1.threads
+         << " threads at " << mbps(load1) << " MB/s, bad pages " << load1.bad_pages << endl;
+
+    for (int i = 0;  i < 10;  ++i)
+    {
+        (*spmap)[scatter(i)] = -i;
+    }
+
+    auto    save2 = sm::save_image(path);
+
+    cout << "saved again: hashed " << save2.bytes_hashed << " bytes, reused " << save2.pages_reused
+         << " page checksums" << endl;
+
+    //- Damage one byte of the image on disk, which must be caught on load.
+    //
+    FILE*   fp = fopen(path, "r+b");
+    long    at = 0;
+    int     ch = 0;
+
+    if (fp != nullptr)
+    {
+        fseek(fp, 0, SEEK_END);
+        at = ftell(fp) / 2;
+        fseek(fp, at, SEEK_SET);
+        ch = fgetc(fp);
+        fseek(fp, at, SEEK_SET);
+        fputc(ch ^ 0x10, fp);
+        fclose(fp);
+    }
+
+    sm::clear_segments();
+
+    bool    caught = false;
+
+    try
+    {
+        sm::map_image(path);
+    }
+    catch (runtime_error const& ex)
+    {
+        cout << "corrupt image rejected: " << ex.what() << endl;
+        caught = true;
+    }
+
+    //- Repair it and load it for good.
+    //
+    fp = fopen(path, "r+b");
+
+    if (fp != nullptr)
+    {
+        fseek(fp, at, SEEK_SET);
+        fputc(ch, fp);
+        fclose(fp);
+    }
+
+    auto    load2  = sm::map_image(path);
+    int     errors = (caught  &&  load2.bad_pages == 0) ? 0 : 1;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        errors += ((*spmap)[scatter(i)] != ((i < 10) ? -i : i)) ? 1 : 0;
+    }
+
+    cout << "errors after reload: " << errors << endl;
+
+    remove(path);
+}
+
+void test20()
+{
+    using sm       = segmented_private_storage_model;
+    using demo_map = test_btree_map<int, int>;
+
+    int const       count        = 50000;
+    int const       batches      = 200;
+    int const       batch_size   = 20;
+    int const       threads      = 4;
+    char const*     image_path   = "test20.img";
+    char const*     journal_path = "test20.jnl";
+
+    auto            spmap = test_roots::find_or_construct<demo_map>("test20.map");
+    vector<int>     expected(count);
+    test_journal    journal;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[scatter(i)] = expected[i] = i;
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST JOURNAL  ****" << endl;
+
+    sm::save_image(image_path);
+    journal.open(journal_path);
+
+    //- Commit small batches of updates one at a time.
+    //
+    auto    start = chrono::high_resolution_clock::now();
+
+    for (int b = 0;  b < batches;  ++b)
+    {
+        for (int j = 0;  j < batch_size;  ++j)
+        {
+            int     i = (b * 7919 + j * 104729) % count;
+
+            expected[i] = b * batch_size + j;
+            (*spmap)[scatter(i)] = expected[i];
+        }
+        journal.commit();
+    }
+
+    auto    finish = chrono::high_resolution_clock::now();
+    auto    stats1 = journal.statistics();
+
+    cout << "commits: " << stats1.commits << ", bytes per commit: "
+         << stats1.bytes_written / stats1.commits << ", usec per commit: "
+         << chrono::duration_cast<chrono::microseconds>(finish - start).count() / batches << endl;
+
+    //- Several threads commit concurrently; each applies its update and writes its block under
+    //  a common lock, and then waits for durability outside it, so that syncs are shared.
+    //
+    mutex           update_lock;
+    vector<thread>  workers;
+
+    for (int t = 0;  t < threads;  ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            for (int b = 0;  b < batches;  ++b)
+            {
+                uint64_t    sequence;
+                {
+                    lock_guard<mutex>   lock(update_lock);
+                    int                 i = (t * batches + b) % count;
+
+                    expected[i] = -(t * batches + b);
+                    (*spmap)[scatter(i)] = expected[i];
+                    sequence = journal.write();
+                }
+                journal.sync(sequence);
+            }
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+
+    auto    stats2 = journal.statistics();
+
+    cout << "concurrent commits: " << (stats2.commits - stats1.commits) << ", syncs: "
+         << (stats2.syncs - stats1.syncs) << endl;
+
+    //- Simulate a crash: lose the heap, and leave a torn block at the end of the journal.  Then
+    //  recover from the snapshot and the journal.
+    //
+    journal.close();
+    sm::clear_segments();
+
+    FILE*   fp = fopen(journal_path, "ab");
+
+    if (fp != nullptr)
+    {
+        fwrite("JBLK torn", 1, 9, fp);
+        fclose(fp);
+    }
+
+    start = chrono::high_resolution_clock::now();
+    sm::map_image(image_path, nullptr, 0, false);
+    auto    replay = test_journal::replay(journal_path);
+    finish = chrono::high_resolution_clock::now();
+
+    int     errors = replay.torn_tail ? 0 : 1;
+
+    spmap = test_roots::find<demo_map>("test20.map");
+
+    if (!spmap)
+    {
+        cout << "map not found after recovery" << endl;
+        return;
+    }
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        errors += ((*spmap)[scatter(i)] != expected[i]) ? 1 : 0;
+    }
+
+    cout << "replayed " << replay.commits << " commits, " << replay.bytes_applied << " bytes in "
+         << chrono::duration_cast<chrono::microseconds>(finish - start).count() << " usec"
+         << endl;
+
+    //- Resume journaling, allocating new entries in the recovered heap, and fold the journal
+    //  into a new snapshot.  Then commit once more, so that the journal's numbering continues
+    //  past the checkpoint.
+    //
+    journal.open(journal_path);
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[-1 - i] = i;
+    }
+    (*spmap)[scatter(0)] = expected[0] = 1;
+    journal.checkpoint(image_path);
+
+    fp = fopen(journal_path, "rb");
+
+    long    journal_size = -1;
+
+    if (fp != nullptr)
+    {
+        fseek(fp, 0, SEEK_END);
+        journal_size = ftell(fp);
+        fclose(fp);
+    }
+
+    (*spmap)[scatter(1)] = expected[1] = 2;
+    journal.commit();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        errors += ((*spmap)[scatter(i)] != expected[i]  ||  (*spmap)[-1 - i] != i) ? 1 : 0;
+    }
+
+    //- Recover again from the new snapshot and the journal continuing after it.  Then repeat
+    //  the journal's only block, as a damaged copy might, and check that replay rejects it.
+    //
+    journal.close();
+    sm::clear_segments();
+    sm::map_image(image_path, nullptr, 0, false);
+    replay = test_journal::replay(journal_path);
+    spmap  = test_roots::find<demo_map>("test20.map");
+
+    errors += (replay.commits == 1  &&  spmap  &&  (*spmap)[scatter(1)] == 2) ? 0 : 1;
+
+    vector<char>    contents;
+
+    if ((fp = fopen(journal_path, "rb")) != nullptr)
+    {
+        int     ch;
+
+        while ((ch = fgetc(fp)) != EOF)
+        {
+            contents.push_back(static_cast<char>(ch));
+        }
+        fclose(fp);
+    }
+    if ((fp = fopen(journal_path, "ab")) != nullptr)
+    {
+        fwrite(contents.data() + journal_size, 1, contents.size() - journal_size, fp);
+        fclose(fp);
+    }
+
+    bool    rejected = false;
+
+    try
+    {
+        test_journal::replay(journal_path);
+    }
+    catch (runtime_error const& ex)
+    {
+        cout << "repeated block rejected: " << ex.what() << endl;
+        rejected = true;
+    }
+    errors += rejected ? 0 : 1;
+
+    cout << "journal size after checkpoint: " << journal_size << ", errors after recovery: "
+         << errors << endl;
+
+    remove(journal_path);
+    remove(image_path);
+}
+
+void test21()
+{
+    cout << endl;
+    cout << "****************************" << endl;
+    cout << "****  TEST REPLICATION  ****" << endl;
+
+#if defined(__unix__) || defined(__APPLE__)
+    using sm       = segmented_private_storage_model;
+    using demo_map = test_btree_map<int, int>;
+
+    struct follower_report
+    {
+        int64_t     sum;
+        uint64_t    sequence;
+        uint64_t    reads;
+        bool        found;
+    };
+
+    int const   count      = 50000;
+    int const   rounds     = 100;
+    int const   round_size = 20;
+    int         fds[2];
+
+    auto    spmap = test_roots::find_or_construct<demo_map>("test21.map");
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[scatter(i)] = i;
+    }
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        cout << "unable to create socket pair" << endl;
+        return;
+    }
+
+    pid_t   pid = fork();
+
+    if (pid == 0)
+    {
+        //- The follower starts with an empty heap, and reads it between batches of updates.
+        //
+        close(fds[0]);
+        sm::clear_segments();
+
+        test_follower       follower(fds[1]);
+        follower_report     report = {};
+
+        while (!follower.at_end())
+        {
+            follower.receive(true);
+
+            if (follower.sequence() != 0)
+            {
+                auto    spfollower = test_roots::find<demo_map>("test21.map");
+
+                report.reads += (spfollower != nullptr  &&
+                                 spfollower->find(scatter(0)) != spfollower->end());
+            }
+        }
+
+        auto    spfollower = test_roots::find<demo_map>("test21.map");
+
+        for (int i = 0;  spfollower != nullptr  &&  i < count;  ++i)
+        {
+            report.sum += (*spfollower)[scatter(i)];
+        }
+        report.found    = (spfollower != nullptr);
+        report.sequence = follower.sequence();
+
+        segmented_file_io::write_all(fds[1], &report, sizeof(report));
+        _exit(0);
+    }
+
+    close(fds[1]);
+
+    test_leader     leader(fds[0]);
+    int64_t         sum = 0;
+
+    leader.publish();
+
+    auto    initial = leader.statistics();
+    auto    start   = chrono::high_resolution_clock::now();
+
+    for (int r = 0;  r < rounds;  ++r)
+    {
+        for (int j = 0;  j < round_size;  ++j)
+        {
+            (*spmap)[scatter((r * 7919 + j * 104729) % count)] = -(r * round_size + j) - count;
+        }
+        leader.publish();
+    }
+
+    auto    finish = chrono::high_resolution_clock::now();
+    auto    stats  = leader.statistics();
+
+    shutdown(fds[0], SHUT_WR);
+
+    follower_report     report = {};
+    bool                got    = segmented_file_io::read_all(fds[0], &report, sizeof(report));
+
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        sum += (*spmap)[scatter(i)];
+    }
+
+    cout << "initial block: " << initial.bytes_sent << " bytes, bytes per update round: "
+         << (stats.bytes_sent - initial.bytes_sent) / rounds << ", usec per round: "
+         << chrono::duration_cast<chrono::microseconds>(finish - start).count() / rounds << endl;
+    cout << "follower reads while catching up: " << report.reads << ", errors: "
+         << ((got  &&  report.found  &&  report.sum == sum  &&
+              report.sequence == leader.sequence()) ? 0 : 1) << endl;
+
+    //- A stream that fails to read is an error, not the leader closing it; the write end of a
+    //  pipe whose reader has gone polls as ready, but cannot be read.
+    //
+    int     pfds[2];
+    bool    reported = false;
+
+    if (pipe(pfds) == 0)
+    {
+        close(pfds[0]);
+
+        try
+        {
+            test_follower   broken(pfds[1]);
+
+            broken.receive(false);
+        }
+        catch (std::runtime_error const&)
+        {
+            reported = true;
+        }
+        close(pfds[1]);
+    }
+    cout << "read error reported: " << reported << ", errors: " << (reported ? 0 : 1) << endl;
+#else
+    cout << "replication demo requires fork() and socketpair()" << endl;
+#endif
+}
+
+void test22()
+{
+    using demo_map = test_btree_map<int, int>;
+
+    int const   count      = 50000;
+    int const   batch_size = 20000;
+
+    auto        spmap = test_roots::find_or_construct<demo_map>("test22.map");
+    int64_t     sum   = 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        (*spmap)[scatter(i)] = i;
+        sum += i;
+    }
+
+    size_t      size = spmap->size();
+    size_t      used = test_strategy::statistics().bytes_allocated;
+
+    cout << endl;
+    cout << "*****************************" << endl;
+    cout << "****  TEST TRANSACTIONS  ****" << endl;
+
+    //- An import that updates existing entries, adds new ones, and then fails part way.
+    //
+    auto        start    = chrono::high_resolution_clock::now();
+    auto        finish   = start;
+    size_t      restored = 0;
+    double      begin_ms = 0;
+
+    try
+    {
+        test_transaction    txn;
+
+        begin_ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now()
+                                                   - start).count();
+
+        for (int i = 0;  i < batch_size;  ++i)
+        {
+            (*spmap)[scatter(i)] += 1;
+            (*spmap)[-2 - i]      = i;
+        }
+        throw runtime_error("import failed");
+    }
+    catch (runtime_error const&)
+    {}
+
+    //- The same import, rolled back explicitly in order to time the rollback.
+    //
+    {
+        test_transaction    txn;
+
+        for (int i = 0;  i < batch_size;  ++i)
+        {
+            (*spmap)[scatter(i)] += 1;
+            (*spmap)[-2 - i]      = i;
+        }
+        start    = chrono::high_resolution_clock::now();
+        restored = txn.rollback();
+        finish   = chrono::high_resolution_clock::now();
+    }
+
+    int64_t     after = 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        after += (*spmap)[scatter(i)];
+    }
+
+    int     errors = (after != sum) + (spmap->size() != size) +
+                     (test_strategy::statistics().bytes_allocated != used);
+
+    //- A committed transaction keeps its changes.
+    //
+    {
+        test_transaction    txn;
+
+        (*spmap)[-2] = 1;
+        txn.commit();
+    }
+    errors += (spmap->size() != size + 1);
+    spmap->erase(-2);
+
+    //- A capture taken inside a transaction records its writes, so the next capture after a
+    //  rollback must record them undone, even on a page that the rollback returned to the image
+    //  file; otherwise a journal or replica would keep the rolled-back bytes.
+    //
+    using sm = segmented_private_storage_model;
+
+    segmented_change_tracker<sm>    tracker;
+    vector<bool>                    clean;
+    uint8_t*                        pclean = nullptr;
+
+    for (size_t s = sm::first_segment();  pclean == nullptr  &&  s <= sm::max_segment_count();
+         ++s)
+    {
+        if (sm::segment_address(s) != nullptr  &&  sm::find_clean_pages(s, clean))
+        {
+            auto    it = find(clean.begin(), clean.end(), true);
+
+            if (it != clean.end())
+            {
+                pclean = sm::segment_address(s) + (it - clean.begin()) * sm::page_size;
+            }
+        }
+    }
+    if (pclean != nullptr)
+    {
+        uint8_t const   saved = *pclean;
+
+        tracker.reset(true);
+        {
+            test_transaction    txn;
+
+            *pclean = static_cast<uint8_t>(~saved);
+            tracker.capture(1);
+            txn.rollback();
+        }
+        errors += (*pclean != saved  ||  tracker.capture(2) == 0);
+    }
+
+    cout << "begin: " << begin_ms << " ms, rollback: "
+         << chrono::duration<double, milli>(finish - start).count() << " ms, pages restored: "
+         << restored << ", errors: " << errors << endl;
+}
+
+//- A message passed between threads (or processes sharing the heap) by synthetic pointer.
+//
+struct ipc_message
+{
+    uint64_t                m_stamp;        //- Nanoseconds, when it was sent
+    uint64_t                m_sequence;
+    test_rhx_vector<int>    m_data;
+};
+
+inline uint64_t
+steady_nanoseconds()
+{
+    auto    since = chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(since).count());
+}
+
+void
+report_ipc(char const* name, int messages, chrono::duration<double> elapsed, uint64_t latency,
+           int64_t sum, int64_t expected)
+{
+    cout << name << ": " << static_cast<uint64_t>(messages / elapsed.count()) << " msgs/s, "
+         << "mean latency " << (latency / messages) / 1000.0 << " usec, errors: "
+         << (sum != expected) << endl;
+}
+
+void test23()
+{
+    using message_ptr = test_pointer<ipc_message>;
+    using spsc_queue  = rhx_spsc_queue<message_ptr, test_allocator<message_ptr>>;
+    using mpmc_queue  = rhx_mpmc_queue<message_ptr, test_allocator<message_ptr>>;
+    using clock       = chrono::high_resolution_clock;
+
+    int const   messages  = 200000;
+    int const   msg_size  = 16;
+    int const   threads   = 2;          //- Producers, and consumers, in the MPMC run
+    int64_t     expected  = 0;
+
+    for (int i = 0;  i < messages;  ++i)
+    {
+        expected += int64_t(i) * msg_size * msg_size + (msg_size * (msg_size - 1)) / 2;
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST IPC RINGS ****" << endl;
+
+    //- Start from a heap without garbage, so that the collection at the end finds only the
+    //  consumed messages.
+    //
+    test_collector::collect();
+
+    //- Consumed messages are returned to the producers through a second queue and reused, so
+    //  that the queues carry the only traffic between the two sides.  New messages are built
+    //  only while none are free; the leaky strategy is not thread-safe, so that is serialized.
+    //
+    mutex   heap_lock;
+
+    auto    make = [&](auto& free_queue, uint64_t sequence) -> message_ptr
+    {
+        message_ptr     pm;
+
+        if (!free_queue.try_pop(pm))
+        {
+            lock_guard<mutex>   lock(heap_lock);
+
+            pm = allocate<ipc_message, test_strategy>();
+            pm->m_data.reserve(msg_size);
+        }
+
+        pm->m_sequence = sequence;
+        pm->m_data.clear();
+
+        for (int j = 0;  j < msg_size;  ++j)
+        {
+            pm->m_data.push_back(static_cast<int>(sequence) * msg_size + j);
+        }
+        pm->m_stamp = steady_nanoseconds();
+        return pm;
+    };
+
+    auto    consume = [&](auto& free_queue, message_ptr pm, int64_t& sum, uint64_t& latency)
+    {
+        latency += steady_nanoseconds() - pm->m_stamp;
+
+        for (int v : pm->m_data)
+        {
+            sum += v;
+        }
+        while (!free_queue.try_push(pm))
+        {
+            this_thread::yield();
+        }
+    };
+
+    //- Finally, the free messages are released through the allocator; for the leaky strategy,
+    //  that leaves them to the collector.
+    //
+    size_t  released = 0;
+
+    auto    release = [&](auto& free_queue)
+    {
+        message_ptr     pm;
+
+        while (free_queue.try_pop(pm))
+        {
+            test_allocator<ipc_message>().destroy(static_cast<ipc_message*>(pm));
+            test_allocator<ipc_message>().deallocate(pm);
+            ++released;
+        }
+    };
+
+    //- One producer and one consumer.
+    //
+    {
+        auto        spq     = test_roots::find_or_construct<spsc_queue>("test23.spsc", 1024);
+        auto        spfree  = test_roots::find_or_construct<spsc_queue>("test23.spsc.free", 4096);
+        int64_t     sum     = 0;
+        uint64_t    latency = 0;
+        auto        start   = clock::now();
+
+        thread      consumer([&]
+        {
+            message_ptr     pm;
+
+            for (int n = 0;  n < messages;  )
+            {
+                if (spq->try_pop(pm))
+                {
+                    consume(*spfree, pm, sum, latency);
+                    ++n;
+                }
+                else
+                {
+                    this_thread::yield();
+                }
+            }
+        });
+
+        for (int i = 0;  i < messages;  ++i)
+        {
+            message_ptr     pm = make(*spfree, i);
+
+            while (!spq->try_push(pm))
+            {
+                this_thread::yield();
+            }
+        }
+        consumer.join();
+        release(*spfree);
+
+        report_ipc("SPSC ring", messages, clock::now() - start, latency, sum, expected);
+    }
+
+    //- Several producers and consumers.
+    //
+    {
+        auto            mpq      = test_roots::find_or_construct<mpmc_queue>("test23.mpmc", 1024);
+        auto            mpfree   = test_roots::find_or_construct<mpmc_queue>("test23.mpmc.free",
+                                                                             4096);
+        atomic<int>     consumed(0);
+        int64_t         sums[threads]      = {};
+        uint64_t        latencies[threads] = {};
+        vector<thread>  workers;
+        auto            start    = clock::now();
+
+        for (int t = 0;  t < threads;  ++t)
+        {
+            workers.emplace_back([&, t]
+            {
+                for (int i = t;  i < messages;  i += threads)
+                {
+                    message_ptr     pm = make(*mpfree, i);
+
+                    while (!mpq->try_push(pm))
+                    {
+                        this_thread::yield();
+                    }
+                }
+            });
+            workers.emplace_back([&, t]
+            {
+                message_ptr     pm;
+
+                while (consumed.load() < messages)
+                {
+                    if (mpq->try_pop(pm))
+                    {
+                        consume(*mpfree, pm, sums[t], latencies[t]);
+                        consumed.fetch_add(1);
+                    }
+                    else
+                    {
+                        this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& w : workers)
+        {
+            w.join();
+        }
+        release(*mpfree);
+
+        int64_t     sum     = 0;
+        uint64_t    latency = 0;
+
+        for (int t = 0;  t < threads;  ++t)
+        {
+            sum     += sums[t];
+            latency += latencies[t];
+        }
+        report_ipc("MPMC ring", messages, clock::now() - start, latency, sum, expected);
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    //- The baseline: the same messages, serialized into a pipe and rebuilt by the reader.
+    //
+    {
+        struct wire_header
+        {
+            uint64_t    m_stamp;
+            uint64_t    m_sequence;
+            uint64_t    m_count;
+        };
+
+        int         fds[2];
+        int64_t     sum     = 0;
+        uint64_t    latency = 0;
+
+        if (pipe(fds) != 0)
+        {
+            cout << "unable to create pipe" << endl;
+            return;
+        }
+
+        auto        start = clock::now();
+
+        thread      reader([&]
+        {
+            vector<uint8_t>     wire(sizeof(wire_header) + msg_size * sizeof(int));
+            wire_header         hdr;
+
+            for (int n = 0;  n < messages;  ++n)
+            {
+                if (!segmented_file_io::read_all(fds[0], wire.data(), wire.size()))
+                {
+                    break;
+                }
+                memcpy(&hdr, wire.data(), sizeof(hdr));
+
+                vector<int>     data(static_cast<size_t>(hdr.m_count));
+
+                memcpy(data.data(), wire.data() + sizeof(hdr), data.size() * sizeof(int));
+                latency += steady_nanoseconds() - hdr.m_stamp;
+
+                for (int v : data)
+                {
+                    sum += v;
+                }
+            }
+        });
+
+        vector<uint8_t>     wire(sizeof(wire_header) + msg_size * sizeof(int));
+
+        for (int i = 0;  i < messages;  ++i)
+        {
+            vector<int>     data;
+
+            for (int j = 0;  j < msg_size;  ++j)
+            {
+                data.push_back(i * msg_size + j);
+            }
+
+            wire_header     hdr = {steady_nanoseconds(), uint64_t(i), data.size()};
+
+            memcpy(wire.data(), &hdr, sizeof(hdr));
+            memcpy(wire.data() + sizeof(hdr), data.data(), data.size() * sizeof(int));
+
+            if (!segmented_file_io::write_all(fds[1], wire.data(), wire.size()))
+            {
+                break;
+            }
+        }
+        reader.join();
+        close(fds[0]);
+        close(fds[1]);
+
+        report_ipc("pipe + serialization", messages, clock::now() - start, latency, sum,
+                   expected);
+    }
+#endif
+
+    auto    gcstats = test_collector::collect();
+
+    cout << "messages built: " << released << ", bytes reclaimed by the collector: "
+         << gcstats.bytes_freed << endl;
+}
+
+void test24()
+{
+    using sm       = segmented_private_storage_model;
+    using demo_map = test_btree_map<int, int>;
+
+    int const   count   = 16 << 20;    //- A 64MB block, sixteen times the old segment size
+    int const   entries = 50000;
+
+    auto        spmap  = test_roots::find_or_construct<demo_map>("test24.map");
+    auto        pmap   = static_cast<demo_map*>(spmap);
+    uint64_t    epoch  = sm::relocation_epoch();
+    size_t      before = 0;
+    size_t      after  = 0;
+
+    cout << endl;
+    cout << "****************************" << endl;
+    cout << "****  TEST SEGMENT GROWTH ***" << endl;
+
+    for (int i = 0;  i < entries;  ++i)
+    {
+        (*spmap)[scatter(i)] = i;
+    }
+    for (size_t s = sm::first_segment();  s <= sm::max_segment_count();  ++s)
+    {
+        before += sm::segment_size(s);
+    }
+
+    //- The block does not fit in what the current segment has committed, so the segment grows
+    //  in place to hold it; nothing moves, and the map allocated earlier stays where it was.
+    //
+    auto        start  = chrono::high_resolution_clock::now();
+    int64_t     sum    = 0;
+    int         errors = 0;
+
+    {
+        test_rhx_vector<int>    big;
+
+        big.reserve(count);
+
+        for (int i = 0;  i < count;  ++i)
+        {
+            big.push_back(i);
+        }
+        for (size_t s = sm::first_segment();  s <= sm::max_segment_count();  ++s)
+        {
+            after += sm::segment_size(s);
+        }
+        for (int i = 0;  i < count;  ++i)
+        {
+            sum += big[i];
+        }
+    }
+
+    auto        finish = chrono::high_resolution_clock::now();
+
+    errors += (sum != int64_t(count) * (count - 1) / 2);
+    errors += (static_cast<demo_map*>(test_roots::find<demo_map>("test24.map")) != pmap);
+    errors += (pmap->find(scatter(12345)) == pmap->end()  ||
+               pmap->find(scatter(12345))->second != 12345);
+    errors += (sm::relocation_epoch() != epoch);
+
+    test_collector::collect();
+
+    cout << "block of " << count * sizeof(int) << " bytes built in "
+         << chrono::duration<double, milli>(finish - start).count() << " ms" << endl;
+    cout << "committed segment bytes: " << before << " before, " << after << " after, "
+         << sm::max_segment_size() << " reserved per segment" << endl;
+    cout << "relocations: " << (sm::relocation_epoch() - epoch) << ", errors: " << errors << endl;
+}
+
+void test25()
+{
+    using traits = storage_model_traits<single_segment_storage_model>;
+
+    int const   count  = 100000;
+    int const   passes = 50;
+
+    auto    spvec = allocate<single_rhx_vector<int>, single_strategy>();
+    auto    spmap = allocate<single_btree_map<int, int>, single_strategy>();
+    auto    sptst = allocate<test_rhx_vector<int>, test_strategy>();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        spvec->push_back(i);
+        sptst->push_back(i);
+        (*spmap)[scatter(i)] = i;
+    }
+
+    vector<int*>                raw_ptrs;
+    vector<test_pointer<int>>   plain_ptrs;
+    vector<single_pointer<int>> single_ptrs;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        int     j = static_cast<int>((i * 40503LL) % count);
+
+        raw_ptrs.push_back(&(*spvec)[j]);
+        plain_ptrs.push_back(&(*sptst)[j]);
+        single_ptrs.push_back(&(*spvec)[j]);
+    }
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "**  TEST ONE SEGMENT  **" << endl;
+    cout << "single segment: " << traits::single_segment << endl;
+
+    long long   raw_sum    = run_translation_workload("raw pointer          ", raw_ptrs, passes);
+    long long   plain_sum  = run_translation_workload("segmented synthetic  ", plain_ptrs, passes);
+    long long   single_sum = run_translation_workload("single-segment ptr   ", single_ptrs, passes);
+    long long   batch_sum  = run_batch_translation_workload("single-segment batch ", single_ptrs,
+                                                            passes, false);
+
+    //- Relocating the segment changes only its base address, which every translation reloads.
+    //
+    cout << "******  SWAPPING  ******" << endl;
+    single_strategy::swap_buffers();
+
+    long long   moved_sum = run_translation_workload("single after relocate", single_ptrs, 1);
+    int         errors    = 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        errors += ((*spvec)[i] != i  ||  (*spmap)[scatter(i)] != i) ? 1 : 0;
+    }
+    errors += (spmap->size() != static_cast<size_t>(count)) ? 1 : 0;
+
+    bool    mismatch = (raw_sum != plain_sum  ||  raw_sum != single_sum  ||  raw_sum != batch_sum
+                        ||  moved_sum != raw_sum / passes);
+
+    cout << "errors: " << (mismatch ? 1 : 0) << ", errors after relocation: " << errors << endl;
+}
+
+//- Allocates a name and a counter for each of count entries, the names from the given
+//  generation and the counters from the young one, then increments every counter once, as a
+//  workload would between two snapshots.  Reports how many pages were dirtied.
+//
+int run_generation_workload(char const* name, test_strategy::generation gen, int count)
+{
+    test_allocator<char>            name_alloc{test_strategy(gen)};
+    vector<test_rhx_string<char>>   names;
+    vector<int*>                    counters;
+    vector<uintptr_t>               name_pages;
+    vector<uintptr_t>               dirty_pages;
+    char                            str[64];
+
+    auto    page        = [](void const* p) { return reinterpret_cast<uintptr_t>(p) / 4096; };
+    auto    count_pages = [](vector<uintptr_t>& pages)
+                          {
+                              sort(pages.begin(), pages.end());
+                              pages.erase(unique(pages.begin(), pages.end()), pages.end());
+                              return pages.size();
+                          };
+
+    names.reserve(count);
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        sprintf(str, "reference entry #%d, written once and read often", i);
+        names.emplace_back(str, name_alloc);
+        counters.push_back(&*test_allocator<int>().allocate(4));
+        counters.back()[0] = 0;
+        name_pages.push_back(page(names.back().data()));
+        name_pages.push_back(page(names.back().data() + names.back().size()));
+    }
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        counters[i][0] += 1;
+        dirty_pages.push_back(page(counters[i]));
+    }
+
+    size_t  dirty  = count_pages(dirty_pages);
+    size_t  named  = count_pages(name_pages);
+    size_t  mixed  = 0;
+    int     errors = 0;
+
+    for (uintptr_t pg : name_pages)
+    {
+        mixed += binary_search(dirty_pages.begin(), dirty_pages.end(), pg) ? 1 : 0;
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        sprintf(str, "reference entry #%d, written once and read often", i);
+        errors += (names[i].compare(str) != 0  ||  counters[i][0] != 1) ? 1 : 0;
+    }
+
+    cout << name << ": " << dirty << " pages dirtied, " << mixed << " of " << named
+         << " pages of names among them" << endl;
+
+    return errors + ((gen == test_strategy::tenured_generation  &&  mixed != 0) ? 1 : 0);
+}
+
+void test26()
+{
+    int const   count = 20000;
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "**  TEST GENERATIONS  **" << endl;
+
+    size_t  before = test_strategy::statistics().tenured_allocations;
+    int     errors = run_generation_workload("names interleaved", test_strategy::young_generation,
+                                             count);
+    size_t  middle = test_strategy::statistics().tenured_allocations;
+
+    errors += run_generation_workload("names tenured    ", test_strategy::tenured_generation,
+                                      count);
+
+    size_t  after = test_strategy::statistics().tenured_allocations;
+
+    cout << "tenured allocations: " << (middle - before) << " interleaved, " << (after - middle)
+         << " tenured, errors: " << errors << endl;
+}
+
+//- Builds count records whose keys are drawn from distinct strings, once as per-node copies
+//  of the strings and once as handles into an intern pool, then times looking every record's
+//  key up in a flat map keyed each way.  Reports the heap bytes taken by the keys of both.
+//
+void test27()
+{
+    using test_intern_pool = rhx_basic_intern_pool<char, char_traits<char>, test_allocator<char>>;
+    using interned         = test_intern_pool::handle;
+
+    int const   count    = 200000;
+    int const   distinct = 1000;
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST INTERN  *****" << endl;
+
+    auto    sppool  = allocate<test_intern_pool, test_strategy>();
+    auto    spnodes = allocate<test_vector<test_rhx_string<char>>, test_strategy>();
+    auto    sphands = allocate<test_vector<interned>, test_strategy>();
+    auto    spsmap  = allocate<test_flat_map<test_rhx_string<char>, int>, test_strategy>();
+    auto    sphmap  = allocate<test_flat_map<interned, int>, test_strategy>();
+    char            str[64];
+    vector<string>  keys;
+
+    auto    ns = [](chrono::steady_clock::duration d)
+                 { return chrono::duration_cast<chrono::nanoseconds>(d).count(); };
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        sprintf(str, "this is test key string %d", scatter(i) % distinct);
+        keys.emplace_back(str);
+    }
+
+    spnodes->reserve(count);
+    sphands->reserve(count);
+
+    size_t  b0 = test_strategy::statistics().bytes_allocated;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        spnodes->emplace_back(keys[i].c_str());
+    }
+
+    size_t  b1 = test_strategy::statistics().bytes_allocated;
+    auto    t0 = chrono::steady_clock::now();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        sphands->push_back(sppool->intern(keys[i].c_str()));
+    }
+
+    auto    t1 = chrono::steady_clock::now();
+    size_t  b2 = test_strategy::statistics().bytes_allocated;
+
+    for (int i = 0;  i < distinct;  ++i)
+    {
+        sprintf(str, "this is test key string %d", i);
+        (*spsmap)[test_rhx_string<char>(str)] = i;
+        (*sphmap)[sppool->find(str)]          = i;
+    }
+
+    long    ssum = 0;
+    long    hsum = 0;
+    auto    t2   = chrono::steady_clock::now();
+
+    for (int pass = 0;  pass < 10;  ++pass)
+    {
+        for (auto const& k : *spnodes)
+        {
+            ssum += spsmap->find(k)->second;
+        }
+    }
+
+    auto    t3 = chrono::steady_clock::now();
+
+    for (int pass = 0;  pass < 10;  ++pass)
+    {
+        for (auto const& k : *sphands)
+        {
+            hsum += sphmap->find(k)->second;
+        }
+    }
+
+    auto    t4 = chrono::steady_clock::now();
+    auto    st = sppool->statistics();
+
+    cout << "per-node keys: " << (b1 - b0) << " bytes, " << (ns(t3 - t2) / (10 * count))
+         << " ns/find (checksum " << ssum << ")" << endl;
+    cout << "interned keys: " << (b2 - b1) << " bytes, " << (ns(t4 - t3) / (10 * count))
+         << " ns/find (checksum " << hsum << "), " << (ns(t1 - t0) / count) << " ns/intern" << endl;
+    cout << "pool: " << st.strings << " strings of " << st.requests << " requests, "
+         << st.bytes_stored << " bytes stored, " << st.bytes_saved << " bytes saved" << endl;
+
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+
+    int     errors = (ssum != hsum  ||  sppool->size() != size_t(distinct)) ? 1 : 0;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        interned const&     h = (*sphands)[i];
+        char const*         k = keys[i].c_str();
+
+        errors += (h != sppool->intern(k)  ||  h != sppool->find(k)  ||  keys[i] != h.c_str()  ||
+                   (*spnodes)[i].compare(h.c_str()) != 0) ? 1 : 0;
+    }
+    errors += (sppool->find("not a test key")  ||  sppool->size() != size_t(distinct)) ? 1 : 0;
+
+    cout << "errors after relocation: " << errors << endl;
+}
+
+//- A record that is linked into an insertion-order list, an index ordered by rank, and an
+//  index hashed by id, through hooks of its own.
+//
+struct demo_record
+:   rhx_list_hook<test_pointer<void>>
+,   rhx_tree_hook<test_pointer<void>>
+,   rhx_hash_hook<test_pointer<void>>
+{
+    int     id;
+    int     rank;
+
+    struct by_rank
+    {
+        bool    operator ()(demo_record const& a, demo_record const& b) const
+                { return a.rank < b.rank; }
+        bool    operator ()(demo_record const& a, int rank) const  { return a.rank < rank; }
+        bool    operator ()(int rank, demo_record const& b) const  { return rank < b.rank; }
+    };
+
+    struct id_hash
+    {
+        size_t  operator ()(demo_record const& r) const     { return hash<int>()(r.id); }
+        size_t  operator ()(int id) const                   { return hash<int>()(id); }
+    };
+
+    struct id_equal
+    {
+        bool    operator ()(demo_record const& a, demo_record const& b) const
+                { return a.id == b.id; }
+        bool    operator ()(demo_record const& a, int id) const     { return a.id == id; }
+    };
+
+    //- The compactor finds the links in each hook through the containers that own them.
+    //
+    template<class V>
+    void    trace(V& visitor)
+            {
+                using list_type = rhx_intrusive_list<demo_record, test_pointer<void>>;
+                using tree_type = rhx_intrusive_tree<demo_record, test_pointer<void>, by_rank>;
+                using hash_type = rhx_intrusive_hash<demo_record, test_pointer<void>, id_hash,
+                                                     id_equal, test_allocator<demo_record>>;
+
+                list_type::trace_hook(*this, visitor);
+                tree_type::trace_hook(*this, visitor);
+                hash_type::trace_hook(*this, visitor);
+            }
+};
+
+void test28()
+{
+    using record_ptr   = test_pointer<demo_record>;
+    using record_list  = rhx_intrusive_list<demo_record, test_pointer<void>>;
+    using record_tree  = rhx_intrusive_tree<demo_record, test_pointer<void>, demo_record::by_rank>;
+    using record_hash  = rhx_intrusive_hash<demo_record, test_pointer<void>, demo_record::id_hash,
+                                            demo_record::id_equal, test_allocator<demo_record>>;
+
+    int const   count = 100000;
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "***  TEST INTRUSIVE  ***" << endl;
+
+    vector<record_ptr>  records;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        records.push_back(allocate<demo_record, test_strategy>());
+        records.back()->id   = i;
+        records.back()->rank = scatter(i);
+    }
+
+    auto    sporder = allocate<test_list<record_ptr>, test_strategy>();
+    auto    spranks = allocate<test_map<int, record_ptr>, test_strategy>();
+    auto    spids   = allocate<test_umap<int, record_ptr>, test_strategy>();
+    auto    splist  = allocate<record_list, test_strategy>();
+    auto    sptree  = allocate<record_tree, test_strategy>();
+    auto    sphash  = allocate<record_hash, test_strategy>();
+
+    auto    ns      = [](chrono::steady_clock::duration d)
+                      { return chrono::duration_cast<chrono::nanoseconds>(d).count(); };
+    auto    report  = [&](char const* name, test_strategy::heap_statistics const& s0,
+                          test_strategy::heap_statistics const& s1, long long build,
+                          long long scan, long long find, long sum)
+                      {
+                          cout << name << ": " << (s1.allocations - s0.allocations)
+                               << " allocations, " << (s1.bytes_allocated - s0.bytes_allocated)
+                               << " bytes, " << (build / count) << " ns/link, "
+                               << (scan / count) << " ns/ordered step, " << (find / count)
+                               << " ns/find (checksum " << sum << ")" << endl;
+                      };
+
+    auto    s0 = test_strategy::statistics();
+    auto    t0 = chrono::steady_clock::now();
+
+    for (record_ptr const& p : records)
+    {
+        sporder->push_back(p);
+        spranks->emplace(p->rank, p);
+        spids->emplace(p->id, p);
+    }
+
+    auto    t1   = chrono::steady_clock::now();
+    auto    s1   = test_strategy::statistics();
+    long    sum1 = 0;
+
+    for (auto const& e : *spranks)
+    {
+        sum1 += e.second->id;
+    }
+
+    auto    t2 = chrono::steady_clock::now();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        sum1 += spids->find(scatter(i) % count)->second->rank & 0xFF;
+    }
+
+    auto    t3 = chrono::steady_clock::now();
+
+    report("std containers", s0, s1, ns(t1 - t0), ns(t2 - t1), ns(t3 - t2), sum1);
+
+    s0 = test_strategy::statistics();
+    t0 = chrono::steady_clock::now();
+
+    for (record_ptr const& p : records)
+    {
+        splist->push_back(*p);
+        sptree->insert(*p);
+        sphash->insert(*p);
+    }
+
+    t1 = chrono::steady_clock::now();
+    s1 = test_strategy::statistics();
+
+    long    sum2 = 0;
+
+    for (demo_record const& r : *sptree)
+    {
+        sum2 += r.id;
+    }
+
+    t2 = chrono::steady_clock::now();
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        sum2 += sphash->find(scatter(i) % count)->rank & 0xFF;
+    }
+
+    t3 = chrono::steady_clock::now();
+
+    report("intrusive     ", s0, s1, ns(t1 - t0), ns(t2 - t1), ns(t3 - t2), sum2);
+
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+
+    //- Unlink every third record from all three indexes, then check that each index still
+    //  holds exactly the others, in the right order.
+    //
+    int     errors = (sum1 != sum2) ? 1 : 0;
+
+    for (int i = 0;  i < count;  i += 3)
+    {
+        demo_record&    r = *records[i];
+
+        splist->remove(r);
+        sptree->erase(sptree->find(r.rank));
+        sphash->remove(r);
+    }
+
+    int     expect = 0;
+    int     prev   = -1;
+
+    for (demo_record const& r : *splist)
+    {
+        expect += (expect % 3 == 0) ? 1 : 0;
+        errors += (r.id != expect++) ? 1 : 0;
+    }
+    for (demo_record const& r : *sptree)
+    {
+        errors += (r.rank <= prev  ||  r.id % 3 == 0) ? 1 : 0;
+        prev    = r.rank;
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        auto    it = sphash->find(i);
+        bool    in = (i % 3 != 0);
+
+        errors += ((it != sphash->end()) != in  ||  sptree->contains(scatter(i)) != in  ||
+                   (in  &&  it->rank != scatter(i))) ? 1 : 0;
+    }
+
+    size_t  left = count - (count + 2) / 3;
+
+    errors += (splist->size() != left  ||  sptree->size() != left  ||  sphash->size() != left);
+
+    cout << "records left " << left << ", errors after relocation: " << errors << endl;
+}
+
+//- A list node whose pointers the compactor finds through its trace() member.
+//
+struct demo_chain_node
+{
+    test_pointer<demo_chain_node>   next;
+    test_rhx_vector<int>            payload;
+    int                             id;
+
+    template<class V>
+    void    trace(V& visitor)
+            {
+                visitor(next);
+                payload.trace(visitor);
+            }
+};
+
+void test29()
+{
+    using node_ptr     = test_pointer<demo_chain_node>;
+    using string_map   = test_btree_map<int, test_rhx_string<char>>;
+    using vector_map   = test_flat_map<int, test_rhx_vector<int>>;
+    using intern_pool  = rhx_basic_intern_pool<char, char_traits<char>, test_allocator<char>>;
+    using handles      = test_rhx_vector<intern_pool::handle>;
+    using vector_ptr   = test_pointer<test_rhx_vector<int>>;
+    using spsc_queue   = rhx_spsc_queue<vector_ptr, test_allocator<vector_ptr>>;
+    using mpmc_queue   = rhx_mpmc_queue<vector_ptr, test_allocator<vector_ptr>>;
+    using record_ptr   = test_pointer<demo_record>;
+    using record_list  = rhx_intrusive_list<demo_record, test_pointer<void>>;
+    using record_tree  = rhx_intrusive_tree<demo_record, test_pointer<void>, demo_record::by_rank>;
+    using record_hash  = rhx_intrusive_hash<demo_record, test_pointer<void>, demo_record::id_hash,
+                                            demo_record::id_equal, test_allocator<demo_record>>;
+
+    int const   count   = 200000;
+    int const   entries = 5000;
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST COMPACT  ****" << endl;
+
+    //- Allocate the nodes, their payloads, and some garbage in one order, and link the nodes
+    //  in another, so that walking the list jumps all over the heap.
+    //
+    vector<node_ptr>    nodes;
+    vector<int>         order;
+
+    for (int i = 0;  i < count;  ++i)
+    {
+        nodes.push_back(allocate<demo_chain_node, test_strategy>());
+        nodes.back()->id = i;
+        test_allocator<char>().allocate(64);
+        order.push_back(i);
+    }
+    for (int i = 0;  i < count;  ++i)
+    {
+        for (int j = 0;  j < 4;  ++j)
+        {
+            nodes[i]->payload.push_back(i + j);
+        }
+    }
+    sort(order.begin(), order.end(), [](int a, int b) { return scatter(a) < scatter(b); });
+
+    node_ptr    head = nodes[order[0]];
+
+    for (int i = 1;  i < count;  ++i)
+    {
+        nodes[order[i - 1]]->next = nodes[order[i]];
+    }
+    nodes.clear();
+
+    auto    spids = test_roots::find_or_construct<test_rhx_vector<int>>("test29.ids");
+
+    for (int i = 0;  i < count;  i += 100)
+    {
+        spids->push_back(order[i]);
+    }
+
+    //- One of each rhx container, reached only through the root directory, and each holding
+    //  pointers to blocks of its own, among more garbage.
+    //
+    auto    spstrings = test_roots::find_or_construct<string_map>("test29.strings");
+    auto    spvectors = test_roots::find_or_construct<vector_map>("test29.vectors");
+    auto    sppool    = test_roots::find_or_construct<intern_pool>("test29.pool");
+    auto    sphandles = test_roots::find_or_construct<handles>("test29.handles");
+    auto    spspsc    = test_roots::find_or_construct<spsc_queue>("test29.spsc", 16);
+    auto    spmpmc    = test_roots::find_or_construct<mpmc_queue>("test29.mpmc", 16);
+    auto    splist    = test_roots::find_or_construct<record_list>("test29.list");
+    auto    sptree    = test_roots::find_or_construct<record_tree>("test29.tree");
+    auto    sphash    = test_roots::find_or_construct<record_hash>("test29.hash");
+
+    for (int i = 0;  i < entries;  ++i)
+    {
+        string      key = to_string(i % 100);
+        record_ptr  rec = allocate<demo_record, test_strategy>();
+
+        (*spstrings)[scatter(i)] = test_rhx_string<char>(key.c_str());
+        (*spvectors)[scatter(i)] = test_rhx_vector<int>{i, i, i};
+        sphandles->push_back(sppool->intern(key.c_str()));
+        test_allocator<char>().allocate(64);
+
+        rec->id   = i;
+        rec->rank = scatter(i);
+        splist->push_back(*rec);
+        sptree->insert(*rec);
+        sphash->insert(*rec);
+    }
+    //- Two objects named in the directory but not registered as roots: one reachable through
+    //  a queue, whose entry must follow it, and one garbage, whose entry must be withdrawn.
+    //
+    auto    spshared = test_roots::find_or_construct<test_rhx_vector<int>>("test29.shared");
+
+    test_roots::find_or_construct<test_rhx_vector<int>>("test29.garbage")->push_back(1);
+
+    for (int i = 0;  i < 10;  ++i)
+    {
+        vector_ptr  pv = (i == 0) ? vector_ptr(spshared)
+                                  : allocate<test_rhx_vector<int>, test_strategy>();
+
+        *pv = test_rhx_vector<int>{i, i, i};
+        ((i % 2 == 0) ? spspsc->try_push(pv) : spmpmc->try_push(pv));
+    }
+
+    auto    check_containers = [&]()
+    {
+        int     errors = 0;
+        int     i      = 0;
+
+        spstrings = test_roots::find<string_map>("test29.strings");
+        spvectors = test_roots::find<vector_map>("test29.vectors");
+        sppool    = test_roots::find<intern_pool>("test29.pool");
+        sphandles = test_roots::find<handles>("test29.handles");
+        splist    = test_roots::find<record_list>("test29.list");
+        sptree    = test_roots::find<record_tree>("test29.tree");
+        sphash    = test_roots::find<record_hash>("test29.hash");
+
+        if (!spstrings  ||  !spvectors  ||  !sppool  ||  !sphandles  ||  !splist  ||  !sptree  ||
+            !sphash)
+        {
+            return 1;
+        }
+        for (int k = 0;  k < entries;  ++k)
+        {
+            string  key = to_string(k % 100);
+
+            errors += (spstrings->at(scatter(k)).compare(key.c_str()) != 0  ||
+                       spvectors->at(scatter(k)).size() != 3  ||
+                       spvectors->at(scatter(k))[2] != k  ||
+                       (*sphandles)[k] != sppool->find(key.c_str())  ||
+                       key != (*sphandles)[k].c_str()) ? 1 : 0;
+        }
+        for (demo_record const& rec : *splist)
+        {
+            errors += (rec.id != i++  ||  sphash->find(rec.id) == sphash->end()  ||
+                       &*sphash->find(rec.id) != &rec) ? 1 : 0;
+        }
+
+        int     last  = -1;
+        int     ranks = 0;
+        int     walks = 0;
+
+        for (auto it = spstrings->begin();  it != spstrings->end();  ++it, ++walks)
+        {
+            errors += (it->first <= last) ? 1 : 0;
+            last    = it->first;
+        }
+        last = -1;
+
+        for (demo_record const& rec : *sptree)
+        {
+            errors += (rec.rank <= last) ? 1 : 0;
+            last    = rec.rank;
+            ranks  += 1;
+        }
+        return errors + ((i != entries  ||  ranks != entries  ||  walks != entries) ? 1 : 0);
+    };
+
+    auto    walk = [&head](long& sum)
+                   {
+                       auto    t0 = chrono::steady_clock::now();
+
+                       for (node_ptr p = head;  p != nullptr;  p = p->next)
+                       {
+                           sum += p->id + p->payload[3];
+                       }
+                       return chrono::duration_cast<chrono::nanoseconds>(
+                                  chrono::steady_clock::now() - t0).count() / count;
+                   };
+    auto    check = [&head, &order, &spids]()
+                    {
+                        int     errors = 0;
+                        int     i      = 0;
+
+                        for (node_ptr p = head;  p != nullptr;  p = p->next, ++i)
+                        {
+                            errors += (i >= count  ||  p->id != order[i]  ||
+                                       p->payload.size() != 4  ||
+                                       p->payload[0] != p->id  ||  p->payload[3] != p->id + 3)
+                                      ? 1 : 0;
+                        }
+                        for (size_t k = 0;  k < spids->size();  ++k)
+                        {
+                            errors += ((*spids)[k] != order[k * 100]) ? 1 : 0;
+                        }
+                        return errors + ((i != count) ? 1 : 0);
+                    };
+
+    long    sum1 = 0;
+    long    sum2 = 0;
+    auto    ns1  = walk(sum1);
+
+    test_compactor  compactor;
+
+    compactor.add_root(head);
+    compactor.add_root<test_rhx_vector<int>>("test29.ids");
+    compactor.add_root<string_map>("test29.strings");
+    compactor.add_root<vector_map>("test29.vectors");
+    compactor.add_root<intern_pool>("test29.pool");
+    compactor.add_root<handles>("test29.handles");
+    compactor.add_root<spsc_queue>("test29.spsc");
+    compactor.add_root<mpmc_queue>("test29.mpmc");
+    compactor.add_root<record_list>("test29.list");
+    compactor.add_root<record_tree>("test29.tree");
+    compactor.add_root<record_hash>("test29.hash");
+
+    auto    cstats = compactor.compact();
+    auto    ns2    = walk(sum2);
+
+    spids = test_roots::find<test_rhx_vector<int>>("test29.ids");
+
+    cout << "moved blocks: " << cstats.blocks_moved << ", moved bytes: " << cstats.bytes_moved
+         << endl;
+    cout << "used bytes before: " << cstats.bytes_before << ", after: " << cstats.bytes_after
+         << ", released bytes: " << cstats.bytes_released << ", vacated segments: "
+         << cstats.segments_vacated << endl;
+    cout << "list walk before: " << ns1 << " ns/node, after: " << ns2 << " ns/node" << endl;
+
+    int     errors = check() + check_containers() + ((sum1 != sum2) ? 1 : 0);
+
+    errors += (test_roots::contains("test29.garbage")  ||
+               test_roots::find<test_rhx_vector<int>>("test29.garbage")) ? 1 : 0;
+    errors += (test_roots::find_or_construct<test_rhx_vector<int>>("test29.garbage")->empty()  &&
+               test_roots::contains("test29.garbage")) ? 0 : 1;
+
+    //- The strategy carries on allocating from the compacted heap.
+    //
+    spids->push_back(-1);
+    errors += (spids->back() != -1) ? 1 : 0;
+    spids->pop_back();
+
+    cout << "******  SWAPPING  ******" << endl;
+    test_strategy::swap_buffers();
+
+    errors += check() + check_containers();
+
+    //- The queues give up their messages in the order pushed.
+    //
+    spspsc = test_roots::find<spsc_queue>("test29.spsc");
+    spmpmc = test_roots::find<mpmc_queue>("test29.mpmc");
+
+    for (int i = 0;  i < 10;  ++i)
+    {
+        vector_ptr  pv;
+        bool        got = (spspsc  &&  spmpmc  &&
+                           ((i % 2 == 0) ? spspsc->try_pop(pv) : spmpmc->try_pop(pv)));
+
+        errors += (!got  ||  pv->size() != 3  ||  (*pv)[0] != i) ? 1 : 0;
+        errors += (i == 0  &&  pv != test_roots::find<test_rhx_vector<int>>("test29.shared"))
+                  ? 1 : 0;
+    }
+
+    cout << "errors after compaction and relocation: " << errors << endl;
+}
+
+void test30()
+{
+    using sm = segmented_private_storage_model;
+
+    size_t const    seg_words = (32u << 20) / sizeof(uint64_t);
+    size_t const    mb        = 1u << 20;
+
+    cout << endl;
+    cout << "************************" << endl;
+    cout << "****  TEST TIERING  ****" << endl;
+
+    //- Up to four spare segments, the first of which is used throughout and the others only at
+    //  the start.
+    //
+    vector<size_t>  segs;
+
+    for (size_t s = sm::max_segment_count();  s >= sm::first_segment()  &&  segs.size() < 4;  --s)
+    {
+        if (sm::segment_address(s) == nullptr)
+        {
+            segs.push_back(s);
+        }
+    }
+    if (segs.size() < 2)
+    {
+        cout << "tiering demo requires two free segments, errors: 1" << endl;
+        return;
+    }
+    for (size_t s : segs)
+    {
+        sm::allocate_segment(s, seg_words * sizeof(uint64_t));
+
+        uint64_t*   pw = reinterpret_cast<uint64_t*>(sm::segment_address(s));
+
+        for (size_t i = 0;  i < seg_words;  ++i)
+        {
+            pw[i] = (uint64_t(s) << 32) | i;
+        }
+    }
+
+    //- Reads one word per cache line, and counts those that do not hold what was written.
+    //
+    int     errors = 0;
+    auto    scan   = [&errors, seg_words](size_t s)
+                     {
+                         uint64_t const*    pw = reinterpret_cast<uint64_t const*>(
+                                                     sm::segment_address(s));
+                         auto               t0 = chrono::steady_clock::now();
+
+                         for (size_t i = 0;  i < seg_words;  i += 8)
+                         {
+                             errors += (pw[i] != ((uint64_t(s) << 32) | i)) ? 1 : 0;
+                         }
+                         return chrono::duration_cast<chrono::nanoseconds>(
+                                    chrono::steady_clock::now() - t0).count() /
+                                (seg_words * sizeof(uint64_t) / sm::page_size);
+                     };
+    auto    report = [mb](char const* name, sm::tiering_stats const& ts)
+                     {
+                         cout << name << ": " << ts.segments_referenced << " referenced, "
+                              << ts.segments_evicted << " evicted, "
+                              << ts.bytes_written / 1024 << " kB written, "
+                              << ts.bytes_released / mb << " MB released, "
+                              << ts.resident_bytes / mb << " MB resident" << endl;
+                     };
+
+    sm::open_cold_store("test30.cold");
+    report("baseline", sm::sample_segments());
+
+    for (int pass = 1;  pass <= 3;  ++pass)
+    {
+        scan(segs[0]);
+        report((pass == 1) ? "pass 1  " : (pass == 2) ? "pass 2  " : "pass 3  ",
+               sm::sample_segments(2));
+    }
+
+    //- Where the kernel reports no referenced bits, nothing is evicted.
+    //
+    int     evicted = 0;
+
+    for (size_t s : segs)
+    {
+        evicted += sm::segment_evicted(s) ? 1 : 0;
+    }
+    errors += (evicted != 0  &&  (sm::segment_evicted(segs[0])  ||
+                                  evicted != static_cast<int>(segs.size()) - 1)) ? 1 : 0;
+
+    scan(segs[0]);
+
+    auto    hot_ns  = scan(segs[0]);
+    auto    cold_ns = scan(segs[1]);
+    auto    warm_ns = scan(segs[1]);
+
+    cout << "cold segments evicted: " << evicted << " of " << (segs.size() - 1) << endl;
+    cout << "scan: " << hot_ns << " ns/page hot, " << cold_ns << " ns/page reloading, "
+         << warm_ns << " ns/page reloaded" << endl;
+
+    //- Dirty one page of a reloaded segment; evicting it again writes only that page.  Then
+    //  bound the resident bytes, which evicts even the segments in use.
+    //
+    reinterpret_cast<uint64_t*>(sm::segment_address(segs[1]))[0] = uint64_t(segs[1]) << 32;
+
+    auto    again = sm::evict_segment(segs[1]);
+
+    //- The segment was never mapped from an image, so although the store now backs its pages,
+    //  none is clean; otherwise a change tracker would skip the writes made before eviction.
+    //
+    vector<bool>    clean;
+
+    sm::find_clean_pages(segs[1], clean);
+    errors += static_cast<int>(count(clean.begin(), clean.end(), true));
+
+    auto    bound = sm::sample_segments(2, 16 * mb);
+
+    report("re-evict", again);
+    report("bounded ", bound);
+
+    //- Checksums are brought up to date when a segment is evicted, so those of the evicted
+    //  segments can be verified.
+    //
+    vector<size_t>  cold;
+
+    for (size_t s : segs)
+    {
+        scan(s);
+
+        if (sm::segment_evicted(s))
+        {
+            cold.push_back(s);
+        }
+    }
+    if (!cold.empty())
+    {
+        errors += static_cast<int>(sm::verify_segments(cold.data(), cold.size()).bad_pages);
+    }
+
+    for (size_t s : segs)
+    {
+        sm::deallocate_segment(s);
+    }
+    sm::close_cold_store();
+
+    cout << "errors after eviction and reload: " << errors << endl;
+}
+
 int main()
 {
     test1();
@@ -281,6 +3205,30 @@ int main()
     test4();
     test5();
     test6();
+    test7();
+    test8();
+    test9();
+    test10();
+    test11();
+    test12();
+    test13();
+    test14();
+    test15();
+    test16();
+    test17();
+    test18();
+    test19();
+    test20();
+    test21();
+    test22();
+    test23();
+    test24();
+    test25();
+    test26();
+    test27();
+    test28();
+    test29();
+    test30();
 
     return 0;
 }
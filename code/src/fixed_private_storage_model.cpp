@@ -0,0 +1,496 @@
+//==================================================================================================
+//  File:
+//      fixed_private_storage_model.cpp
+//
+//  Summary:
+//      Implements a heap class for testing rhx_allocator that tries to map its segments at fixed
+//      addresses.
+//==================================================================================================
+//
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "fixed_private_storage_model.h"
+#include "segmented_heap_image.h"
+#include "segmented_private_storage_model.h"
+
+#if defined(_WIN32)
+    #define FIXED_PRIVATE_STORAGE_MODEL_WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #define FIXED_PRIVATE_STORAGE_MODEL_MMAN
+    #include <sys/mman.h>
+    #ifndef MAP_ANONYMOUS
+        #define MAP_ANONYMOUS   MAP_ANON
+    #endif
+    #ifndef MAP_NORESERVE
+        #define MAP_NORESERVE   0
+    #endif
+#endif
+
+uint8_t*
+    fixed_private_storage_model::sm_segment_addr[max_segments + 2];
+
+fixed_private_storage_model::size_type
+    fixed_private_storage_model::sm_segment_size[max_segments + 2];
+
+uint8_t*
+    fixed_private_storage_model::sm_shadow_addr[max_segments + 2];
+
+uint8_t*    fixed_private_storage_model::sm_reserved_addr = nullptr;
+bool        fixed_private_storage_model::sm_reserve_tried = false;
+bool        fixed_private_storage_model::sm_fixed         = false;
+
+fixed_private_storage_model::state_hook     fixed_private_storage_model::sm_store_hook  = nullptr;
+fixed_private_storage_model::state_hook     fixed_private_storage_model::sm_reload_hook = nullptr;
+
+namespace {
+//--------------------------------------------------------------------------------------------------
+//  Buffers that cannot be placed in the reserved range (shadow buffers, and every buffer when
+//  the reservation failed) come from the free store, aligned exactly as in the segmented model.
+//--------------------------------------------------------------------------------------------------
+//
+uint8_t*
+allocate_aligned(std::size_t size, std::size_t align)
+{
+    uint8_t*    praw = new uint8_t[size + align + sizeof(uint8_t*)];
+    uintptr_t   addr = reinterpret_cast<uintptr_t>(praw + sizeof(uint8_t*));
+    uint8_t*    pbuf = reinterpret_cast<uint8_t*>((addr + align - 1) & ~(uintptr_t)(align - 1));
+
+    memcpy(pbuf - sizeof(uint8_t*), &praw, sizeof(uint8_t*));
+    return pbuf;
+}
+
+void
+deallocate_aligned(uint8_t* pbuf)
+{
+    uint8_t*    praw;
+
+    memcpy(&praw, pbuf - sizeof(uint8_t*), sizeof(uint8_t*));
+    delete [] praw;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Address space primitives.  A reserved range is inaccessible until pages are committed;
+//  committed pages read as zero, and decommitting them discards their contents.
+//--------------------------------------------------------------------------------------------------
+//
+uint8_t*
+reserve_pages(uint64_t addr, uint64_t size)
+{
+#if defined(FIXED_PRIVATE_STORAGE_MODEL_WIN32)
+    if (sizeof(void*) >= 8)
+    {
+        void*   p = VirtualAlloc(reinterpret_cast<void*>(static_cast<uintptr_t>(addr)),
+                                 static_cast<SIZE_T>(size), MEM_RESERVE, PAGE_NOACCESS);
+        return static_cast<uint8_t*>(p);
+    }
+#elif defined(FIXED_PRIVATE_STORAGE_MODEL_MMAN)
+    if (sizeof(void*) >= 8)
+    {
+        void*   hint  = reinterpret_cast<void*>(static_cast<uintptr_t>(addr));
+        int     flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    #ifdef MAP_FIXED_NOREPLACE
+        flags |= MAP_FIXED_NOREPLACE;
+    #endif
+        void*   p = mmap(hint, static_cast<size_t>(size), PROT_NONE, flags, -1, 0);
+
+        //- Without MAP_FIXED_NOREPLACE the address is only a hint, and older kernels ignore the
+        //  flag; either way, a mapping somewhere else is of no use.
+        //
+        if (p == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        if (p != hint)
+        {
+            munmap(p, static_cast<size_t>(size));
+            return nullptr;
+        }
+        return static_cast<uint8_t*>(p);
+    }
+#endif
+    (void) addr;
+    (void) size;
+    return nullptr;
+}
+
+bool
+commit_pages(uint8_t* p, std::size_t size)
+{
+#if defined(FIXED_PRIVATE_STORAGE_MODEL_WIN32)
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#elif defined(FIXED_PRIVATE_STORAGE_MODEL_MMAN)
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#else
+    (void) p;
+    (void) size;
+    return false;
+#endif
+}
+
+void
+decommit_pages(uint8_t* p, std::size_t size)
+{
+#if defined(FIXED_PRIVATE_STORAGE_MODEL_WIN32)
+    VirtualFree(p, size, MEM_DECOMMIT);
+#elif defined(FIXED_PRIVATE_STORAGE_MODEL_MMAN)
+    //- Mapping fresh pages over the old ones both releases them and leaves zeros behind for the
+    //  next commit.
+    //
+    mmap(p, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+#else
+    (void) p;
+    (void) size;
+#endif
+}
+
+inline std::size_t
+round_to_page(std::size_t size, std::size_t page)
+{
+    return (size + page - 1) & ~(page - 1);
+}
+
+using sm_type      = fixed_private_storage_model;
+using image_format = segmented_heap_image<sm_type>;
+using image_header = image_format::header;
+
+//- Appends the checksum of each page of a buffer to a table.
+//
+void
+append_page_checksums(std::vector<uint32_t>& table, uint8_t const* pbuf, std::size_t size)
+{
+    for (std::size_t at = 0;  at < size;  at += sm_type::page_size)
+    {
+        std::size_t     n = (at + sm_type::page_size < size) ? sm_type::page_size : size - at;
+
+        table.push_back(sm_type::checksum(pbuf + at, n));
+    }
+}
+
+}   //- anonymous namespace
+
+void
+fixed_private_storage_model::allocate_segment(size_type segment, size_type size)
+{
+    if (segment >= first_segment()  &&  segment <= max_segments  &&
+        size <= max_size  &&  sm_segment_addr[segment] == nullptr)
+    {
+        uint8_t*    pslot = reserve_range() ? slot_address(segment) : nullptr;
+
+        sm_shadow_addr[segment] = allocate_aligned(max_size, max_align);
+        memset(sm_shadow_addr[segment], 0, max_size);
+
+        if (pslot != nullptr  &&  commit_pages(pslot, round_to_page(size, max_align)))
+        {
+            sm_segment_addr[segment] = pslot;
+        }
+        else
+        {
+            sm_segment_addr[segment] = allocate_aligned(max_size, max_align);
+            memset(sm_segment_addr[segment], 0, max_size);
+        }
+
+        sm_segment_size[segment] = size;
+        update_mode();
+    }
+}
+
+void
+fixed_private_storage_model::deallocate_segment(size_type segment)
+{
+    if (sm_segment_addr[segment] != nullptr)
+    {
+        size_type   size = round_to_page(sm_segment_size[segment], max_align);
+
+        uint8_t*    pslot = slot_address(segment);
+
+        for (uint8_t* pbuf : {sm_shadow_addr[segment], sm_segment_addr[segment]})
+        {
+            if (pbuf == pslot)
+            {
+                decommit_pages(pbuf, size);
+            }
+            else
+            {
+                deallocate_aligned(pbuf);
+            }
+        }
+        sm_shadow_addr[segment]  = nullptr;
+        sm_segment_addr[segment] = nullptr;
+        sm_segment_size[segment] = 0;
+        update_mode();
+    }
+}
+
+//- Changes the size of a segment without moving it.  New bytes read as zero, so bytes that a
+//  segment gives up are cleared, and those in its slot are decommitted.
+//
+void
+fixed_private_storage_model::resize_segment(size_type segment, size_type size)
+{
+    if (segment < first_segment()  ||  segment > max_segments  ||
+        sm_segment_addr[segment] == nullptr  ||  size > max_size)
+    {
+        throw std::out_of_range("invalid segment or segment size");
+    }
+
+    size_type   old_size   = sm_segment_size[segment];
+    size_type   old_extent = round_to_page(old_size, max_align);
+    size_type   new_extent = round_to_page(size, max_align);
+    uint8_t*    pslot      = slot_address(segment);
+
+    for (uint8_t* pbuf : {sm_shadow_addr[segment], sm_segment_addr[segment]})
+    {
+        if (pbuf != pslot)
+        {
+            if (size < old_size)
+            {
+                memset(pbuf + size, 0, old_size - size);
+            }
+        }
+        else if (new_extent > old_extent)
+        {
+            if (!commit_pages(pbuf + old_extent, new_extent - old_extent))
+            {
+                throw std::bad_alloc();
+            }
+        }
+        else if (size < old_size)
+        {
+            memset(pbuf + size, 0, ((new_extent < old_size) ? new_extent : old_size) - size);
+            decommit_pages(pbuf + new_extent, old_extent - new_extent);
+        }
+    }
+
+    sm_segment_size[segment] = size;
+}
+
+void
+fixed_private_storage_model::clear_segments()
+{
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        deallocate_segment(i);
+    }
+    if (sm_reload_hook != nullptr)
+    {
+        sm_reload_hook();
+    }
+}
+
+void
+fixed_private_storage_model::swap_buffers()
+{
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        if (sm_segment_addr[i] != nullptr)
+        {
+            memcpy(sm_shadow_addr[i], sm_segment_addr[i], sm_segment_size[i]);
+            std::swap(sm_shadow_addr[i], sm_segment_addr[i]);
+        }
+    }
+    update_mode();
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Writes every allocated segment, with its page checksums, to a heap image file.  Unlike the
+//  segmented model, this one keeps no checksums between saves, so every page is hashed.  The
+//  allocation strategy stores its bookkeeping in the heap first.  The image is written under a
+//  temporary name and renamed into place.
+//--------------------------------------------------------------------------------------------------
+//
+void
+fixed_private_storage_model::save_image(char const* path)
+{
+    if (sm_store_hook != nullptr)
+    {
+        sm_store_hook();
+    }
+
+    image_header            hdr = image_format::make_header(image_format::fixed_encoding);
+    std::vector<size_type>  segments;
+    std::vector<uint32_t>   table;
+
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        if (sm_segment_addr[i] != nullptr)
+        {
+            hdr.m_sizes[i] = sm_segment_size[i];
+            segments.push_back(i);
+            append_page_checksums(table, sm_segment_addr[i], sm_segment_size[i]);
+        }
+    }
+    hdr.m_header_crc = image_format::header_checksum(hdr);
+
+    std::string     temp = std::string(path) + ".tmp";
+    std::FILE*      fp   = std::fopen(temp.c_str(), "wb");
+    bool            ok   = (fp != nullptr)  &&
+                           image_format::write_padded(fp, &hdr, sizeof(hdr))  &&
+                           image_format::write_padded(fp, table.data(),
+                                                      table.size() * sizeof(uint32_t));
+
+    for (size_type i : segments)
+    {
+        ok = ok  &&  image_format::write_padded(fp, sm_segment_addr[i], hdr.m_sizes[i]);
+    }
+
+    if (fp != nullptr  &&  std::fclose(fp) != 0)
+    {
+        ok = false;
+    }
+#ifndef FIXED_PRIVATE_STORAGE_MODEL_MMAN
+    //- Only POSIX rename() replaces an existing file.
+    //
+    if (ok)
+    {
+        std::remove(path);
+    }
+#endif
+    if (!ok  ||  std::rename(temp.c_str(), path) != 0)
+    {
+        std::remove(temp.c_str());
+        throw std::runtime_error("unable to write heap image");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Reads the segments of a heap image saved by this model into new segments with the numbers
+//  they had, which must be free; in fixed mode they land in their slots, at the addresses that
+//  the pointers stored in them hold.  Every page is checked against its checksum, and an image
+//  that fails is unloaded again and rejected.
+//--------------------------------------------------------------------------------------------------
+//
+void
+fixed_private_storage_model::map_image(char const* path)
+{
+    image_header    hdr;
+    std::FILE*      fp = std::fopen(path, "rb");
+
+    if (fp == nullptr  ||  !image_format::read_header(fp, hdr))
+    {
+        if (fp != nullptr)
+        {
+            std::fclose(fp);
+        }
+        throw std::runtime_error("invalid heap image");
+    }
+    if (hdr.m_encoding != image_format::fixed_encoding  ||  hdr.m_segment_size != max_size)
+    {
+        std::fclose(fp);
+        throw std::runtime_error("heap image was saved by an incompatible storage model");
+    }
+
+    std::vector<size_type>  segments;
+    std::vector<uint32_t>   table;
+
+    for (size_type i = 0;  i <= max_segments + 1;  ++i)
+    {
+        if (hdr.m_sizes[i] != 0  &&  (i < first_segment()  ||  i > max_segments  ||
+            hdr.m_sizes[i] > max_size  ||  sm_segment_addr[i] != nullptr))
+        {
+            std::fclose(fp);
+            throw std::out_of_range("heap image segment is invalid or in use");
+        }
+        if (hdr.m_sizes[i] != 0)
+        {
+            segments.push_back(i);
+        }
+    }
+
+    table.resize(static_cast<size_type>(image_format::checksum_bytes(hdr) / sizeof(uint32_t)));
+
+    bool    ok = std::fseek(fp, static_cast<long>(image_format::checksum_offset()), SEEK_SET) == 0
+                 &&  std::fread(table.data(), sizeof(uint32_t), table.size(), fp) == table.size();
+
+    std::vector<uint32_t>   loaded;
+
+    for (size_type i : segments)
+    {
+        size_type   size   = static_cast<size_type>(hdr.m_sizes[i]);
+        long        offset = static_cast<long>(image_format::segment_offset(hdr, i));
+
+        if (ok)
+        {
+            allocate_segment(i, size);
+            ok = sm_segment_addr[i] != nullptr  &&  std::fseek(fp, offset, SEEK_SET) == 0  &&
+                 std::fread(sm_segment_addr[i], 1, size, fp) == size;
+        }
+        if (ok)
+        {
+            append_page_checksums(loaded, sm_segment_addr[i], size);
+        }
+    }
+    std::fclose(fp);
+
+    //- Leave no part of a failed image behind.
+    //
+    if (!ok  ||  loaded != table)
+    {
+        for (size_type i : segments)
+        {
+            deallocate_segment(i);
+        }
+        throw std::runtime_error(ok ? "heap image failed verification"
+                                    : "unable to load heap image");
+    }
+
+    //- An image that holds the first segment holds a heap, whose bookkeeping comes with it.
+    //
+    if (hdr.m_sizes[first_segment()] != 0  &&  sm_reload_hook != nullptr)
+    {
+        sm_reload_hook();
+    }
+}
+
+//- Heap images share the segmented model's checksum.
+//
+uint32_t
+fixed_private_storage_model::checksum(void const* p, size_type n, uint32_t crc) noexcept
+{
+    return segmented_private_storage_model::checksum(p, n, crc);
+}
+
+//- The reservation is attempted once, and is kept for the life of the process.
+//
+bool
+fixed_private_storage_model::reserve_range()
+{
+    if (!sm_reserve_tried)
+    {
+        sm_reserve_tried = true;
+        sm_reserved_addr = reserve_pages(fixed_base(), fixed_range_size());
+    }
+    return sm_reserved_addr != nullptr;
+}
+
+uint8_t*
+fixed_private_storage_model::slot_address(size_type segment) noexcept
+{
+    return (sm_reserved_addr != nullptr) ? sm_reserved_addr + segment * max_size : nullptr;
+}
+
+//- Pointers may be dereferenced without translation only when every live segment is in its slot.
+//
+void
+fixed_private_storage_model::update_mode() noexcept
+{
+    bool    fixed = (sm_reserved_addr != nullptr);
+
+    for (size_type i = first_segment();  fixed  &&  i <= max_segments;  ++i)
+    {
+        fixed = (sm_segment_addr[i] == nullptr  ||  sm_segment_addr[i] == slot_address(i));
+    }
+    sm_fixed = fixed;
+}
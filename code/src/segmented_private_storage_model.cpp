@@ -6,9 +6,54 @@
 //      Defines a very simple heap class for testing rhx_allocator.
 //==================================================================================================
 //
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 #include "segmented_private_storage_model.h"
+#include "segmented_heap_image.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SEGMENTED_PRIVATE_STORAGE_MODEL_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if (defined(__SSE4_2__) && defined(__x86_64__)) || (defined(_M_X64) && defined(__AVX__))
+    #define SEGMENTED_PRIVATE_STORAGE_MODEL_CRC_SSE42
+    #include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+    #define SEGMENTED_PRIVATE_STORAGE_MODEL_CRC_ARM
+    #include <arm_acle.h>
+#endif
+
+#if defined(_WIN32)
+    #define SEGMENTED_PRIVATE_STORAGE_MODEL_WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #define SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #ifndef MAP_ANONYMOUS
+        #define MAP_ANONYMOUS   MAP_ANON
+    #endif
+    #ifndef MAP_NORESERVE
+        #define MAP_NORESERVE   0
+    #endif
+#endif
 
 uint8_t*   
     segmented_private_storage_model::sm_segment_addr[max_segments + 2];
@@ -22,32 +67,680 @@ segmented_private_storage_model::size_type
 uint8_t*   
     segmented_private_storage_model::sm_shadow_addr[max_segments + 2];
 
+bool
+    segmented_private_storage_model::sm_segment_mapped[max_segments + 2];
+
+uint32_t
+    segmented_private_storage_model::sm_page_crc[max_segments + 2][max_size / page_size];
+
+bool
+    segmented_private_storage_model::sm_segment_unverified[max_segments + 2];
+
+bool
+    segmented_private_storage_model::sm_transaction_open = false;
+
+segmented_private_storage_model::size_type
+    segmented_private_storage_model::sm_undo_size[max_segments + 2];
+
+std::vector<bool>
+    segmented_private_storage_model::sm_undo_clean[max_segments + 2];
+
+alignas(64) uint64_t
+    segmented_private_storage_model::sm_relocation_epoch = 0;
+
+std::FILE*
+    segmented_private_storage_model::sm_cold_store = nullptr;
+
+bool
+    segmented_private_storage_model::sm_segment_cold[max_segments + 2];
+
+segmented_private_storage_model::size_type
+    segmented_private_storage_model::sm_idle_passes[max_segments + 2];
+
+std::vector<bool>
+    segmented_private_storage_model::sm_page_written[max_segments + 2];
+
+segmented_private_storage_model::state_hook
+    segmented_private_storage_model::sm_store_hook = nullptr;
+
+segmented_private_storage_model::state_hook
+    segmented_private_storage_model::sm_reload_hook = nullptr;
+
+namespace {
+#if !defined(SEGMENTED_PRIVATE_STORAGE_MODEL_WIN32)  &&  \
+    !defined(SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN)
+//--------------------------------------------------------------------------------------------------
+//  Without virtual memory services, segment buffers come from the free store, aligned to
+//  segment_alignment() so that an offset aligned to any power of two up to that value yields an
+//  address with the same alignment.  The address returned by new[] is stashed in the word just
+//  below the aligned block so that it can be freed later.
+//--------------------------------------------------------------------------------------------------
+//
+uint8_t*
+allocate_aligned(std::size_t size, std::size_t align)
+{
+    uint8_t*    praw = new uint8_t[size + align + sizeof(uint8_t*)];
+    uintptr_t   addr = reinterpret_cast<uintptr_t>(praw + sizeof(uint8_t*));
+    uint8_t*    pbuf = reinterpret_cast<uint8_t*>((addr + align - 1) & ~(uintptr_t)(align - 1));
+
+    memcpy(pbuf - sizeof(uint8_t*), &praw, sizeof(uint8_t*));
+    return pbuf;
+}
+
+void
+deallocate_aligned(uint8_t* pbuf)
+{
+    uint8_t*    praw;
+
+    memcpy(&praw, pbuf - sizeof(uint8_t*), sizeof(uint8_t*));
+    delete [] praw;
+}
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Address space primitives.  A reserved range is inaccessible until pages are committed, and
+//  its base is page-aligned (and so aligned to segment_alignment()); committed pages read as
+//  zero, and decommitting them discards their contents.  Without virtual memory services, the
+//  whole range is allocated and zeroed up front, and committing does nothing.
+//--------------------------------------------------------------------------------------------------
+//
+uint8_t*
+reserve_pages(std::size_t size)
+{
+#if defined(SEGMENTED_PRIVATE_STORAGE_MODEL_WIN32)
+    return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS));
+#elif defined(SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN)
+    void*   p = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return (p != MAP_FAILED) ? static_cast<uint8_t*>(p) : nullptr;
+#else
+    uint8_t*    p = allocate_aligned(size, segmented_private_storage_model::max_align);
+
+    memset(p, 0, size);
+    return p;
+#endif
+}
+
+bool
+commit_pages(uint8_t* p, std::size_t size)
+{
+    if (size == 0)
+    {
+        return true;
+    }
+#if defined(SEGMENTED_PRIVATE_STORAGE_MODEL_WIN32)
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#elif defined(SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN)
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#else
+    (void) p;
+    return true;
+#endif
+}
+
+void
+decommit_pages(uint8_t* p, std::size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+#if defined(SEGMENTED_PRIVATE_STORAGE_MODEL_WIN32)
+    VirtualFree(p, size, MEM_DECOMMIT);
+#elif defined(SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN)
+    //- Mapping fresh pages over the old ones (which may be file-backed) both releases them and
+    //  leaves zeros behind for the next commit.
+    //
+    mmap(p, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+#else
+    memset(p, 0, size);
+#endif
+}
+
+void
+release_pages(uint8_t* p, std::size_t size)
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+#if defined(SEGMENTED_PRIVATE_STORAGE_MODEL_WIN32)
+    (void) size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN)
+    munmap(p, size);
+#else
+    (void) size;
+    deallocate_aligned(p);
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Rebasing describes how the synthetic pointers in an imported image are renumbered: a word
+//  whose segment field lies in [m_image_first, m_image_first + m_count), and whose offset is
+//  below the size of that image segment, is moved to the corresponding segment counting from
+//  m_new_first.
+//--------------------------------------------------------------------------------------------------
+//
+struct rebase_info
+{
+    uint64_t            m_image_first;
+    uint64_t            m_count;
+    uint64_t            m_new_first;
+    std::size_t const*  mp_sizes;
+};
+
+uint64_t const  offset_mask = ~uint64_t(0u) >> 16;
+
+inline void
+rebase_word(uint64_t& word, rebase_info const& info)
+{
+    uint64_t    index  = (word >> 48) - info.m_image_first;
+    uint64_t    offset = word & offset_mask;
+
+    if (index < info.m_count  &&  offset < info.mp_sizes[index])
+    {
+        word = ((info.m_new_first + index) << 48) | offset;
+    }
+}
+
+//- Rewrites every word of the buffer that looks like a synthetic pointer into the image.  Almost
+//  all words are not, so with SSE2 four words at a time are screened on their segment fields
+//  alone, and only candidates are examined one by one.
+//
+void
+rebase_pointers(uint64_t* pwords, std::size_t count, rebase_info const& info)
+{
+    std::size_t     i = 0;
+
+#ifdef SEGMENTED_PRIVATE_STORAGE_MODEL_SSE2
+    __m128i const   first = _mm_set1_epi32(static_cast<int>(info.m_image_first));
+    __m128i const   limit = _mm_set1_epi32(static_cast<int>(info.m_count));
+    __m128i const   zero  = _mm_setzero_si128();
+
+    for (;  i + 4 <= count;  i += 4)
+    {
+        __m128i     lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pwords + i));
+        __m128i     hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pwords + i + 2));
+
+        //- After shifting, the low dword of each lane holds a segment field; subtracting the
+        //  image's first segment leaves a value in [0, count) only for candidates.
+        //
+        __m128i     dlo = _mm_sub_epi32(_mm_srli_epi64(lo, 48), first);
+        __m128i     dhi = _mm_sub_epi32(_mm_srli_epi64(hi, 48), first);
+        __m128i     mlo = _mm_andnot_si128(_mm_cmpgt_epi32(zero, dlo), _mm_cmplt_epi32(dlo, limit));
+        __m128i     mhi = _mm_andnot_si128(_mm_cmpgt_epi32(zero, dhi), _mm_cmplt_epi32(dhi, limit));
+        int         hit = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(mlo, mhi))) & 0x5;
+
+        if (hit != 0)
+        {
+            rebase_word(pwords[i],     info);
+            rebase_word(pwords[i + 1], info);
+            rebase_word(pwords[i + 2], info);
+            rebase_word(pwords[i + 3], info);
+        }
+    }
+#endif
+
+    for (;  i < count;  ++i)
+    {
+        rebase_word(pwords[i], info);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+//  CRC32C (Castagnoli) of a byte range, using the SSE4.2 or ARMv8 CRC instructions when the
+//  compiler targets them, and the slicing-by-8 method otherwise.
+//--------------------------------------------------------------------------------------------------
+//
+#if defined(SEGMENTED_PRIVATE_STORAGE_MODEL_CRC_SSE42)
+
+uint32_t
+crc32c(uint32_t crc, uint8_t const* p, std::size_t n)
+{
+    uint64_t    c = ~crc;
+    uint64_t    word;
+
+    for (;  n >= 8;  n -= 8, p += 8)
+    {
+        memcpy(&word, p, sizeof(word));
+        c = _mm_crc32_u64(c, word);
+    }
+    for (;  n > 0;  --n, ++p)
+    {
+        c = _mm_crc32_u8(static_cast<uint32_t>(c), *p);
+    }
+    return ~static_cast<uint32_t>(c);
+}
+
+#elif defined(SEGMENTED_PRIVATE_STORAGE_MODEL_CRC_ARM)
+
+uint32_t
+crc32c(uint32_t crc, uint8_t const* p, std::size_t n)
+{
+    uint32_t    c = ~crc;
+    uint64_t    word;
+
+    for (;  n >= 8;  n -= 8, p += 8)
+    {
+        memcpy(&word, p, sizeof(word));
+        c = __crc32cd(c, word);
+    }
+    for (;  n > 0;  --n, ++p)
+    {
+        c = __crc32cb(c, *p);
+    }
+    return ~c;
+}
+
+#else
+
+struct crc32c_tables
+{
+    uint32_t    m_table[8][256];
+
+    crc32c_tables()
+    {
+        for (uint32_t i = 0;  i < 256;  ++i)
+        {
+            uint32_t    c = i;
+
+            for (int k = 0;  k < 8;  ++k)
+            {
+                c = (c >> 1) ^ ((c & 1u) ? 0x82F63B78u : 0u);
+            }
+            m_table[0][i] = c;
+        }
+        for (uint32_t i = 0;  i < 256;  ++i)
+        {
+            for (int t = 1;  t < 8;  ++t)
+            {
+                uint32_t    prev = m_table[t - 1][i];
+
+                m_table[t][i] = (prev >> 8) ^ m_table[0][prev & 0xFFu];
+            }
+        }
+    }
+};
+
+inline uint32_t
+load_le32(uint8_t const* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint32_t
+crc32c(uint32_t crc, uint8_t const* p, std::size_t n)
+{
+    static crc32c_tables const  tables;
+
+    auto const&     t = tables.m_table;
+    uint32_t        c = ~crc;
+
+    for (;  n >= 8;  n -= 8, p += 8)
+    {
+        uint32_t    lo = load_le32(p) ^ c;
+        uint32_t    hi = load_le32(p + 4);
+
+        c = t[7][lo & 0xFFu] ^ t[6][(lo >> 8) & 0xFFu] ^ t[5][(lo >> 16) & 0xFFu] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xFFu] ^ t[2][(hi >> 8) & 0xFFu] ^ t[1][(hi >> 16) & 0xFFu] ^ t[0][hi >> 24];
+    }
+    for (;  n > 0;  --n, ++p)
+    {
+        c = t[0][(c ^ *p) & 0xFFu] ^ (c >> 8);
+    }
+    return ~c;
+}
+
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Heap image files are laid out as segmented_heap_image<> describes, with pointers stored as
+//  segment numbers and offsets.  Segments are committed in multiples of the image alignment,
+//  so that the pages past a mapped segment's contents are never backed by the file.
+//--------------------------------------------------------------------------------------------------
+//
+using sm_type      = segmented_private_storage_model;
+using image_format = segmented_heap_image<sm_type>;
+using image_header = image_format::header;
+
+std::size_t const   image_alignment = image_format::alignment;
+
+inline uint64_t
+image_extent(uint64_t size)
+{
+    return image_format::extent(size);
+}
+
+inline std::size_t
+page_count(uint64_t size)
+{
+    return image_format::page_count(size);
+}
+
+//- The checksum of a page of zeros, which is what every page of a segment holds when it is
+//  first committed.
+//
+uint32_t
+zero_page_checksum()
+{
+    static uint8_t const    zeros[sm_type::page_size] = {};
+    static uint32_t const   crc = crc32c(0, zeros, sizeof(zeros));
+
+    return crc;
+}
+
+//- Sets clean[i] for each page of the buffer that is still backed by the file it was mapped
+//  from, and so has not been written since; returns false if that cannot be determined.  On
+//  Linux, /proc/self/pagemap reports this for every virtual page: a page that is present and
+//  maps the file, or that has never been faulted in (and is not in swap), is clean.
+//
+bool
+find_mapped_clean_pages(uint8_t const* pbuf, std::size_t npages, std::vector<bool>& clean)
+{
+#if defined(__linux__)
+    uintptr_t const     sys_page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t const     first    = reinterpret_cast<uintptr_t>(pbuf) / sys_page;
+    uintptr_t const     last     = (reinterpret_cast<uintptr_t>(pbuf) +
+                                    npages * sm_type::page_size - 1) / sys_page;
+
+    std::vector<uint64_t>   entries(last - first + 1);
+    std::size_t             nbytes = entries.size() * sizeof(uint64_t);
+
+    int     fd = open("/proc/self/pagemap", O_RDONLY);
+    bool    ok = (fd >= 0)  &&
+                 pread(fd, entries.data(), nbytes, static_cast<off_t>(first * sizeof(uint64_t)))
+                    == static_cast<ssize_t>(nbytes);
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    if (!ok)
+    {
+        return false;
+    }
+
+    clean.assign(npages, true);
+
+    for (std::size_t i = 0;  i < npages;  ++i)
+    {
+        uintptr_t   lo = (reinterpret_cast<uintptr_t>(pbuf) + i * sm_type::page_size) / sys_page;
+        uintptr_t   hi = (reinterpret_cast<uintptr_t>(pbuf) + (i + 1) * sm_type::page_size - 1)
+                            / sys_page;
+
+        for (uintptr_t vp = lo;  vp <= hi;  ++vp)
+        {
+            uint64_t    e       = entries[vp - first];
+            bool        present = ((e >> 63) & 1u) != 0;
+            bool        swapped = ((e >> 62) & 1u) != 0;
+            bool        file    = ((e >> 61) & 1u) != 0;
+
+            if (present ? !file : swapped)
+            {
+                clean[i] = false;
+            }
+        }
+    }
+    return true;
+#else
+    (void) pbuf;
+    (void) npages;
+    (void) clean;
+    return false;
+#endif
+}
+
+//- Runs f(segment) on its own thread for each listed segment, and sums the statistics.
+//
+template<class F>
+sm_type::checksum_stats
+run_per_segment(std::vector<std::size_t> const& segments, F f)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<sm_type::checksum_stats>    parts(segments.size());
+    std::vector<std::thread>                threads;
+
+    auto    start = clock::now();
+
+    for (std::size_t i = 0;  i < segments.size();  ++i)
+    {
+        threads.emplace_back([&parts, &segments, &f, i]{ parts[i] = f(segments[i]); });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    sm_type::checksum_stats     stats = {};
+
+    for (auto const& part : parts)
+    {
+        stats.bytes_hashed += part.bytes_hashed;
+        stats.pages_reused += part.pages_reused;
+        stats.bad_pages    += part.bad_pages;
+    }
+    stats.threads = threads.size();
+    stats.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    return stats;
+}
+
+//- Drops the private copy of a page of a file mapping, so that its contents revert to those of
+//  the file.  Only used for pages that find_clean_pages() once reported as file-backed.
+//
+void
+discard_private_page(uint8_t* ppage)
+{
+#ifdef SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN
+    madvise(ppage, segmented_private_storage_model::page_size, MADV_DONTNEED);
+#else
+    (void) ppage;
+#endif
+}
+
+//- The resident and recently referenced bytes of a segment's buffers.
+//
+struct segment_usage
+{
+    std::size_t     m_resident;         //- Resident bytes of the primary and shadow buffers
+    std::size_t     m_referenced;       //- Bytes of the primary buffer referenced recently
+};
+
+//- Fills usage[i] for each segment i whose buffers are at primary[i] and shadow[i], and then
+//  clears the referenced bits of every page in the process, so that the next call reports the
+//  pages referenced in between; returns false if that cannot be determined.  On Linux, the
+//  kernel reports the resident and referenced bytes of each mapping in /proc/self/smaps, and
+//  clears the bits when "1" is written to /proc/self/clear_refs.
+//
+bool
+read_segment_usage(uint8_t* const* primary, uint8_t* const* shadow, std::size_t count,
+                   std::size_t range, segment_usage* usage)
+{
+#if defined(__linux__)
+    std::FILE*  fp = std::fopen("/proc/self/smaps", "r");
+
+    if (fp == nullptr)
+    {
+        return false;
+    }
+
+    std::fill(usage, usage + count, segment_usage{});
+
+    char                line[512];
+    unsigned long long  lo, hi, kb;
+    segment_usage*      pcurr   = nullptr;
+    bool                primary_range = false;
+
+    while (std::fgets(line, sizeof(line), fp) != nullptr)
+    {
+        if (std::sscanf(line, "%llx-%llx ", &lo, &hi) == 2)
+        {
+            pcurr = nullptr;
+
+            for (std::size_t i = 0;  i < count;  ++i)
+            {
+                uintptr_t   p = reinterpret_cast<uintptr_t>(primary[i]);
+                uintptr_t   s = reinterpret_cast<uintptr_t>(shadow[i]);
+
+                if (p != 0  &&  lo >= p  &&  lo < p + range)
+                {
+                    pcurr = &usage[i];
+                    primary_range = true;
+                }
+                else if (s != 0  &&  lo >= s  &&  lo < s + range)
+                {
+                    pcurr = &usage[i];
+                    primary_range = false;
+                }
+            }
+        }
+        else if (pcurr != nullptr  &&  std::sscanf(line, "Rss: %llu kB", &kb) == 1)
+        {
+            pcurr->m_resident += static_cast<std::size_t>(kb * 1024u);
+        }
+        else if (pcurr != nullptr  &&  primary_range  &&
+                 std::sscanf(line, "Referenced: %llu kB", &kb) == 1)
+        {
+            pcurr->m_referenced += static_cast<std::size_t>(kb * 1024u);
+        }
+    }
+    std::fclose(fp);
+
+    fp = std::fopen("/proc/self/clear_refs", "w");
+
+    bool    ok = (fp != nullptr)  &&  std::fputs("1", fp) >= 0;
+
+    if (fp != nullptr  &&  std::fclose(fp) != 0)
+    {
+        ok = false;
+    }
+    return ok;
+#else
+    (void) primary;
+    (void) shadow;
+    (void) count;
+    (void) range;
+    (void) usage;
+    return false;
+#endif
+}
+
+}   //- anonymous namespace
+
+//- Reserves max_size bytes of address space for each of the segment's buffers, so that it can
+//  later grow in place, and commits enough of them to hold size bytes.  Segments are committed
+//  in multiples of image_alignment bytes, which is at least the system page size.
+//
 void
 segmented_private_storage_model::allocate_segment(size_type segment, size_type size)
 {
     if (segment >= first_segment()  &&  segment <= max_segments  &&  
         size <= max_size  &&  sm_segment_addr[segment] == nullptr)
     {
-        sm_shadow_addr[segment] = new uint8_t[size];
-        memset(sm_shadow_addr[segment], 0, size);
+        size_type   extent = static_cast<size_type>(image_extent(size));
+        uint8_t*    pshd   = reserve_pages(max_size);
+        uint8_t*    pseg   = reserve_pages(max_size);
 
-        sm_segment_addr[segment] = new uint8_t[size];
-        memset(sm_segment_addr[segment], 0, size);
+        if (pshd == nullptr  ||  pseg == nullptr  ||
+            !commit_pages(pshd, extent)  ||  !commit_pages(pseg, extent))
+        {
+            release_pages(pshd, max_size);
+            release_pages(pseg, max_size);
+            throw std::bad_alloc();
+        }
 
+        sm_shadow_addr[segment]  = pshd;
+        sm_segment_addr[segment] = pseg;
         sm_segment_size[segment] = size;
+        ++sm_relocation_epoch;
     }
 }
 
+//- A segment that existed when the open transaction began cannot be deallocated, since its
+//  shadow buffer holds the transaction's undo image.
+//
 void
 segmented_private_storage_model::deallocate_segment(size_type segment)
 {
     if (sm_segment_addr[segment] != nullptr)
     {
-        delete [] sm_shadow_addr[segment];
-        delete [] sm_segment_addr[segment];
+        if (sm_transaction_open  &&  sm_undo_size[segment] != 0)
+        {
+            throw std::logic_error("segment is in use by a heap transaction");
+        }
+        release_pages(sm_shadow_addr[segment], max_size);
+        release_pages(sm_segment_addr[segment], max_size);
+
+        sm_shadow_addr[segment]  = nullptr;
         sm_segment_addr[segment] = nullptr;
         sm_segment_size[segment] = 0;
+        sm_segment_mapped[segment]     = false;
+        sm_segment_unverified[segment] = false;
+        sm_segment_cold[segment]       = false;
+        sm_idle_passes[segment]        = 0;
+        sm_page_written[segment].clear();
+        ++sm_relocation_epoch;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Changes the size of a segment without moving it, so that its base address, and every offset
+//  below the new size, remain valid.  Growing commits more of the address space reserved for
+//  the segment, and the new bytes read as zero; shrinking discards the bytes past the new size
+//  and decommits the pages that held them.  A segment that existed when the open transaction
+//  began cannot shrink below the size it had then.
+//--------------------------------------------------------------------------------------------------
+//
+void
+segmented_private_storage_model::resize_segment(size_type segment, size_type size)
+{
+    if (segment < first_segment()  ||  segment > max_segments  ||
+        sm_segment_addr[segment] == nullptr  ||  size > max_size)
+    {
+        throw std::out_of_range("invalid segment or segment size");
+    }
+    if (sm_transaction_open  &&  size < sm_undo_size[segment])
+    {
+        throw std::logic_error("segment is in use by a heap transaction");
+    }
+
+    size_type   old_size   = sm_segment_size[segment];
+    size_type   old_extent = static_cast<size_type>(image_extent(old_size));
+    size_type   new_extent = static_cast<size_type>(image_extent(size));
+
+    for (uint8_t* pbuf : {sm_shadow_addr[segment], sm_segment_addr[segment]})
+    {
+        if (new_extent > old_extent  &&
+            !commit_pages(pbuf + old_extent, new_extent - old_extent))
+        {
+            throw std::bad_alloc();
+        }
+        if (size < old_size)
+        {
+            size_type   kept = (new_extent < old_size) ? new_extent : old_size;
+
+            memset(pbuf + size, 0, kept - size);
+            decommit_pages(pbuf + new_extent, old_extent - new_extent);
+        }
+    }
+
+    //- Pages of a mapped segment that are never touched are reported as clean, and keep their
+    //  checksums, so the checksums of the new pages are set now.
+    //
+    size_type   npages = page_count(size);
+
+    for (size_type i = old_size / page_size;  i < npages  &&  size > old_size;  ++i)
+    {
+        size_type   n = (i + 1 < npages) ? size_type(page_size) : size - i * page_size;
+
+        sm_page_crc[segment][i] = (n == page_size  &&  i * page_size >= old_size)
+                                ? zero_page_checksum()
+                                : crc32c(0, sm_segment_addr[segment] + i * page_size, n);
     }
+
+    sm_segment_size[segment] = size;
 }
 
 void
@@ -57,14 +750,789 @@ segmented_private_storage_model::clear_segments()
     {
         deallocate_segment(i);
     }
+    reload_state();
 }
 
 void
 segmented_private_storage_model::swap_buffers()
 {
+    if (sm_transaction_open)
+    {
+        throw std::logic_error("cannot swap buffers during a heap transaction");
+    }
+
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        if (sm_segment_addr[i] != nullptr)
+        {
+            memcpy(sm_shadow_addr[i], sm_segment_addr[i], sm_segment_size[i]);
+            std::swap(sm_shadow_addr[i], sm_segment_addr[i]);
+            sm_segment_cold[i] = false;
+            sm_page_written[i].clear();
+        }
+    }
+    ++sm_relocation_epoch;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Opens a transaction by saving the contents of every segment in its shadow buffer, which then
+//  serves as the undo image until the transaction is committed or rolled back.  Pages of mapped
+//  segments that are still backed by the image file are not copied, since rolling back can
+//  simply discard any private copies made of them since.
+//--------------------------------------------------------------------------------------------------
+//
+void
+segmented_private_storage_model::begin_transaction()
+{
+    if (sm_transaction_open)
+    {
+        throw std::logic_error("a heap transaction is already open");
+    }
+
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        uint8_t*    pseg = sm_segment_addr[i];
+        uint8_t*    pshd = sm_shadow_addr[i];
+        size_type   size = sm_segment_size[i];
+
+        sm_undo_size[i] = (pseg != nullptr) ? size : 0;
+        sm_undo_clean[i].clear();
+
+        if (pseg == nullptr)
+        {
+            continue;
+        }
+        if (!find_clean_pages(i, sm_undo_clean[i]))
+        {
+            sm_undo_clean[i].clear();
+            memcpy(pshd, pseg, size);
+            continue;
+        }
+
+        for (size_type j = 0, offset = 0;  offset < size;  ++j, offset += page_size)
+        {
+            size_type   n = (offset + page_size < size) ? size_type(page_size) : size - offset;
+
+            if (!sm_undo_clean[i][j])
+            {
+                memcpy(pshd + offset, pseg + offset, n);
+            }
+        }
+    }
+
+    sm_transaction_open = true;
+}
+
+void
+segmented_private_storage_model::commit_transaction() noexcept
+{
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        sm_undo_clean[i].clear();
+    }
+    sm_transaction_open = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Returns every segment to its state when the open transaction began, and ends it.  Segments
+//  allocated since are deallocated, and those that grew are shrunk back.  Only pages that
+//  differ from the undo image are copied back, and private copies of pages that were backed by
+//  the image file are discarded, which lets the kernel read them from the file again.  A change
+//  tracker may have captured what such a page held during the transaction, so the page is no
+//  longer reported as clean.  Returns the number of pages restored.
+//--------------------------------------------------------------------------------------------------
+//
+segmented_private_storage_model::size_type
+segmented_private_storage_model::rollback_transaction()
+{
+    if (!sm_transaction_open)
+    {
+        throw std::logic_error("no heap transaction is open");
+    }
+
+    std::vector<bool>   clean;
+    size_type           restored = 0;
+
+    sm_transaction_open = false;
+
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        uint8_t*            pseg = sm_segment_addr[i];
+        uint8_t const*      pshd = sm_shadow_addr[i];
+        size_type           size = sm_undo_size[i];
+        std::vector<bool>&  undo = sm_undo_clean[i];
+
+        if (pseg == nullptr)
+        {
+            continue;
+        }
+        if (size == 0)
+        {
+            deallocate_segment(i);
+            continue;
+        }
+        if (sm_segment_size[i] > size)
+        {
+            resize_segment(i, size);
+        }
+
+        bool                known   = !undo.empty()  &&  find_clean_pages(i, clean);
+        std::vector<bool>&  written = sm_page_written[i];
+
+        for (size_type j = 0, offset = 0;  offset < size;  ++j, offset += page_size)
+        {
+            size_type   n = (offset + page_size < size) ? size_type(page_size) : size - offset;
+
+            if (!undo.empty()  &&  undo[j])
+            {
+                if (!known  ||  !clean[j])
+                {
+                    discard_private_page(pseg + offset);
+                    ++restored;
+
+                    if (written.size() <= j)
+                    {
+                        written.resize(j + 1, false);
+                    }
+                    written[j] = true;
+                }
+            }
+            else if (memcmp(pseg + offset, pshd + offset, n) != 0)
+            {
+                memcpy(pseg + offset, pshd + offset, n);
+                ++restored;
+            }
+        }
+        undo.clear();
+    }
+
+    return restored;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Copies the segments of a heap image, which were numbered consecutively from image_first when
+//  the image was captured, into the highest run of free segments, and then renumbers the
+//  synthetic pointers in the copies so that they refer to the new segments.  The scan is
+//  conservative: any word that has the shape of a pointer into the image is rewritten.  Returns
+//  the segment number to which image_first was mapped.
+//--------------------------------------------------------------------------------------------------
+//
+segmented_private_storage_model::size_type
+segmented_private_storage_model::import_segments
+(uint8_t const* const* images, size_type const* sizes, size_type count, size_type image_first)
+{
+    if (count == 0  ||  image_first < first_segment()  ||  image_first + count > max_segments + 1)
+    {
+        throw std::out_of_range("invalid image segment range");
+    }
+
+    for (size_type i = 0;  i < count;  ++i)
+    {
+        if (sizes[i] > max_size  ||  (sizes[i] % sizeof(uint64_t)) != 0)
+        {
+            throw std::length_error("invalid image segment size");
+        }
+    }
+
+    size_type   new_first = 0;
+
+    size_type   lowest = first_segment() + count - 1;
+
+    for (size_type last = max_segments;  new_first == 0  &&  last >= lowest;  --last)
+    {
+        size_type   n = 0;
+
+        while (n < count  &&  sm_segment_addr[last - n] == nullptr)
+        {
+            ++n;
+        }
+        if (n == count)
+        {
+            new_first = last - count + 1;
+        }
+    }
+
+    if (new_first == 0)
+    {
+        throw std::bad_alloc();
+    }
+
+    rebase_info     info = {image_first, count, new_first, sizes};
+
+    for (size_type i = 0;  i < count;  ++i)
+    {
+        allocate_segment(new_first + i, sizes[i]);
+        memcpy(sm_segment_addr[new_first + i], images[i], sizes[i]);
+        rebase_pointers(reinterpret_cast<uint64_t*>(sm_segment_addr[new_first + i]),
+                        sizes[i] / sizeof(uint64_t), info);
+    }
+
+    return new_first;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Writes every allocated segment, with its page checksums, to a heap image file that
+//  map_image() can restore, after the allocation strategy has stored its bookkeeping in the
+//  heap.  Checksums are brought up to date first, one thread per segment;
+//  pages of mapped segments that have not been written since they were loaded keep the
+//  checksums they were loaded with.  The image is written under a temporary name and renamed
+//  into place, so that an interrupted save never leaves a torn image at the given path, and so
+//  that a file which is currently mapped is not overwritten.
+//--------------------------------------------------------------------------------------------------
+//
+segmented_private_storage_model::checksum_stats
+segmented_private_storage_model::save_image(char const* path)
+{
+    store_state();
+
+    image_header                hdr = image_format::make_header(image_format::offset_encoding);
+    std::vector<size_type>      segments;
+
+    for (size_type i = first_segment();  i <= max_segments;  ++i)
+    {
+        if (sm_segment_addr[i] != nullptr)
+        {
+            hdr.m_sizes[i] = sm_segment_size[i];
+            segments.push_back(i);
+        }
+    }
+    hdr.m_header_crc = image_format::header_checksum(hdr);
+
+    checksum_stats  stats = run_per_segment(segments, update_checksums);
+
+    std::vector<uint32_t>   table;
+
+    for (size_type i : segments)
+    {
+        table.insert(table.end(), sm_page_crc[i], sm_page_crc[i] + page_count(hdr.m_sizes[i]));
+    }
+
+    std::string     temp = std::string(path) + ".tmp";
+    std::FILE*      fp   = std::fopen(temp.c_str(), "wb");
+    bool            ok   = (fp != nullptr)  &&
+                           image_format::write_padded(fp, &hdr, sizeof(hdr))  &&
+                           image_format::write_padded(fp, table.data(),
+                                                      table.size() * sizeof(uint32_t));
+
+    for (size_type i : segments)
+    {
+        ok = ok  &&  image_format::write_padded(fp, sm_segment_addr[i], hdr.m_sizes[i]);
+    }
+
+    if (fp != nullptr  &&  std::fclose(fp) != 0)
+    {
+        ok = false;
+    }
+#ifndef SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN
+    //- Only POSIX rename() replaces an existing file.
+    //
+    if (ok)
+    {
+        std::remove(path);
+    }
+#endif
+    if (!ok  ||  std::rename(temp.c_str(), path) != 0)
+    {
+        std::remove(temp.c_str());
+        throw std::runtime_error("unable to write heap image");
+    }
+
+    return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Installs the segments of a heap image file at the segment numbers they had when it was
+//  saved, which must be free.  Where mmap() is available, the segments are private mappings of
+//  the file, so that nothing is read until a page is first touched, and the file itself is never
+//  modified; each mapping is placed at the start of address space reserved for the segment, so
+//  that the segment can still grow in place.  The segments listed in hot[] are expected to be
+//  needed soon, and the kernel is asked to start reading them ahead.  Elsewhere the image is
+//  simply read into new segments.
+//
+//  With verify set, every page is checked against its checksum before returning, and an image
+//  that fails is unloaded again and rejected.  Otherwise checking is left to the caller, who
+//  may call verify_segments() for each segment before first using it.
+//--------------------------------------------------------------------------------------------------
+//
+segmented_private_storage_model::checksum_stats
+segmented_private_storage_model::map_image
+(char const* path, size_type const* hot, size_type hot_count, bool verify)
+{
+    image_header    hdr;
+    std::FILE*      fp = std::fopen(path, "rb");
+
+    if (fp == nullptr  ||  !image_format::read_header(fp, hdr))
+    {
+        if (fp != nullptr)
+        {
+            std::fclose(fp);
+        }
+        throw std::runtime_error("invalid heap image");
+    }
+    if (hdr.m_encoding != image_format::offset_encoding  ||  hdr.m_segment_size != max_size)
+    {
+        std::fclose(fp);
+        throw std::runtime_error("heap image was saved by an incompatible storage model");
+    }
+
+    std::vector<size_type>  segments;
+
+    for (size_type i = 0;  i <= max_segments + 1;  ++i)
+    {
+        if (hdr.m_sizes[i] != 0  &&  (i < first_segment()  ||  i > max_segments  ||
+            hdr.m_sizes[i] > max_size  ||  sm_segment_addr[i] != nullptr))
+        {
+            std::fclose(fp);
+            throw std::out_of_range("heap image segment is invalid or in use");
+        }
+        if (hdr.m_sizes[i] != 0)
+        {
+            segments.push_back(i);
+        }
+    }
+
+    //- The checksum table is read into the (free) segments' checksum arrays.
+    //
+    bool    ok = std::fseek(fp, static_cast<long>(image_format::checksum_offset()), SEEK_SET) == 0;
+
+    for (size_type i : segments)
+    {
+        ok = ok  &&  std::fread(sm_page_crc[i], sizeof(uint32_t), page_count(hdr.m_sizes[i]), fp)
+                        == page_count(hdr.m_sizes[i]);
+    }
+
+#ifdef SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN
+    for (size_type i : segments)
+    {
+        if (!ok)
+        {
+            break;
+        }
+
+        size_t      len  = static_cast<size_t>(image_extent(hdr.m_sizes[i]));
+        uint8_t*    pseg = reserve_pages(max_size);
+        uint8_t*    pshd = reserve_pages(max_size);
+
+        ok = pseg != nullptr  &&  pshd != nullptr  &&  commit_pages(pshd, len)  &&
+             mmap(pseg, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fileno(fp),
+                  static_cast<off_t>(image_format::segment_offset(hdr, i))) != MAP_FAILED;
+
+        if (ok)
+        {
+            sm_segment_addr[i]   = pseg;
+            sm_shadow_addr[i]    = pshd;
+            sm_segment_size[i]   = static_cast<size_type>(hdr.m_sizes[i]);
+            sm_segment_mapped[i] = true;
+        }
+        else
+        {
+            release_pages(pseg, max_size);
+            release_pages(pshd, max_size);
+        }
+    }
+
+    for (size_type i = 0;  ok  &&  i < hot_count;  ++i)
+    {
+        if (hot[i] <= max_segments  &&  sm_segment_mapped[hot[i]])
+        {
+            madvise(sm_segment_addr[hot[i]], image_extent(sm_segment_size[hot[i]]),
+                    MADV_WILLNEED);
+        }
+    }
+#else
+    (void) hot;
+    (void) hot_count;
+
+    for (size_type i : segments)
+    {
+        size_t  size = static_cast<size_t>(hdr.m_sizes[i]);
+
+        if (ok)
+        {
+            long    offset = static_cast<long>(image_format::segment_offset(hdr, i));
+
+            allocate_segment(i, size);
+            ok = std::fseek(fp, offset, SEEK_SET) == 0  &&
+                 std::fread(sm_segment_addr[i], 1, size, fp) == size;
+        }
+    }
+#endif
+
+    std::fclose(fp);
+    ++sm_relocation_epoch;
+
+    for (size_type i : segments)
+    {
+        sm_segment_unverified[i] = (sm_segment_addr[i] != nullptr);
+    }
+
+    checksum_stats  stats = {};
+
+    if (ok  &&  verify)
+    {
+        stats = verify_segments(segments.data(), segments.size());
+    }
+
+    //- Leave no part of a failed image behind.
+    //
+    if (!ok  ||  stats.bad_pages != 0)
+    {
+        for (size_type i : segments)
+        {
+            deallocate_segment(i);
+        }
+        throw std::runtime_error(ok ? "heap image failed verification"
+                                    : "unable to map heap image");
+    }
+
+    //- An image that holds the first segment holds a heap, whose bookkeeping comes with it.
+    //
+    if (hdr.m_sizes[first_segment()] != 0)
+    {
+        reload_state();
+    }
+    return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Checks the pages of the given loaded segments against the checksums they were saved with,
+//  one thread per segment, or of every segment not yet verified if none are given.
+//--------------------------------------------------------------------------------------------------
+//
+segmented_private_storage_model::checksum_stats
+segmented_private_storage_model::verify_segments(size_type const* segments, size_type count)
+{
+    std::vector<size_type>  pending;
+
+    if (segments != nullptr)
+    {
+        pending.assign(segments, segments + count);
+    }
+    else
+    {
+        for (size_type i = first_segment();  i <= max_segments;  ++i)
+        {
+            if (sm_segment_unverified[i])
+            {
+                pending.push_back(i);
+            }
+        }
+    }
+
+    return run_per_segment(pending, check_checksums);
+}
+
+segmented_private_storage_model::checksum_stats
+segmented_private_storage_model::update_checksums(size_type segment)
+{
+    checksum_stats      stats  = {};
+    uint8_t const*      pbuf   = sm_segment_addr[segment];
+    size_type           size   = sm_segment_size[segment];
+    size_type           npages = page_count(size);
+    std::vector<bool>   clean;
+
+    find_backed_pages(segment, clean);
+
+    for (size_type i = 0;  i < npages;  ++i)
+    {
+        if (clean[i])
+        {
+            ++stats.pages_reused;
+        }
+        else
+        {
+            size_type   n = (i + 1 < npages) ? size_type(page_size) : size - i * page_size;
+
+            sm_page_crc[segment][i] = crc32c(0, pbuf + i * page_size, n);
+            stats.bytes_hashed += n;
+        }
+    }
+    return stats;
+}
+
+segmented_private_storage_model::checksum_stats
+segmented_private_storage_model::check_checksums(size_type segment)
+{
+    checksum_stats      stats  = {};
+    uint8_t const*      pbuf   = sm_segment_addr[segment];
+    size_type           size   = sm_segment_size[segment];
+    size_type           npages = page_count(size);
+
+    for (size_type i = 0;  pbuf != nullptr  &&  i < npages;  ++i)
+    {
+        size_type   n = (i + 1 < npages) ? size_type(page_size) : size - i * page_size;
+
+        if (crc32c(0, pbuf + i * page_size, n) != sm_page_crc[segment][i])
+        {
+            ++stats.bad_pages;
+        }
+        stats.bytes_hashed += n;
+    }
+    sm_segment_unverified[segment] = false;
+
+    return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Sets clean[i] for each page of the segment that is known not to have been written since the
+//  segment was mapped from an image, and returns whether any such knowledge was available.  Only
+//  pages of mapped segments can be known to be clean; for any other segment, every page is
+//  reported as possibly dirty.  A page backed by the cold store is clean only if it was also
+//  unwritten when the segment was evicted, since the store holds whatever the page contained
+//  then, and a page that a rollback returned to the file's contents is never clean again.
+//--------------------------------------------------------------------------------------------------
+//
+bool
+segmented_private_storage_model::find_clean_pages(size_type segment, std::vector<bool>& clean)
+{
+    if (!find_backed_pages(segment, clean))
+    {
+        return false;
+    }
+    std::vector<bool> const&    written = sm_page_written[segment];
+
+    for (size_type i = 0;  i < clean.size()  &&  i < written.size();  ++i)
+    {
+        clean[i] = clean[i]  &&  !written[i];
+    }
+    return true;
+}
+
+//- Sets backed[i] for each page of the segment that is still backed by the file its primary
+//  buffer was last mapped from, be it the image or the cold store, and so has not been written
+//  since.  Eviction and the checksums need no more than this.
+//
+bool
+segmented_private_storage_model::find_backed_pages(size_type segment, std::vector<bool>& backed)
+{
+    size_type   npages = page_count(sm_segment_size[segment]);
+
+    if (sm_segment_addr[segment] == nullptr  ||  !sm_segment_mapped[segment]  ||
+        !find_mapped_clean_pages(sm_segment_addr[segment], npages, backed))
+    {
+        backed.assign(npages, false);
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Opens a new cold store at the given path, to which sample_segments() and evict_segment()
+//  write segments that are not in use.  Where mmap() is available, the file is unlinked as soon
+//  as it is open, so that its space is reclaimed when the last evicted segment is unmapped;
+//  elsewhere there is nothing to map it with, and segments are never evicted.
+//--------------------------------------------------------------------------------------------------
+//
+void
+segmented_private_storage_model::open_cold_store(char const* path)
+{
+    if (sm_cold_store != nullptr)
+    {
+        throw std::logic_error("a cold store is already open");
+    }
+
+    //- A previous store at the same path may still be mapped by evicted segments, so it is
+    //  replaced by a new file rather than truncated.
+    //
+    std::remove(path);
+
+    if ((sm_cold_store = std::fopen(path, "w+b")) == nullptr)
+    {
+        throw std::runtime_error("unable to create cold store");
+    }
+#ifdef SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN
+    std::remove(path);
+#endif
+}
+
+//- Segments already evicted remain mapped from the store, which lives on until they are
+//  deallocated, but no more are evicted until another store is opened.
+//
+void
+segmented_private_storage_model::close_cold_store()
+{
+    if (sm_cold_store != nullptr)
+    {
+        std::fclose(sm_cold_store);
+        sm_cold_store = nullptr;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Samples the kernel's referenced bits for the pages of every segment, and evicts segments to
+//  the cold store: those not referenced during the last idle_passes passes, and then, while the
+//  segments' resident bytes exceed max_resident (if nonzero), the least recently referenced of
+//  the rest.  Evicted segments stay at the same addresses, so no pointer or translation changes;
+//  touching one of their pages later simply faults it back in from the file.
+//
+//  Sampling clears the referenced bits of the whole process, and eviction must not race with
+//  writes to the heap.  Without access information, or while a transaction is open, nothing is
+//  evicted.
+//--------------------------------------------------------------------------------------------------
+//
+segmented_private_storage_model::tiering_stats
+segmented_private_storage_model::sample_segments(size_type idle_passes, size_type max_resident)
+{
+    tiering_stats           stats = {};
+    segment_usage           usage[max_segments + 2];
+    std::vector<size_type>  candidates;
+
+    bool    known = read_segment_usage(sm_segment_addr, sm_shadow_addr, max_segments + 2,
+                                       max_size, usage);
+
     for (size_type i = first_segment();  i <= max_segments;  ++i)
     {
-        memcpy(sm_shadow_addr[i], sm_segment_addr[i], sm_segment_size[i]);
-        std::swap(sm_shadow_addr[i], sm_segment_addr[i]);
+        if (sm_segment_addr[i] == nullptr)
+        {
+            continue;
+        }
+        if (!known  ||  usage[i].m_referenced != 0)
+        {
+            ++stats.segments_referenced;
+            sm_idle_passes[i] = 0;
+        }
+        else
+        {
+            ++sm_idle_passes[i];
+        }
+        if (known  &&  usage[i].m_resident != 0)
+        {
+            stats.resident_bytes += usage[i].m_resident;
+            candidates.push_back(i);
+        }
+    }
+
+    //- Candidates are taken longest idle first, and the largest first among equals.
+    //
+    std::sort(candidates.begin(), candidates.end(), [&usage](size_type a, size_type b)
+              {
+                  return (sm_idle_passes[a] != sm_idle_passes[b])
+                       ? sm_idle_passes[a] > sm_idle_passes[b]
+                       : usage[a].m_resident > usage[b].m_resident;
+              });
+
+    for (size_type i : candidates)
+    {
+        bool    over = (max_resident != 0  &&  stats.resident_bytes > max_resident);
+
+        if (over  ||  sm_idle_passes[i] >= idle_passes)
+        {
+            tiering_stats   part = evict(i, usage[i].m_resident);
+
+            stats.segments_evicted += part.segments_evicted;
+            stats.bytes_written    += part.bytes_written;
+            stats.bytes_released   += part.bytes_released;
+            stats.resident_bytes   -= part.bytes_released;
+        }
+    }
+
+    return stats;
+}
+
+//- Evicts the segment to the cold store whether or not it is in use.
+//
+segmented_private_storage_model::tiering_stats
+segmented_private_storage_model::evict_segment(size_type segment)
+{
+    segment_usage   usage[max_segments + 2];
+
+    if (segment < first_segment()  ||  segment > max_segments)
+    {
+        throw std::out_of_range("invalid segment");
+    }
+    if (!read_segment_usage(sm_segment_addr, sm_shadow_addr, max_segments + 2, max_size, usage))
+    {
+        usage[segment].m_resident = 0;
+    }
+    return evict(segment, usage[segment].m_resident);
+}
+
+//--------------------------------------------------------------------------------------------------
+//  Writes the segment to its region of the cold store, maps the region over the segment's
+//  primary buffer, and decommits its shadow buffer.  A segment evicted before only needs the
+//  pages written since to be written again, since the rest are still backed by the store.  The
+//  checksums of written pages are brought up to date first, so that save_image() can go on
+//  reusing the checksums of pages that are backed by a file.
+//--------------------------------------------------------------------------------------------------
+//
+segmented_private_storage_model::tiering_stats
+segmented_private_storage_model::evict(size_type segment, size_type resident)
+{
+    tiering_stats   stats = {};
+
+#ifdef SEGMENTED_PRIVATE_STORAGE_MODEL_MMAN
+    if (sm_cold_store == nullptr  ||  sm_segment_addr[segment] == nullptr  ||
+        sm_transaction_open)
+    {
+        return stats;
     }
+
+    uint8_t*            pseg   = sm_segment_addr[segment];
+    size_type           extent = static_cast<size_type>(image_extent(sm_segment_size[segment]));
+    uint64_t            base   = uint64_t(segment) * max_size;
+    std::vector<bool>   clean;
+
+    update_checksums(segment);
+
+    bool    known = find_backed_pages(segment, clean);
+    bool    reuse = sm_segment_cold[segment]  &&  known;
+    bool    ok    = true;
+
+    //- Pages past the segment's size are all zero, and are always written, so that the region
+    //  never holds stale bytes from before the segment last shrank.
+    //
+    for (size_type i = 0;  ok  &&  i < extent / page_size;  ++i)
+    {
+        if (!reuse  ||  i >= clean.size()  ||  !clean[i])
+        {
+            ok = std::fseek(sm_cold_store, static_cast<long>(base + i * page_size), SEEK_SET) == 0
+              && std::fwrite(pseg + i * page_size, 1, page_size, sm_cold_store) == page_size;
+            stats.bytes_written += page_size;
+        }
+    }
+
+    if (!ok  ||  std::fflush(sm_cold_store) != 0  ||
+        mmap(pseg, extent, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+             fileno(sm_cold_store), static_cast<off_t>(base)) == MAP_FAILED)
+    {
+        throw std::runtime_error("unable to evict segment to cold store");
+    }
+
+    decommit_pages(sm_shadow_addr[segment], extent);
+
+    if (!commit_pages(sm_shadow_addr[segment], extent))
+    {
+        throw std::bad_alloc();
+    }
+
+    //- Pages that were not backed by a file have been written since the segment was mapped
+    //  from an image, and stay flagged through later evictions; a segment that was never
+    //  mapped has every page flagged.
+    //
+    std::vector<bool>&  written = sm_page_written[segment];
+
+    written.resize(extent / page_size, false);
+
+    for (size_type i = 0;  i < written.size();  ++i)
+    {
+        written[i] = written[i]  ||  !known  ||  i >= clean.size()  ||  !clean[i];
+    }
+
+    sm_segment_mapped[segment] = true;
+    sm_segment_cold[segment]   = true;
+
+    stats.segments_evicted = 1;
+    stats.bytes_released   = resident;
+#else
+    (void) segment;
+    (void) resident;
+#endif
+
+    return stats;
+}
+
+uint32_t
+segmented_private_storage_model::checksum(void const* p, size_type n, uint32_t crc) noexcept
+{
+    return crc32c(crc, static_cast<uint8_t const*>(p), n);
 }
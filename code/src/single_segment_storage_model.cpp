@@ -0,0 +1,252 @@
+//==================================================================================================
+//  File:
+//      single_segment_storage_model.cpp
+//
+//  Summary:
+//      Implements a heap class for testing rhx_allocator whose heap lives in exactly one segment.
+//==================================================================================================
+//
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "single_segment_storage_model.h"
+
+#if defined(_WIN32)
+    #define SINGLE_SEGMENT_STORAGE_MODEL_WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+    #define SINGLE_SEGMENT_STORAGE_MODEL_MMAN
+    #include <sys/mman.h>
+    #ifndef MAP_ANONYMOUS
+        #define MAP_ANONYMOUS   MAP_ANON
+    #endif
+    #ifndef MAP_NORESERVE
+        #define MAP_NORESERVE   0
+    #endif
+#endif
+
+uint8_t*
+    single_segment_storage_model::sm_segment_addr[max_segments + 2];
+
+single_segment_storage_model::size_type
+    single_segment_storage_model::sm_segment_size[max_segments + 2];
+
+uint8_t*
+    single_segment_storage_model::sm_shadow_addr[max_segments + 2];
+
+single_segment_storage_model::state_hook
+    single_segment_storage_model::sm_reload_hook = nullptr;
+
+namespace {
+#if !defined(SINGLE_SEGMENT_STORAGE_MODEL_WIN32)  &&  !defined(SINGLE_SEGMENT_STORAGE_MODEL_MMAN)
+//--------------------------------------------------------------------------------------------------
+//  Without virtual memory services, buffers come from the free store, aligned exactly as in the
+//  segmented model.
+//--------------------------------------------------------------------------------------------------
+//
+uint8_t*
+allocate_aligned(std::size_t size, std::size_t align)
+{
+    uint8_t*    praw = new uint8_t[size + align + sizeof(uint8_t*)];
+    uintptr_t   addr = reinterpret_cast<uintptr_t>(praw + sizeof(uint8_t*));
+    uint8_t*    pbuf = reinterpret_cast<uint8_t*>((addr + align - 1) & ~(uintptr_t)(align - 1));
+
+    memcpy(pbuf - sizeof(uint8_t*), &praw, sizeof(uint8_t*));
+    return pbuf;
+}
+
+void
+deallocate_aligned(uint8_t* pbuf)
+{
+    uint8_t*    praw;
+
+    memcpy(&praw, pbuf - sizeof(uint8_t*), sizeof(uint8_t*));
+    delete [] praw;
+}
+#endif
+
+//--------------------------------------------------------------------------------------------------
+//  Address space primitives, as in the segmented model.  A reserved range is inaccessible until
+//  pages are committed; committed pages read as zero, and decommitting them discards their
+//  contents.  Without virtual memory services, the whole range is allocated and zeroed up
+//  front, and committing does nothing.
+//--------------------------------------------------------------------------------------------------
+//
+uint8_t*
+reserve_pages(std::size_t size)
+{
+#if defined(SINGLE_SEGMENT_STORAGE_MODEL_WIN32)
+    return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS));
+#elif defined(SINGLE_SEGMENT_STORAGE_MODEL_MMAN)
+    void*   p = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return (p != MAP_FAILED) ? static_cast<uint8_t*>(p) : nullptr;
+#else
+    uint8_t*    p = allocate_aligned(size, single_segment_storage_model::max_align);
+
+    memset(p, 0, size);
+    return p;
+#endif
+}
+
+bool
+commit_pages(uint8_t* p, std::size_t size)
+{
+    if (size == 0)
+    {
+        return true;
+    }
+#if defined(SINGLE_SEGMENT_STORAGE_MODEL_WIN32)
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#elif defined(SINGLE_SEGMENT_STORAGE_MODEL_MMAN)
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#else
+    (void) p;
+    return true;
+#endif
+}
+
+void
+decommit_pages(uint8_t* p, std::size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+#if defined(SINGLE_SEGMENT_STORAGE_MODEL_WIN32)
+    VirtualFree(p, size, MEM_DECOMMIT);
+#elif defined(SINGLE_SEGMENT_STORAGE_MODEL_MMAN)
+    mmap(p, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+#else
+    memset(p, 0, size);
+#endif
+}
+
+void
+release_pages(uint8_t* p, std::size_t size)
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+#if defined(SINGLE_SEGMENT_STORAGE_MODEL_WIN32)
+    (void) size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(SINGLE_SEGMENT_STORAGE_MODEL_MMAN)
+    munmap(p, size);
+#else
+    (void) size;
+    deallocate_aligned(p);
+#endif
+}
+
+inline std::size_t
+round_to_page(std::size_t size)
+{
+    return (size + single_segment_storage_model::max_align - 1) &
+           ~std::size_t(single_segment_storage_model::max_align - 1);
+}
+
+}   //- anonymous namespace
+
+void
+single_segment_storage_model::allocate_segment(size_type segment, size_type size)
+{
+    if (segment == first_segment()  &&  size <= max_size  &&  sm_segment_addr[segment] == nullptr)
+    {
+        size_type   extent = round_to_page(size);
+        uint8_t*    pshd   = reserve_pages(max_size);
+        uint8_t*    pseg   = reserve_pages(max_size);
+
+        if (pshd == nullptr  ||  pseg == nullptr  ||
+            !commit_pages(pshd, extent)  ||  !commit_pages(pseg, extent))
+        {
+            release_pages(pshd, max_size);
+            release_pages(pseg, max_size);
+            throw std::bad_alloc();
+        }
+
+        sm_shadow_addr[segment]  = pshd;
+        sm_segment_addr[segment] = pseg;
+        sm_segment_size[segment] = size;
+    }
+}
+
+void
+single_segment_storage_model::deallocate_segment(size_type segment)
+{
+    if (segment == first_segment()  &&  sm_segment_addr[segment] != nullptr)
+    {
+        release_pages(sm_shadow_addr[segment], max_size);
+        release_pages(sm_segment_addr[segment], max_size);
+
+        sm_shadow_addr[segment]  = nullptr;
+        sm_segment_addr[segment] = nullptr;
+        sm_segment_size[segment] = 0;
+    }
+}
+
+//- Changes the size of the segment without moving it.  New bytes read as zero, so bytes that
+//  the segment gives up are cleared, and whole pages of them are decommitted.
+//
+void
+single_segment_storage_model::resize_segment(size_type segment, size_type size)
+{
+    if (segment != first_segment()  ||  sm_segment_addr[segment] == nullptr  ||  size > max_size)
+    {
+        throw std::out_of_range("invalid segment or segment size");
+    }
+
+    size_type   old_size   = sm_segment_size[segment];
+    size_type   old_extent = round_to_page(old_size);
+    size_type   new_extent = round_to_page(size);
+
+    for (uint8_t* pbuf : {sm_shadow_addr[segment], sm_segment_addr[segment]})
+    {
+        if (new_extent > old_extent  &&
+            !commit_pages(pbuf + old_extent, new_extent - old_extent))
+        {
+            throw std::bad_alloc();
+        }
+        if (size < old_size)
+        {
+            size_type   kept = (new_extent < old_size) ? new_extent : old_size;
+
+            memset(pbuf + size, 0, kept - size);
+            decommit_pages(pbuf + new_extent, old_extent - new_extent);
+        }
+    }
+
+    sm_segment_size[segment] = size;
+}
+
+void
+single_segment_storage_model::clear_segments()
+{
+    deallocate_segment(first_segment());
+
+    if (sm_reload_hook != nullptr)
+    {
+        sm_reload_hook();
+    }
+}
+
+void
+single_segment_storage_model::swap_buffers()
+{
+    size_type   i = first_segment();
+
+    if (sm_segment_addr[i] != nullptr)
+    {
+        memcpy(sm_shadow_addr[i], sm_segment_addr[i], sm_segment_size[i]);
+        std::swap(sm_shadow_addr[i], sm_segment_addr[i]);
+    }
+}